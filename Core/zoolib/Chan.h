@@ -48,6 +48,9 @@ using ChanSize = DeriveFrom<ChanAspect_Size>;
 
 using ChanSizeSet = DeriveFrom<ChanAspect_SizeSet>;
 
+template <typename EE>
+using ChanSpan = DeriveFrom<ChanAspect_Span<EE>>;
+
 template <typename EE>
 using ChanU = DeriveFrom<ChanAspect_Unread<EE>>;
 
@@ -77,6 +80,16 @@ using ChanRPos = DeriveFrom
 	ChanAspect_Unread<EE>
 	>;
 
+template <typename EE>
+using ChanRPosSpan = DeriveFrom
+	<
+	ChanAspect_Pos,
+	ChanAspect_Read<EE>,
+	ChanAspect_Size,
+	ChanAspect_Span<EE>,
+	ChanAspect_Unread<EE>
+	>;
+
 template <typename EE>
 using ChanWPos = DeriveFrom
 	<
@@ -173,6 +173,30 @@ public:
 inline void sSizeSet(const ChanAspect_SizeSet& iAspect, uint64 iSize)
 	{ sNonConst(iAspect).SizeSet(iSize); }
 
+// =================================================================================================
+#pragma mark - ChanAspect_Span
+
+/** Implemented by read chans whose content is already in addressable memory. Span returns the
+elements from the current position onwards without consuming them; call Skip to do that. The
+span remains valid until the chan is destroyed. */
+
+template <class EE>
+class ChanAspect_Span
+:	public virtual UserOfElement<EE>
+	{
+public:
+	virtual PaC<const EE> Span() = 0;
+	};
+
+template <class EE>
+PaC<const EE> sSpan(const ChanAspect_Span<EE>& iAspect)
+	{ return sNonConst(iAspect).Span(); }
+
+/// Returns the Span aspect of iAspect's chan, or null if it has none.
+template <class EE>
+ChanAspect_Span<EE>* sSpannable(const ChanAspect_Read<EE>& iAspect)
+	{ return dynamic_cast<ChanAspect_Span<EE>*>(&sNonConst(iAspect)); }
+
 // =================================================================================================
 #pragma mark - ChanAspect_Unread
 
@@ -227,6 +251,21 @@ class ChanAspect_Write
 public:
 	virtual size_t Write(const EE* iSource, size_t iCount) = 0;
 
+	// Gather-write. The default writes the fragments in turn, stopping at the first that's
+	// not entirely accepted. Chans that can pass several fragments on in one go override it.
+	virtual size_t WriteV(const PaC<const EE>* iSources, size_t iCount)
+		{
+		size_t result = 0;
+		for (size_t xx = 0; xx < iCount; ++xx)
+			{
+			const size_t countWritten = this->Write(sPointer(iSources[xx]), sCount(iSources[xx]));
+			result += countWritten;
+			if (countWritten < sCount(iSources[xx]))
+				break;
+			}
+		return result;
+		}
+
 	virtual void Flush()
 		{}
 	};
@@ -235,6 +274,11 @@ template <class EE>
 inline size_t sWrite(const ChanAspect_Write<EE>& iAspect, const EE* iSource, size_t iCount)
 	{ return sNonConst(iAspect).Write(iSource, iCount); }
 
+template <class EE>
+inline size_t sWriteV(const ChanAspect_Write<EE>& iAspect,
+	const PaC<const EE>* iSources, size_t iCount)
+	{ return sNonConst(iAspect).WriteV(iSources, iCount); }
+
 template <class EE>
 inline void sFlush(const ChanAspect_Write<EE>& iAspect)
 	{ sNonConst(iAspect).Flush(); }
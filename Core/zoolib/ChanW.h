@@ -65,6 +65,50 @@ template <class EE>
 void sEWrite(const ChanW<EE>& iChan, const EE* iSource, size_t iCount)
 	{ iCount == sWriteFully<EE>(iChan, iSource, iCount) || sThrow_ExhaustedW(); }
 
+template <class EE>
+size_t sWriteVFully(const ChanW<EE>& iChan, const PaC<const EE>* iSources, size_t iCount)
+	{
+	size_t result = 0;
+	while (iCount)
+		{
+		size_t countWritten = sWriteV(iChan, iSources, iCount);
+		if (not countWritten)
+			break;
+		result += countWritten;
+
+		// Step over the fragments that were completely written.
+		while (iCount && countWritten >= sCount(*iSources))
+			{
+			countWritten -= sCount(*iSources);
+			++iSources;
+			--iCount;
+			}
+
+		if (countWritten)
+			{
+			// Finish off the fragment that was partially written.
+			const size_t countRemaining = sCount(*iSources) - countWritten;
+			const size_t countFinished =
+				sWriteFully(iChan, sPointer(*iSources) + countWritten, countRemaining);
+			result += countFinished;
+			if (countFinished < countRemaining)
+				break;
+			++iSources;
+			--iCount;
+			}
+		}
+	return result;
+	}
+
+template <class EE>
+void sEWriteV(const ChanW<EE>& iChan, const PaC<const EE>* iSources, size_t iCount)
+	{
+	size_t countTotal = 0;
+	for (size_t xx = 0; xx < iCount; ++xx)
+		countTotal += sCount(iSources[xx]);
+	countTotal == sWriteVFully<EE>(iChan, iSources, iCount) || sThrow_ExhaustedW();
+	}
+
 // =================================================================================================
 #pragma mark -
 
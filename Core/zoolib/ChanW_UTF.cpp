@@ -48,7 +48,7 @@ void sWrite(const ChanW_UTF& iChanW,
 	{
 	const UTF16* localSource = iSource;
 	size_t localCountCP = iCountCP;
-	while (iCountCU)
+	while (iCountCU && localCountCP)
 		{
 		UTF32 buffer[kBufSize];
 		size_t utf16Consumed;
@@ -86,13 +86,79 @@ void sWrite(const ChanW_UTF& iChanW,
 		*oCountCP = iCountCP - localCountCP;
 	}
 
+static void spWrite_Native8(ChanW_UTF_Native8& iChanW,
+	const UTF8* iSource,
+	size_t iCountCU, size_t* oCountCU, size_t iCountCP, size_t* oCountCP)
+	{
+	// The sink takes UTF-8, so we need only sanitize what we're given (which for runs of ASCII is
+	// a straight copy) rather than decode it to UTF-32 for the sink to then re-encode.
+	// Code points are only counted if the limit could be reached, or we must report them.
+	const bool countCP = oCountCP || iCountCP < iCountCU;
+	const UTF8* localSource = iSource;
+	size_t localCountCP = iCountCP;
+	while (iCountCU && localCountCP)
+		{
+		UTF8 buffer[kBufSize];
+		size_t utf8Consumed;
+		size_t utf8Generated;
+		if (not Unicode::sUTF8ToUTF8(
+			localSource, iCountCU,
+			&utf8Consumed, nullptr,
+			buffer, kBufSize,
+			&utf8Generated,
+			localCountCP, nullptr))
+			{
+			// localSource[0] to localSource[iCountCU] ends with an incomplete UTF8 sequence.
+			if (utf8Consumed == 0)
+				break;
+			}
+
+		size_t utf8Written = 0;
+		while (utf8Written < utf8Generated)
+			{
+			if (const size_t countWritten =
+				iChanW.WriteUTF8(buffer + utf8Written, utf8Generated - utf8Written))
+				{
+				utf8Written += countWritten;
+				}
+			else
+				{
+				break;
+				}
+			}
+
+		if (utf8Written < utf8Generated)
+			{
+			// It's a truncated write. We need to convert from utf8Written back into
+			// the number of source code units.
+			const size_t codePoints = Unicode::sCUToCP(buffer, utf8Written);
+			localSource += Unicode::sCPToCU(localSource, codePoints);
+			localCountCP -= codePoints;
+			break;
+			}
+
+		localSource += utf8Consumed;
+		iCountCU -= utf8Consumed;
+		if (countCP)
+			localCountCP -= Unicode::sCUToCP(buffer, utf8Generated);
+		}
+
+	if (oCountCU)
+		*oCountCU = localSource - iSource;
+	if (oCountCP)
+		*oCountCP = iCountCP - localCountCP;
+	}
+
 void sWrite(const ChanW_UTF& iChanW,
 	const UTF8* iSource,
 	size_t iCountCU, size_t* oCountCU, size_t iCountCP, size_t* oCountCP)
 	{
+	if (ChanW_UTF_Native8* theChanW = dynamic_cast<ChanW_UTF_Native8*>(&sNonConst(iChanW)))
+		return spWrite_Native8(*theChanW, iSource, iCountCU, oCountCU, iCountCP, oCountCP);
+
 	const UTF8* localSource = iSource;
 	size_t localCountCP = iCountCP;
-	while (iCountCU)
+	while (iCountCU && localCountCP)
 		{
 		UTF32 buffer[kBufSize];
 		size_t utf8Consumed;
@@ -140,6 +140,9 @@ public:
 // =================================================================================================
 #pragma mark - ChanW_UTF_Native8
 
+/// UTF-8 written to a ChanW_UTF_Native8 with sWrite and friends reaches WriteUTF8 without
+/// being decoded to UTF-32.
+
 class ChanW_UTF_Native8
 :	public ChanW_UTF
 	{
@@ -20,6 +20,8 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/Counted.h"
 
+#include <typeinfo>
+
 namespace ZooLib {
 
 // =================================================================================================
@@ -90,13 +92,28 @@ void CountedBase::Release()
 			return;
 			}
 
-		if (sAtomic_CAS(&fRefCount, oldRefCount, oldRefCount - 1))
+		if (oldRefCount & kBiased)
+			{
+			// Only a CountedBiased sets kBiased, and this is a slow path anyway.
+			dynamic_cast<CountedBiased*>(this)->pRelease_Biased();
+			return;
+			}
+
+		// sAtomic_CAS is relaxed, and our writes to the object must be visible to whichever
+		// thread ends up finalizing it.
+		int expected = oldRefCount;
+		if (fRefCount.compare_exchange_weak(expected, oldRefCount - 1, std::memory_order_release))
 			return;
 		}
 	}
 
 bool CountedBase::IsShared() const
-	{ return sAtomic_Get(&fRefCount) > 1; }
+	{
+	const int theRefCount = sAtomic_Get(&fRefCount);
+	if (theRefCount & kBiased)
+		return dynamic_cast<const CountedBiased*>(this)->pIsShared_Biased();
+	return theRefCount > 1;
+	}
 
 bool CountedBase::IsReferenced() const
 	{ return sAtomic_Get(&fRefCount) > 0; }
@@ -146,6 +163,293 @@ int CountedBase::pCOMRelease()
 		}
 	}
 
+// =================================================================================================
+#pragma mark - CountedBiased::Owner
+
+// Whilst an object is biased, fRefCount holds CountedBase::kBiased, kQueued if the object is on its
+// owner's queue, and the count of references held by other threads, offset by kSharedZero.
+
+static const int kQueued = 1 << 29;
+static const int kSharedZero = 1 << 28;
+static const int kSharedMask = kQueued - 1;
+
+static int spShared(int iRefCount)
+	{ return (iRefCount & kSharedMask) - kSharedZero; }
+
+class CountedBiased::Owner
+	{
+public:
+	Owner()
+	:	fBiasedCount(0)
+	,	fQueued(nullptr)
+	,	fExited(false)
+		{}
+
+	static Owner* sEnsureCurrent();
+
+	void Push(CountedBiased* iCountedBiased);
+	void Drain();
+
+	// How many objects are biased towards us. Only touched by our thread until it exits, and
+	// thereafter only with fMtx held.
+	size_t fBiasedCount;
+
+private:
+	class Reaper;
+	void pExit();
+	CountedBiased* pFoldQueued();
+	static void spReleaseMerged(CountedBiased* iMerged);
+
+	// Objects queued by other threads for us to fold in.
+	std::atomic<CountedBiased*> fQueued;
+
+	// Protects fExited, and once it's set serializes the folding done by releasing threads.
+	ZMtx fMtx;
+	bool fExited;
+	};
+
+CountedBiased::Owner CountedBiased::sNoOwner;
+
+// Tears down the thread's Owner as the thread exits.
+class CountedBiased::Owner::Reaper
+	{
+public:
+	~Reaper()
+		{ spCurrentOwner()->pExit(); }
+	};
+
+CountedBiased::Owner* CountedBiased::Owner::sEnsureCurrent()
+	{
+	Owner*& theOwner = spCurrentOwner();
+	if (theOwner == &sNoOwner)
+		{
+		static thread_local Reaper spReaper;
+		(void)spReaper;
+		theOwner = new Owner;
+		}
+	return theOwner;
+	}
+
+void CountedBiased::Owner::Push(CountedBiased* iCountedBiased)
+	{
+	CountedBiased* theMerged = nullptr;
+	bool deleteThis = false;
+	{
+	ZAcqMtx acq(fMtx);
+	if (not fExited)
+		{
+		CountedBiased* theHead = fQueued.load();
+		do	{
+			iCountedBiased->fNextQueued = theHead;
+			} while (not fQueued.compare_exchange_weak(theHead, iCountedBiased));
+		return;
+		}
+
+	// Our thread has gone, so nothing else will fold iCountedBiased in. fMtx keeps us from
+	// racing other releasing threads over fOwnerCount.
+	if (iCountedBiased->pFold())
+		{
+		iCountedBiased->fNextQueued = nullptr;
+		theMerged = iCountedBiased;
+		}
+	deleteThis = fBiasedCount == 0;
+	}
+
+	// Nothing refers to us any longer, and the final releases may well touch other Owners, so
+	// do them with fMtx released.
+	if (deleteThis)
+		delete this;
+	spReleaseMerged(theMerged);
+	}
+
+void CountedBiased::Owner::Drain()
+	{
+	if (not fQueued.load(std::memory_order_relaxed))
+		return;
+
+	spReleaseMerged(this->pFoldQueued());
+	}
+
+void CountedBiased::Owner::pExit()
+	{
+	spCurrentOwner() = &sNoOwner;
+
+	CountedBiased* theMerged;
+	bool deleteThis;
+	{
+	ZAcqMtx acq(fMtx);
+	fExited = true;
+	theMerged = this->pFoldQueued();
+	deleteThis = fBiasedCount == 0;
+	}
+
+	// If objects are still biased towards us, the thread that merges the last of them deletes us.
+	if (deleteThis)
+		delete this;
+	spReleaseMerged(theMerged);
+	}
+
+// Folds in everything queued, returning those objects that merged as a list linked by
+// fNextQueued, for the caller to release.
+CountedBiased* CountedBiased::Owner::pFoldQueued()
+	{
+	CountedBiased* theMerged = nullptr;
+	// An object folded in may be requeued straight away, so grab fNextQueued first.
+	for (CountedBiased* theCB = fQueued.exchange(nullptr); theCB; /*no inc*/)
+		{
+		CountedBiased* theNext = theCB->fNextQueued;
+		if (theCB->pFold())
+			{
+			theCB->fNextQueued = theMerged;
+			theMerged = theCB;
+			}
+		theCB = theNext;
+		}
+	return theMerged;
+	}
+
+void CountedBiased::Owner::spReleaseMerged(CountedBiased* iMerged)
+	{
+	while (iMerged)
+		{
+		CountedBiased* theNext = iMerged->fNextQueued;
+		iMerged->CountedBase::Release();
+		iMerged = theNext;
+		}
+	}
+
+// =================================================================================================
+#pragma mark - CountedBiased
+
+CountedBiased::CountedBiased()
+:	fOwner(nullptr)
+,	fOwnerCount(0)
+,	fNextQueued(nullptr)
+	{}
+
+CountedBiased::~CountedBiased()
+	{ ZAssertStop(1, not fOwner.load()); }
+
+void CountedBiased::sMergeQueued()
+	{ spCurrentOwner()->Drain(); }
+
+void CountedBiased::pRelease_Biased()
+	{
+	// A release by a thread other than our owner, or by our owner of a reference it didn't count.
+	for (int oldRefCount = sAtomic_Get(&fRefCount); /*no test*/; /*no inc*/)
+		{
+		if (not (oldRefCount & kBiased))
+			{
+			// We've been merged.
+			CountedBase::Release();
+			return;
+			}
+
+		// If the count goes negative we're releasing a reference our owner counted, so it
+		// has to fold us in.
+		int newRefCount = oldRefCount - 1;
+		const bool needsQueueing = not (oldRefCount & kQueued) && spShared(newRefCount) < 0;
+		if (needsQueueing)
+			newRefCount |= kQueued;
+
+		if (fRefCount.compare_exchange_weak(oldRefCount, newRefCount))
+			{
+			if (needsQueueing)
+				fOwner.load()->Push(this);
+			return;
+			}
+		}
+	}
+
+bool CountedBiased::pIsShared_Biased() const
+	{
+	// Only our owner can see fOwnerCount, anyone else has to assume the worst.
+	if (fOwner.load(std::memory_order_relaxed) != spCurrentOwner())
+		return true;
+	return fOwnerCount + spShared(sAtomic_Get(&fRefCount)) > 1;
+	}
+
+void CountedBiased::pRetain_Slow()
+	{
+	if (sAtomic_Get(&fRefCount) != 0)
+		{
+		// Our owner is another thread (or we've been merged), and a plain increment works
+		// for either representation.
+		sAtomic_Add(&fRefCount, 1);
+		return;
+		}
+
+	CountedBase::Retain();
+
+	Owner* theOwner = Owner::sEnsureCurrent();
+
+	// Unless Initialize took references of its own, ours is the only one and we can bias towards
+	// this thread without anyone else noticing.
+	if (sAtomic_CAS(&fRefCount, 1, kBiased | kSharedZero))
+		{
+		fOwnerCount = 1;
+		++theOwner->fBiasedCount;
+		fOwner = theOwner;
+		}
+
+	theOwner->Drain();
+	}
+
+void CountedBiased::pRelease_Slow()
+	{
+	Owner* theOwner = spCurrentOwner();
+	if (fOwner.load(std::memory_order_relaxed) == theOwner && fOwnerCount == 1)
+		{
+		fOwnerCount = 0;
+		if (this->pMerge())
+			CountedBase::Release();
+		theOwner->Drain();
+		}
+	else
+		{
+		this->pRelease_Biased();
+		}
+	}
+
+// Returns true if we merged, in which case the caller must CountedBase::Release us.
+bool CountedBiased::pFold()
+	{
+	int theShared;
+	for (int oldRefCount = sAtomic_Get(&fRefCount); /*no test*/; /*no inc*/)
+		{
+		theShared = spShared(oldRefCount);
+		if (fRefCount.compare_exchange_weak(oldRefCount, kBiased | kSharedZero))
+			break;
+		}
+
+	// What we took plus what others hold is never negative, so neither is the sum.
+	fOwnerCount += theShared;
+	return fOwnerCount == 0 && this->pMerge();
+	}
+
+// Returns true if we merged, in which case the caller must CountedBase::Release us.
+bool CountedBiased::pMerge()
+	{
+	// Our owner holds no references, so the count is what other threads hold. Convert it to
+	// an ordinary count, plus one that our caller then Releases so as to get the usual
+	// finalization.
+	for (int oldRefCount = sAtomic_Get(&fRefCount); /*no test*/; /*no inc*/)
+		{
+		if (oldRefCount & kQueued)
+			{
+			// Releases by other threads are yet to be folded in, which will call us again.
+			return false;
+			}
+
+		if (fRefCount.compare_exchange_weak(oldRefCount, spShared(oldRefCount) + 1))
+			break;
+		}
+
+	--fOwner.load()->fBiasedCount;
+	fOwner = nullptr;
+	return true;
+	}
+
 // =================================================================================================
 #pragma mark - CountedBase::WPProxy
 
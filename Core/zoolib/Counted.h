@@ -58,8 +58,13 @@ protected:
 	int pCOMRelease();
 
 private:
+	// Set in fRefCount by CountedBiased whilst an object is biased to a thread.
+	static const int kBiased = 1 << 30;
+
 	ZAtomic_t fRefCount;
 	ZP<WPProxy> fWPProxy;
+
+	friend class CountedBiased;
 	};
 
 // =================================================================================================
@@ -80,6 +85,80 @@ inline void sCheck(CountedBase* iP)
 class Counted : public virtual CountedBase
 	{};
 
+// =================================================================================================
+#pragma mark - CountedBiased
+
+// Biased reference counting, after Choi, Shull and Torrellas, "Biased Reference Counting", 2018.
+// The thread that first retains a CountedBiased becomes its owner, and its retains and releases
+// are plain increments and decrements of fOwnerCount. Other threads use fRefCount atomically, and
+// their count can go negative when they release references the owner took. The owner folds such
+// objects back in when it next takes its slow path, or when it calls sMergeQueued. When fOwnerCount
+// reaches zero the object reverts to being an ordinary CountedBase.
+//
+// Derive from CountedBiased (as well as from Counted, if need be) when instances are mostly used
+// by a single thread. References can still be passed between threads, but every release by a
+// thread other than the owner takes the slow path, so classes whose instances are routinely
+// handed off to another thread to be discarded should not opt in. When the owner exits, objects
+// still biased towards it are folded in by whichever threads release them.
+
+class CountedBiased
+:	public virtual CountedBase
+	{
+public:
+	CountedBiased();
+	virtual ~CountedBiased();
+
+	void Retain()
+		{
+		if (fOwner.load(std::memory_order_relaxed) == spCurrentOwner())
+			++fOwnerCount;
+		else
+			this->pRetain_Slow();
+		}
+
+	void Release()
+		{
+		if (fOwner.load(std::memory_order_relaxed) == spCurrentOwner() && fOwnerCount > 1)
+			--fOwnerCount;
+		else
+			this->pRelease_Slow();
+		}
+
+	// Fold in releases made by other threads of references that this thread took.
+	static void sMergeQueued();
+
+private:
+	void pRelease_Biased();
+	bool pIsShared_Biased() const;
+
+	void pRetain_Slow();
+	void pRelease_Slow();
+	bool pFold();
+	bool pMerge();
+
+	class Owner;
+
+	// Threads that have never owned anything see sNoOwner, which no object has as its fOwner.
+	static Owner sNoOwner;
+	static Owner*& spCurrentOwner()
+		{
+		static thread_local Owner* spOwner = &sNoOwner;
+		return spOwner;
+		}
+
+	std::atomic<Owner*> fOwner;
+	int fOwnerCount;
+	CountedBiased* fNextQueued;
+
+	friend class CountedBase;
+	};
+
+inline void sRetain(CountedBiased& iObject)
+	{ iObject.Retain(); }
+
+inline void sRelease(CountedBiased& iObject)
+	{ iObject.Release(); }
+
 // =================================================================================================
 #pragma mark - CountedBase::WPProxy
 
@@ -196,11 +196,22 @@ by using <code>\#pragma ushort_wchar_t on</code>
 #include "zoolib/ZDebug.h"
 
 #include <ctype.h>
+#include <string.h> // For memcpy
 
 #if ZCONFIG_SPI_Enabled(ICU)
 	#include "unicode/uchar.h"
 #endif
 
+// With GCC or Clang on x86 we can compile SSE2 and AVX2 code regardless of the flags the
+// rest of the file is built with, and choose between them at runtime.
+#if (ZCONFIG(Compiler, GCC) || ZCONFIG(Compiler, Clang)) \
+	&& (ZCONFIG(Processor, x86) || ZCONFIG(Processor, x86_64))
+	#define ZCONFIG_Unicode_x86_SIMD 1
+	#include <immintrin.h>
+#else
+	#define ZCONFIG_Unicode_x86_SIMD 0
+#endif
+
 // =================================================================================================
 
 namespace ZooLib {
@@ -403,6 +414,140 @@ template struct Functions_Convert_T<string32::iterator>;
 template struct Functions_Convert_T<string16::iterator>;
 template struct Functions_Convert_T<string8::iterator>;
 
+// =================================================================================================
+#pragma mark - Copying runs of ASCII
+
+// Text is very often mostly ASCII, and a run of ASCII bytes can be copied into code units of
+// any width without decoding. spCopyASCII copies the leading run of ASCII in iSource, up to
+// iCount bytes, and returns its length. On x86 we find and widen 16 bytes at a time with SSE2,
+// or 32 at a time with AVX2 if the processor has it. Otherwise, and for the tail of a run,
+// we check 8 bytes at a time.
+
+namespace { // anonymous
+
+template <class D>
+size_t spCopyASCII_Scalar(const UTF8* iSource, size_t iCount, D* oDest)
+	{
+	size_t xx = 0;
+	for (/*no init*/; xx + 8 <= iCount; xx += 8)
+		{
+		uint64 theWord;
+		memcpy(&theWord, iSource + xx, 8);
+		if (theWord & 0x8080808080808080ULL)
+			break;
+		for (size_t yy = xx; yy < xx + 8; ++yy)
+			oDest[yy] = uint8(iSource[yy]);
+		}
+
+	while (xx < iCount && uint8(iSource[xx]) < 0x80)
+		{
+		oDest[xx] = uint8(iSource[xx]);
+		++xx;
+		}
+	return xx;
+	}
+
+#if ZCONFIG_Unicode_x86_SIMD
+
+__attribute__((target("sse2")))
+inline void spStore16_SSE2(__m128i iBytes, UTF32* oDest)
+	{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lo = _mm_unpacklo_epi8(iBytes, zero);
+	const __m128i hi = _mm_unpackhi_epi8(iBytes, zero);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(oDest), _mm_unpacklo_epi16(lo, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(oDest + 4), _mm_unpackhi_epi16(lo, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(oDest + 8), _mm_unpacklo_epi16(hi, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(oDest + 12), _mm_unpackhi_epi16(hi, zero));
+	}
+
+__attribute__((target("sse2")))
+inline void spStore16_SSE2(__m128i iBytes, UTF16* oDest)
+	{
+	const __m128i zero = _mm_setzero_si128();
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(oDest), _mm_unpacklo_epi8(iBytes, zero));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(oDest + 8), _mm_unpackhi_epi8(iBytes, zero));
+	}
+
+__attribute__((target("sse2")))
+inline void spStore16_SSE2(__m128i iBytes, UTF8* oDest)
+	{ _mm_storeu_si128(reinterpret_cast<__m128i*>(oDest), iBytes); }
+
+template <class D>
+__attribute__((target("sse2")))
+size_t spCopyASCII_SSE2(const UTF8* iSource, size_t iCount, D* oDest)
+	{
+	size_t xx = 0;
+	for (/*no init*/; xx + 16 <= iCount; xx += 16)
+		{
+		const __m128i theBytes =
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(iSource + xx));
+		if (_mm_movemask_epi8(theBytes))
+			break;
+		spStore16_SSE2(theBytes, oDest + xx);
+		}
+	return xx + spCopyASCII_Scalar(iSource + xx, iCount - xx, oDest + xx);
+	}
+
+__attribute__((target("avx2")))
+inline void spStore32_AVX2(const UTF8* iSource, __m256i, UTF32* oDest)
+	{
+	for (size_t xx = 0; xx < 32; xx += 8)
+		{
+		const __m128i theBytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(iSource + xx));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(oDest + xx), _mm256_cvtepu8_epi32(theBytes));
+		}
+	}
+
+__attribute__((target("avx2")))
+inline void spStore32_AVX2(const UTF8*, __m256i iBytes, UTF16* oDest)
+	{
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(oDest),
+		_mm256_cvtepu8_epi16(_mm256_castsi256_si128(iBytes)));
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(oDest + 16),
+		_mm256_cvtepu8_epi16(_mm256_extracti128_si256(iBytes, 1)));
+	}
+
+__attribute__((target("avx2")))
+inline void spStore32_AVX2(const UTF8*, __m256i iBytes, UTF8* oDest)
+	{ _mm256_storeu_si256(reinterpret_cast<__m256i*>(oDest), iBytes); }
+
+template <class D>
+__attribute__((target("avx2")))
+size_t spCopyASCII_AVX2(const UTF8* iSource, size_t iCount, D* oDest)
+	{
+	size_t xx = 0;
+	for (/*no init*/; xx + 32 <= iCount; xx += 32)
+		{
+		const __m256i theBytes =
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(iSource + xx));
+		if (_mm256_movemask_epi8(theBytes))
+			break;
+		spStore32_AVX2(iSource + xx, theBytes, oDest + xx);
+		}
+	return xx + spCopyASCII_SSE2(iSource + xx, iCount - xx, oDest + xx);
+	}
+
+// If we're called before these are initialized we just use the scalar code.
+const bool spHasSSE2 = (__builtin_cpu_init(), __builtin_cpu_supports("sse2"));
+const bool spHasAVX2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+
+#endif // ZCONFIG_Unicode_x86_SIMD
+
+template <class D>
+size_t spCopyASCII(const UTF8* iSource, size_t iCount, D* oDest)
+	{
+	#if ZCONFIG_Unicode_x86_SIMD
+		if (spHasAVX2)
+			return spCopyASCII_AVX2(iSource, iCount, oDest);
+		if (spHasSSE2)
+			return spCopyASCII_SSE2(iSource, iCount, oDest);
+	#endif
+	return spCopyASCII_Scalar(iSource, iCount, oDest);
+	}
+
+} // anonymous namespace
+
 // =================================================================================================
 #pragma mark - Converting between different serializations, template functions
 
@@ -496,6 +641,73 @@ bool spConvert_T(
 		iSourceCU, nullptr);
 	}
 
+// The same as spConvert_T, but with a UTF-8 source, any run of ASCII is copied en masse.
+template <class D>
+bool spConvert_UTF8_T(
+	const UTF8* iSource, size_t iSourceCU,
+	size_t* oSourceCU, size_t* oSourceCUSkipped,
+	D* oDest, size_t iDestCU,
+	size_t* oDestCU,
+	size_t iMaxCP, size_t* oCountCP)
+	{
+	const UTF8* localSource = iSource;
+	const UTF8* localSourceEnd = iSource + iSourceCU;
+
+	D* localDest = oDest;
+	D* localDestEnd = oDest + iDestCU;
+
+	size_t localCP = iMaxCP;
+	bool sourceComplete = true;
+
+	size_t localSkipped = 0;
+	while (localSource < localSourceEnd && localDest < localDestEnd && localCP)
+		{
+		if (uint8(*localSource) < 0x80)
+			{
+			size_t theCount = localSourceEnd - localSource;
+			if (theCount > size_t(localDestEnd - localDest))
+				theCount = localDestEnd - localDest;
+			if (theCount > localCP)
+				theCount = localCP;
+
+			theCount = spCopyASCII(localSource, theCount, localDest);
+			localSource += theCount;
+			localDest += theCount;
+			localCP -= theCount;
+			continue;
+			}
+
+		const UTF8* priorLocalSource = localSource;
+		UTF32 theCP;
+		size_t cuSkipped = 0;
+		if (not sReadInc(localSource, localSourceEnd, theCP, cuSkipped))
+			{
+			if (localSource < localSourceEnd)
+				sourceComplete = false;
+			break;
+			}
+
+		if (not sWriteInc(localDest, localDestEnd, theCP))
+			{
+			localSource = priorLocalSource;
+			break;
+			}
+		--localCP;
+		localSkipped += cuSkipped;
+		}
+
+	if (oSourceCU)
+		*oSourceCU = localSource - iSource;
+	if (oSourceCUSkipped)
+		*oSourceCUSkipped = localSkipped;
+	if (oDestCU)
+		*oDestCU = localDest - oDest;
+	if (oCountCP)
+		*oCountCP = iMaxCP - localCP;
+
+	return sourceComplete;
+	}
+
 } // anonymous namespace
 
 // =================================================================================================
@@ -593,11 +805,12 @@ bool sUTF8ToUTF32(
 	UTF32* oDest, size_t iDestCount,
 	size_t* oDestCount)
 	{
-	return spConvert_T(
+	return spConvert_UTF8_T(
 		iSource, iSourceCU,
 		oSourceCU, oSourceCUSkipped,
 		oDest, iDestCount,
-		oDestCount);
+		oDestCount,
+		iSourceCU, nullptr);
 	}
 
 bool sUTF8ToUTF16(
@@ -607,7 +820,7 @@ bool sUTF8ToUTF16(
 	size_t* oDestCU,
 	size_t iMaxCP, size_t* oCountCP)
 	{
-	return spConvert_T(
+	return spConvert_UTF8_T(
 		iSource, iSourceCU,
 		oSourceCU, oSourceCUSkipped,
 		oDest, iDestCU,
@@ -622,7 +835,7 @@ bool sUTF8ToUTF8(
 	size_t* oDestCU,
 	size_t iMaxCP, size_t* oCountCP)
 	{
-	return spConvert_T(
+	return spConvert_UTF8_T(
 		iSource, iSourceCU,
 		oSourceCU, oSourceCUSkipped,
 		oDest, iDestCU,
@@ -0,0 +1,1334 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#include "zoolib/POSIX/AsyncIO_POSIX.h"
+
+#if ZCONFIG_SPI_Enabled(POSIX)
+
+#include "zoolib/Callable_Bind.h"
+#include "zoolib/ZThread.h"
+
+#include "zoolib/POSIX/Util_POSIXFD.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdexcept> // For runtime_error
+#include <string.h> // For memcpy
+#include <unistd.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if ZCONFIG_AsyncIO_UseIOURing
+	#include <linux/io_uring.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	// We need poll32_events, which arrived alongside IORING_FEAT_POLL_32BITS, and the
+	// syscall numbers, which older libcs don't define.
+	#if not defined(IORING_FEAT_POLL_32BITS) || not defined(__NR_io_uring_setup)
+		#undef ZCONFIG_AsyncIO_UseIOURing
+		#define ZCONFIG_AsyncIO_UseIOURing 0
+	#endif
+#endif
+
+#if ZCONFIG_AsyncIO_UseEPoll
+	#include <sys/epoll.h>
+	#include <sys/eventfd.h>
+#endif
+
+// MacOS X has no MSG_NOSIGNAL, it relies on SO_NOSIGPIPE having been set on the socket,
+// as NetEndpoint_Socket does.
+#ifndef MSG_NOSIGNAL
+	#define MSG_NOSIGNAL 0
+#endif
+
+namespace ZooLib {
+
+using std::pair;
+using std::runtime_error;
+using std::unordered_map;
+using std::unordered_set;
+using std::vector;
+
+typedef AsyncIO_POSIX::Callable_Completion Callable_Completion;
+
+// =================================================================================================
+#pragma mark - Helpers (anonymous)
+
+namespace { // anonymous
+
+enum EOp { eOp_Read, eOp_Write, eOp_Accept, eOp_Connect };
+
+struct Op
+	{
+	Op(EOp iOp, int iFD, const ZP<Callable_Completion>& iCompletion, bool iCallDirectly)
+	:	fOp(iOp)
+	,	fFD(iFD)
+	,	fAddress(nullptr)
+	,	fCount(0)
+	,	fSockAddrLen(0)
+	,	fCallDirectly(iCallDirectly)
+	,	fIsSocket(true)
+	,	fWaiting(false)
+	,	fCompletion(iCompletion)
+		{}
+
+	const EOp fOp;
+	const int fFD;
+
+	// Read and Write.
+	byte* fAddress;
+	size_t fCount;
+
+	// Connect.
+	sockaddr_storage fSockAddr;
+	socklen_t fSockAddrLen;
+
+	const bool fCallDirectly;
+
+	// Cleared when a Write finds its fd is not a socket, after which we use write, not send.
+	bool fIsSocket;
+
+	// Set while waiting for the fd to become ready, or for a connect to be established.
+	bool fWaiting;
+
+	const ZP<Callable_Completion> fCompletion;
+	};
+
+Op* spNewOp_Connect(int iFD, const sockaddr* iAddr, socklen_t iAddrLen,
+	const ZP<Callable_Completion>& iCompletion, bool iCallDirectly)
+	{
+	Op* theOp = new Op(eOp_Connect, iFD, iCompletion, iCallDirectly);
+	theOp->fSockAddrLen = std::min<socklen_t>(iAddrLen, sizeof(theOp->fSockAddr));
+	::memcpy(&theOp->fSockAddr, iAddr, theOp->fSockAddrLen);
+	return theOp;
+	}
+
+bool spWantsReadable(const Op* iOp)
+	{ return iOp->fOp == eOp_Read || iOp->fOp == eOp_Accept; }
+
+// Consumes iOp.
+void spComplete(const ZP<Starter>& iStarter, Op* iOp, ssize_t iResult)
+	{
+	const ZP<Callable_Completion> theCompletion = iOp->fCompletion;
+	const bool callDirectly = iOp->fCallDirectly;
+	delete iOp;
+
+	if (not theCompletion)
+		return;
+
+	if (callDirectly || not sQStart(iStarter, sBindR(theCompletion, iResult)))
+		{
+		try { theCompletion->QCall(iResult); }
+		catch (...) {}
+		}
+	}
+
+ssize_t spConnectResult(int iFD)
+	{
+	int err = 0;
+	socklen_t theLength = sizeof(err);
+	if (0 > ::getsockopt(iFD, SOL_SOCKET, SO_ERROR, &err, &theLength))
+		err = errno;
+	return -err;
+	}
+
+// Returns false if iOp would block.
+bool spAttempt(Op* iOp, ssize_t& oResult)
+	{
+	for (;;)
+		{
+		ssize_t result = -1;
+		switch (iOp->fOp)
+			{
+			case eOp_Read:
+				{
+				result = ::read(iOp->fFD, iOp->fAddress, iOp->fCount);
+				break;
+				}
+			case eOp_Write:
+				{
+				if (iOp->fIsSocket)
+					{
+					result = ::send(iOp->fFD, iOp->fAddress, iOp->fCount, MSG_NOSIGNAL);
+					if (result < 0 && errno == ENOTSOCK)
+						{
+						iOp->fIsSocket = false;
+						continue;
+						}
+					}
+				else
+					{
+					result = ::write(iOp->fFD, iOp->fAddress, iOp->fCount);
+					}
+				break;
+				}
+			case eOp_Accept:
+				{
+				result = ::accept(iOp->fFD, nullptr, nullptr);
+				break;
+				}
+			case eOp_Connect:
+				{
+				if (iOp->fWaiting)
+					{
+					// The socket is writable, so the connect has finished one way or another.
+					oResult = spConnectResult(iOp->fFD);
+					return true;
+					}
+
+				result = ::connect(iOp->fFD,
+					reinterpret_cast<const sockaddr*>(&iOp->fSockAddr), iOp->fSockAddrLen);
+
+				if (result < 0 && errno == EINPROGRESS)
+					{
+					iOp->fWaiting = true;
+					return false;
+					}
+				break;
+				}
+			}
+
+		if (result >= 0)
+			{
+			oResult = result;
+			return true;
+			}
+
+		const int err = errno;
+		if (err == EAGAIN || err == EWOULDBLOCK)
+			return false;
+
+		if (err != EINTR)
+			{
+			oResult = -err;
+			return true;
+			}
+		}
+	}
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - AsyncIO_Readiness
+
+namespace { // anonymous
+
+class AsyncIO_Readiness
+:	public AsyncIO_POSIX
+	{
+public:
+	AsyncIO_Readiness(const ZP<Starter>& iStarter);
+	virtual ~AsyncIO_Readiness();
+
+// From Counted via AsyncIO_POSIX
+	virtual void Finalize();
+
+// From AsyncIO_POSIX
+	virtual void Read(int iFD, byte* oDest, size_t iCount,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly);
+
+	virtual void Write(int iFD, const byte* iSource, size_t iCount,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly);
+
+	virtual void Accept(int iListenFD,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly);
+
+	virtual void Connect(int iFD, const sockaddr* iAddr, socklen_t iAddrLen,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly);
+
+private:
+	struct FDState
+		{
+		vector<Op*> fReaders;
+		vector<Op*> fWriters;
+		};
+
+	struct Ready
+		{
+		int fFD;
+		bool fReadable;
+		bool fWritable;
+		};
+
+	void pStart(Op* iOp);
+
+	bool pArm_Locked(int iFD, const FDState& iFDState);
+	void pWake();
+	void pWait(vector<Ready>& oReady);
+
+	void pRun();
+	static void spRun(AsyncIO_Readiness* iAsyncIO);
+
+	ZMtx fMtx;
+	const ZP<Starter> fStarter;
+	unordered_map<int,FDState> fMap;
+	bool fShutdown;
+
+	// Ops that finished when pStart first attempted them, whose completions pRun calls.
+	vector<pair<Op*,ssize_t>> fPosted;
+
+	#if ZCONFIG_AsyncIO_UseEPoll
+		int fEPollFD;
+		int fEventFD;
+	#else
+		int fWakePipe[2];
+	#endif
+	};
+
+AsyncIO_Readiness::AsyncIO_Readiness(const ZP<Starter>& iStarter)
+:	fStarter(iStarter)
+,	fShutdown(false)
+	{
+	#if ZCONFIG_AsyncIO_UseEPoll
+		fEPollFD = ::epoll_create1(EPOLL_CLOEXEC);
+		if (fEPollFD < 0)
+			throw runtime_error("AsyncIO_Readiness, epoll_create1 failed");
+
+		fEventFD = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (fEventFD < 0)
+			{
+			::close(fEPollFD);
+			throw runtime_error("AsyncIO_Readiness, eventfd failed");
+			}
+
+		struct epoll_event theEvent = {};
+		theEvent.events = EPOLLIN;
+		theEvent.data.fd = fEventFD;
+		if (0 != ::epoll_ctl(fEPollFD, EPOLL_CTL_ADD, fEventFD, &theEvent))
+			{
+			::close(fEventFD);
+			::close(fEPollFD);
+			throw runtime_error("AsyncIO_Readiness, epoll_ctl failed");
+			}
+	#else
+		if (0 != ::pipe(fWakePipe))
+			throw runtime_error("AsyncIO_Readiness, pipe failed");
+		Util_POSIXFD::sSetNonBlocking(fWakePipe[0]);
+		Util_POSIXFD::sSetNonBlocking(fWakePipe[1]);
+	#endif
+
+	ZThread::sStart_T<AsyncIO_Readiness*>(spRun, this);
+	}
+
+AsyncIO_Readiness::~AsyncIO_Readiness()
+	{
+	// We're deleted by spRun once pRun has exited, so there's no one else to contend with.
+	vector<pair<Op*,ssize_t>> toComplete;
+	toComplete.swap(fPosted);
+	for (unordered_map<int,FDState>::iterator iter = fMap.begin(); iter != fMap.end(); ++iter)
+		{
+		const vector<Op*>& theReaders = iter->second.fReaders;
+		for (vector<Op*>::const_iterator iterOp = theReaders.begin();
+			iterOp != theReaders.end(); ++iterOp)
+			{ toComplete.push_back(pair<Op*,ssize_t>(*iterOp, -ECANCELED)); }
+
+		const vector<Op*>& theWriters = iter->second.fWriters;
+		for (vector<Op*>::const_iterator iterOp = theWriters.begin();
+			iterOp != theWriters.end(); ++iterOp)
+			{ toComplete.push_back(pair<Op*,ssize_t>(*iterOp, -ECANCELED)); }
+		}
+	fMap.clear();
+
+	#if ZCONFIG_AsyncIO_UseEPoll
+		::close(fEventFD);
+		::close(fEPollFD);
+	#else
+		::close(fWakePipe[0]);
+		::close(fWakePipe[1]);
+	#endif
+
+	for (vector<pair<Op*,ssize_t>>::iterator iter = toComplete.begin();
+		iter != toComplete.end(); ++iter)
+		{ spComplete(fStarter, iter->first, iter->second); }
+	}
+
+void AsyncIO_Readiness::Finalize()
+	{
+	ZAcqMtx acq(fMtx);
+	if (not this->FinishFinalize())
+		return;
+
+	// Rather than waiting for our thread to exit we let it delete us, as Starter_ThreadLoop
+	// does. So the last reference can safely be dropped by a completion running on that thread.
+	fShutdown = true;
+	this->pWake();
+	}
+
+void AsyncIO_Readiness::Read(int iFD, byte* oDest, size_t iCount,
+	const ZP<Callable_Completion>& iCompletion, bool iCallDirectly)
+	{
+	Op* theOp = new Op(eOp_Read, iFD, iCompletion, iCallDirectly);
+	theOp->fAddress = oDest;
+	theOp->fCount = iCount;
+	this->pStart(theOp);
+	}
+
+void AsyncIO_Readiness::Write(int iFD, const byte* iSource, size_t iCount,
+	const ZP<Callable_Completion>& iCompletion, bool iCallDirectly)
+	{
+	Op* theOp = new Op(eOp_Write, iFD, iCompletion, iCallDirectly);
+	theOp->fAddress = const_cast<byte*>(iSource);
+	theOp->fCount = iCount;
+	this->pStart(theOp);
+	}
+
+void AsyncIO_Readiness::Accept(int iListenFD,
+	const ZP<Callable_Completion>& iCompletion, bool iCallDirectly)
+	{ this->pStart(new Op(eOp_Accept, iListenFD, iCompletion, iCallDirectly)); }
+
+void AsyncIO_Readiness::Connect(int iFD, const sockaddr* iAddr, socklen_t iAddrLen,
+	const ZP<Callable_Completion>& iCompletion, bool iCallDirectly)
+	{ this->pStart(spNewOp_Connect(iFD, iAddr, iAddrLen, iCompletion, iCallDirectly)); }
+
+void AsyncIO_Readiness::pStart(Op* iOp)
+	{
+	ssize_t result;
+	const bool finished = spAttempt(iOp, result);
+
+	ZAcqMtx acq(fMtx);
+	if (fShutdown)
+		{
+		ZRelMtx rel(fMtx);
+		spComplete(fStarter, iOp, finished ? result : -ECANCELED);
+		return;
+		}
+
+	if (not finished)
+		{
+		FDState& theFDState = fMap[iOp->fFD];
+		vector<Op*>& theOps = spWantsReadable(iOp) ? theFDState.fReaders : theFDState.fWriters;
+		theOps.push_back(iOp);
+		if (this->pArm_Locked(iOp->fFD, theFDState))
+			return;
+
+		result = -errno;
+		theOps.pop_back();
+		if (theFDState.fReaders.empty() && theFDState.fWriters.empty())
+			fMap.erase(iOp->fFD);
+		}
+
+	// Even an op that's already finished is completed from our thread, never from within
+	// the call that initiated it. So a completion that starts another op can't recurse.
+	fPosted.push_back(pair<Op*,ssize_t>(iOp, result));
+	if (fPosted.size() == 1)
+		this->pWake();
+	}
+
+#if ZCONFIG_AsyncIO_UseEPoll
+
+bool AsyncIO_Readiness::pArm_Locked(int iFD, const FDState& iFDState)
+	{
+	// As in SocketWatcher, registrations persist, disarmed by EPOLLONESHOT when they fire.
+	// Level-triggered, so readiness that arrived before we (re)armed is not lost.
+	struct epoll_event theEvent = {};
+	theEvent.events = EPOLLONESHOT;
+	if (not iFDState.fReaders.empty())
+		theEvent.events |= EPOLLIN | EPOLLRDHUP;
+	if (not iFDState.fWriters.empty())
+		theEvent.events |= EPOLLOUT;
+	theEvent.data.fd = iFD;
+
+	if (0 == ::epoll_ctl(fEPollFD, EPOLL_CTL_MOD, iFD, &theEvent))
+		return true;
+
+	if (errno == ENOENT && 0 == ::epoll_ctl(fEPollFD, EPOLL_CTL_ADD, iFD, &theEvent))
+		return true;
+
+	return false;
+	}
+
+void AsyncIO_Readiness::pWake()
+	{
+	const uint64_t theOne = 1;
+	::write(fEventFD, &theOne, sizeof(theOne));
+	}
+
+void AsyncIO_Readiness::pWait(vector<Ready>& oReady)
+	{
+	const int kMaxEvents = 64;
+	struct epoll_event theEvents[kMaxEvents];
+	const int count = ::epoll_wait(fEPollFD, theEvents, kMaxEvents, -1);
+	for (int xx = 0; xx < count; ++xx)
+		{
+		const int theFD = theEvents[xx].data.fd;
+		if (theFD == fEventFD)
+			{
+			uint64_t theCount;
+			::read(fEventFD, &theCount, sizeof(theCount));
+			continue;
+			}
+
+		const uint32_t theFlags = theEvents[xx].events;
+		const bool hasError = theFlags & (EPOLLERR | EPOLLHUP);
+		Ready theReady;
+		theReady.fFD = theFD;
+		theReady.fReadable = hasError || (theFlags & (EPOLLIN | EPOLLRDHUP));
+		theReady.fWritable = hasError || (theFlags & EPOLLOUT);
+		oReady.push_back(theReady);
+		}
+	}
+
+#else // ZCONFIG_AsyncIO_UseEPoll
+
+bool AsyncIO_Readiness::pArm_Locked(int iFD, const FDState& iFDState)
+	{
+	// pWait rebuilds its pollfd array from fMap, it just needs to be told to do so.
+	this->pWake();
+	return true;
+	}
+
+void AsyncIO_Readiness::pWake()
+	{
+	const byte theByte = 0;
+	::write(fWakePipe[1], &theByte, 1);
+	}
+
+void AsyncIO_Readiness::pWait(vector<Ready>& oReady)
+	{
+	vector<pollfd> thePollFDs;
+	{
+	ZAcqMtx acq(fMtx);
+	pollfd theWake = { fWakePipe[0], POLLIN, 0 };
+	thePollFDs.push_back(theWake);
+	for (unordered_map<int,FDState>::iterator iter = fMap.begin(); iter != fMap.end(); ++iter)
+		{
+		pollfd thePollFD = { iter->first, 0, 0 };
+		if (not iter->second.fReaders.empty())
+			thePollFD.events |= POLLIN;
+		if (not iter->second.fWriters.empty())
+			thePollFD.events |= POLLOUT;
+		if (thePollFD.events)
+			thePollFDs.push_back(thePollFD);
+		}
+	}
+
+	if (0 >= ::poll(&thePollFDs[0], thePollFDs.size(), -1))
+		return;
+
+	if (thePollFDs[0].revents)
+		{
+		byte buf[64];
+		while (0 < ::read(fWakePipe[0], buf, sizeof(buf)))
+			{}
+		}
+
+	for (size_t xx = 1; xx < thePollFDs.size(); ++xx)
+		{
+		const short theFlags = thePollFDs[xx].revents;
+		if (not theFlags)
+			continue;
+		const bool hasError = theFlags & (POLLERR | POLLHUP | POLLNVAL);
+		Ready theReady;
+		theReady.fFD = thePollFDs[xx].fd;
+		theReady.fReadable = hasError || (theFlags & POLLIN);
+		theReady.fWritable = hasError || (theFlags & POLLOUT);
+		oReady.push_back(theReady);
+		}
+	}
+
+#endif // ZCONFIG_AsyncIO_UseEPoll
+
+void AsyncIO_Readiness::pRun()
+	{
+	vector<Ready> theReady;
+	vector<pair<Op*,ssize_t>> toComplete;
+	vector<Op*> toAttempt;
+	for (;;)
+		{
+		theReady.clear();
+		this->pWait(theReady);
+
+		ZAcqMtx acq(fMtx);
+		if (fShutdown)
+			break;
+
+		// toComplete is empty here, so this just takes whatever pStart has posted.
+		toComplete.swap(fPosted);
+
+		for (vector<Ready>::iterator iter = theReady.begin(); iter != theReady.end(); ++iter)
+			{
+			const int theFD = iter->fFD;
+			unordered_map<int,FDState>::iterator iterMap = fMap.find(theFD);
+			if (iterMap == fMap.end())
+				continue;
+
+			// Take the ops that might now succeed, and attempt them without holding fMtx.
+			toAttempt.clear();
+			if (iter->fReadable)
+				toAttempt.swap(iterMap->second.fReaders);
+			if (iter->fWritable)
+				{
+				toAttempt.insert(toAttempt.end(),
+					iterMap->second.fWriters.begin(), iterMap->second.fWriters.end());
+				iterMap->second.fWriters.clear();
+				}
+
+			vector<Op*> stillBlocked;
+			{
+			ZRelMtx rel(fMtx);
+			for (vector<Op*>::iterator iterOp = toAttempt.begin();
+				iterOp != toAttempt.end(); ++iterOp)
+				{
+				ssize_t result;
+				if (spAttempt(*iterOp, result))
+					toComplete.push_back(pair<Op*,ssize_t>(*iterOp, result));
+				else
+					stillBlocked.push_back(*iterOp);
+				}
+			}
+
+			// fMap may have been changed while fMtx was released.
+			FDState& theFDState = fMap[theFD];
+			for (vector<Op*>::reverse_iterator iterOp = stillBlocked.rbegin();
+				iterOp != stillBlocked.rend(); ++iterOp)
+				{
+				vector<Op*>& theOps =
+					spWantsReadable(*iterOp) ? theFDState.fReaders : theFDState.fWriters;
+				theOps.insert(theOps.begin(), *iterOp);
+				}
+
+			if (theFDState.fReaders.empty() && theFDState.fWriters.empty())
+				{
+				fMap.erase(theFD);
+				}
+			else if (not this->pArm_Locked(theFD, theFDState))
+				{
+				const ssize_t result = -errno;
+				for (vector<Op*>::iterator iterOp = theFDState.fReaders.begin();
+					iterOp != theFDState.fReaders.end(); ++iterOp)
+					{ toComplete.push_back(pair<Op*,ssize_t>(*iterOp, result)); }
+				for (vector<Op*>::iterator iterOp = theFDState.fWriters.begin();
+					iterOp != theFDState.fWriters.end(); ++iterOp)
+					{ toComplete.push_back(pair<Op*,ssize_t>(*iterOp, result)); }
+				fMap.erase(theFD);
+				}
+			}
+
+		ZRelMtx rel(fMtx);
+		for (vector<pair<Op*,ssize_t>>::iterator iter = toComplete.begin();
+			iter != toComplete.end(); ++iter)
+			{ spComplete(fStarter, iter->first, iter->second); }
+		toComplete.clear();
+		}
+	}
+
+void AsyncIO_Readiness::spRun(AsyncIO_Readiness* iAsyncIO)
+	{
+	ZThread::sSetName("AsyncIO_Readiness");
+
+	iAsyncIO->pRun();
+	delete iAsyncIO;
+	}
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - AsyncIO_IOURing
+
+#if ZCONFIG_AsyncIO_UseIOURing
+
+namespace { // anonymous
+
+// The user_data of our cancellation timeouts. Ops' addresses are never this, and our
+// cancels and NOPs have zero user_data.
+const uint64 kUserData_Timeout = 1;
+
+// How long we give outstanding ops to respond to being cancelled.
+const __kernel_timespec spTimeout_Cancel = { 1, 0 };
+
+int spEnter(int iRingFD, unsigned iToSubmit, unsigned iMinComplete, unsigned iFlags)
+	{ return ::syscall(__NR_io_uring_enter, iRingFD, iToSubmit, iMinComplete, iFlags, nullptr, 0); }
+
+bool spSupportsOps(int iRingFD)
+	{
+	const size_t kOpCount = 256;
+	vector<byte> theBuffer(sizeof(io_uring_probe) + kOpCount * sizeof(io_uring_probe_op));
+	io_uring_probe* theProbe = reinterpret_cast<io_uring_probe*>(&theBuffer[0]);
+	if (0 > ::syscall(__NR_io_uring_register, iRingFD, IORING_REGISTER_PROBE, theProbe, kOpCount))
+		return false;
+
+	const int theOps[] =
+		{
+		IORING_OP_NOP, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_SEND,
+		IORING_OP_ACCEPT, IORING_OP_CONNECT, IORING_OP_POLL_ADD, IORING_OP_ASYNC_CANCEL,
+		IORING_OP_TIMEOUT
+		};
+
+	for (size_t xx = 0; xx < countof(theOps); ++xx)
+		{
+		const int theOp = theOps[xx];
+		if (theOp > theProbe->last_op)
+			return false;
+		if (not (theProbe->ops[theOp].flags & IO_URING_OP_SUPPORTED))
+			return false;
+		}
+	return true;
+	}
+
+class AsyncIO_IOURing
+:	public AsyncIO_POSIX
+	{
+public:
+	AsyncIO_IOURing(const ZP<Starter>& iStarter);
+	virtual ~AsyncIO_IOURing();
+
+	bool Initialize(size_t iQueueDepth);
+
+// From Counted via AsyncIO_POSIX
+	virtual void Finalize();
+
+// From AsyncIO_POSIX
+	virtual void Read(int iFD, byte* oDest, size_t iCount,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly);
+
+	virtual void Write(int iFD, const byte* iSource, size_t iCount,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly);
+
+	virtual void Accept(int iListenFD,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly);
+
+	virtual void Connect(int iFD, const sockaddr* iAddr, socklen_t iAddrLen,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly);
+
+private:
+	void pStart(Op* iOp);
+	void pComplete(Op* iOp, ssize_t iResult);
+	void pReaped(Op* iOp, int iResult);
+
+	void pCancel_Locked(bool iShutDownFDs);
+	void pSubmit_Locked(Op* iOp);
+	bool pPlace_Locked(const io_uring_sqe& iSQE);
+	void pPush_Locked(const io_uring_sqe& iSQE);
+	void pFlush_Locked();
+
+	void pRun();
+	static void spRun(AsyncIO_IOURing* iAsyncIO);
+
+	ZMtx fMtx;
+	ZCnd fCnd;
+	const ZP<Starter> fStarter;
+
+	int fRingFD;
+	void* fSQRing;
+	size_t fSQRingSize;
+	void* fCQRing;
+	size_t fCQRingSize;
+	io_uring_sqe* fSQEs;
+	size_t fSQEsSize;
+
+	unsigned* fSQHead;
+	unsigned* fSQTail;
+	unsigned fSQMask;
+	unsigned fSQEntries;
+	unsigned* fSQArray;
+
+	unsigned* fCQHead;
+	unsigned* fCQTail;
+	unsigned fCQMask;
+	io_uring_cqe* fCQEs;
+
+	// SQEs that are in the ring, but that the kernel has not yet been told about.
+	unsigned fUnsubmitted;
+	bool fFlushing;
+	// Set when the kernel refused SQEs because completions are backed up, cleared by the
+	// reaper once it's drained them.
+	bool fBacklogged;
+
+	// The reaper must never wait for room in the SQ, it's what makes room. SQEs it couldn't
+	// place are kept here till it has.
+	ZThread::ID fReaperID;
+	vector<io_uring_sqe> fDeferred;
+
+	bool fShutdown;
+	// Set once the reaper's been started, after which it's the reaper that deletes us.
+	bool fRunning;
+	unordered_set<Op*> fInFlight;
+	};
+
+AsyncIO_IOURing::AsyncIO_IOURing(const ZP<Starter>& iStarter)
+:	fStarter(iStarter)
+,	fRingFD(-1)
+,	fSQRing(MAP_FAILED)
+,	fSQRingSize(0)
+,	fCQRing(MAP_FAILED)
+,	fCQRingSize(0)
+,	fSQEs((io_uring_sqe*)MAP_FAILED)
+,	fSQEsSize(0)
+,	fUnsubmitted(0)
+,	fFlushing(false)
+,	fBacklogged(false)
+,	fReaperID(0)
+,	fShutdown(false)
+,	fRunning(false)
+	{}
+
+AsyncIO_IOURing::~AsyncIO_IOURing()
+	{
+	// We're deleted by Finalize if Initialize failed, otherwise by spRun once pRun has exited.
+	if (fSQEs != MAP_FAILED)
+		::munmap(fSQEs, fSQEsSize);
+	if (fCQRing != MAP_FAILED && fCQRing != fSQRing)
+		::munmap(fCQRing, fCQRingSize);
+	if (fSQRing != MAP_FAILED)
+		::munmap(fSQRing, fSQRingSize);
+	if (fRingFD >= 0)
+		::close(fRingFD);
+	}
+
+bool AsyncIO_IOURing::Initialize(size_t iQueueDepth)
+	{
+	io_uring_params theParams = {};
+	// Plenty of room for completions, so that the kernel rarely has to buffer them itself.
+	theParams.flags = IORING_SETUP_CQSIZE;
+	theParams.cq_entries = 4 * iQueueDepth;
+
+	fRingFD = ::syscall(__NR_io_uring_setup, iQueueDepth, &theParams);
+	if (fRingFD < 0)
+		return false;
+
+	// Without NODROP the kernel discards completions when the CQ is full.
+	if (not (theParams.features & IORING_FEAT_NODROP) || not spSupportsOps(fRingFD))
+		return false;
+
+	fSQRingSize = theParams.sq_off.array + theParams.sq_entries * sizeof(unsigned);
+	fCQRingSize = theParams.cq_off.cqes + theParams.cq_entries * sizeof(io_uring_cqe);
+
+	const bool singleMMap = theParams.features & IORING_FEAT_SINGLE_MMAP;
+	if (singleMMap)
+		fSQRingSize = fCQRingSize = std::max(fSQRingSize, fCQRingSize);
+
+	fSQRing = ::mmap(nullptr, fSQRingSize,
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fRingFD, IORING_OFF_SQ_RING);
+	if (fSQRing == MAP_FAILED)
+		return false;
+
+	if (singleMMap)
+		{
+		fCQRing = fSQRing;
+		}
+	else
+		{
+		fCQRing = ::mmap(nullptr, fCQRingSize,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fRingFD, IORING_OFF_CQ_RING);
+		if (fCQRing == MAP_FAILED)
+			return false;
+		}
+
+	fSQEsSize = theParams.sq_entries * sizeof(io_uring_sqe);
+	fSQEs = (io_uring_sqe*)::mmap(nullptr, fSQEsSize,
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fRingFD, IORING_OFF_SQES);
+	if (fSQEs == MAP_FAILED)
+		return false;
+
+	byte* theSQRing = static_cast<byte*>(fSQRing);
+	fSQHead = reinterpret_cast<unsigned*>(theSQRing + theParams.sq_off.head);
+	fSQTail = reinterpret_cast<unsigned*>(theSQRing + theParams.sq_off.tail);
+	fSQMask = *reinterpret_cast<unsigned*>(theSQRing + theParams.sq_off.ring_mask);
+	fSQEntries = *reinterpret_cast<unsigned*>(theSQRing + theParams.sq_off.ring_entries);
+	fSQArray = reinterpret_cast<unsigned*>(theSQRing + theParams.sq_off.array);
+
+	byte* theCQRing = static_cast<byte*>(fCQRing);
+	fCQHead = reinterpret_cast<unsigned*>(theCQRing + theParams.cq_off.head);
+	fCQTail = reinterpret_cast<unsigned*>(theCQRing + theParams.cq_off.tail);
+	fCQMask = *reinterpret_cast<unsigned*>(theCQRing + theParams.cq_off.ring_mask);
+	fCQEs = reinterpret_cast<io_uring_cqe*>(theCQRing + theParams.cq_off.cqes);
+
+	fRunning = true;
+	ZThread::sStart_T<AsyncIO_IOURing*>(spRun, this);
+	return true;
+	}
+
+void AsyncIO_IOURing::Finalize()
+	{
+	{
+	ZAcqMtx acq(fMtx);
+	if (not this->FinishFinalize())
+		return;
+
+	fShutdown = true;
+	if (fRunning)
+		{
+		// The reaper deletes us once everything outstanding has completed, so we don't wait
+		// here. Which also means the last reference can be dropped on the reaper's own thread.
+		this->pCancel_Locked(false);
+		return;
+		}
+	}
+	delete this;
+	}
+
+void AsyncIO_IOURing::Read(int iFD, byte* oDest, size_t iCount,
+	const ZP<Callable_Completion>& iCompletion, bool iCallDirectly)
+	{
+	Op* theOp = new Op(eOp_Read, iFD, iCompletion, iCallDirectly);
+	theOp->fAddress = oDest;
+	theOp->fCount = iCount;
+	this->pStart(theOp);
+	}
+
+void AsyncIO_IOURing::Write(int iFD, const byte* iSource, size_t iCount,
+	const ZP<Callable_Completion>& iCompletion, bool iCallDirectly)
+	{
+	Op* theOp = new Op(eOp_Write, iFD, iCompletion, iCallDirectly);
+	theOp->fAddress = const_cast<byte*>(iSource);
+	theOp->fCount = iCount;
+	this->pStart(theOp);
+	}
+
+void AsyncIO_IOURing::Accept(int iListenFD,
+	const ZP<Callable_Completion>& iCompletion, bool iCallDirectly)
+	{ this->pStart(new Op(eOp_Accept, iListenFD, iCompletion, iCallDirectly)); }
+
+void AsyncIO_IOURing::Connect(int iFD, const sockaddr* iAddr, socklen_t iAddrLen,
+	const ZP<Callable_Completion>& iCompletion, bool iCallDirectly)
+	{ this->pStart(spNewOp_Connect(iFD, iAddr, iAddrLen, iCompletion, iCallDirectly)); }
+
+void AsyncIO_IOURing::pStart(Op* iOp)
+	{
+	ZAcqMtx acq(fMtx);
+	if (fShutdown)
+		{
+		ZRelMtx rel(fMtx);
+		spComplete(fStarter, iOp, -ECANCELED);
+		return;
+		}
+	fInFlight.insert(iOp);
+	this->pSubmit_Locked(iOp);
+	}
+
+void AsyncIO_IOURing::pComplete(Op* iOp, ssize_t iResult)
+	{
+	{
+	ZAcqMtx acq(fMtx);
+	fInFlight.erase(iOp);
+	}
+	spComplete(fStarter, iOp, iResult);
+	}
+
+void AsyncIO_IOURing::pReaped(Op* iOp, int iResult)
+	{
+	ZAcqMtx acq(fMtx);
+	if (iOp->fWaiting)
+		{
+		// The fd's become ready (or the poll failed or was cancelled).
+		iOp->fWaiting = false;
+		if (iResult >= 0)
+			{
+			if (iOp->fOp == eOp_Connect)
+				iResult = spConnectResult(iOp->fFD);
+			else if (not fShutdown)
+				return this->pSubmit_Locked(iOp);
+			else
+				iResult = -ECANCELED;
+			}
+		}
+	else if (not fShutdown)
+		{
+		if (iResult == -EAGAIN || (iOp->fOp == eOp_Connect && iResult == -EINPROGRESS))
+			{
+			// A non-blocking fd that wasn't ready. Wait till it is, then try again.
+			iOp->fWaiting = true;
+			return this->pSubmit_Locked(iOp);
+			}
+
+		if (iResult == -EINTR)
+			return this->pSubmit_Locked(iOp);
+
+		if (iOp->fOp == eOp_Write && iOp->fIsSocket && iResult == -ENOTSOCK)
+			{
+			iOp->fIsSocket = false;
+			return this->pSubmit_Locked(iOp);
+			}
+		}
+
+	ZRelMtx rel(fMtx);
+	this->pComplete(iOp, iResult);
+	}
+
+void AsyncIO_IOURing::pCancel_Locked(bool iShutDownFDs)
+	{
+	// pPush_Locked releases fMtx while it submits, during which the reaper may be completing
+	// (and deleting) ops, so we take what we need from them now.
+	vector<pair<Op*,int>> toCancel;
+	for (unordered_set<Op*>::const_iterator iter = fInFlight.begin();
+		iter != fInFlight.end(); ++iter)
+		{ toCancel.push_back(pair<Op*,int>(*iter, (*iter)->fFD)); }
+
+	io_uring_sqe theSQE = {};
+	for (vector<pair<Op*,int>>::const_iterator iter = toCancel.begin();
+		iter != toCancel.end(); ++iter)
+		{
+		// An op blocked in the kernel may not respond to cancellation, but shutting down its
+		// socket will complete it.
+		if (iShutDownFDs)
+			::shutdown(iter->second, SHUT_RDWR);
+
+		theSQE = io_uring_sqe();
+		theSQE.opcode = IORING_OP_ASYNC_CANCEL;
+		theSQE.fd = -1;
+		theSQE.addr = reinterpret_cast<uintptr_t>(iter->first);
+		this->pPush_Locked(theSQE);
+		}
+
+	theSQE = io_uring_sqe();
+	theSQE.fd = -1;
+	if (toCancel.empty())
+		{
+		// Just wake the reaper.
+		theSQE.opcode = IORING_OP_NOP;
+		}
+	else
+		{
+		// Wake the reaper after a while, so it can escalate if anything's still outstanding.
+		theSQE.opcode = IORING_OP_TIMEOUT;
+		theSQE.addr = reinterpret_cast<uintptr_t>(&spTimeout_Cancel);
+		theSQE.len = 1;
+		theSQE.user_data = kUserData_Timeout;
+		}
+	this->pPush_Locked(theSQE);
+	}
+
+void AsyncIO_IOURing::pSubmit_Locked(Op* iOp)
+	{
+	io_uring_sqe theSQE = {};
+	theSQE.fd = iOp->fFD;
+	theSQE.user_data = reinterpret_cast<uintptr_t>(iOp);
+
+	if (iOp->fWaiting)
+		{
+		theSQE.opcode = IORING_OP_POLL_ADD;
+		theSQE.poll32_events = spWantsReadable(iOp) ? POLLIN : POLLOUT;
+		}
+	else
+		{
+		switch (iOp->fOp)
+			{
+			case eOp_Read:
+				{
+				theSQE.opcode = IORING_OP_READ;
+				theSQE.addr = reinterpret_cast<uintptr_t>(iOp->fAddress);
+				theSQE.len = std::min<size_t>(iOp->fCount, 0x7FFFFFFF);
+				// Use (and update) the fd's file position, as read does.
+				theSQE.off = uint64(-1);
+				break;
+				}
+			case eOp_Write:
+				{
+				theSQE.opcode = iOp->fIsSocket ? IORING_OP_SEND : IORING_OP_WRITE;
+				theSQE.addr = reinterpret_cast<uintptr_t>(iOp->fAddress);
+				theSQE.len = std::min<size_t>(iOp->fCount, 0x7FFFFFFF);
+				if (iOp->fIsSocket)
+					theSQE.msg_flags = MSG_NOSIGNAL;
+				else
+					theSQE.off = uint64(-1);
+				break;
+				}
+			case eOp_Accept:
+				{
+				theSQE.opcode = IORING_OP_ACCEPT;
+				theSQE.accept_flags = SOCK_CLOEXEC;
+				break;
+				}
+			case eOp_Connect:
+				{
+				theSQE.opcode = IORING_OP_CONNECT;
+				theSQE.addr = reinterpret_cast<uintptr_t>(&iOp->fSockAddr);
+				theSQE.off = iOp->fSockAddrLen;
+				break;
+				}
+			}
+		}
+
+	this->pPush_Locked(theSQE);
+	}
+
+bool AsyncIO_IOURing::pPlace_Locked(const io_uring_sqe& iSQE)
+	{
+	// We're the only writer of the SQ tail, the kernel advances the head as it consumes SQEs.
+	const unsigned theTail = *fSQTail;
+	if (theTail - __atomic_load_n(fSQHead, __ATOMIC_ACQUIRE) >= fSQEntries)
+		return false;
+
+	const unsigned theIndex = theTail & fSQMask;
+	fSQEs[theIndex] = iSQE;
+	fSQArray[theIndex] = theIndex;
+	__atomic_store_n(fSQTail, theTail + 1, __ATOMIC_RELEASE);
+	++fUnsubmitted;
+	return true;
+	}
+
+void AsyncIO_IOURing::pPush_Locked(const io_uring_sqe& iSQE)
+	{
+	while (not this->pPlace_Locked(iSQE))
+		{
+		// The SQ is full.
+		if (ZThread::sID() == fReaperID)
+			{
+			fDeferred.push_back(iSQE);
+			return;
+			}
+
+		if (fFlushing || fBacklogged)
+			fCnd.Wait(fMtx);
+		else
+			this->pFlush_Locked();
+		}
+
+	// If another thread is flushing it'll pick this SQE up when its current io_uring_enter
+	// returns, so concurrent submissions are naturally batched into a single syscall. And if
+	// we're backlogged the reaper will submit it once it's drained the CQ.
+	if (not fFlushing && not fBacklogged)
+		this->pFlush_Locked();
+	}
+
+void AsyncIO_IOURing::pFlush_Locked()
+	{
+	fFlushing = true;
+	while (fUnsubmitted)
+		{
+		const unsigned toSubmit = fUnsubmitted;
+		int result;
+		int err;
+		{
+		ZRelMtx rel(fMtx);
+		result = spEnter(fRingFD, toSubmit, 0, 0);
+		err = errno;
+		}
+
+		if (result > 0)
+			{
+			fUnsubmitted -= result;
+			}
+		else if (result < 0 && err == EBUSY)
+			{
+			// Completions are backed up. Waiting here would stall the reaper if it's us, or
+			// anything the reaper is waiting on, so leave the rest for pRun to submit.
+			fBacklogged = true;
+			break;
+			}
+		else if (result < 0 && err == EAGAIN)
+			{
+			// The kernel's short of resources, give it a moment.
+			ZRelMtx rel(fMtx);
+			ZThread::sSleep(0.001);
+			}
+		else if (result == 0 || err != EINTR)
+			{
+			break;
+			}
+		}
+	fFlushing = false;
+	fCnd.Broadcast();
+	}
+
+void AsyncIO_IOURing::pRun()
+	{
+	{
+	ZAcqMtx acq(fMtx);
+	fReaperID = ZThread::sID();
+	}
+
+	vector<pair<Op*,int>> theReaped;
+	for (;;)
+		{
+		spEnter(fRingFD, 0, 1, IORING_ENTER_GETEVENTS);
+
+		// We're the only reader of the CQ head, the kernel advances the tail.
+		bool timedOut = false;
+		unsigned theHead = *fCQHead;
+		const unsigned theTail = __atomic_load_n(fCQTail, __ATOMIC_ACQUIRE);
+		for (/*no init*/; theHead != theTail; ++theHead)
+			{
+			const io_uring_cqe& theCQE = fCQEs[theHead & fCQMask];
+			if (theCQE.user_data == kUserData_Timeout)
+				timedOut = true;
+			else if (theCQE.user_data)
+				theReaped.push_back(pair<Op*,int>((Op*)uintptr_t(theCQE.user_data), theCQE.res));
+			}
+		__atomic_store_n(fCQHead, theHead, __ATOMIC_RELEASE);
+
+		for (vector<pair<Op*,int>>::iterator iter = theReaped.begin();
+			iter != theReaped.end(); ++iter)
+			{ this->pReaped(iter->first, iter->second); }
+		theReaped.clear();
+
+		ZAcqMtx acq(fMtx);
+
+		// The CQ's drained, so submit whatever was refused or deferred while it was backed up.
+		fBacklogged = false;
+		size_t placed = 0;
+		while (placed < fDeferred.size() && this->pPlace_Locked(fDeferred[placed]))
+			++placed;
+		fDeferred.erase(fDeferred.begin(), fDeferred.begin() + placed);
+		if (not fFlushing)
+			this->pFlush_Locked();
+
+		if (fShutdown)
+			{
+			if (fInFlight.empty())
+				{
+				// Let any submission still under way (e.g. Finalize's) finish with the ring.
+				while (fFlushing)
+					fCnd.Wait(fMtx);
+				break;
+				}
+
+			if (timedOut)
+				this->pCancel_Locked(true);
+			}
+		}
+	}
+
+void AsyncIO_IOURing::spRun(AsyncIO_IOURing* iAsyncIO)
+	{
+	ZThread::sSetName("AsyncIO_IOURing");
+
+	iAsyncIO->pRun();
+	delete iAsyncIO;
+	}
+
+} // anonymous namespace
+
+#endif // ZCONFIG_AsyncIO_UseIOURing
+
+// =================================================================================================
+#pragma mark - sAsyncIO_POSIX
+
+ZP<AsyncIO_POSIX> sAsyncIO_IOURing(const ZP<Starter>& iStarter, size_t iQueueDepth)
+	{
+	#if ZCONFIG_AsyncIO_UseIOURing
+		ZP<AsyncIO_IOURing> theAsyncIO = new AsyncIO_IOURing(iStarter);
+		if (theAsyncIO->Initialize(std::max<size_t>(8, std::min<size_t>(iQueueDepth, 4096))))
+			return theAsyncIO;
+	#endif
+	return null;
+	}
+
+ZP<AsyncIO_POSIX> sAsyncIO_Readiness(const ZP<Starter>& iStarter)
+	{ return new AsyncIO_Readiness(iStarter); }
+
+ZP<AsyncIO_POSIX> sAsyncIO_POSIX(const ZP<Starter>& iStarter)
+	{
+	if (ZP<AsyncIO_POSIX> theAsyncIO = sAsyncIO_IOURing(iStarter, 256))
+		return theAsyncIO;
+	return sAsyncIO_Readiness(iStarter);
+	}
+
+// =================================================================================================
+#pragma mark - ChanConnection_Bin_AsyncIO::Waiter
+
+class ChanConnection_Bin_AsyncIO::Waiter
+:	public AsyncIO_POSIX::Callable_Completion
+	{
+public:
+// From Callable
+	virtual bool QCall(ssize_t iResult)
+		{
+		ZAcqMtx acq(fMtx);
+		fResultQ = iResult;
+		fCnd.Broadcast();
+		return true;
+		}
+
+// Our protocol
+	void Reset()
+		{
+		ZAcqMtx acq(fMtx);
+		fResultQ.Clear();
+		}
+
+	ssize_t Wait()
+		{
+		ZAcqMtx acq(fMtx);
+		while (not fResultQ)
+			fCnd.Wait(fMtx);
+		return *fResultQ;
+		}
+
+private:
+	ZMtx fMtx;
+	ZCnd fCnd;
+	ZQ<ssize_t> fResultQ;
+	};
+
+// =================================================================================================
+#pragma mark - ChanConnection_Bin_AsyncIO
+
+ChanConnection_Bin_AsyncIO::ChanConnection_Bin_AsyncIO(
+	const ZP<AsyncIO_POSIX>& iAsyncIO, const ZP<FDHolder>& iFDHolder)
+:	fAsyncIO(iAsyncIO)
+,	fFDHolder(iFDHolder)
+,	fWaiter_Read(new Waiter)
+,	fWaiter_Write(new Waiter)
+	{}
+
+ChanConnection_Bin_AsyncIO::~ChanConnection_Bin_AsyncIO()
+	{}
+
+void ChanConnection_Bin_AsyncIO::Abort()
+	{ ::shutdown(fFDHolder->GetFD(), SHUT_RDWR); }
+
+bool ChanConnection_Bin_AsyncIO::DisconnectRead(double iTimeout)
+	{
+	for (;;)
+		{
+		if (not this->WaitReadable(iTimeout))
+			return false;
+
+		byte buf[sStackBufferSize];
+		fWaiter_Read->Reset();
+		fAsyncIO->Read(fFDHolder->GetFD(), buf, sizeof(buf), fWaiter_Read, true);
+		const ssize_t result = fWaiter_Read->Wait();
+		if (result == 0)
+			{
+			// The other end has sent FIN.
+			::shutdown(fFDHolder->GetFD(), SHUT_RD);
+			return true;
+			}
+		else if (result < 0)
+			{
+			return false;
+			}
+		}
+	}
+
+void ChanConnection_Bin_AsyncIO::DisconnectWrite()
+	{ ::shutdown(fFDHolder->GetFD(), SHUT_WR); }
+
+size_t ChanConnection_Bin_AsyncIO::Read(byte* oDest, size_t iCount)
+	{
+	if (not iCount)
+		return 0;
+
+	// Our waiter just signals the blocked thread, so it's called directly, rather than going via
+	// a Starter whose threads might all be blocked in this very method.
+	fWaiter_Read->Reset();
+	fAsyncIO->Read(fFDHolder->GetFD(), oDest, iCount, fWaiter_Read, true);
+	const ssize_t result = fWaiter_Read->Wait();
+	return result > 0 ? result : 0;
+	}
+
+size_t ChanConnection_Bin_AsyncIO::Readable()
+	{ return Util_POSIXFD::sReadable(fFDHolder->GetFD()); }
+
+bool ChanConnection_Bin_AsyncIO::WaitReadable(double iTimeout)
+	{ return Util_POSIXFD::sWaitReadable(fFDHolder->GetFD(), iTimeout); }
+
+size_t ChanConnection_Bin_AsyncIO::Write(const byte* iSource, size_t iCount)
+	{
+	if (not iCount)
+		return 0;
+
+	fWaiter_Write->Reset();
+	fAsyncIO->Write(fFDHolder->GetFD(), iSource, iCount, fWaiter_Write, true);
+	const ssize_t result = fWaiter_Write->Wait();
+	return result > 0 ? result : 0;
+	}
+
+ZP<FDHolder> ChanConnection_Bin_AsyncIO::GetFDHolder()
+	{ return fFDHolder; }
+
+} // namespace ZooLib
+
+#endif // ZCONFIG_SPI_Enabled(POSIX)
@@ -0,0 +1,134 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#ifndef __ZooLib_POSIX_AsyncIO_POSIX_h__
+#define __ZooLib_POSIX_AsyncIO_POSIX_h__ 1
+#include "zconfig.h"
+#include "zoolib/ZCONFIG_SPI.h"
+
+#include "zoolib/Callable.h"
+#include "zoolib/Chan.h"
+#include "zoolib/Starter.h"
+
+#include "zoolib/POSIX/Chan_Bin_POSIXFD.h" // For FDHolder and FDHolderProvider
+
+#if ZCONFIG_SPI_Enabled(POSIX)
+
+#include <sys/socket.h> // For sockaddr and socklen_t
+#include <sys/types.h> // For ssize_t
+
+// Use io_uring where it's available, falling back to epoll, or to poll.
+#ifndef ZCONFIG_AsyncIO_UseIOURing
+	#if ZCONFIG_SPI_Enabled(Linux) && defined(__has_include)
+		#if __has_include(<linux/io_uring.h>)
+			#define ZCONFIG_AsyncIO_UseIOURing 1
+		#endif
+	#endif
+	#ifndef ZCONFIG_AsyncIO_UseIOURing
+		#define ZCONFIG_AsyncIO_UseIOURing 0
+	#endif
+#endif
+
+#ifndef ZCONFIG_AsyncIO_UseEPoll
+	#define ZCONFIG_AsyncIO_UseEPoll ZCONFIG_SPI_Enabled(Linux)
+#endif
+
+namespace ZooLib {
+
+// =================================================================================================
+#pragma mark - AsyncIO_POSIX
+
+/** Completion-based I/O on file descriptors. Each operation returns immediately, and when it
+has finished its completion is started on the Starter the AsyncIO_POSIX was created with. The
+completion is passed the byte count for Read and Write, the new fd for Accept, zero for Connect,
+or a negated errno value on failure. Buffers must remain valid until the completion is called.
+
+If iCallDirectly is true, the completion is called on our I/O thread instead, so it must be
+quick and must not block. A Write to a socket never raises SIGPIPE.
+
+Have at most one Read and one Write outstanding on an fd at once, or their order is undefined.
+Shut down a socket, rather than closing it, to complete its outstanding operations. Any still
+outstanding when the AsyncIO_POSIX is released are completed with -ECANCELED, from our I/O
+thread, which exits once they have all been completed. If some don't respond to cancellation
+promptly, their sockets are shut down. */
+
+class AsyncIO_POSIX
+:	public Counted
+	{
+public:
+	typedef Callable<void(ssize_t)> Callable_Completion;
+
+	virtual void Read(int iFD, byte* oDest, size_t iCount,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly = false) = 0;
+
+	virtual void Write(int iFD, const byte* iSource, size_t iCount,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly = false) = 0;
+
+	virtual void Accept(int iListenFD,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly = false) = 0;
+
+	virtual void Connect(int iFD, const sockaddr* iAddr, socklen_t iAddrLen,
+		const ZP<Callable_Completion>& iCompletion, bool iCallDirectly = false) = 0;
+	};
+
+// =================================================================================================
+#pragma mark - sAsyncIO_POSIX
+
+/// Returns null if the kernel lacks io_uring or any of the operations we need.
+ZP<AsyncIO_POSIX> sAsyncIO_IOURing(const ZP<Starter>& iStarter, size_t iQueueDepth);
+
+/// Attempts each operation directly, and waits for readiness with epoll or poll if it would block.
+/// fds must be non-blocking.
+ZP<AsyncIO_POSIX> sAsyncIO_Readiness(const ZP<Starter>& iStarter);
+
+/// sAsyncIO_IOURing if it's available, otherwise sAsyncIO_Readiness.
+ZP<AsyncIO_POSIX> sAsyncIO_POSIX(const ZP<Starter>& iStarter);
+
+// =================================================================================================
+#pragma mark - ChanConnection_Bin_AsyncIO
+
+/// Presents a blocking connection interface on a socket whose I/O is done by an AsyncIO_POSIX.
+
+class ChanConnection_Bin_AsyncIO
+:	public ChanConnection<byte>
+,	public FDHolderProvider
+	{
+public:
+	ChanConnection_Bin_AsyncIO(const ZP<AsyncIO_POSIX>& iAsyncIO, const ZP<FDHolder>& iFDHolder);
+	virtual ~ChanConnection_Bin_AsyncIO();
+
+// From ChanAspect_Abort
+	virtual void Abort();
+
+// From ChanAspect_DisconnectRead
+	virtual bool DisconnectRead(double iTimeout);
+
+// From ChanAspect_DisconnectWrite
+	virtual void DisconnectWrite();
+
+// From ChanAspect_Read<byte>
+	virtual size_t Read(byte* oDest, size_t iCount);
+	virtual size_t Readable();
+
+// From ChanAspect_WaitReadable
+	virtual bool WaitReadable(double iTimeout);
+
+// From ChanAspect_Write<byte>
+	virtual size_t Write(const byte* iSource, size_t iCount);
+
+// From FDHolderProvider
+	virtual ZP<FDHolder> GetFDHolder();
+
+	class Waiter;
+
+protected:
+	const ZP<AsyncIO_POSIX> fAsyncIO;
+	const ZP<FDHolder> fFDHolder;
+	const ZP<Waiter> fWaiter_Read;
+	const ZP<Waiter> fWaiter_Write;
+	};
+
+} // namespace ZooLib
+
+#endif // ZCONFIG_SPI_Enabled(POSIX)
+
+#endif // __ZooLib_POSIX_AsyncIO_POSIX_h__
@@ -24,6 +24,8 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/POSIX/Util_POSIXFD.h"
 
+#include "zoolib/Util_Chan.h" // For sCopyFully
+
 #include <unistd.h> // For close
 
 namespace ZooLib {
@@ -63,6 +65,26 @@ FDHolder_CloseOnDestroy::~FDHolder_CloseOnDestroy()
 int FDHolder_CloseOnDestroy::GetFD()
 	{ return fFD; }
 
+// =================================================================================================
+#pragma mark - sCopyFully_FD
+
+std::pair<uint64,uint64> sCopyFully_FD(
+	const ChanR_Bin& iChanR, const ChanW_Bin& iChanW, uint64 iCount)
+	{
+	if (FDHolderProvider* theProviderR = dynamic_cast<FDHolderProvider*>(&sNonConst(iChanR)))
+		{
+		if (FDHolderProvider* theProviderW = dynamic_cast<FDHolderProvider*>(&sNonConst(iChanW)))
+			{
+			const ZP<FDHolder> theFDHolderR = theProviderR->GetFDHolder();
+			const ZP<FDHolder> theFDHolderW = theProviderW->GetFDHolder();
+			const uint64 countCopied =
+				Util_POSIXFD::sCopy(theFDHolderR->GetFD(), theFDHolderW->GetFD(), iCount);
+			return std::pair<uint64,uint64>(countCopied, countCopied);
+			}
+		}
+	return sCopyFully(iChanR, iChanW, iCount);
+	}
+
 // =================================================================================================
 #pragma mark - ChanR_Bin_POSIXFD
 
@@ -79,6 +101,9 @@ size_t ChanR_Bin_POSIXFD::Read(byte* oDest, size_t iCount)
 size_t ChanR_Bin_POSIXFD::Readable()
 	{ return Util_POSIXFD::sReadable(fFDHolder->GetFD()); }
 
+ZP<FDHolder> ChanR_Bin_POSIXFD::GetFDHolder()
+	{ return fFDHolder; }
+
 // =================================================================================================
 #pragma mark - ChanW_Bin_POSIXFD
 
@@ -92,6 +117,12 @@ ChanW_Bin_POSIXFD::~ChanW_Bin_POSIXFD()
 size_t ChanW_Bin_POSIXFD::Write(const byte* iSource, size_t iCount)
 	{ return Util_POSIXFD::sWrite(fFDHolder->GetFD(), iSource, iCount); }
 
+size_t ChanW_Bin_POSIXFD::WriteV(const PaC<const byte>* iSources, size_t iCount)
+	{ return Util_POSIXFD::sWriteV(fFDHolder->GetFD(), iSources, iCount); }
+
+ZP<FDHolder> ChanW_Bin_POSIXFD::GetFDHolder()
+	{ return fFDHolder; }
+
 // =================================================================================================
 #pragma mark - ChanRPos_Bin_POSIXFD
 
@@ -120,6 +151,9 @@ uint64 ChanRPos_Bin_POSIXFD::Size()
 size_t ChanRPos_Bin_POSIXFD::Unread(const byte* iSource, size_t iCount)
 	{ return Util_POSIXFD::sUnread(fFDHolder->GetFD(), iSource, iCount); }
 
+ZP<FDHolder> ChanRPos_Bin_POSIXFD::GetFDHolder()
+	{ return fFDHolder; }
+
 // =================================================================================================
 #pragma mark - ChanWPos_Bin_POSIXFD
 
@@ -145,6 +179,12 @@ void ChanWPos_Bin_POSIXFD::SizeSet(uint64 iSize)
 size_t ChanWPos_Bin_POSIXFD::Write(const byte* iSource, size_t iCount)
 	{ return Util_POSIXFD::sWrite(fFDHolder->GetFD(), iSource, iCount); }
 
+size_t ChanWPos_Bin_POSIXFD::WriteV(const PaC<const byte>* iSources, size_t iCount)
+	{ return Util_POSIXFD::sWriteV(fFDHolder->GetFD(), iSources, iCount); }
+
+ZP<FDHolder> ChanWPos_Bin_POSIXFD::GetFDHolder()
+	{ return fFDHolder; }
+
 // =================================================================================================
 #pragma mark - ChanRWPos_Bin_POSIXFD
 
@@ -179,6 +219,12 @@ size_t ChanRWPos_Bin_POSIXFD::Write(const byte* iSource, size_t iCount)
 size_t ChanRWPos_Bin_POSIXFD::Unread(const byte* iSource, size_t iCount)
 	{ return Util_POSIXFD::sUnread(fFDHolder->GetFD(), iSource, iCount); }
 
+size_t ChanRWPos_Bin_POSIXFD::WriteV(const PaC<const byte>* iSources, size_t iCount)
+	{ return Util_POSIXFD::sWriteV(fFDHolder->GetFD(), iSources, iCount); }
+
+ZP<FDHolder> ChanRWPos_Bin_POSIXFD::GetFDHolder()
+	{ return fFDHolder; }
+
 // =================================================================================================
 #pragma mark - ChanRAbort_Bin_POSIXFD
 
@@ -201,6 +247,9 @@ size_t ChanRAbort_Bin_POSIXFD::Readable()
 bool ChanRAbort_Bin_POSIXFD::WaitReadable(double iTimeout)
 	{ return Util_POSIXFD::sWaitReadable(fFDHolder->GetFD(), iTimeout); }
 
+ZP<FDHolder> ChanRAbort_Bin_POSIXFD::GetFDHolder()
+	{ return fFDHolder; }
+
 // =================================================================================================
 #pragma mark - ChanWAbort_Bin_POSIXFD
 
@@ -217,6 +266,12 @@ void ChanWAbort_Bin_POSIXFD::Abort()
 size_t ChanWAbort_Bin_POSIXFD::Write(const byte* iSource, size_t iCount)
 	{ return Util_POSIXFD::sWriteCon(fFDHolder->GetFD(), iSource, iCount); }
 
+size_t ChanWAbort_Bin_POSIXFD::WriteV(const PaC<const byte>* iSources, size_t iCount)
+	{ return Util_POSIXFD::sWriteVCon(fFDHolder->GetFD(), iSources, iCount); }
+
+ZP<FDHolder> ChanWAbort_Bin_POSIXFD::GetFDHolder()
+	{ return fFDHolder; }
+
 // =================================================================================================
 #pragma mark - ChanRWAbort_Bin_POSIXFD
 
@@ -242,6 +297,12 @@ bool ChanRWAbort_Bin_POSIXFD::WaitReadable(double iTimeout)
 size_t ChanRWAbort_Bin_POSIXFD::Write(const byte* iSource, size_t iCount)
 	{ return Util_POSIXFD::sWriteCon(fFDHolder->GetFD(), iSource, iCount); }
 
+size_t ChanRWAbort_Bin_POSIXFD::WriteV(const PaC<const byte>* iSources, size_t iCount)
+	{ return Util_POSIXFD::sWriteVCon(fFDHolder->GetFD(), iSources, iCount); }
+
+ZP<FDHolder> ChanRWAbort_Bin_POSIXFD::GetFDHolder()
+	{ return fFDHolder; }
+
 } // namespace ZooLib
 
 #endif // ZCONFIG_SPI_Enabled(POSIX)
@@ -80,11 +80,33 @@ protected:
 	int fFD;
 	};
 
+// =================================================================================================
+#pragma mark - FDHolderProvider
+
+/// Implemented by chans that read or write a file descriptor with no intervening buffering,
+/// so that sCopyFully_FD can have the kernel move data between them.
+
+class FDHolderProvider
+	{
+public:
+	virtual ZP<FDHolder> GetFDHolder() = 0;
+	};
+
+// =================================================================================================
+#pragma mark - sCopyFully_FD
+
+/// As sCopyFully, but if both chans are FDHolderProviders the data is moved by
+/// Util_POSIXFD::sCopy, using sendfile or splice and not passing through user space.
+
+std::pair<uint64,uint64> sCopyFully_FD(
+	const ChanR_Bin& iChanR, const ChanW_Bin& iChanW, uint64 iCount);
+
 // =================================================================================================
 #pragma mark - ChanR_Bin_POSIXFD
 
 class ChanR_Bin_POSIXFD
 :	public ChanR<byte>
+,	public FDHolderProvider
 	{
 	ChanR_Bin_POSIXFD(const ZP<FDHolder>& iFDHolder);
 	~ChanR_Bin_POSIXFD();
@@ -93,6 +115,9 @@ class ChanR_Bin_POSIXFD
 	virtual size_t Read(byte* oDest, size_t iCount);
 	virtual size_t Readable();
 
+// From FDHolderProvider
+	virtual ZP<FDHolder> GetFDHolder();
+
 protected:
 	const ZP<FDHolder> fFDHolder;
 	};
@@ -102,6 +127,7 @@ protected:
 
 class ChanW_Bin_POSIXFD
 :	public ChanW_Bin
+,	public FDHolderProvider
 	{
 public:
 	ChanW_Bin_POSIXFD(const ZP<FDHolder>& iFDHolder);
@@ -109,6 +135,10 @@ public:
 
 // From ChanAspect_Write<byte>
 	virtual size_t Write(const byte* iSource, size_t iCount);
+	virtual size_t WriteV(const PaC<const byte>* iSources, size_t iCount);
+
+// From FDHolderProvider
+	virtual ZP<FDHolder> GetFDHolder();
 
 protected:
 	const ZP<FDHolder> fFDHolder;
@@ -119,6 +149,7 @@ protected:
 
 class ChanRPos_Bin_POSIXFD
 :	public ChanRPos<byte>
+,	public FDHolderProvider
 	{
 public:
 	ChanRPos_Bin_POSIXFD(const ZP<FDHolder>& iFDHolder);
@@ -138,6 +169,9 @@ public:
 // From ChanAspect_Unread<byte>
 	virtual size_t Unread(const byte* iSource, size_t iCount);
 
+// From FDHolderProvider
+	virtual ZP<FDHolder> GetFDHolder();
+
 protected:
 	const ZP<FDHolder> fFDHolder;
 	};
@@ -147,6 +181,7 @@ protected:
 
 class ChanWPos_Bin_POSIXFD
 :	public ChanWPos<byte>
+,	public FDHolderProvider
 	{
 public:
 	ChanWPos_Bin_POSIXFD(const ZP<FDHolder>& iFDHolder);
@@ -164,6 +199,10 @@ public:
 
 // From ChanAspect_Write<byte>
 	virtual size_t Write(const byte* iSource, size_t iCount);
+	virtual size_t WriteV(const PaC<const byte>* iSources, size_t iCount);
+
+// From FDHolderProvider
+	virtual ZP<FDHolder> GetFDHolder();
 
 protected:
 	const ZP<FDHolder> fFDHolder;
@@ -174,6 +213,7 @@ protected:
 
 class ChanRWPos_Bin_POSIXFD
 :	public ChanRWPos<byte>
+,	public FDHolderProvider
 	{
 public:
 	ChanRWPos_Bin_POSIXFD(const ZP<FDHolder>& iFDHolder);
@@ -195,10 +235,14 @@ public:
 
 // From ChanAspect_Write<byte>
 	virtual size_t Write(const byte* iSource, size_t iCount);
+	virtual size_t WriteV(const PaC<const byte>* iSources, size_t iCount);
 
 // From ChanAspect_Unread<byte>
 	virtual size_t Unread(const byte* iSource, size_t iCount);
 
+// From FDHolderProvider
+	virtual ZP<FDHolder> GetFDHolder();
+
 protected:
 	const ZP<FDHolder> fFDHolder;
 	};
@@ -208,6 +252,7 @@ protected:
 
 class ChanRAbort_Bin_POSIXFD
 :	public ChanRAbort<byte>
+,	public FDHolderProvider
 	{
 public:
 	ChanRAbort_Bin_POSIXFD(const ZP<FDHolder>& iFDHolder);
@@ -223,6 +268,9 @@ public:
 // From ChanAspect_WaitReadable
 	virtual bool WaitReadable(double iTimeout);
 
+// From FDHolderProvider
+	virtual ZP<FDHolder> GetFDHolder();
+
 protected:
 	const ZP<FDHolder> fFDHolder;
 	};
@@ -232,6 +280,7 @@ protected:
 
 class ChanWAbort_Bin_POSIXFD
 :	public ChanWAbort<byte>
+,	public FDHolderProvider
 	{
 public:
 	ChanWAbort_Bin_POSIXFD(const ZP<FDHolder>& iFDHolder);
@@ -242,6 +291,10 @@ public:
 
 // From ChanAspect_Write<byte>
 	virtual size_t Write(const byte* iSource, size_t iCount);
+	virtual size_t WriteV(const PaC<const byte>* iSources, size_t iCount);
+
+// From FDHolderProvider
+	virtual ZP<FDHolder> GetFDHolder();
 
 protected:
 	const ZP<FDHolder> fFDHolder;
@@ -252,6 +305,7 @@ protected:
 
 class ChanRWAbort_Bin_POSIXFD
 :	public ChanRWAbort<byte>
+,	public FDHolderProvider
 	{
 public:
 	ChanRWAbort_Bin_POSIXFD(const ZP<FDHolder>& iFDHolder);
@@ -269,6 +323,10 @@ public:
 
 // From ChanAspect_Write<byte>
 	virtual size_t Write(const byte* iSource, size_t iCount);
+	virtual size_t WriteV(const PaC<const byte>* iSources, size_t iCount);
+
+// From FDHolderProvider
+	virtual ZP<FDHolder> GetFDHolder();
 
 protected:
 	const ZP<FDHolder> fFDHolder;
@@ -0,0 +1,144 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#include "zoolib/POSIX/Chan_Bin_POSIXMapped.h"
+
+#if ZCONFIG_SPI_Enabled(POSIX)
+
+#include "zoolib/Channer.h"
+
+#include <cstring> // For memcpy
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h> // For sysconf
+
+namespace ZooLib {
+
+// =================================================================================================
+#pragma mark - Helpers (anonymous)
+
+namespace { // anonymous
+
+int spAdvice(File::Advice iAdvice)
+	{
+	switch (iAdvice)
+		{
+		case File::adviceNormal: return POSIX_MADV_NORMAL;
+		case File::adviceSequential: return POSIX_MADV_SEQUENTIAL;
+		case File::adviceRandom: return POSIX_MADV_RANDOM;
+		case File::adviceWillNeed: return POSIX_MADV_WILLNEED;
+		}
+	return POSIX_MADV_NORMAL;
+	}
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - ChanRPos_Bin_POSIXMapped
+
+ChanRPos_Bin_POSIXMapped::ChanRPos_Bin_POSIXMapped(
+	const ZP<FDHolder>& iFDHolder, const void* iAddress, size_t iSize)
+:	fFDHolder(iFDHolder)
+,	fAddress(static_cast<const byte*>(iAddress))
+,	fSize(iSize)
+,	fPosition(0)
+	{}
+
+ChanRPos_Bin_POSIXMapped::~ChanRPos_Bin_POSIXMapped()
+	{ ::munmap(const_cast<byte*>(fAddress), fSize); }
+
+uint64 ChanRPos_Bin_POSIXMapped::Pos()
+	{ return fPosition; }
+
+void ChanRPos_Bin_POSIXMapped::PosSet(uint64 iPos)
+	{ fPosition = iPos; }
+
+size_t ChanRPos_Bin_POSIXMapped::Read(byte* oDest, size_t iCount)
+	{
+	const size_t countToCopy = sClamped(iCount, fSize, fPosition);
+	if (countToCopy)
+		std::memcpy(oDest, fAddress + fPosition, countToCopy);
+	fPosition += countToCopy;
+	return countToCopy;
+	}
+
+uint64 ChanRPos_Bin_POSIXMapped::Skip(uint64 iCount)
+	{
+	const uint64 countToSkip = sClamped(iCount, fSize, fPosition);
+	fPosition += countToSkip;
+	return countToSkip;
+	}
+
+size_t ChanRPos_Bin_POSIXMapped::Readable()
+	{ return sClampedAvailable(fSize, fPosition); }
+
+uint64 ChanRPos_Bin_POSIXMapped::Size()
+	{ return fSize; }
+
+PaC<const byte> ChanRPos_Bin_POSIXMapped::Span()
+	{
+	if (fSize > fPosition)
+		return PaC<const byte>(fAddress + fPosition, fSize - fPosition);
+	return PaC<const byte>(fAddress + fSize, 0);
+	}
+
+size_t ChanRPos_Bin_POSIXMapped::Unread(const byte*, size_t iCount)
+	{
+	// The mapping is read-only, so unlike ChanRPos_XX_Memory we can't accept
+	// content other than what was there already -- just back up.
+	const size_t countToUnread = std::min<uint64>(iCount, fPosition);
+	fPosition -= countToUnread;
+	return countToUnread;
+	}
+
+void ChanRPos_Bin_POSIXMapped::Advise(File::Advice iAdvice)
+	{ this->Advise(iAdvice, 0, fSize); }
+
+void ChanRPos_Bin_POSIXMapped::Advise(File::Advice iAdvice, uint64 iOffset, uint64 iCount)
+	{
+	const uint64 countAvailable = sClamped(iCount, fSize, iOffset);
+	if (not countAvailable)
+		return;
+
+	// posix_madvise requires a page-aligned address.
+	const size_t pageSize = ::sysconf(_SC_PAGESIZE);
+	const size_t slop = size_t(iOffset) % pageSize;
+	::posix_madvise(const_cast<byte*>(fAddress + iOffset - slop),
+		size_t(countAvailable) + slop, spAdvice(iAdvice));
+	}
+
+// =================================================================================================
+#pragma mark - sChannerRPos_Bin_POSIXMapped
+
+ZP<ChannerRPos_Bin> sChannerRPos_Bin_POSIXMapped(
+	const ZP<FDHolder>& iFDHolder, File::Advice iAdvice)
+	{
+	const int theFD = iFDHolder->GetFD();
+
+	struct stat theStat;
+	if (0 != ::fstat(theFD, &theStat) || not S_ISREG(theStat.st_mode))
+		return null;
+
+	// mmap rejects a zero length. And files in /proc and the like claim to be
+	// empty regular files, yet have content when read, so leave those to our caller.
+	if (theStat.st_size <= 0 || uint64(theStat.st_size) > uint64(size_t(-1)))
+		return null;
+
+	const size_t theSize = theStat.st_size;
+
+	void* theAddress = ::mmap(nullptr, theSize, PROT_READ, MAP_SHARED, theFD, 0);
+	if (theAddress == MAP_FAILED)
+		return null;
+
+	ZP<Channer_T<ChanRPos_Bin_POSIXMapped>> theChanner =
+		sChanner_T<ChanRPos_Bin_POSIXMapped>(iFDHolder, theAddress, theSize);
+
+	if (iAdvice != File::adviceNormal)
+		theChanner->Advise(iAdvice);
+
+	return theChanner;
+	}
+
+} // namespace ZooLib
+
+#endif // ZCONFIG_SPI_Enabled(POSIX)
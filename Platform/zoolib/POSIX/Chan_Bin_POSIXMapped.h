@@ -0,0 +1,70 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#ifndef __ZooLib_POSIX_Chan_Bin_POSIXMapped_h__
+#define __ZooLib_POSIX_Chan_Bin_POSIXMapped_h__ 1
+#include "zconfig.h"
+#include "zoolib/ZCONFIG_SPI.h"
+
+#include "zoolib/File.h" // For File::Advice
+
+#include "zoolib/POSIX/Chan_Bin_POSIXFD.h" // For FDHolder
+
+#if ZCONFIG_SPI_Enabled(POSIX)
+
+namespace ZooLib {
+
+// =================================================================================================
+#pragma mark - ChanRPos_Bin_POSIXMapped
+
+/** Reads from a read-only mmap of an entire file. Its Span aspect provides direct access to
+the mapped bytes. We keep the FDHolder, and thus any lock on the file, for our lifetime. */
+
+class ChanRPos_Bin_POSIXMapped
+:	public virtual ChanRPosSpan<byte>
+	{
+public:
+	// We take ownership of the mapping of iSize bytes at iAddress, and unmap it when we're done.
+	ChanRPos_Bin_POSIXMapped(const ZP<FDHolder>& iFDHolder, const void* iAddress, size_t iSize);
+	virtual ~ChanRPos_Bin_POSIXMapped();
+
+// From ChanAspect_Pos
+	virtual uint64 Pos();
+	virtual void PosSet(uint64 iPos);
+
+// From ChanAspect_Read<byte>
+	virtual size_t Read(byte* oDest, size_t iCount);
+	virtual uint64 Skip(uint64 iCount);
+	virtual size_t Readable();
+
+// From ChanAspect_Size
+	virtual uint64 Size();
+
+// From ChanAspect_Span<byte>
+	virtual PaC<const byte> Span();
+
+// From ChanAspect_Unread<byte>
+	virtual size_t Unread(const byte* iSource, size_t iCount);
+
+// Our protocol
+	void Advise(File::Advice iAdvice);
+	void Advise(File::Advice iAdvice, uint64 iOffset, uint64 iCount);
+
+protected:
+	const ZP<FDHolder> fFDHolder;
+	const byte* fAddress;
+	const size_t fSize;
+	uint64 fPosition;
+	};
+
+// =================================================================================================
+#pragma mark - sChannerRPos_Bin_POSIXMapped
+
+/// Returns null if iFDHolder does not reference a non-empty regular file, or it can't be mapped.
+ZP<ChannerRPos_Bin> sChannerRPos_Bin_POSIXMapped(
+	const ZP<FDHolder>& iFDHolder, File::Advice iAdvice);
+
+} // namespace ZooLib
+
+#endif // ZCONFIG_SPI_Enabled(POSIX)
+
+#endif // __ZooLib_POSIX_Chan_Bin_POSIXMapped_h__
@@ -23,6 +23,7 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #if ZCONFIG_API_Enabled(File_POSIX)
 
 #include "zoolib/POSIX/Chan_Bin_POSIXFD.h"
+#include "zoolib/POSIX/Chan_Bin_POSIXMapped.h"
 #include "zoolib/POSIX/Compat_fcntl.h"
 
 #include <cstring>
@@ -787,6 +788,19 @@ ZP<ChannerRPos_Bin> FileLoc_POSIX::OpenRPos(bool iPreventWriters)
 	return null;
 	}
 
+ZP<ChannerRPos_Bin> FileLoc_POSIX::OpenRMapped(bool iPreventWriters, File::Advice iAdvice)
+	{
+	if (ZP<FDHolder> theFDHolder = spOpen(this->pGetPath().c_str(), true, false, iPreventWriters))
+		{
+		if (ZP<ChannerRPos_Bin> theChanner = sChannerRPos_Bin_POSIXMapped(theFDHolder, iAdvice))
+			return theChanner;
+
+		// Not something that can be mapped (a device, a FIFO, /proc entry), so just read it.
+		return sChanner_T<ChanRPos_Bin_POSIXFD>(theFDHolder);
+		}
+	return null;
+	}
+
 ZP<ChannerWPos_Bin> FileLoc_POSIX::OpenWPos(bool iPreventWriters)
 	{
 	if (ZP<FDHolder> theFDHolder = spOpen(this->pGetPath().c_str(), false, true, iPreventWriters))
@@ -86,6 +86,7 @@ public:
 	virtual bool Delete();
 
 	virtual ZP<ChannerRPos_Bin> OpenRPos(bool iPreventWriters);
+	virtual ZP<ChannerRPos_Bin> OpenRMapped(bool iPreventWriters, File::Advice iAdvice);
 	virtual ZP<ChannerWPos_Bin> OpenWPos(bool iPreventWriters);
 	virtual ZP<ChannerRWPos_Bin> OpenRWPos(bool iPreventWriters);
 
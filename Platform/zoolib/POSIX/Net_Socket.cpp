@@ -31,6 +31,7 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <unistd.h>
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 using std::string;
 
@@ -47,6 +48,24 @@ namespace ZooLib {
 // has closed can cause delivery of a sigpipe. These helper functions, and the conditional
 // code in the NetEndpoint_Socket constructor, work around that issue.
 
+// sendmsg takes at most IOV_MAX fragments, so we pass no more than this many at once.
+static const size_t kMaxFragments = 64;
+
+static void spInitMsg(
+	msghdr& oMsg, iovec* oIOV, const PaC<const byte>* iSources, size_t iCount)
+	{
+	const size_t countFragments = std::min(iCount, kMaxFragments);
+	for (size_t xx = 0; xx < countFragments; ++xx)
+		{
+		oIOV[xx].iov_base = const_cast<byte*>(sPointer(iSources[xx]));
+		oIOV[xx].iov_len = sCount(iSources[xx]);
+		}
+
+	sMemZero_T(oMsg);
+	oMsg.msg_iov = oIOV;
+	oMsg.msg_iovlen = countFragments;
+	}
+
 #ifdef __APPLE__
 // For MacOS X we set an option on the socket to indicate that sigpipe should not
 // be delivered when the far end closes on us. That option was not defined in headers
@@ -72,6 +91,14 @@ static void spSetSocketOptions(int iSocket)
 ssize_t Net_Socket::sSend(int iSocket, const char* iSource, size_t iCount)
 	{ return ::send(iSocket, iSource, iCount, 0); }
 
+ssize_t Net_Socket::sSendV(int iSocket, const PaC<const byte>* iSources, size_t iCount)
+	{
+	msghdr theMsg;
+	iovec theIOV[kMaxFragments];
+	spInitMsg(theMsg, theIOV, iSources, iCount);
+	return ::sendmsg(iSocket, &theMsg, 0);
+	}
+
 ssize_t Net_Socket::sReceive(int iSocket, char* oDest, size_t iCount)
 	{ return ::recv(iSocket, oDest, iCount, 0); }
 
@@ -125,6 +152,37 @@ ssize_t Net_Socket::sSend(int iSocket, const char* iSource, size_t iCount)
 		}
 	}
 
+ssize_t Net_Socket::sSendV(int iSocket, const PaC<const byte>* iSources, size_t iCount)
+	{
+	msghdr theMsg;
+	iovec theIOV[kMaxFragments];
+	spInitMsg(theMsg, theIOV, iSources, iCount);
+
+	if (spCanUse_MSG_NOSIGNAL)
+		{
+		return ::sendmsg(iSocket, &theMsg, MSG_NOSIGNAL);
+		}
+	else if (spChecked_MSG_NOSIGNAL)
+		{
+		return ::sendmsg(iSocket, &theMsg, 0);
+		}
+	else
+		{
+		int result = ::sendmsg(iSocket, &theMsg, MSG_NOSIGNAL);
+		if (result >= 0)
+			{
+			spCanUse_MSG_NOSIGNAL = true;
+			spChecked_MSG_NOSIGNAL = true;
+			}
+		else if (errno == EINVAL)
+			{
+			spChecked_MSG_NOSIGNAL = true;
+			return ::sendmsg(iSocket, &theMsg, 0);
+			}
+		return result;
+		}
+	}
+
 ssize_t Net_Socket::sReceive(int iSocket, char* oDest, size_t iCount)
 	{
 	if (spCanUse_MSG_NOSIGNAL)
@@ -344,6 +402,41 @@ size_t NetEndpoint_Socket::Write(const byte* iSource, size_t iCount)
 	return localSource - (const char*)iSource;
 	}
 
+size_t NetEndpoint_Socket::WriteV(const PaC<const byte>* iSources, size_t iCount)
+	{
+	// Skip leading empty fragments, so a zero result from the socket can only mean it's closed.
+	while (iCount && not sCount(*iSources))
+		{
+		++iSources;
+		--iCount;
+		}
+
+	while (iCount)
+		{
+		const ssize_t result = Net_Socket::sSendV(fSocketFD, iSources, iCount);
+
+		if (result < 0)
+			{
+			const int err = errno;
+			if (err == EAGAIN)
+				Util_POSIXFD::sWaitWriteable(fSocketFD, 10);
+			else if (err != EINTR)
+				break;
+			}
+		else if (result == 0)
+			{
+			// result is zero, indicating that the other end has closed its receive side.
+			break;
+			}
+		else
+			{
+			// Partial progress is fine, our caller (generally sWriteVFully) picks up from here.
+			return result;
+			}
+		}
+	return 0;
+	}
+
 void NetEndpoint_Socket::Abort()
 	{
 	// Cause a RST to be sent when we close().
@@ -392,6 +485,9 @@ void NetEndpoint_Socket::DisconnectWrite()
 bool NetEndpoint_Socket::WaitReadable(double iTimeout)
 	{ return Util_POSIXFD::sWaitReadable(fSocketFD, iTimeout); }
 
+ZP<FDHolder> NetEndpoint_Socket::GetFDHolder()
+	{ return new FDHolder_Std(fSocketFD); }
+
 int NetEndpoint_Socket::GetSocketFD()
 	{ return fSocketFD; }
 
@@ -38,6 +38,8 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/ZThread.h"
 
+#include "zoolib/POSIX/Chan_Bin_POSIXFD.h" // For FDHolderProvider
+
 namespace ZooLib {
 
 // =================================================================================================
@@ -47,6 +49,7 @@ class Net_Socket
 	{
 public:
 	static ssize_t sSend(int iSocket, const char* iSource, size_t iCount);
+	static ssize_t sSendV(int iSocket, const PaC<const byte>* iSources, size_t iCount);
 	static ssize_t sReceive(int iSocket, char* oDest, size_t iCount);
 //	static bool sWaitReadable(int iSocket, double iTimeout);
 //	static void sWaitWriteable(int iSocket);
@@ -88,6 +91,7 @@ ZP<NetListener_Socket> sNetListener_Socket(int iFD);
 
 class NetEndpoint_Socket
 :	public ChannerConnection_Bin
+,	public FDHolderProvider
 	{
 public:
 	NetEndpoint_Socket(int iSocketFD);
@@ -99,6 +103,7 @@ public:
 
 // From ChanW_Bin
 	virtual size_t Write(const byte* iSource, size_t iCount);
+	virtual size_t WriteV(const PaC<const byte>* iSources, size_t iCount);
 
 // From ChanClose
 	virtual void Abort();
@@ -108,6 +113,9 @@ public:
 // From ChanAspect_WaitReadable
 	virtual bool WaitReadable(double iTimeout);
 
+// From FDHolderProvider
+	virtual ZP<FDHolder> GetFDHolder();
+
 // Our protocol
 	int GetSocketFD();
 
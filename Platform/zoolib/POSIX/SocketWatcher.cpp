@@ -20,46 +20,128 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/POSIX/SocketWatcher.h"
 
+#include "zoolib/ZDebug.h"
 #include "zoolib/ZMACRO_foreach.h"
 
-// We may want to override FD_SETSIZE, so we can handle > 1024 fds at once.
+#include <errno.h>
+#include <unistd.h>
 
-// See comment in Solaris' /usr/include/sys/ioctl.h
-#if __sun__
-	#define BSD_COMP
-#endif
+#include <stdexcept> // For runtime_error
+
+
+#if ZCONFIG_SocketWatcher_UseEPoll
+
+	#include <sys/epoll.h>
+	#include <sys/eventfd.h>
+
+#else
+
+	// See comment in Solaris' /usr/include/sys/ioctl.h
+	#if __sun__
+		#define BSD_COMP
+	#endif
 
-#include <sys/ioctl.h>
-#include <sys/select.h>
+	#include <sys/ioctl.h>
+	#include <sys/select.h>
 
-#include <set>
+	#ifndef FD_COPY
+		#include "zoolib/Memory.h"
+		#define FD_COPY(a, b) sMemCopy(b, a, sizeof(fd_set))
+	#endif
 
-#ifndef FD_COPY
-	#include "zoolib/ZMemory.h"
-	#define FD_COPY(a, b) sMemCopy(a, b, sizeof(fd_set))
 #endif
 
 namespace ZooLib {
 
-using std::pair;
+using std::runtime_error;
 using std::set;
 
 // =================================================================================================
 #pragma mark - SocketWatcher
 
 SocketWatcher::SocketWatcher()
-:	fThreadRunning(false)
+:	SocketWatcher(1)
 	{}
 
+SocketWatcher::SocketWatcher(size_t iThreadCount)
+#if ZCONFIG_SocketWatcher_UseEPoll
+:	fThreadCount(iThreadCount ? iThreadCount : 1)
+#else
+:	fThreadCount(1)
+#endif
+,	fThreadsRunning(0)
+,	fShutdown(false)
+	{
+	#if ZCONFIG_SocketWatcher_UseEPoll
+		fEPollFD = ::epoll_create1(EPOLL_CLOEXEC);
+		if (fEPollFD < 0)
+			throw runtime_error("SocketWatcher, epoll_create1 failed");
+
+		fEventFD = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (fEventFD < 0)
+			{
+			::close(fEPollFD);
+			throw runtime_error("SocketWatcher, eventfd failed");
+			}
+
+		struct epoll_event theEvent = {};
+		theEvent.events = EPOLLIN;
+		theEvent.data.fd = fEventFD;
+		if (0 > ::epoll_ctl(fEPollFD, EPOLL_CTL_ADD, fEventFD, &theEvent))
+			{
+			::close(fEventFD);
+			::close(fEPollFD);
+			throw runtime_error("SocketWatcher, epoll_ctl failed");
+			}
+	#endif
+	}
+
+SocketWatcher::~SocketWatcher()
+	{
+	ZAcqMtx acq(fMtx);
+	fShutdown = true;
+
+	#if ZCONFIG_SocketWatcher_UseEPoll
+		// The eventfd is level-triggered and never drained, so every thread sees it.
+		const uint64_t theOne = 1;
+		while (sizeof(theOne) != ::write(fEventFD, &theOne, sizeof(theOne)))
+			ZAssert(errno == EINTR);
+	#endif
+
+	fCnd.Broadcast();
+	while (fThreadsRunning)
+		fCnd.Wait(fMtx);
+
+	#if ZCONFIG_SocketWatcher_UseEPoll
+		::close(fEventFD);
+		::close(fEPollFD);
+	#endif
+	}
+
 bool SocketWatcher::QInsert(const Pair_t& iPair)
 	{
 	ZAcqMtx acq(fMtx);
-	if (not fSet.insert(iPair).second)
+	set<ZP<Callable_Void>>& theCallables = fMap[iPair.first];
+	const bool wasEmpty = theCallables.empty();
+	if (not theCallables.insert(iPair.second).second)
 		return false;
 
-	if (not fThreadRunning)
+	if (wasEmpty)
 		{
-		fThreadRunning = true;
+		try
+			{
+			this->pArm(iPair.first);
+			}
+		catch (...)
+			{
+			fMap.erase(iPair.first);
+			throw;
+			}
+		}
+
+	while (fThreadsRunning < fThreadCount)
+		{
+		++fThreadsRunning;
 		ZThread::sStart_T<SocketWatcher*>(spRun, this);
 		}
 	fCnd.Broadcast();
@@ -69,7 +151,19 @@ bool SocketWatcher::QInsert(const Pair_t& iPair)
 bool SocketWatcher::QErase(const Pair_t& iPair)
 	{
 	ZAcqMtx acq(fMtx);
-	return fSet.erase(iPair);
+	Map_t::iterator iter = fMap.find(iPair.first);
+	if (iter == fMap.end())
+		return false;
+
+	if (not iter->second.erase(iPair.second))
+		return false;
+
+	if (iter->second.empty())
+		{
+		fMap.erase(iter);
+		this->pDisarm(iPair.first);
+		}
+	return true;
 	}
 
 bool SocketWatcher::QInsert(int iSocket, const ZP<Callable_Void>& iCallable)
@@ -78,19 +172,102 @@ bool SocketWatcher::QInsert(int iSocket, const ZP<Callable_Void>& iCallable)
 bool SocketWatcher::QErase(int iSocket, const ZP<Callable_Void>& iCallable)
 	{ return this->QErase(Pair_t(iSocket, iCallable)); }
 
+#if ZCONFIG_SocketWatcher_UseEPoll
+
+void SocketWatcher::pArm(int iSocket)
+	{
+	// Registrations persist -- a socket that's fired is left in the epoll set but disarmed
+	// by EPOLLONESHOT, and is rearmed here with EPOLL_CTL_MOD. If the socket was closed in
+	// the interim the kernel will have dropped it, and we fall back to EPOLL_CTL_ADD.
+	struct epoll_event theEvent = {};
+	theEvent.events = EPOLLIN | EPOLLPRI | EPOLLET | EPOLLONESHOT;
+	theEvent.data.fd = iSocket;
+	if (0 == ::epoll_ctl(fEPollFD, EPOLL_CTL_MOD, iSocket, &theEvent))
+		return;
+
+	if (errno != ENOENT || 0 > ::epoll_ctl(fEPollFD, EPOLL_CTL_ADD, iSocket, &theEvent))
+		throw runtime_error("SocketWatcher, epoll_ctl failed");
+	}
+
+void SocketWatcher::pDisarm(int iSocket)
+	{
+	// ENOENT and EBADF just mean the socket was closed, and the kernel has already dropped it.
+	if (0 > ::epoll_ctl(fEPollFD, EPOLL_CTL_DEL, iSocket, nullptr)
+		&& errno != ENOENT && errno != EBADF)
+		{
+		throw runtime_error("SocketWatcher, epoll_ctl failed");
+		}
+	}
+
+void SocketWatcher::pRun()
+	{
+	const int kMaxEvents = 64;
+	struct epoll_event theEvents[kMaxEvents];
+
+	for (;;)
+		{
+		// Wait 100ms at most, so we notice when there's nothing pending.
+		const int count = ::epoll_wait(fEPollFD, theEvents, kMaxEvents, 100);
+
+		ZAcqMtx acq(fMtx);
+		if (fShutdown || (count <= 0 && fMap.empty()))
+			{
+			// Shutting down, or nothing's pending, exit thread.
+			--fThreadsRunning;
+			fCnd.Broadcast();
+			break;
+			}
+
+		// Gather the callables
+		set<ZP<Callable_Void>> toCall;
+		for (int xx = 0; xx < count; ++xx)
+			{
+			const int theFD = theEvents[xx].data.fd;
+			if (theFD == fEventFD)
+				continue;
+
+			Map_t::iterator iter = fMap.find(theFD);
+			if (iter == fMap.end())
+				continue;
+
+			toCall.insert(iter->second.begin(), iter->second.end());
+			fMap.erase(iter);
+			}
+
+		ZRelMtx rel(fMtx);
+		this->pCall(toCall);
+		}
+	}
+
+#else // ZCONFIG_SocketWatcher_UseEPoll
+
+void SocketWatcher::pArm(int iSocket)
+	{}
+
+void SocketWatcher::pDisarm(int iSocket)
+	{}
+
 void SocketWatcher::pRun()
 	{
 	ZAcqMtx acq(fMtx);
 	for (;;)
 		{
-		if (fSet.empty())
+		if (fShutdown)
+			{
+			--fThreadsRunning;
+			fCnd.Broadcast();
+			break;
+			}
+
+		if (fMap.empty())
 			{
 			// Nothing pending, wait 100ms in case something else comes along.
 			fCnd.WaitFor(fMtx, 0.1);
-			if (fSet.empty())
+			if (fMap.empty() || fShutdown)
 				{
 				// Still nothing pending, exit thread.
-				fThreadRunning = false;
+				--fThreadsRunning;
+				fCnd.Broadcast();
 				break;
 				}
 			}
@@ -99,12 +276,12 @@ void SocketWatcher::pRun()
 			fd_set readSet;
 			FD_ZERO(&readSet);
 			int largest = 0;
-			foreacha (entry, fSet)
+			foreacha (entry, fMap)
 				{
 				const int theFD = entry.first;
 				if (largest < theFD)
 					largest = theFD;
-				FD_SET(entry.first, &readSet);
+				FD_SET(theFD, &readSet);
 				}
 
 			fd_set exceptSet;
@@ -128,45 +305,37 @@ void SocketWatcher::pRun()
 
 			// Gather the callables
 			set<ZP<Callable_Void>> toCall;
-
-			for (int fd = 1; fd <= largest; ++fd)
+			for (Map_t::iterator iter = fMap.begin(); iter != fMap.end(); /*no inc*/)
 				{
-				if (FD_ISSET(fd, &readSet))
+				const int theFD = iter->first;
+				if (FD_ISSET(theFD, &readSet) || FD_ISSET(theFD, &exceptSet))
 					{
-					--count;
-					if (FD_ISSET(fd, &exceptSet))
-						--count;
+					toCall.insert(iter->second.begin(), iter->second.end());
+					iter = fMap.erase(iter);
 					}
-				else if (FD_ISSET(fd, &exceptSet))
-					{ --count; }
 				else
-					{ continue; }
-
-				const Set_t::iterator iterBegin = fSet.lower_bound(Pair_t(fd, null));
-				Set_t::iterator iter = iterBegin;
-				const Set_t::iterator iterEnd = fSet.end();
-				while (iter->first == fd and iter != iterEnd)
 					{
-					if (iter->second)
-						toCall.insert(iter->second);
 					++iter;
 					}
-				fSet.erase(iterBegin, iterEnd);
-
-				if (count <= 0)
-					break;
 				}
 
 			ZRelMtx rel(fMtx);
-			foreacha (entry, toCall)
-				{
-				try { entry->Call(); }
-				catch (...) {}
-				}
+			this->pCall(toCall);
 			}
 		}
 	}
 
+#endif // ZCONFIG_SocketWatcher_UseEPoll
+
+void SocketWatcher::pCall(set<ZP<Callable_Void>>& ioCallables)
+	{
+	foreacha (entry, ioCallables)
+		{
+		try { entry->Call(); }
+		catch (...) {}
+		}
+	}
+
 void SocketWatcher::spRun(SocketWatcher* iSocketWatcher)
 	{
 	ZThread::sSetName("SocketWatcher");
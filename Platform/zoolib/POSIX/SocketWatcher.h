@@ -28,17 +28,29 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/ZThread.h"
 
 #include <set>
+#include <unordered_map>
+
+// Use epoll where it's available, otherwise fall back to select.
+#ifndef ZCONFIG_SocketWatcher_UseEPoll
+	#define ZCONFIG_SocketWatcher_UseEPoll ZCONFIG_SPI_Enabled(Linux)
+#endif
 
 namespace ZooLib {
 
 // =================================================================================================
 #pragma mark - SocketWatcher
 
+// When a registered socket becomes readable (or has an exceptional condition) every
+// callable registered against it is called once, and the registrations are removed.
+// iThreadCount watcher threads share the dispatch; the select fallback always uses one.
+
 class SocketWatcher
 :	NonCopyable
 	{
 public:
 	SocketWatcher();
+	SocketWatcher(size_t iThreadCount);
+	~SocketWatcher();
 
 	typedef std::pair<int,ZP<Callable_Void>> Pair_t;
 
@@ -56,12 +68,25 @@ private:
 	void pRun();
 	static void spRun(SocketWatcher* iSocketWatcher);
 
+	void pArm(int iSocket);
+	void pDisarm(int iSocket);
+
+	void pCall(std::set<ZP<Callable_Void>>& ioCallables);
+
 	ZMtx fMtx;
 	ZCnd fCnd;
 
-	bool fThreadRunning;
-	typedef std::set<Pair_t> Set_t;
-	Set_t fSet;
+	const size_t fThreadCount;
+	size_t fThreadsRunning;
+	bool fShutdown;
+
+	typedef std::unordered_map<int,std::set<ZP<Callable_Void>>> Map_t;
+	Map_t fMap;
+
+	#if ZCONFIG_SocketWatcher_UseEPoll
+		int fEPollFD;
+		int fEventFD;
+	#endif
 	};
 
 } // namespace ZooLib
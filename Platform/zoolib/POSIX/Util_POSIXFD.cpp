@@ -45,8 +45,16 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <sys/ioctl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h> // For writev
 #include <unistd.h>
 
+#if defined(linux) || defined(__linux__)
+	#include <fcntl.h> // For splice
+	#include <pthread.h> // For pthread_sigmask
+	#include <signal.h>
+	#include <sys/sendfile.h>
+#endif
+
 // AG 2005-01-04. It looks like poll.h is not always present on MacOS X.
 // We don't use poll on MacOS, so we can just skip the include for now.
 #ifndef __APPLE__
@@ -327,6 +335,256 @@ size_t sWriteCon(int iFD, const byte* iSource, size_t iCount)
 	return localSource - iSource;
 	}
 
+static size_t spWriteV(int iFD, const PaC<const byte>* iSources, size_t iCount, bool iWait)
+	{
+	size_t result = 0;
+
+	// How much of *iSources has already been written.
+	size_t countDone = 0;
+
+	while (iCount)
+		{
+		iovec theIOVs[64];
+		size_t countIOVs = 0;
+		for (/*no init*/; countIOVs < countof(theIOVs) && countIOVs < iCount; ++countIOVs)
+			{
+			const size_t offset = countIOVs ? 0 : countDone;
+			theIOVs[countIOVs].iov_base = (void*)(sPointer(iSources[countIOVs]) + offset);
+			theIOVs[countIOVs].iov_len = sCount(iSources[countIOVs]) - offset;
+			}
+
+		const ssize_t countWritten = ::writev(iFD, theIOVs, countIOVs);
+		if (countWritten < 0)
+			{
+			const int err = errno;
+			if (err == EAGAIN && iWait)
+				sWaitWriteable(iFD, 10);
+			else if (err != EINTR)
+				break;
+			continue;
+			}
+
+		result += countWritten;
+
+		// Step past what was written. Empty fragments are stepped past too, so a zero
+		// result only stops us if the leading fragment had something in it.
+		const PaC<const byte>* priorSources = iSources;
+		size_t countRemaining = countWritten;
+		while (iCount && countRemaining >= sCount(*iSources) - countDone)
+			{
+			countRemaining -= sCount(*iSources) - countDone;
+			countDone = 0;
+			++iSources;
+			--iCount;
+			}
+		countDone += countRemaining;
+
+		if (countWritten == 0 && iSources == priorSources)
+			break;
+		}
+	return result;
+	}
+
+size_t sWriteV(int iFD, const PaC<const byte>* iSources, size_t iCount)
+	{ return spWriteV(iFD, iSources, iCount, false); }
+
+size_t sWriteVCon(int iFD, const PaC<const byte>* iSources, size_t iCount)
+	{ return spWriteV(iFD, iSources, iCount, true); }
+
+#if defined(linux) || defined(__linux__)
+
+namespace { // anonymous
+
+// Writing to a socket whose peer has gone raises SIGPIPE, which by default kills the process.
+// sendfile, splice and write have no MSG_NOSIGNAL equivalent, so while copying we block SIGPIPE
+// on this thread, and consume any instance we caused before unblocking it.
+class SIGPIPE_Blocker
+	{
+public:
+	SIGPIPE_Blocker()
+		{
+		sigemptyset(&fSet);
+		sigaddset(&fSet, SIGPIPE);
+		sigset_t prior;
+		::pthread_sigmask(SIG_BLOCK, &fSet, &prior);
+		// If it was already blocked then any pending instance isn't ours to discard.
+		fWasBlocked = sigismember(&prior, SIGPIPE);
+		}
+
+	~SIGPIPE_Blocker()
+		{
+		if (fWasBlocked)
+			return;
+
+		const struct timespec zero = { 0, 0 };
+		while (::sigtimedwait(&fSet, nullptr, &zero) < 0 && errno == EINTR)
+			{}
+
+		::pthread_sigmask(SIG_UNBLOCK, &fSet, nullptr);
+		}
+
+private:
+	sigset_t fSet;
+	bool fWasBlocked;
+	};
+
+} // anonymous namespace
+
+// sendfile requires a source that can be mmapped, which in practice means a regular file.
+// Returns false if it's not applicable and nothing has been moved.
+static bool spQCopy_sendfile(int iSourceFD, int iDestFD, uint64 iCount, uint64& ioCountCopied)
+	{
+	while (ioCountCopied < iCount)
+		{
+		const ssize_t result = ::sendfile(iDestFD, iSourceFD, nullptr,
+			sMin<uint64>(iCount - ioCountCopied, 1 << 30));
+
+		if (result > 0)
+			{
+			ioCountCopied += result;
+			}
+		else if (result == 0)
+			{
+			break;
+			}
+		else
+			{
+			const int err = errno;
+			if (err == EAGAIN)
+				sWaitWriteable(iDestFD, 10);
+			else if ((err == EINVAL || err == ENOSYS) && ioCountCopied == 0)
+				return false;
+			else if (err != EINTR)
+				break;
+			}
+		}
+	return true;
+	}
+
+// Writes the iCount bytes sitting in iPipeFD to iDestFD. Returns false if it fell short.
+static bool spQDrain(int iPipeFD, int iDestFD, size_t iCount, uint64& ioCountCopied)
+	{
+	byte buf[sStackBufferSize];
+	while (iCount)
+		{
+		const size_t countRead = sReadCon(iPipeFD, buf, sMin(iCount, sizeof(buf)));
+		if (not countRead)
+			return false;
+
+		const size_t countWritten = sWriteCon(iDestFD, buf, countRead);
+		ioCountCopied += countWritten;
+		if (countWritten < countRead)
+			return false;
+
+		iCount -= countRead;
+		}
+	return true;
+	}
+
+// splice requires that one end be a pipe, so we move the data through one of our own.
+// Returns false if it's not applicable, with anything already moved counted in ioCountCopied.
+static bool spQCopy_splice(int iSourceFD, int iDestFD, uint64 iCount, uint64& ioCountCopied)
+	{
+	int thePipe[2];
+	if (0 != ::pipe(thePipe))
+		return false;
+
+	bool result = true;
+	while (ioCountCopied < iCount)
+		{
+		const ssize_t countIn = ::splice(iSourceFD, nullptr, thePipe[1], nullptr,
+			sMin<uint64>(iCount - ioCountCopied, 64 * 1024), SPLICE_F_MOVE);
+
+		if (countIn == 0)
+			break;
+
+		if (countIn < 0)
+			{
+			const int err = errno;
+			if (err == EAGAIN)
+				{
+				sWaitReadable(iSourceFD, 10);
+				continue;
+				}
+			if (err == EINTR)
+				continue;
+			// Our pipe is empty at this point, so nothing is lost by falling back.
+			if (err == EINVAL || err == ENOSYS)
+				result = false;
+			break;
+			}
+
+		ssize_t countInPipe = countIn;
+		while (countInPipe)
+			{
+			const ssize_t countOut = ::splice(thePipe[0], nullptr, iDestFD, nullptr,
+				countInPipe, SPLICE_F_MOVE);
+			if (countOut > 0)
+				{
+				countInPipe -= countOut;
+				ioCountCopied += countOut;
+				}
+			else if (countOut < 0 && errno == EAGAIN)
+				{
+				sWaitWriteable(iDestFD, 10);
+				}
+			else if (countOut < 0 && (errno == EINVAL || errno == ENOSYS))
+				{
+				// The destination can't be spliced to, e.g. it was opened with O_APPEND. Write
+				// what we've already taken from the source, then fall back to read and write.
+				result = not spQDrain(thePipe[0], iDestFD, countInPipe, ioCountCopied);
+				::close(thePipe[0]);
+				::close(thePipe[1]);
+				return result;
+				}
+			else if (countOut == 0 || errno != EINTR)
+				{
+				// The destination failed. What's in the pipe is lost, as it
+				// would be had we read it into a buffer and failed to write it.
+				::close(thePipe[0]);
+				::close(thePipe[1]);
+				return true;
+				}
+			}
+		}
+
+	::close(thePipe[0]);
+	::close(thePipe[1]);
+	return result;
+	}
+
+#endif // defined(linux) || defined(__linux__)
+
+uint64 sCopy(int iSourceFD, int iDestFD, uint64 iCount)
+	{
+	uint64 countCopied = 0;
+
+	#if defined(linux) || defined(__linux__)
+		const SIGPIPE_Blocker theBlocker;
+
+		if (spQCopy_sendfile(iSourceFD, iDestFD, iCount, countCopied))
+			return countCopied;
+
+		if (spQCopy_splice(iSourceFD, iDestFD, iCount, countCopied))
+			return countCopied;
+	#endif
+
+	byte buf[sStackBufferSize];
+	while (countCopied < iCount)
+		{
+		const size_t countRead =
+			sReadCon(iSourceFD, buf, sMin<uint64>(iCount - countCopied, sizeof(buf)));
+		if (not countRead)
+			break;
+
+		const size_t countWritten = sWriteCon(iDestFD, buf, countRead);
+		countCopied += countWritten;
+		if (countWritten < countRead)
+			break;
+		}
+	return countCopied;
+	}
+
 } // namespace Util_POSIXFD
 } // namespace ZooLib
 
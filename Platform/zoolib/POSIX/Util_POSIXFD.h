@@ -28,6 +28,7 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <sys/select.h> // For fd_set
 
 #include "zoolib/ZStdInt.h" // For uint64 and size_t
+#include "zoolib/ZTypes.h" // For PaC
 
 namespace ZooLib {
 namespace Util_POSIXFD {
@@ -54,6 +55,13 @@ size_t sUnread(int iFD, const byte* iSource, size_t iCount);
 size_t sUnreadableLimit(int iFD);
 size_t sWrite(int iFD, const byte* iSource, size_t iCount);
 size_t sWriteCon(int iFD, const byte* iSource, size_t iCount);
+size_t sWriteV(int iFD, const PaC<const byte>* iSources, size_t iCount);
+size_t sWriteVCon(int iFD, const PaC<const byte>* iSources, size_t iCount);
+
+// Moves up to iCount bytes from iSourceFD's current position to iDestFD, with sendfile or
+// splice where the platform and the descriptors allow, otherwise via a buffer. Returns the
+// count moved, which is less than iCount only if the source ran dry or the destination failed.
+uint64 sCopy(int iSourceFD, int iDestFD, uint64 iCount);
 
 } // namespace Util_POSIXFD
 } // namespace ZooLib
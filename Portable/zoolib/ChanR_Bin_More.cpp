@@ -27,6 +27,18 @@ namespace ZooLib {
 
 ZQ<std::string> sQReadString(const ChanR_Bin& iChanR, size_t iCount)
 	{
+	if (ChanAspect_Span<byte>* theSpannable = sSpannable(iChanR))
+		{
+		// Construct the string directly from the chan's memory.
+		const PaC<const byte> theSpan = theSpannable->Span();
+		if (sCount(theSpan) >= iCount)
+			{
+			std::string theString((const char*)sPointer(theSpan), iCount);
+			sSkip(iChanR, iCount);
+			return theString;
+			}
+		}
+
 	std::string theString(iCount, 0);
 	if (iCount and iCount != sReadMemFully(iChanR, const_cast<char*>(theString.data()), iCount))
 		return null;
@@ -0,0 +1,239 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#include "zoolib/Chan_Bin_ZLib.h"
+
+#if ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
+#include <stdexcept> // For runtime_error
+
+namespace ZooLib {
+
+using std::max;
+using std::min;
+using std::runtime_error;
+
+// =================================================================================================
+#pragma mark - Helpers (anonymous)
+
+namespace { // anonymous
+
+int spWindowBits(int iWindowBits)
+	{ return max(8, min(15, iWindowBits)); }
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - ChanR_Bin_Inflate
+
+ChanR_Bin_Inflate::ChanR_Bin_Inflate(const ChanR_Bin& iChanR)
+:	inherited(iChanR)
+	{ this->pInit(ZLib::eFormatR_Auto, 15, 8192); }
+
+/**
+\param iBufferSize The maximum number of compressed bytes we read from the source chan at once.
+*/
+ChanR_Bin_Inflate::ChanR_Bin_Inflate(const ChanR_Bin& iChanR,
+	ZLib::EFormatR iFormatR, int iWindowBits, size_t iBufferSize)
+:	inherited(iChanR)
+	{ this->pInit(iFormatR, iWindowBits, iBufferSize); }
+
+ChanR_Bin_Inflate::~ChanR_Bin_Inflate()
+	{ ::inflateEnd(&fState); }
+
+size_t ChanR_Bin_Inflate::Read(byte* oDest, size_t iCount)
+	{
+	fState.next_out = reinterpret_cast<Bytef*>(oDest);
+	fState.avail_out = sClamped(iCount);
+	const size_t countRequested = fState.avail_out;
+
+	// Return as soon as we've produced anything, rather than blocking on
+	// the source for more input than is needed to satisfy this call.
+	while (fState.avail_out == countRequested && countRequested && not fHitEnd)
+		{
+		if (fState.avail_in == 0)
+			{
+			const size_t countRead = sRead(inherited::pGetChan(), &fBuffer[0], fBuffer.size());
+			if (countRead == 0)
+				throw runtime_error("ChanR_Bin_Inflate, source ended within compressed stream");
+			fState.next_in = &fBuffer[0];
+			fState.avail_in = countRead;
+			}
+
+		const int result = ::inflate(&fState, Z_NO_FLUSH);
+		if (result == Z_STREAM_END)
+			{
+			// Consume whatever follows the compressed stream, so a source framed by an enclosing
+			// protocol (e.g. an HTTP body on a kept-alive connection) is left at its own end.
+			fHitEnd = true;
+			fState.avail_in = 0;
+			sSkipAll(inherited::pGetChan());
+			}
+		else if (result != Z_OK && result != Z_BUF_ERROR)
+			throw runtime_error("ChanR_Bin_Inflate, corrupt stream");
+		}
+
+	return countRequested - fState.avail_out;
+	}
+
+uint64 ChanR_Bin_Inflate::Skip(uint64 iCount)
+	{
+	byte buf[sStackBufferSize];
+	return this->Read(buf, min<size_t>(sClamped(iCount), sizeof(buf)));
+	}
+
+size_t ChanR_Bin_Inflate::Readable()
+	{
+	// We can't know how much input will produce output without trying it.
+	return 0;
+	}
+
+void ChanR_Bin_Inflate::pInit(ZLib::EFormatR iFormatR, int iWindowBits, size_t iBufferSize)
+	{
+	fBuffer.resize(max(size_t(1024), min(iBufferSize, size_t(1) << 30)));
+	fHitEnd = false;
+
+	fState.zalloc = nullptr;
+	fState.zfree = nullptr;
+	fState.opaque = nullptr;
+
+	fState.next_in = &fBuffer[0];
+	fState.avail_in = 0;
+
+	fState.next_out = nullptr;
+	fState.avail_out = 0;
+
+	const int windowBits = spWindowBits(iWindowBits);
+	int theWindowBits = windowBits;
+	switch (iFormatR)
+		{
+		case ZLib::eFormatR_Raw: theWindowBits = -windowBits; break;
+		case ZLib::eFormatR_ZLib: theWindowBits = windowBits; break;
+		case ZLib::eFormatR_GZip: theWindowBits = 16 | windowBits; break;
+		case ZLib::eFormatR_Auto: theWindowBits = 32 | windowBits; break;
+		}
+
+	if (Z_OK != ::inflateInit2(&fState, theWindowBits))
+		throw runtime_error("ChanR_Bin_Inflate, inflateInit2 failed");
+	}
+
+// =================================================================================================
+#pragma mark - ChanW_Bin_Deflate
+
+ChanW_Bin_Deflate::ChanW_Bin_Deflate(const ChanW_Bin& iChanW)
+:	inherited(iChanW)
+	{ this->pInit(ZLib::eFormatW_GZip, Z_DEFAULT_COMPRESSION, 15, 8192); }
+
+/**
+\param iBufferSize How much compressed data we accumulate before passing it to the
+destination chan.
+*/
+ChanW_Bin_Deflate::ChanW_Bin_Deflate(const ChanW_Bin& iChanW,
+	ZLib::EFormatW iFormatW, int iLevel, int iWindowBits, size_t iBufferSize)
+:	inherited(iChanW)
+	{ this->pInit(iFormatW, iLevel, iWindowBits, iBufferSize); }
+
+ChanW_Bin_Deflate::~ChanW_Bin_Deflate()
+	{
+	try
+		{
+		this->Finish();
+		}
+	catch (...)
+		{}
+
+	::deflateEnd(&fState);
+	}
+
+size_t ChanW_Bin_Deflate::Write(const byte* iSource, size_t iCount)
+	{
+	if (fFinished)
+		return 0;
+
+	fState.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(iSource));
+	fState.avail_in = sClamped(iCount);
+	const size_t countOffered = fState.avail_in;
+
+	this->pDeflate(Z_NO_FLUSH);
+
+	const size_t countConsumed = countOffered - fState.avail_in;
+	fState.avail_in = 0;
+	return countConsumed;
+	}
+
+void ChanW_Bin_Deflate::Flush()
+	{
+	if (not fFinished && this->pDeflate(Z_SYNC_FLUSH))
+		sFlush(inherited::pGetChan());
+	}
+
+void ChanW_Bin_Deflate::Finish()
+	{
+	if (fFinished)
+		return;
+	fFinished = true;
+
+	if (this->pDeflate(Z_FINISH))
+		sFlush(inherited::pGetChan());
+	}
+
+void ChanW_Bin_Deflate::pInit(
+	ZLib::EFormatW iFormatW, int iLevel, int iWindowBits, size_t iBufferSize)
+	{
+	fBuffer.resize(max(size_t(1024), min(iBufferSize, size_t(1) << 30)));
+	fFinished = false;
+
+	fState.zalloc = nullptr;
+	fState.zfree = nullptr;
+	fState.opaque = nullptr;
+
+	fState.next_in = nullptr;
+	fState.avail_in = 0;
+
+	fState.next_out = &fBuffer[0];
+	fState.avail_out = fBuffer.size();
+
+	const int windowBits = spWindowBits(iWindowBits);
+	int theWindowBits = windowBits;
+	switch (iFormatW)
+		{
+		case ZLib::eFormatW_Raw: theWindowBits = -windowBits; break;
+		case ZLib::eFormatW_ZLib: theWindowBits = windowBits; break;
+		case ZLib::eFormatW_GZip: theWindowBits = 16 | windowBits; break;
+		}
+
+	if (Z_OK != ::deflateInit2(&fState,
+		iLevel, Z_DEFLATED, theWindowBits, 8, Z_DEFAULT_STRATEGY))
+		{
+		throw runtime_error("ChanW_Bin_Deflate, deflateInit2 failed");
+		}
+	}
+
+bool ChanW_Bin_Deflate::pDeflate(int iFlush)
+	{
+	// Standard zlib usage -- keep going till deflate leaves space in our buffer, at which point
+	// it has consumed all its input and, for Z_SYNC_FLUSH and Z_FINISH, emitted all its output.
+	for (;;)
+		{
+		::deflate(&fState, iFlush);
+
+		const bool filled = fState.avail_out == 0;
+		if (const size_t countToWrite = fBuffer.size() - fState.avail_out)
+			{
+			if (countToWrite != sWriteFully(inherited::pGetChan(), &fBuffer[0], countToWrite))
+				{
+				// The destination has closed. Nothing more can usefully be done.
+				fFinished = true;
+				return false;
+				}
+			fState.next_out = &fBuffer[0];
+			fState.avail_out = fBuffer.size();
+			}
+
+		if (not filled)
+			return true;
+		}
+	}
+
+} // namespace ZooLib
+
+#endif // ZCONFIG_API_Enabled(Chan_Bin_ZLib)
@@ -0,0 +1,124 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#ifndef __ZooLib_Chan_Bin_ZLib_h__
+#define __ZooLib_Chan_Bin_ZLib_h__ 1
+#include "zconfig.h"
+#include "zoolib/ZCONFIG_API.h"
+#include "zoolib/ZCONFIG_SPI.h"
+
+#ifndef ZCONFIG_API_Avail__Chan_Bin_ZLib
+	#define ZCONFIG_API_Avail__Chan_Bin_ZLib ZCONFIG_SPI_Enabled(zlib)
+#endif
+
+#ifndef ZCONFIG_API_Desired__Chan_Bin_ZLib
+	#define ZCONFIG_API_Desired__Chan_Bin_ZLib 1
+#endif
+
+#include "zoolib/ChanFilter.h"
+#include "zoolib/ChanR_Bin.h"
+#include "zoolib/ChanW_Bin.h"
+
+#if ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
+#include <zlib.h>
+
+#include <vector>
+
+namespace ZooLib {
+
+// =================================================================================================
+#pragma mark - ZLib
+
+namespace ZLib {
+
+enum EFormatR
+	{
+	eFormatR_Raw,
+	eFormatR_ZLib,
+	eFormatR_GZip,
+	eFormatR_Auto // ZLib or GZip, as indicated by the header.
+	};
+
+enum EFormatW
+	{
+	eFormatW_Raw,
+	eFormatW_ZLib,
+	eFormatW_GZip
+	};
+
+} // namespace ZLib
+
+// =================================================================================================
+#pragma mark - ChanR_Bin_Inflate
+
+/** A read filter that decompresses data read from the source chan. iWindowBits (8 to 15) must
+be at least that used when the data was compressed. Reading ends at the end of the compressed
+stream, at which point the rest of the source is skipped. A corrupt or truncated stream throws
+std::runtime_error. */
+
+class ChanR_Bin_Inflate
+:	public ChanFilter<ChanR_Bin>
+	{
+	typedef ChanFilter<ChanR_Bin> inherited;
+public:
+	ChanR_Bin_Inflate(const ChanR_Bin& iChanR);
+
+	ChanR_Bin_Inflate(const ChanR_Bin& iChanR,
+		ZLib::EFormatR iFormatR, int iWindowBits, size_t iBufferSize);
+
+	virtual ~ChanR_Bin_Inflate();
+
+// From ChanR_Bin
+	virtual size_t Read(byte* oDest, size_t iCount);
+	virtual uint64 Skip(uint64 iCount);
+	virtual size_t Readable();
+
+private:
+	void pInit(ZLib::EFormatR iFormatR, int iWindowBits, size_t iBufferSize);
+
+	z_stream fState;
+	std::vector<Bytef> fBuffer;
+	bool fHitEnd;
+	};
+
+// =================================================================================================
+#pragma mark - ChanW_Bin_Deflate
+
+/** A write filter that compresses data written to it, passing the result to the destination
+chan. iLevel ranges from 1 (fastest) to 9 (smallest), with Z_DEFAULT_COMPRESSION being 6.
+Flush emits everything written so far, at some cost in compression ratio. The stream is
+completed by Finish, or by our destructor if Finish has not been called. */
+
+class ChanW_Bin_Deflate
+:	public ChanFilter<ChanW_Bin>
+	{
+	typedef ChanFilter<ChanW_Bin> inherited;
+public:
+	ChanW_Bin_Deflate(const ChanW_Bin& iChanW);
+
+	ChanW_Bin_Deflate(const ChanW_Bin& iChanW,
+		ZLib::EFormatW iFormatW, int iLevel, int iWindowBits, size_t iBufferSize);
+
+	virtual ~ChanW_Bin_Deflate();
+
+// From ChanW_Bin
+	virtual size_t Write(const byte* iSource, size_t iCount);
+	virtual void Flush();
+
+// Our protocol
+	void Finish();
+
+private:
+	void pInit(ZLib::EFormatW iFormatW, int iLevel, int iWindowBits, size_t iBufferSize);
+	bool pDeflate(int iFlush);
+
+	z_stream fState;
+	std::vector<Bytef> fBuffer;
+	bool fFinished;
+	};
+
+} // namespace ZooLib
+
+#endif // ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
+#endif // __ZooLib_Chan_Bin_ZLib_h__
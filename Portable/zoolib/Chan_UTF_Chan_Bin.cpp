@@ -22,77 +22,60 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/Unicode.h"
 
+#include <algorithm> // For std::copy_n
+
 namespace ZooLib {
 
 // =================================================================================================
-#pragma mark - Static helpers
+#pragma mark - ChanR_UTF_Chan_Bin_UTF8
+
+ChanR_UTF_Chan_Bin_UTF8::ChanR_UTF_Chan_Bin_UTF8(const ChanR_Bin& iChanR_Bin)
+:	fChanR_Bin(iChanR_Bin)
+,	fBufferStart(0)
+,	fBufferEnd(0)
+	{}
 
-static size_t spReadUTF32_UTF8(UTF32* oDest, const size_t iCount,
-	const ChanR_Bin& iChanR_Bin)
+size_t ChanR_UTF_Chan_Bin_UTF8::Read(UTF32* oDest, size_t iCount)
 	{
-	UTF32* localDest = oDest;
-	UTF32* localDestEnd = oDest + iCount;
+	if (not iCount)
+		return 0;
 
-	byte curByte = 0;
-	bool gotByte = false;
-	while (localDest < localDestEnd)
+	for (;;)
 		{
-		if (not gotByte)
+		if (fBufferStart < fBufferEnd)
 			{
-			if (NotQ<byte> theQ = sQRead(iChanR_Bin))
-				break;
-			else
-				curByte = *theQ;
+			size_t countConsumed, countProduced;
+			Unicode::sUTF8ToUTF32(
+				fBuffer + fBufferStart, fBufferEnd - fBufferStart,
+				&countConsumed, nullptr,
+				oDest, iCount,
+				&countProduced);
+
+			fBufferStart += countConsumed;
+			if (countProduced)
+				return countProduced;
 			}
 
-		gotByte = false;
-
-		size_t sequenceLength = Unicode::sUTF8SequenceLength[curByte];
-		if (sequenceLength == 0)
+		// Whatever remains is an incomplete sequence, or nothing at all. Move it to the
+		// front and top up the buffer.
+		const size_t countRemaining = fBufferEnd - fBufferStart;
+		if (countRemaining && fBufferStart)
+			std::copy_n(fBuffer + fBufferStart, countRemaining, fBuffer);
+		fBufferStart = 0;
+		fBufferEnd = countRemaining;
+
+		const size_t countRead =
+			sReadMem(fChanR_Bin, fBuffer + fBufferEnd, kBufferSize - fBufferEnd);
+		if (not countRead)
 			{
-			// It's a continuation or illegal, ignore it.
-			}
-		else if (sequenceLength == 1)
-			{
-			*localDest++ = curByte;
-			}
-		else
-			{
-			UTF32 theCP = curByte & Unicode::sUTF8StartByteMask[sequenceLength];
-			gotByte = false;
-			while (--sequenceLength)
-				{
-				if (NotQ<byte> theQ = sQRead(iChanR_Bin))
-					break;
-				else
-					curByte = *theQ;
-				if ((curByte & 0xC0) != 0x80)
-					{
-					// It's not a legal continuation byte.
-					gotByte = true;
-					break;
-					}
-				theCP <<= 6;
-				theCP += curByte & 0x3F;
-				}
-
-			if (not gotByte)
-				*localDest++ = theCP;
+			// The source is exhausted, and any incomplete sequence is dropped.
+			fBufferEnd = 0;
+			return 0;
 			}
+		fBufferEnd += countRead;
 		}
-	return localDest - oDest;
 	}
 
-// =================================================================================================
-#pragma mark - ZStrimR_StreamUTF8
-
-ChanR_UTF_Chan_Bin_UTF8::ChanR_UTF_Chan_Bin_UTF8(const ChanR_Bin& iChanR_Bin)
-:	fChanR_Bin(iChanR_Bin)
-	{}
-
-size_t ChanR_UTF_Chan_Bin_UTF8::Read(UTF32* oDest, size_t iCount)
-	{ return spReadUTF32_UTF8(oDest, iCount, fChanR_Bin); }
-
 // =================================================================================================
 #pragma mark - ChanW_UTF_Chan_Bin_UTF8
 
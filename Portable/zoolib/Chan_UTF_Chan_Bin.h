@@ -33,6 +33,9 @@ namespace ZooLib {
 
 /// A read strim that sources text by reading UTF-8 code units from a ChanR_Bin.
 
+/** Code units are read from the ChanR_Bin in blocks and decoded en masse, so more may have
+been consumed from it than have been returned as code points. */
+
 class ChanR_UTF_Chan_Bin_UTF8
 :	public ChanR_UTF
 	{
@@ -44,6 +47,11 @@ public:
 
 private:
 	const ChanR_Bin& fChanR_Bin;
+
+	enum { kBufferSize = 4096 };
+	UTF8 fBuffer[kBufferSize];
+	size_t fBufferStart;
+	size_t fBufferEnd;
 	};
 
 // =================================================================================================
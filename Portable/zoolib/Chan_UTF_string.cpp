@@ -38,12 +38,11 @@ ChanRU_UTF_string8::~ChanRU_UTF_string8()
 size_t ChanRU_UTF_string8::Read(UTF32* oDest, size_t iCount)
 	{
 	const size_t theLength = fString.length();
-	if (fPosition >= theLength)
-		{
-		return 0;
-		}
-	else
+	for (;;)
 		{
+		if (fPosition >= theLength)
+			return 0;
+
 		size_t countConsumed;
 		size_t countProduced;
 		Unicode::sUTF8ToUTF32(
@@ -52,7 +51,11 @@ size_t ChanRU_UTF_string8::Read(UTF32* oDest, size_t iCount)
 			oDest, iCount,
 			&countProduced);
 		fPosition += countConsumed;
-		return countProduced;
+
+		// If everything consumed was an invalid code point it was dropped, and returning
+		// zero would look like the end of the string.
+		if (countProduced || not countConsumed)
+			return countProduced;
 		}
 	}
 
@@ -65,7 +68,13 @@ size_t ChanRU_UTF_string8::Unread(const UTF32* iSource, size_t iCount)
 	size_t localCount = 0;
 
 	while (localCount < iCount && Unicode::sDec(stringStart, stringCurrent, stringEnd))
-		++localCount;
+		{
+		// Read drops invalid code points, so they don't count towards iCount.
+		string8::const_iterator probe = stringCurrent;
+		UTF32 theCP;
+		if (Unicode::sReadInc(probe, stringEnd, theCP) && Unicode::sIsValidCP(theCP))
+			++localCount;
+		}
 	fPosition = stringCurrent - stringStart;
 	return localCount;
 	}
@@ -147,6 +147,13 @@ public:
 
 	virtual size_t Write(const EE* iSource, size_t iCount)
 		{
+		if (fOffset && fOffset + iCount > fBuffer.size())
+			{
+			// Rather than topping up the buffer, pass it and the new data on together.
+			const PaC<const EE> theSource(iSource, iCount);
+			return this->WriteV(&theSource, 1);
+			}
+
 		const EE* localSource = iSource;
 		while (iCount)
 			{
@@ -179,6 +186,46 @@ public:
 		return localSource - iSource;
 		}
 
+	virtual size_t WriteV(const PaC<const EE>* iSources, size_t iCount)
+		{
+		size_t countTotal = 0;
+		for (size_t xx = 0; xx < iCount; ++xx)
+			countTotal += sCount(iSources[xx]);
+
+		// If it fits then Write will simply accumulate it.
+		if (fOffset + countTotal <= fBuffer.size())
+			return ChanAspect_Write<EE>::WriteV(iSources, iCount);
+
+		if (fOffset == 0)
+			return sWriteV(inherited::pGetChan(), iSources, iCount);
+
+		// Prefix the fragments with what's buffered, and send everything in one call.
+		PaC<const EE> theSources_Local[8];
+		std::vector<PaC<const EE>> theSources_Heap;
+		PaC<const EE>* theSources = theSources_Local;
+		if (iCount + 1 > countof(theSources_Local))
+			{
+			theSources_Heap.resize(iCount + 1);
+			theSources = &theSources_Heap[0];
+			}
+		theSources[0] = PaC<const EE>(&fBuffer[0], fOffset);
+		std::copy_n(iSources, iCount, theSources + 1);
+
+		const size_t countWritten =
+			sWriteVFully(inherited::pGetChan(), theSources, iCount + 1);
+
+		if (countWritten < fOffset)
+			{
+			// The destination stopped accepting data part way through our buffer.
+			std::copy(&fBuffer[countWritten], &fBuffer[fOffset], &fBuffer[0]);
+			fOffset -= countWritten;
+			return 0;
+			}
+
+		const size_t countBuffered = sGetSet(fOffset, 0);
+		return countWritten - countBuffered;
+		}
+
 	virtual void Flush()
 		{
 		this->pFlush();
@@ -86,6 +86,14 @@ public:
 		return countWritten;
 		}
 
+	virtual size_t WriteV(
+		const PaC<const typename Chan_p::Element_t>* iSources, size_t iCount)
+		{
+		const size_t countWritten = sWriteV(inherited::pGetChan(), iSources, iCount);
+		fCount += countWritten;
+		return countWritten;
+		}
+
 // Our protocol
 	uint64 GetCount()
 		{ return fCount; }
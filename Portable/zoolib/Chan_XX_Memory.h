@@ -32,7 +32,7 @@ namespace ZooLib {
 
 template <class EE>
 class ChanRPos_XX_Memory
-:	public ChanRPos<EE>
+:	public ChanRPosSpan<EE>
 	{
 public:
 	ChanRPos_XX_Memory(const PaC<const EE>& iPaC)
@@ -79,6 +79,14 @@ public:
 	virtual uint64 Size()
 		{ return fSize; }
 
+// From ChanSpan
+	virtual PaC<const EE> Span()
+		{
+		if (fSize > fPosition)
+			return PaC<const EE>(fAddress + fPosition, fSize - fPosition);
+		return PaC<const EE>(fAddress + fSize, 0);
+		}
+
 // From ChanU
 	virtual size_t Unread(const EE* iSource, size_t iCount)
 		{
@@ -0,0 +1,292 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#ifndef __ZooLib_Chan_XX_PipeRing_h__
+#define __ZooLib_Chan_XX_PipeRing_h__ 1
+#include "zconfig.h"
+
+#include "zoolib/Chan.h"
+#include "zoolib/Counted.h"
+#include "zoolib/Time.h"
+
+#include "zoolib/ZThread.h"
+
+#include <atomic>
+#include <vector>
+
+namespace ZooLib {
+
+// =================================================================================================
+#pragma mark - ImpPipeRing
+
+// A bounded single-producer/single-consumer alternative to ImpPipePair. Writes land in a ring
+// of iCapacity elements and return immediately, so the writer only waits when the ring is full,
+// and the reader only when it's empty. Each side spins briefly before parking on a condition.
+
+template <class EE>
+class ImpPipeRing
+:	public Counted
+	{
+public:
+	enum { kSpinCount = 256 };
+
+	ImpPipeRing(size_t iCapacity)
+	:	fBuffer(spCapacity(iCapacity))
+	,	fMask(fBuffer.size() - 1)
+	,	fHead(0)
+	,	fTail(0)
+	,	fReadClosed(false)
+	,	fWriteClosed(false)
+	,	fAborted(false)
+	,	fReaderWaiting(false)
+	,	fWriterWaiting(false)
+		{}
+
+// For ChanAspect_Abort
+	void Abort()
+		{
+		// If the writer has already disconnected then everything it wrote remains
+		// available to the reader.
+		if (not fWriteClosed)
+			fAborted = true;
+		fWriteClosed = true;
+		fReadClosed = true;
+		this->pWakeAll();
+		}
+
+// For ChanAspect_DisconnectRead
+	bool DisconnectRead(double iTimeout)
+		{
+		fReadClosed = true;
+		this->pWakeAll();
+		return true;
+		}
+
+// For ChanAspect_DisconnectWrite
+	void DisconnectWrite()
+		{
+		fWriteClosed = true;
+		this->pWakeAll();
+		}
+
+// For ChanAspect_Read
+	size_t Read(EE* oDest, size_t iCount)
+		{
+		if (not iCount)
+			return 0;
+
+		for (;;)
+			{
+			if (fAborted)
+				return 0;
+
+			const bool writeClosed = fWriteClosed;
+			const size_t tail = fTail.load(std::memory_order_relaxed);
+			const size_t head = fHead;
+			if (head != tail)
+				{
+				const size_t countToCopy = std::min(iCount, head - tail);
+				for (size_t xx = 0; xx < countToCopy; ++xx)
+					{
+					EE& theSlot = fBuffer[(tail + xx) & fMask];
+					oDest[xx] = theSlot;
+					theSlot = EE();
+					}
+				fTail = tail + countToCopy;
+				if (fWriterWaiting)
+					{
+					ZAcqMtx acq(fMutex);
+					fCondition_Write.Broadcast();
+					}
+				return countToCopy;
+				}
+
+			if (writeClosed)
+				return 0;
+
+			this->pWaitReadable(Time::kDay, true);
+			}
+		}
+
+	size_t Readable()
+		{ return fHead - fTail; }
+
+// For ChanAspect_WaitReadable
+	bool WaitReadable(double iTimeout)
+		{ return this->pWaitReadable(iTimeout, false); }
+
+// For ChanAspect_Write
+	size_t Write(const EE* iSource, size_t iCount)
+		{
+		if (not iCount)
+			return 0;
+
+		for (;;)
+			{
+			if (fReadClosed)
+				return 0;
+
+			const size_t head = fHead.load(std::memory_order_relaxed);
+			const size_t tail = fTail;
+			const size_t available = fBuffer.size() - (head - tail);
+			if (available)
+				{
+				const size_t countToCopy = std::min(iCount, available);
+				for (size_t xx = 0; xx < countToCopy; ++xx)
+					fBuffer[(head + xx) & fMask] = iSource[xx];
+				fHead = head + countToCopy;
+				if (fReaderWaiting)
+					{
+					ZAcqMtx acq(fMutex);
+					fCondition_Read.Broadcast();
+					}
+				return countToCopy;
+				}
+
+			this->pWaitWritable();
+			}
+		}
+
+private:
+	static size_t spCapacity(size_t iCapacity)
+		{
+		size_t result = 1;
+		while (result < iCapacity)
+			result <<= 1;
+		return result;
+		}
+
+	bool pReadable()
+		{ return fHead != fTail.load(std::memory_order_relaxed) || fWriteClosed || fAborted; }
+
+	bool pWritable()
+		{ return fHead.load(std::memory_order_relaxed) - fTail != fBuffer.size() || fReadClosed; }
+
+	bool pWaitReadable(double iTimeout, bool iIgnoreTimeout)
+		{
+		for (size_t xx = 0; xx < kSpinCount; ++xx)
+			{
+			if (this->pReadable())
+				return true;
+			}
+
+		const double deadline = Time::sSystem() + iTimeout;
+		ZAcqMtx acq(fMutex);
+		fReaderWaiting = true;
+		bool result = true;
+		while (not this->pReadable())
+			{
+			if (iIgnoreTimeout)
+				{
+				fCondition_Read.Wait(fMutex);
+				}
+			else if (not fCondition_Read.WaitUntil(fMutex, deadline))
+				{
+				result = this->pReadable();
+				break;
+				}
+			}
+		fReaderWaiting = false;
+		return result;
+		}
+
+	void pWaitWritable()
+		{
+		for (size_t xx = 0; xx < kSpinCount; ++xx)
+			{
+			if (this->pWritable())
+				return;
+			}
+
+		ZAcqMtx acq(fMutex);
+		fWriterWaiting = true;
+		while (not this->pWritable())
+			fCondition_Write.Wait(fMutex);
+		fWriterWaiting = false;
+		}
+
+	void pWakeAll()
+		{
+		ZAcqMtx acq(fMutex);
+		fCondition_Read.Broadcast();
+		fCondition_Write.Broadcast();
+		}
+
+	std::vector<EE> fBuffer;
+	const size_t fMask;
+
+	// fHead is advanced only by the writer, fTail only by the reader.
+	std::atomic<size_t> fHead;
+	std::atomic<size_t> fTail;
+
+	std::atomic<bool> fReadClosed;
+	std::atomic<bool> fWriteClosed;
+	std::atomic<bool> fAborted;
+
+	ZMtx fMutex;
+	ZCnd fCondition_Read;
+	ZCnd fCondition_Write;
+	std::atomic<bool> fReaderWaiting;
+	std::atomic<bool> fWriterWaiting;
+	};
+
+// ----------
+
+template <class EE>
+class ChanR_PipeRing
+:	public ChanR<EE>
+	{
+public:
+	ChanR_PipeRing(const ZP<ImpPipeRing<EE>>& iPipeRing)
+	:	fPipeRing(iPipeRing)
+		{}
+
+	virtual ~ChanR_PipeRing()
+		{
+		while (not fPipeRing->DisconnectRead(1 * Time::kDay))
+			{}
+		}
+
+// From ChanAspect_Read
+	virtual size_t Read(EE* oDest, size_t iCount)
+		{ return fPipeRing->Read(oDest, iCount); }
+
+	virtual size_t Readable()
+		{ return fPipeRing->Readable(); }
+
+	ZP<ImpPipeRing<EE>> fPipeRing;
+	};
+
+// ----------
+
+template <class EE>
+class ChanWCon_PipeRing
+:	public ChanWCon<EE>
+	{
+public:
+	ChanWCon_PipeRing(const ZP<ImpPipeRing<EE>>& iPipeRing)
+	:	fPipeRing(iPipeRing)
+		{}
+
+	// ImpPipePair's writer returns only once the reader has taken the data. Ours returns once
+	// it's in the ring, so disconnect rather than abort, and the reader drains what's left.
+	virtual ~ChanWCon_PipeRing()
+		{ fPipeRing->DisconnectWrite(); }
+
+// From ChanAspect_Abort
+	virtual void Abort()
+		{ fPipeRing->Abort(); }
+
+// From ChanAspect_DisconnectWrite
+	virtual void DisconnectWrite()
+		{ return fPipeRing->DisconnectWrite(); }
+
+// From ChanAspect_Write
+	virtual size_t Write(const EE* iSource, size_t iCount)
+		{ return fPipeRing->Write(iSource, iCount); }
+
+	ZP<ImpPipeRing<EE>> fPipeRing;
+	};
+
+} // namespace ZooLib
+
+#endif // __ZooLib_Chan_XX_PipeRing_h__
@@ -468,6 +468,25 @@ ZP<ChannerRPos_Bin> FileSpec::OpenRPos(bool iPreventWriters) const
 	return null;
 	}
 
+/// Return a new ChannerRPos whose content is mapped into memory.
+/**
+Where the file system supports it the returned chan also has a ChanAspect_Span, so that
+consumers can work on the file's content without copying it. Otherwise this is equivalent
+to OpenRPos. \a iAdvice indicates how the content is expected to be accessed.
+
+If the file is truncated by another process while mapped, accessing the
+missing part of the mapping will crash, so consider passing true for \a iPreventWriters.
+*/
+ZP<ChannerRPos_Bin> FileSpec::OpenRMapped(bool iPreventWriters, File::Advice iAdvice) const
+	{
+	if (fLoc)
+		{
+		if (ZP<FileLoc> realLoc = this->pPhysicalLoc())
+			return realLoc->OpenRMapped(iPreventWriters, iAdvice);
+		}
+	return null;
+	}
+
 /// Return a new ChannerW backed by the contents of the file referenced by the file spec.
 ZP<ChannerW_Bin> FileSpec::OpenW(bool iPreventWriters) const
 	{
@@ -735,6 +754,9 @@ ZP<ChannerR_Bin> FileLoc::OpenR(bool iPreventWriters)
 ZP<ChannerRPos_Bin> FileLoc::OpenRPos(bool iPreventWriters)
 	{ return null; }
 
+ZP<ChannerRPos_Bin> FileLoc::OpenRMapped(bool iPreventWriters, File::Advice)
+	{ return this->OpenRPos(iPreventWriters); }
+
 ZP<ChannerW_Bin> FileLoc::OpenW(bool iPreventWriters)
 	{ return this->OpenWPos(iPreventWriters); }
 
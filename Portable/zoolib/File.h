@@ -65,6 +65,15 @@ enum Kind
 	kindDir
 	};
 
+/// How a memory-mapped file is expected to be accessed, see FileSpec::OpenRMapped.
+enum Advice
+	{
+	adviceNormal,
+	adviceSequential,
+	adviceRandom,
+	adviceWillNeed
+	};
+
 } // namespace File
 
 // =================================================================================================
@@ -142,6 +151,8 @@ public:
 	// Open/create with stream API (stateful).
 	ZP<ChannerR_Bin> OpenR(bool iPreventWriters = false) const;
 	ZP<ChannerRPos_Bin> OpenRPos(bool iPreventWriters = false) const;
+	ZP<ChannerRPos_Bin> OpenRMapped(
+		bool iPreventWriters = false, File::Advice iAdvice = File::adviceNormal) const;
 	ZP<ChannerW_Bin> OpenW(bool iPreventWriters = true) const;
 	ZP<ChannerWPos_Bin> OpenWPos(bool iPreventWriters = true) const;
 	ZP<ChannerRWPos_Bin> OpenRWPos(bool iPreventWriters = true) const;
@@ -256,6 +267,7 @@ public:
 
 	virtual ZP<ChannerR_Bin> OpenR(bool iPreventWriters);
 	virtual ZP<ChannerRPos_Bin> OpenRPos(bool iPreventWriters);
+	virtual ZP<ChannerRPos_Bin> OpenRMapped(bool iPreventWriters, File::Advice iAdvice);
 	virtual ZP<ChannerW_Bin> OpenW(bool iPreventWriters);
 	virtual ZP<ChannerWPos_Bin> OpenWPos(bool iPreventWriters);
 	virtual ZP<ChannerRWPos_Bin> OpenRWPos(bool iPreventWriters);
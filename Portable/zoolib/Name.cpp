@@ -20,210 +20,261 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/Name.h"
 
-#include "zoolib/CtorDtor.h"
-#include "zoolib/Default.h"
-
-#include "zoolib/ZDebug.h"
+#include "zoolib/ZThread.h" // For ZMtx
 
+#include <atomic>
 #include <cstring>
 
 namespace ZooLib {
 
-#if ! ZMACRO_NameUsesString
-
 // =================================================================================================
 #pragma mark -
 
-Name& Name::operator=(const Name& iOther)
+static size_t spHash(const char* iChars, size_t iLength)
 	{
-	if (CountedString* self = this->pGetIfCounted())
+	// FNV-1a
+	uint32 result = 2166136261U;
+	for (const char* end = iChars + iLength; iChars != end; ++iChars)
 		{
-		if (const CountedString* other = iOther.pGetIfCounted())
-			{
-			spRetain(other);
-			}
-		else
+		result ^= uint8(*iChars);
+		result *= 16777619U;
+		}
+	return result;
+	}
+
+#if ZMACRO_NameUsesString
+
+// =================================================================================================
+#pragma mark - Name
+
+size_t Name::Hash() const
+	{ return spHash(fString.data(), fString.size()); }
+
+#else // ZMACRO_NameUsesString
+
+// =================================================================================================
+#pragma mark - Name
+
+namespace {
+
+// Each thread remembers the interned entries of the last few literals it has seen, keyed by
+// address. The contents are checked too, in case a caller passes a buffer that's been reused.
+
+struct StaticCache
+	{
+	static const size_t kSlots = 64;
+
+	const char* fStatics[kSlots];
+	const Name::Entry* fEntries[kSlots];
+	};
+
+thread_local StaticCache spStaticCache;
+
+} // anonymous namespace
+
+Name::Name(const char* iStatic)
+	{
+	if (not iStatic || not *iStatic)
+		{
+		fEntry = nullptr;
+		return;
+		}
+
+	const uintptr_t theAddress = reinterpret_cast<uintptr_t>(iStatic);
+	const size_t theSlot = (theAddress ^ (theAddress >> 6)) & (StaticCache::kSlots - 1);
+
+	if (spStaticCache.fStatics[theSlot] == iStatic)
+		{
+		const Entry* theEntry = spStaticCache.fEntries[theSlot];
+		if (0 == std::strcmp(theEntry->fString.c_str(), iStatic))
 			{
-			#if not ZCONFIG_Is64Bit
-				fIsCounted = false;
-			#endif
+			fEntry = theEntry;
+			return;
 			}
-		spRelease(self);
 		}
-	else if (const CountedString* other = iOther.pGetIfCounted())
+
+	fEntry = spIntern(iStatic, std::strlen(iStatic));
+	if (fEntry->fInterned)
 		{
-		spRetain(other);
-		#if not ZCONFIG_Is64Bit
-			fIsCounted = true;
-		#endif
+		spStaticCache.fStatics[theSlot] = iStatic;
+		spStaticCache.fEntries[theSlot] = fEntry;
 		}
-	fIntPtr = iOther.fIntPtr;
-	return *this;
 	}
 
 Name::Name(const string8& iString)
-#if ZCONFIG_Is64Bit
+:	fEntry(spIntern(iString.data(), iString.size()))
+	{}
+
+Name::Name(const ZP<CountedString>& iRefCountedString)
+:	fEntry(nullptr)
 	{
-	CountedString* theCountedString = new CountedString(iString);
-	spRetain(theCountedString);
-	fIntPtr = ((intptr_t)theCountedString) ^ 1ULL<<63;
+	if (iRefCountedString)
+		{
+		const string8& theString = iRefCountedString->Get();
+		fEntry = spIntern(theString.data(), theString.size());
+		}
 	}
-#else
-:	fIsCounted(true)
+
+Name::operator string8() const
 	{
-	CountedString* theCountedString = new CountedString(iString);
-	spRetain(theCountedString);
-	fIntPtr = (intptr_t)theCountedString;
+	if (fEntry)
+		return fEntry->fString;
+	return string8();
 	}
-#endif
 
-Name::Name(const RefCountedString& iRefCountedString)
+int Name::pCompare(const Name& iOther) const
 	{
-	CountedString* theCountedString = iRefCountedString.Get();
-	#if ZCONFIG_Is64Bit
-		if (theCountedString)
-			{
-			spRetain(theCountedString);
-			fIntPtr = ((intptr_t)theCountedString) ^ 1ULL<<63;
-			}
-		else
-			{
-			fIntPtr = 0;
-			}
-	#else
-		if (theCountedString)
-			{
-			spRetain(theCountedString);
-			fIntPtr = (intptr_t)theCountedString;
-			fIsCounted = true;
-			}
-		else
-			{
-			fIntPtr = 0;
-			fIsCounted = false;
-			}
-	#endif
+	if (not fEntry)
+		return iOther.fEntry ? -1 : 0;
+
+	if (not iOther.fEntry)
+		return 1;
+
+	return fEntry->fString.compare(iOther.fEntry->fString);
 	}
 
-Name::operator string8() const
+size_t Name::spHash_Empty()
+	{ return spHash(nullptr, 0); }
+
+// =================================================================================================
+#pragma mark - Name::spIntern
+
+namespace {
+
+// An open-addressed table with linear probing. Slots are only ever filled, never emptied, so a
+// reader can probe without a lock. When the table fills past half it's replaced by one twice
+// the size. The old one is kept, because a reader may still be probing it. The table stops
+// growing once it holds kMaxInterned entries.
+
+struct Table
 	{
-	#if ZCONFIG_Is64Bit
-		if ((bool(fIntPtr & 1ULL<<63)) != (bool(fIntPtr & 1ULL<<62)))
-			return ((const CountedString*)(fIntPtr ^ 1ULL<<63))->Get();
-	#else
-		if (fIsCounted)
-			return ((const CountedString*)fIntPtr)->Get();
-	#endif
-
-	if (fIntPtr)
-		return (const char*)(fIntPtr);
-
-	return sDefault<string8>();
-	}
+	size_t fMask;
+	std::atomic<const Name::Entry*>* fSlots;
+	const Table* fPrior;
+	};
+
+std::atomic<Table*> spTable(nullptr);
+
+const size_t kMaxInterned = 1 << 16;
+
+size_t spCount; // Guarded by spMtx().
 
-Name::operator RefCountedString() const
+std::atomic<bool> spFull(false);
+
+ZMtx& spMtx()
 	{
-	#if ZCONFIG_Is64Bit
-		if ((bool(fIntPtr & 1ULL<<63)) != (bool(fIntPtr & 1ULL<<62)))
-			return (CountedString*)(fIntPtr ^ 1ULL<<63);
-	#else
-		if (fIsCounted)
-			return (CountedString*)fIntPtr;
-	#endif
-
-	if (fIntPtr)
-		return new CountedString((const char*)fIntPtr);
-
-	return null;
+	// Deliberately leaked, Names may be made during static destruction.
+	static ZMtx* spResult = new ZMtx;
+	return *spResult;
 	}
 
-int Name::Compare(const Name& iOther) const
+const Name::Entry* spFind(const Table* iTable, size_t iHash, const char* iChars, size_t iLength)
 	{
-	if (const char* lhs = this->pAsCharStar())
-		{
-		if (const char* rhs = iOther.pAsCharStar())
-			return std::strcmp(lhs, rhs);
-		else
-			return 1;
-		}
-	else if (iOther.pAsCharStar())
+	if (iTable)
 		{
-		return -1;
-		}
-	else
-		{
-		return 0;
+		for (size_t xx = iHash & iTable->fMask; /*no test*/; xx = (xx + 1) & iTable->fMask)
+			{
+			const Name::Entry* theEntry = iTable->fSlots[xx].load(std::memory_order_acquire);
+			if (not theEntry)
+				break;
+			if (theEntry->fHash == iHash
+				&& theEntry->fString.size() == iLength
+				&& 0 == std::memcmp(theEntry->fString.data(), iChars, iLength))
+				{
+				return theEntry;
+				}
+			}
 		}
+	return nullptr;
 	}
 
-bool Name::IsEmpty() const
+void spInsert(Table* ioTable, const Name::Entry* iEntry)
 	{
-	#if ZCONFIG_Is64Bit
-		if ((bool(fIntPtr & 1ULL<<63)) != (bool(fIntPtr & 1ULL<<62)))
-			return ((const CountedString*)(fIntPtr ^ 1ULL<<63))->Get().empty();
-	#else
-		if (fIsCounted)
-			return ((const CountedString*)(fIntPtr))->Get().empty();
-	#endif
-
-	if (fIntPtr)
-		return not ((const char*)(fIntPtr))[0];
-
-	return true;
+	size_t xx = iEntry->fHash & ioTable->fMask;
+	while (ioTable->fSlots[xx].load(std::memory_order_relaxed))
+		xx = (xx + 1) & ioTable->fMask;
+	ioTable->fSlots[xx].store(iEntry, std::memory_order_release);
 	}
 
-void Name::Clear()
+Table* spMakeTable(size_t iCapacity, const Table* iPrior)
 	{
-	if (const CountedString* theCounted = this->pGetIfCounted())
-		spRelease(theCounted);
-	fIntPtr = 0;
+	Table* result = new Table;
+	result->fMask = iCapacity - 1;
+	result->fSlots = new std::atomic<const Name::Entry*>[iCapacity];
+	result->fPrior = iPrior;
+	for (size_t xx = 0; xx < iCapacity; ++xx)
+		result->fSlots[xx].store(nullptr, std::memory_order_relaxed);
 
-	#if not ZCONFIG_Is64Bit
-		fIsCounted = false;
-	#endif
-	}
-
-size_t Name::Hash() const
-	{
-	size_t result = 0;
-	if (const char* i = this->pAsCharStar())
+	if (iPrior)
 		{
-		for (size_t xx = sizeof(size_t); --xx && *i; ++i)
+		for (size_t xx = 0; xx <= iPrior->fMask; ++xx)
 			{
-			result <<= 8;
-			result |= *i;
+			if (const Name::Entry* theEntry = iPrior->fSlots[xx].load(std::memory_order_relaxed))
+				spInsert(result, theEntry);
 			}
 		}
+
 	return result;
 	}
 
-const char* Name::pAsCharStar() const
+} // anonymous namespace
+
+const Name::Entry* Name::spIntern(const char* iChars, size_t iLength)
 	{
-	#if ZCONFIG_Is64Bit
-		if ((bool(fIntPtr & 1ULL<<63)) != (bool(fIntPtr & 1ULL<<62)))
-			return ((const CountedString*)(fIntPtr ^ 1ULL<<63))->Get().c_str();
-	#else
-		if (fIsCounted)
-			return ((const CountedString*)(fIntPtr))->Get().c_str();
-	#endif
-	return (const char*)fIntPtr;
-	}
+	if (not iLength)
+		return nullptr;
+
+	const size_t theHash = spHash(iChars, iLength);
+
+	if (const Entry* theEntry =
+		spFind(spTable.load(std::memory_order_acquire), theHash, iChars, iLength))
+		{
+		return theEntry;
+		}
+
+	Entry* theEntry = new Entry;
+	sAtomic_Set(&theEntry->fRefCount, 1);
+	theEntry->fHash = theHash;
+	theEntry->fString.assign(iChars, iLength);
+
+	if (not spFull.load(std::memory_order_relaxed))
+		{
+		ZAcqMtx acq(spMtx());
 
-const Name::CountedString* Name::pGetIfCounted() const
-	{ return const_cast<Name*>(this)->pGetIfCounted(); }
+		Table* theTable = spTable.load(std::memory_order_relaxed);
+		if (const Entry* theExisting = spFind(theTable, theHash, iChars, iLength))
+			{
+			delete theEntry;
+			return theExisting;
+			}
+
+		if (spCount < kMaxInterned)
+			{
+			if (not theTable || 2 * (spCount + 1) > theTable->fMask + 1)
+				{
+				theTable = spMakeTable(theTable ? 2 * (theTable->fMask + 1) : 1024, theTable);
+				spTable.store(theTable, std::memory_order_release);
+				}
+
+			theEntry->fInterned = true;
+			spInsert(theTable, theEntry);
+			++spCount;
+			return theEntry;
+			}
 
-Name::CountedString* Name::pGetIfCounted()
+		spFull.store(true, std::memory_order_relaxed);
+		}
+
+	theEntry->fInterned = false;
+	return theEntry;
+	}
+
+void Name::spRelease(const Entry* iEntry)
 	{
-	#if ZCONFIG_Is64Bit
-		if ((bool(fIntPtr & 1ULL<<63)) != (bool(fIntPtr & 1ULL<<62)))
-			return (CountedString*)(fIntPtr ^ 1ULL<<63);
-	#else
-		if (fIsCounted)
-			return (CountedString*)fIntPtr;
-	#endif
-	return nullptr;
+	if (sAtomic_DecAndTest(&iEntry->fRefCount))
+		delete iEntry;
 	}
 
-#endif // ! ZMACRO_NameUsesString
+#endif // ZMACRO_NameUsesString
 
 } // namespace ZooLib
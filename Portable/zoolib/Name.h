@@ -22,6 +22,7 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define __ZooLib_Name_h__ 1
 #include "zconfig.h"
 
+#include "zoolib/Atomic.h"
 #include "zoolib/Compare_T.h"
 #include "zoolib/CountedVal.h"
 #include "zoolib/UnicodeString.h" // For string8
@@ -32,7 +33,9 @@ namespace ZooLib {
 // =================================================================================================
 #pragma mark - Name
 
-#define ZMACRO_NameUsesString 1
+#ifndef ZMACRO_NameUsesString
+	#define ZMACRO_NameUsesString 0
+#endif
 
 #if ZMACRO_NameUsesString
 
@@ -64,8 +67,6 @@ public:
 	operator string8() const
 		{ return fString; }
 
-//	operator RefCountedString() const;
-
 	inline bool operator<(const Name& iOther) const
 		{ return fString < iOther.fString; }
 
@@ -73,7 +74,7 @@ public:
 		{ return fString == iOther.fString; }
 
 	int Compare(const Name& iOther) const
-		{ return fString.compare(fString); }
+		{ return fString.compare(iOther.fString); }
 
 	bool IsEmpty() const
 		{ return fString.empty(); }
@@ -81,89 +82,115 @@ public:
 	void Clear()
 		{ fString.clear(); }
 
-//	size_t Hash() const;
+	size_t Hash() const;
 
 private:
 	string8 fString;
 	};
 
-#elif not ZMACRO_NameUsesString
+#else // ZMACRO_NameUsesString
+
+/*
+A Name is a pointer to an entry in a process-wide table of interned strings. Equal strings
+share an entry, so copying a Name copies a pointer, equality is a pointer comparison and the
+hash is computed just once, when a string is first interned. Ordering falls back to comparing
+the strings, unless the Names are the same. The empty string is the null pointer.
+
+Interned entries are never freed. Finding one takes no lock, only adding one does. So that
+names from untrusted input can't grow the table without bound it stops taking new strings once
+it's full, and a string that isn't in it by then gets an entry of its own, which is reference
+counted and compared by content. A string is thus either interned for every Name that holds it,
+or for none of them.
+*/
 
 class Name
 	{
 public:
 	typedef CountedVal<string8> CountedString;
-	typedef ZP<CountedString> RefCountedString;
+
+	struct Entry
+		{
+		bool fInterned;
+		mutable ZAtomic_t fRefCount; // Only used if not fInterned.
+		size_t fHash;
+		string8 fString;
+		};
 
 	inline Name()
-	:	fIntPtr(0)
-	#if not ZCONFIG_Is64Bit
-	,	fIsCounted(false)
-	#endif
+	:	fEntry(nullptr)
 		{}
 
 	inline Name(const Name& iOther)
-	:	fIntPtr(iOther.fIntPtr)
-	#if not ZCONFIG_Is64Bit
-	,	fIsCounted(iOther.fIsCounted)
-	#endif
+	:	fEntry(iOther.fEntry)
 		{
-		if (CountedString* theCounted = this->pGetIfCounted())
-			spRetain(theCounted);
+		if (fEntry && not fEntry->fInterned)
+			sAtomic_Inc(&fEntry->fRefCount);
 		}
 
-	Name& operator=(const Name& iOther);
+	Name& operator=(const Name& iOther)
+		{
+		if (iOther.fEntry && not iOther.fEntry->fInterned)
+			sAtomic_Inc(&iOther.fEntry->fRefCount);
+		if (fEntry && not fEntry->fInterned)
+			spRelease(fEntry);
+		fEntry = iOther.fEntry;
+		return *this;
+		}
 
 	inline ~Name()
 		{
-		if (CountedString* theCounted = this->pGetIfCounted())
-			spRelease(theCounted);
+		if (fEntry && not fEntry->fInterned)
+			spRelease(fEntry);
 		}
 
-	Name(const char* iStatic)
-	:	fIntPtr(((intptr_t)iStatic))
-	#if not ZCONFIG_Is64Bit
-	,	fIsCounted(false)
-	#endif
-		{}
+	Name(const char* iStatic);
 
 	Name(const string8& iString);
-	Name(const RefCountedString& iRefCountedString);
-	
+
+	Name(const ZP<CountedString>& iRefCountedString);
+
 	operator string8() const;
-	operator RefCountedString() const;
 
 	inline bool operator<(const Name& iOther) const
-		{ return this->Compare(iOther) < 0; }
+		{ return fEntry != iOther.fEntry && this->pCompare(iOther) < 0; }
 
 	inline bool operator==(const Name& iOther) const
-		{ return this->Compare(iOther) == 0; }
+		{
+		return fEntry == iOther.fEntry
+			|| (fEntry && iOther.fEntry
+			&& not fEntry->fInterned && not iOther.fEntry->fInterned
+			&& fEntry->fString == iOther.fEntry->fString);
+		}
 
-	int Compare(const Name& iOther) const;
+	int Compare(const Name& iOther) const
+		{ return fEntry == iOther.fEntry ? 0 : this->pCompare(iOther); }
 
-	bool IsEmpty() const;
+	bool IsEmpty() const
+		{ return not fEntry; }
 
-	void Clear();
+	void Clear()
+		{
+		if (fEntry && not fEntry->fInterned)
+			spRelease(fEntry);
+		fEntry = nullptr;
+		}
 
-	size_t Hash() const;
+	size_t Hash() const
+		{ return fEntry ? fEntry->fHash : spHash_Empty(); }
 
 private:
-	CountedString* pGetIfCounted();
-	const CountedString* pGetIfCounted() const;
+	int pCompare(const Name& iOther) const;
 
-	const char* pAsCharStar() const;
+	static size_t spHash_Empty();
 
-	static void spRetain(const CountedString* iCounted);
+	static const Entry* spIntern(const char* iChars, size_t iLength);
 
-	static void spRelease(const CountedString* iCounted);
+	static void spRelease(const Entry* iEntry);
 
-	intptr_t fIntPtr;
-	#if not ZCONFIG_Is64Bit
-		bool fIsCounted;
-	#endif
+	const Entry* fEntry;
 	};
 
-#endif
+#endif // ZMACRO_NameUsesString
 
 template <> struct RelopsTraits_HasEQ<Name> : public RelopsTraits_Has {};
 template <> struct RelopsTraits_HasLT<Name> : public RelopsTraits_Has {};
@@ -32,12 +32,21 @@ bool Compare_ZP_CountedString::operator()(const ZP_CountedString& l, const ZP_Co
 #pragma mark - sName
 
 Name sName(const string8& iString)
-	{ return sName(sCountedVal<string8>(iString)); }
+	{
+	#if ZMACRO_NameUsesString
+		return sName(sCountedVal<string8>(iString));
+	#else
+		// Names are interned, so there's nothing for a uniquifier to do.
+		return Name(iString);
+	#endif
+	}
 
 Name sName(const ZP_CountedString& iCountedString)
 	{
-	if (ThreadVal_NameUniquifier::Type_t* theUniquifier = ThreadVal_NameUniquifier::sPMut())
-		return Name(theUniquifier->Get(iCountedString));
+	#if ZMACRO_NameUsesString
+		if (ThreadVal_NameUniquifier::Type_t* theUniquifier = ThreadVal_NameUniquifier::sPMut())
+			return Name(theUniquifier->Get(iCountedString));
+	#endif
 	return Name(iCountedString);
 	}
 
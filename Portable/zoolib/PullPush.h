@@ -27,6 +27,7 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/Callable_Function.h"
 #include "zoolib/Chan.h"
 #include "zoolib/Chan_XX_PipePair.h"
+#include "zoolib/Chan_XX_PipeRing.h"
 #include "zoolib/Channer.h"
 #include "zoolib/ChanR.h"
 #include "zoolib/ChanR_Bin.h"
@@ -188,6 +189,28 @@ PullPushPair<EE> sMakePullPushPair()
 	return thePair;
 	}
 
+// A non-zero iCapacity gets a bounded ring rather than a rendezvous, so the writer
+// can run up to iCapacity elements ahead of the reader.
+template <class EE>
+void sMakePullPushPair(size_t iCapacity,
+	ZP<ChannerWCon<EE>>& oChannerW, ZP<ChannerR<EE>>& oChannerR)
+	{
+	if (not iCapacity)
+		return sMakePullPushPair<EE>(oChannerW, oChannerR);
+
+	ZP<ImpPipeRing<EE>> theImp = new ImpPipeRing<EE>(iCapacity);
+	oChannerW = sChanner_T<ChanWCon_PipeRing<EE>>(theImp);
+	oChannerR = sChanner_T<ChanR_PipeRing<EE>>(theImp);
+	}
+
+template <class EE>
+PullPushPair<EE> sMakePullPushPair(size_t iCapacity)
+	{
+	PullPushPair<EE> thePair;
+	sMakePullPushPair<EE>(iCapacity, thePair.first, thePair.second);
+	return thePair;
+	}
+
 // ----------
 
 template <class Pull_p, class Push_p>
@@ -208,9 +231,10 @@ void sRunPullPush_Channer(
 template <class Pull_p, class Push_p>
 ZP<ChannerR<Push_p>> sStartPullPush(
 	const ZP<Callable<void(const ChanR<Pull_p>&,const ChanW<Push_p>&)>>& iCallable,
-	const ZP<ChannerR<Pull_p>>& iChannerR)
+	const ZP<ChannerR<Pull_p>>& iChannerR,
+	size_t iCapacity)
 	{
-	PullPushPair<Push_p> thePullPushPair = sMakePullPushPair<Push_p>();
+	PullPushPair<Push_p> thePullPushPair = sMakePullPushPair<Push_p>(iCapacity);
 	sStartOnNewThread
 		(
 		sBindR
@@ -224,6 +248,12 @@ ZP<ChannerR<Push_p>> sStartPullPush(
 	return thePullPushPair.second;
 	}
 
+template <class Pull_p, class Push_p>
+ZP<ChannerR<Push_p>> sStartPullPush(
+	const ZP<Callable<void(const ChanR<Pull_p>&,const ChanW<Push_p>&)>>& iCallable,
+	const ZP<ChannerR<Pull_p>>& iChannerR)
+	{ return sStartPullPush<Pull_p,Push_p>(iCallable, iChannerR, 0); }
+
 } // namespace ZooLib
 
 #endif // __ZooLib_PullPush_h__
@@ -31,6 +31,7 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/Chan_UTF_Escaped.h"
 #include "zoolib/Channer_Bin.h"
 #include "zoolib/Channer_UTF.h"
+#include "zoolib/Compat_cmath.h" // For NAN and INFINITY
 #include "zoolib/Data_ZZ.h"
 #include "zoolib/NameUniquifier.h" // For sName
 #include "zoolib/ParseException.h"
@@ -40,6 +41,15 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/Util_STL_vector.h"
 #include "zoolib/ZMACRO_foreach.h"
 
+// The buffer-based parser uses SSE2 to skip runs of whitespace and of plain string content.
+// It's part of the x86_64 baseline, so there's no need for runtime dispatch.
+#if (ZCONFIG(Compiler, GCC) || ZCONFIG(Compiler, Clang)) && defined(__SSE2__)
+	#define ZCONFIG_PullPush_JSON_SSE2 1
+	#include <emmintrin.h>
+#else
+	#define ZCONFIG_PullPush_JSON_SSE2 0
+#endif
+
 namespace ZooLib {
 
 using namespace PullPush;
@@ -405,6 +415,1005 @@ bool sPull_JSON_Push_PPT(const ChanRU_UTF& iChanRU,
 		}
 	}
 
+// =================================================================================================
+#pragma mark - Scanner_JSON (anonymous)
+
+// Scanner_JSON and the sPull_JSON_XXX functions taking a PaC below parse exactly what the
+// ChanRU_UTF-based code above parses, producing the same values and the same errors. They work
+// directly on UTF-8 code units rather than on code points pulled one at a time through virtual
+// calls.
+//
+// Scanner_JSON requires well-formed UTF-8, where every code unit with its high bit set is part of
+// a valid shortest-form sequence. So syntax can be matched code unit by code unit, and string
+// content copied verbatim. A buffer that's not well-formed is first cleaned up by
+// Unicode::sUTF8ToUTF8, which is how ChanRU_UTF_string8 would have presented it.
+
+namespace { // anonymous
+
+bool spIsWhitespace(UTF32 iCP)
+	{
+	if (Unicode::sIsWhitespace(iCP))
+		return true;
+
+	if (iCP == 0xFEFF)
+		{
+		// BOM -- treat it as whitespace.
+		return true;
+		}
+
+	return false;
+	}
+
+bool spIsDigit(UTF8 iCU)
+	{ return uint8(iCU - '0') < 10; }
+
+inline bool spReadCP(const UTF8*& ioCur, const UTF8* iEnd, UTF32& oCP)
+	{
+	if (ioCur < iEnd && uint8(*ioCur) < 0x80)
+		{
+		oCP = uint8(*ioCur++);
+		return true;
+		}
+	return Unicode::sReadInc(ioCur, iEnd, oCP);
+	}
+
+// The first code unit at or after iCur that has its high bit set.
+const UTF8* spSkipASCII(const UTF8* iCur, const UTF8* iEnd)
+	{
+	#if ZCONFIG_PullPush_JSON_SSE2
+		while (iEnd - iCur >= 16)
+			{
+			const __m128i theCUs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iCur));
+			if (const int theMask = _mm_movemask_epi8(theCUs))
+				return iCur + __builtin_ctz(theMask);
+			iCur += 16;
+			}
+	#endif
+
+	while (iCur < iEnd && uint8(*iCur) < 0x80)
+		++iCur;
+	return iCur;
+	}
+
+bool spIsWellFormed(const UTF8* iCur, const UTF8* iEnd)
+	{
+	for (;;)
+		{
+		iCur = spSkipASCII(iCur, iEnd);
+		if (iCur >= iEnd)
+			return true;
+
+		const UTF8* const theStart = iCur;
+		UTF32 theCP;
+		size_t countSkipped = 0;
+		if (not Unicode::sReadInc(iCur, iEnd, theCP, countSkipped)
+			|| countSkipped || not Unicode::sIsValid(theCP))
+			{ return false; }
+
+		const size_t theLength = theCP < 0x80 ? 1 : theCP < 0x800 ? 2 : theCP < 0x10000 ? 3 : 4;
+		if (size_t(iCur - theStart) != theLength)
+			return false;
+		}
+	}
+
+// The first code unit at or after iCur that's not a space, tab, CR or LF.
+const UTF8* spSkipSpaces(const UTF8* iCur, const UTF8* iEnd)
+	{
+	#if ZCONFIG_PullPush_JSON_SSE2
+		while (iEnd - iCur >= 16)
+			{
+			const __m128i theCUs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iCur));
+			const __m128i isSpace = _mm_or_si128(
+				_mm_or_si128(
+					_mm_cmpeq_epi8(theCUs, _mm_set1_epi8(' ')),
+					_mm_cmpeq_epi8(theCUs, _mm_set1_epi8('\t'))),
+				_mm_or_si128(
+					_mm_cmpeq_epi8(theCUs, _mm_set1_epi8('\n')),
+					_mm_cmpeq_epi8(theCUs, _mm_set1_epi8('\r'))));
+
+			if (const int notSpace = ~_mm_movemask_epi8(isSpace) & 0xFFFF)
+				return iCur + __builtin_ctz(notSpace);
+			iCur += 16;
+			}
+	#endif
+
+	while (iCur < iEnd && (*iCur == ' ' || *iCur == '\t' || *iCur == '\n' || *iCur == '\r'))
+		++iCur;
+	return iCur;
+	}
+
+// The first code unit at or after iCur that's iTerminator, a backslash, CR, LF, or 0xE2 (which
+// starts U+2028 and U+2029, the other EOLs). Everything before it is plain string content.
+const UTF8* spScanString(const UTF8* iCur, const UTF8* iEnd, UTF8 iTerminator)
+	{
+	#if ZCONFIG_PullPush_JSON_SSE2
+		const __m128i theTerminator = _mm_set1_epi8(iTerminator);
+		while (iEnd - iCur >= 16)
+			{
+			const __m128i theCUs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iCur));
+			const __m128i isSpecial = _mm_or_si128(
+				_mm_or_si128(
+					_mm_cmpeq_epi8(theCUs, theTerminator),
+					_mm_cmpeq_epi8(theCUs, _mm_set1_epi8('\\'))),
+				_mm_or_si128(
+					_mm_or_si128(
+						_mm_cmpeq_epi8(theCUs, _mm_set1_epi8('\n')),
+						_mm_cmpeq_epi8(theCUs, _mm_set1_epi8('\r'))),
+					_mm_cmpeq_epi8(theCUs, _mm_set1_epi8(char(0xE2)))));
+
+			if (const int theMask = _mm_movemask_epi8(isSpecial))
+				return iCur + __builtin_ctz(theMask);
+			iCur += 16;
+			}
+	#endif
+
+	for (/*no init*/; iCur < iEnd; ++iCur)
+		{
+		const UTF8 theCU = *iCur;
+		if (theCU == iTerminator || theCU == '\\' || theCU == '\n' || theCU == '\r'
+			|| uint8(theCU) == 0xE2)
+			{ break; }
+		}
+	return iCur;
+	}
+
+class Scanner_JSON
+	{
+public:
+	Scanner_JSON(const PaC<const UTF8>& iPaC, const Util_Chan_JSON::PullTextOptions_JSON& iRO)
+	:	fBegin(sPointer(iPaC))
+	,	fCur(fBegin)
+	,	fEnd(fBegin + sCount(iPaC))
+	,	fAllowUnquotedPropertyNames(iRO.fAllowUnquotedPropertyNames.DGet(false))
+	,	fAllowEquals(iRO.fAllowEquals.DGet(false))
+	,	fAllowSemiColons(iRO.fAllowSemiColons.DGet(false))
+	,	fLooseSeparators(iRO.fLooseSeparators.DGet(false))
+	,	fAllowBinary(iRO.fAllowBinary.DGet(false))
+		{}
+
+	size_t CountConsumed() const
+		{ return fCur - fBegin; }
+
+	bool IsAt(UTF8 iCU) const
+		{ return fCur < fEnd && *fCur == iCU; }
+
+	bool TryRead(UTF8 iCU)
+		{
+		if (fCur < fEnd && *fCur == iCU)
+			{
+			++fCur;
+			return true;
+			}
+		return false;
+		}
+
+	void SkipWSAndComments()
+		{
+		for (;;)
+			{
+			if (this->pAtPlainASCII())
+				return;
+
+			fCur = spSkipSpaces(fCur, fEnd);
+
+			if (this->pAtPlainASCII())
+				return;
+
+			const UTF8* next = fCur;
+			UTF32 theCP;
+			if (not spReadCP(next, fEnd, theCP))
+				return;
+
+			if (spIsWhitespace(theCP))
+				{
+				fCur = next;
+				continue;
+				}
+
+			if (theCP != '/' || not spReadCP(next, fEnd, theCP))
+				return;
+
+			if (theCP == '/')
+				{
+				// Skip to the end of the line, and the EOL itself.
+				fCur = next;
+				while (spReadCP(fCur, fEnd, theCP) && not Unicode::sIsEOL(theCP))
+					{}
+				}
+			else if (theCP == '*')
+				{
+				fCur = next;
+				for (bool priorWasStar = false; /*no test*/; priorWasStar = theCP == '*')
+					{
+					if (not spReadCP(fCur, fEnd, theCP))
+						{
+						sThrow_ParseException(
+							"Unexpected end of data while parsing a /**/ comment");
+						}
+
+					if (priorWasStar && theCP == '/')
+						break;
+					}
+				}
+			else
+				{
+				return;
+				}
+			}
+		}
+
+	void ReadSeparators(const char* iWhat)
+		{
+		if (fLooseSeparators)
+			{
+			// We allow zero or more separators
+			for (;;)
+				{
+				this->SkipWSAndComments();
+				if (this->TryRead(','))
+					{}
+				else if (fAllowSemiColons && this->TryRead(';'))
+					{}
+				else
+					break;
+				}
+			}
+		else
+			{
+			this->SkipWSAndComments();
+			if (this->TryRead(','))
+				{}
+			else if (fAllowSemiColons)
+				{
+				if (not this->TryRead(';'))
+					{
+					sThrow_ParseException(
+						string("Require ',' or ';' to separate ") + iWhat + " elements");
+					}
+				}
+			else
+				{
+				sThrow_ParseException(string("Require ',' to separate ") + iWhat + " elements");
+				}
+			}
+		}
+
+	void ReadName(string& oName)
+		{
+		oName.resize(0);
+
+		if (this->TryRead('"'))
+			{
+			this->pReadEscaped('"', oName);
+			}
+		else if (this->TryRead('\''))
+			{
+			this->pReadEscaped('\'', oName);
+			}
+		else
+			{
+			if (fAllowUnquotedPropertyNames)
+				{
+				UTF32 theCP;
+				for (const UTF8* next = fCur;
+					spReadCP(next, fEnd, theCP)
+					&& (Unicode::sIsAlphaDigit(theCP) || theCP == '_');
+					fCur = next)
+					{ oName += theCP; }
+				}
+
+			if (oName.empty())
+				sThrow_ParseException("Expected a member name");
+			}
+		}
+
+	void ReadNameSeparator()
+		{
+		this->SkipWSAndComments();
+
+		if (not this->TryRead(':'))
+			{
+			if (not fAllowEquals)
+				sThrow_ParseException("Expected ':' after a member name");
+
+			if (not this->TryRead('='))
+				sThrow_ParseException("Expected ':' or '=' after a member name");
+			}
+
+		this->SkipWSAndComments();
+		}
+
+	bool TryReadString(string& oString)
+		{
+		UTF8 theTerminator;
+		if (this->TryRead('"'))
+			theTerminator = '"';
+		else if (this->TryRead('\''))
+			theTerminator = '\'';
+		else
+			return false;
+
+		// See spPull_JSON_String_Push_UTF for the meaning of quotesSeen.
+		int quotesSeen = 1;
+		for (;;)
+			{
+			switch (quotesSeen)
+				{
+				case 0:
+					{
+					this->SkipWSAndComments();
+
+					if (this->TryRead(theTerminator))
+						quotesSeen = 1;
+					else
+						return true;
+					break;
+					}
+				case 1:
+					{
+					if (this->TryRead(theTerminator))
+						{
+						quotesSeen = 2;
+						}
+					else
+						{
+						this->pReadEscaped(theTerminator, oString);
+						quotesSeen = 0;
+						}
+					break;
+					}
+				case 2:
+					{
+					if (this->TryRead(theTerminator))
+						{
+						quotesSeen = 3;
+						const UTF8* next = fCur;
+						UTF32 theCP;
+						if (spReadCP(next, fEnd, theCP) && Unicode::sIsEOL(theCP))
+							fCur = next;
+						}
+					else
+						{
+						quotesSeen = 0;
+						}
+					break;
+					}
+				case 3:
+					{
+					this->pReadRaw(oString);
+					quotesSeen = 0;
+					break;
+					}
+				}
+			}
+		}
+
+	bool TryReadBinary(Data_ZZ& oData)
+		{
+		if (not fAllowBinary || not this->TryRead('<'))
+			return false;
+
+		this->SkipWSAndComments();
+
+		string theBytes;
+		if (this->TryRead('='))
+			{
+			// As ChanR_Bin_ASCIIStrim feeding ChanR_Bin_Base64Decode would do, we consider only
+			// ASCII code points, and drop any incomplete final quad.
+			const Base64::Decode theDecode = Base64::sDecode_Normal();
+			uint32 theSource = 0;
+			size_t theSourceCount = 0;
+			for (;;)
+				{
+				UTF32 theCP;
+				if (not spReadCP(fCur, fEnd, theCP))
+					sThrow_ParseException("Expected '>' to close a base64 data");
+
+				if (theCP == '>')
+					break;
+
+				if (theCP >= 0x80)
+					continue;
+
+				const uint8 theSextet = theDecode.fTable[theCP];
+				if (theSextet == 0xFF)
+					continue;
+
+				theSource = (theSource << 6) | theSextet;
+				if (++theSourceCount == 4)
+					{
+					theBytes += char(theSource >> 16);
+					theBytes += char(theSource >> 8);
+					theBytes += char(theSource);
+					theSource = 0;
+					theSourceCount = 0;
+					}
+				}
+			}
+		else
+			{
+			for (;;)
+				{
+				this->SkipWSAndComments();
+				const int firstDigit = this->pReadHexDigit();
+				if (firstDigit < 0)
+					break;
+
+				this->SkipWSAndComments();
+				const int secondDigit = this->pReadHexDigit();
+				if (secondDigit < 0)
+					sThrow_ParseException("Could not read second nibble of byte");
+
+				theBytes += char(firstDigit * 16 + secondDigit);
+				}
+
+			if (not this->TryRead('>'))
+				sThrow_ParseException("Expected '>' to close a hex data");
+			}
+
+		oData = Data_ZZ(theBytes.data(), theBytes.size());
+		return true;
+		}
+
+	template <class Val_p>
+	bool TryReadOther(Val_p& oVal)
+		{
+		int64 asInt64;
+		double asDouble;
+		bool isDouble;
+
+		if (this->pTryReadNumber(asInt64, asDouble, isDouble))
+			{
+			if (isDouble)
+				{
+				oVal = asDouble;
+				}
+			else
+				{
+				if (fAllowBinary && asInt64 == -1)
+					{
+					// Read and discard an L suffix (that python puts on things sometimes)
+					this->TryRead('l') || this->TryRead('L');
+					}
+				oVal = asInt64;
+				}
+			return true;
+			}
+
+		if (this->pTryReadCaseless("null"))
+			{
+			oVal = null;
+			return true;
+			}
+
+		if (this->pTryReadCaseless("false"))
+			{
+			oVal = false;
+			return true;
+			}
+
+		if (this->pTryReadCaseless("true"))
+			{
+			oVal = true;
+			return true;
+			}
+
+		return false;
+		}
+
+private:
+	// Nothing in '!'..DEL is whitespace, and only '/' can start a comment, so the common case
+	// of a structural character or value needs no code point decoding.
+	bool pAtPlainASCII() const
+		{ return fCur < fEnd && uint8(*fCur) > ' ' && uint8(*fCur) < 0x80 && *fCur != '/'; }
+
+	int pReadHexDigit()
+		{
+		const UTF8* next = fCur;
+		UTF32 theCP;
+		if (spReadCP(next, fEnd, theCP))
+			{
+			const int result = Unicode::sHexValue(theCP);
+			if (result >= 0)
+				{
+				fCur = next;
+				return result;
+				}
+			}
+		return -1;
+		}
+
+	bool pTryReadCaseless(const char* iLowerCase)
+		{
+		const UTF8* next = fCur;
+		for (/*no init*/; *iLowerCase; ++iLowerCase)
+			{
+			UTF32 theCP;
+			if (not spReadCP(next, fEnd, theCP) || Unicode::sToLower(theCP) != UTF32(*iLowerCase))
+				return false;
+			}
+		fCur = next;
+		return true;
+		}
+
+	// Reads up to and including iTerminator, with the semantics of ChanR_UTF_Escaped.
+	void pReadEscaped(UTF8 iTerminator, string& ioString)
+		{
+		for (;;)
+			{
+			const UTF8* const runEnd = spScanString(fCur, fEnd, iTerminator);
+			ioString.append(fCur, runEnd);
+			fCur = runEnd;
+
+			UTF32 theCP;
+			if (not spReadCP(fCur, fEnd, theCP))
+				sThrow_ParseException("Unexpected end of strim whilst parsing a string");
+
+			if (theCP == UTF32(iTerminator))
+				return;
+
+			if (Unicode::sIsEOL(theCP))
+				sThrow_ParseException("Illegal end of line whilst parsing a string");
+
+			if (theCP == '\\')
+				theCP = this->pReadEscape();
+
+			// ChanW_UTF_string would discard an invalid code point from an escape.
+			if (Unicode::sIsValid(theCP))
+				ioString += theCP;
+			}
+		}
+
+	UTF32 pReadEscape()
+		{
+		UTF32 theCP;
+		if (not spReadCP(fCur, fEnd, theCP))
+			sThrow_ParseException("Unexpected end of strim after parsing escape");
+
+		switch (theCP)
+			{
+			case '\\': return '\\';
+			case 't': return '\t';
+			case 'n': return '\n';
+			case 'r': return '\r';
+			case 'b': return '\b';
+			case 'f': return '\f';
+			case '"': return '\"';
+			case '\'': return '\'';
+			case '/': return '/';
+			case 'x':
+				{
+				int theDigit = this->pReadHexDigit();
+				if (theDigit < 0)
+					sThrow_ParseException("Illegal non-hex digit following \"\\x\"");
+
+				UTF32 result = theDigit;
+				while ((theDigit = this->pReadHexDigit()) >= 0)
+					result = (result << 4) + theDigit;
+				return result;
+				}
+			case 'u':
+			case 'U':
+				{
+				int32 requiredChars = 4;
+				if (theCP == 'U')
+					requiredChars = 8;
+
+				UTF32 result = 0;
+				while (requiredChars--)
+					{
+					const int theDigit = this->pReadHexDigit();
+					if (theDigit < 0)
+						{
+						sThrow_ParseException(string8("Illegal non-hex digit in \"\\")
+							+ char(theCP) + "\" escape sequence");
+						}
+					result = (result << 4) + theDigit;
+					}
+				return result;
+				}
+			}
+
+		// Gotta love escape sequences. This message
+		// has "\" (quote, backslash, quote) at the end.
+		sThrow_ParseException("Illegal character following \"\\\"");
+		return 0;
+		}
+
+	// Reads up to and including the next """, which closes a raw segment whatever the string's
+	// own terminator is.
+	void pReadRaw(string& ioString)
+		{
+		for (size_t quotesSeen = 0; /*no test*/; /*no inc*/)
+			{
+			const UTF8* const theStart = fCur;
+			UTF32 theCP;
+			if (not spReadCP(fCur, fEnd, theCP))
+				sThrow_ParseException("Expected \"\"\" to close a string");
+
+			if (theCP == '"')
+				{
+				if (++quotesSeen == 3)
+					return;
+				}
+			else
+				{
+				ioString.append(quotesSeen, '"');
+				quotesSeen = 0;
+				ioString.append(theStart, fCur);
+				}
+			}
+		}
+
+	// The equivalent of Util_Chan::sTryRead_SignedGenericNumber.
+	bool pTryReadNumber(int64& oInt64, double& oDouble, bool& oIsDouble)
+		{
+		const UTF8* cur = fCur;
+
+		bool isNegative = false;
+		bool hadSign = false;
+		if (cur < fEnd && (*cur == '-' || *cur == '+'))
+			{
+			hadSign = true;
+			isNegative = *cur++ == '-';
+			}
+
+		if (cur < fEnd && *cur == '0')
+			{
+			const UTF8 theNext = cur + 1 < fEnd ? cur[1] : 0;
+			if (theNext == 'x' || theNext == 'X')
+				{
+				cur += 2;
+				const UTF8* const digitsStart = cur;
+				uint64 theValue = 0;
+				for (int theDigit; cur < fEnd && (theDigit = Unicode::sHexValue(*cur)) >= 0; ++cur)
+					theValue = theValue * 16 + theDigit;
+
+				if (cur == digitsStart)
+					sThrow_ParseException("Expected a valid hex integer after '0x' prefix");
+
+				oIsDouble = false;
+				oInt64 = int64(isNegative ? 0 - theValue : theValue);
+				fCur = cur;
+				return true;
+				}
+
+			if (theNext != '.' && not spIsDigit(theNext))
+				{
+				oIsDouble = false;
+				oInt64 = 0;
+				fCur = cur + 1;
+				return true;
+				}
+			}
+
+		fCur = cur;
+		if (this->pTryReadCaseless("nan"))
+			{
+			oIsDouble = true;
+			oInt64 = 0;
+			oDouble = isNegative ? -NAN : NAN;
+			return true;
+			}
+
+		if (this->pTryReadCaseless("inf"))
+			{
+			oIsDouble = true;
+			oInt64 = 0;
+			oDouble = isNegative ? -INFINITY : INFINITY;
+			return true;
+			}
+
+		const UTF8* const intStart = cur;
+		int64 theInt64 = 0;
+		bool isDouble = false;
+		for (/*no init*/; cur < fEnd && spIsDigit(*cur); ++cur)
+			{
+			if (not isDouble)
+				{
+				const int64 priorInt64 = theInt64;
+				theInt64 = int64(uint64(theInt64) * 10 + (*cur - '0'));
+				if (theInt64 < priorInt64)
+					{
+					// We've overflowed.
+					isDouble = true;
+					}
+				}
+			}
+		const UTF8* const intEnd = cur;
+
+		if (intStart == intEnd)
+			{
+			if (hadSign)
+				{
+				// We've already absorbed a plus or minus sign, hence we have a parse exception.
+				if (isNegative)
+					sThrow_ParseException("Expected a valid number after '-' prefix");
+				else
+					sThrow_ParseException("Expected a valid number after '+' prefix");
+				}
+			return false;
+			}
+
+		const UTF8* fracStart = cur;
+		if (cur < fEnd && *cur == '.')
+			{
+			isDouble = true;
+			fracStart = ++cur;
+			while (cur < fEnd && spIsDigit(*cur))
+				++cur;
+			}
+		const UTF8* const fracEnd = cur;
+
+		int64 theExponent = fracStart - fracEnd;
+		if (cur < fEnd && (*cur == 'e' || *cur == 'E'))
+			{
+			isDouble = true;
+			++cur;
+
+			bool isNegativeExponent = false;
+			bool hadExponentSign = false;
+			if (cur < fEnd && (*cur == '-' || *cur == '+'))
+				{
+				hadExponentSign = true;
+				isNegativeExponent = *cur++ == '-';
+				}
+
+			const UTF8* const exponentStart = cur;
+			uint64 exponent = 0;
+			for (/*no init*/; cur < fEnd && spIsDigit(*cur); ++cur)
+				exponent = exponent * 10 + (*cur - '0');
+
+			if (cur == exponentStart)
+				{
+				if (hadExponentSign)
+					sThrow_ParseException("Expected a valid integer after sign prefix");
+				sThrow_ParseException("Expected a valid exponent after 'e'");
+				}
+
+			theExponent += int64(isNegativeExponent ? 0 - exponent : exponent);
+			}
+
+		fCur = cur;
+
+		oIsDouble = isDouble;
+		oInt64 = int64(isNegative ? 0 - uint64(theInt64) : uint64(theInt64));
+
+		if (not isDouble)
+			{
+			oDouble = double(oInt64);
+			}
+		else
+			{
+			double theDouble;
+			if (fracStart == fracEnd)
+				{
+				theDouble = Util_Chan::sDecimalAsDouble(intStart, intEnd - intStart, theExponent);
+				}
+			else
+				{
+				// sDecimalAsDouble wants the digits contiguous, without the decimal point.
+				string theDigits(intStart, intEnd);
+				theDigits.append(fracStart, fracEnd);
+				theDouble = Util_Chan::sDecimalAsDouble(
+					theDigits.data(), theDigits.size(), theExponent);
+				}
+			oDouble = isNegative ? -theDouble : theDouble;
+			}
+
+		return true;
+		}
+
+	const UTF8* const fBegin;
+	const UTF8* fCur;
+	const UTF8* const fEnd;
+
+	const bool fAllowUnquotedPropertyNames;
+	const bool fAllowEquals;
+	const bool fAllowSemiColons;
+	const bool fLooseSeparators;
+	const bool fAllowBinary;
+	};
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - sPull_JSON_Push_PPT, sPull_JSON_AsZZ (from a PaC)
+
+static bool spPull_JSON_Push_PPT(Scanner_JSON& ioScanner, const ChanW_PPT& iChanW)
+	{
+	ioScanner.SkipWSAndComments();
+
+	if (ioScanner.TryRead('['))
+		{
+		sPush_Start_Seq(iChanW);
+		for (;;)
+			{
+			ioScanner.SkipWSAndComments();
+			if (ioScanner.TryRead(']'))
+				{
+				sPush_End(iChanW);
+				return true;
+				}
+
+			if (not spPull_JSON_Push_PPT(ioScanner, iChanW))
+				sThrow_ParseException("Expected value");
+
+			ioScanner.ReadSeparators("array");
+			}
+		}
+	else if (ioScanner.TryRead('{'))
+		{
+		sPush_Start_Map(iChanW);
+		for (;;)
+			{
+			ioScanner.SkipWSAndComments();
+			if (ioScanner.TryRead('}'))
+				{
+				sPush_End(iChanW);
+				return true;
+				}
+
+			string theName;
+			ioScanner.ReadName(theName);
+
+			sPush(sName(theName), iChanW);
+
+			ioScanner.ReadNameSeparator();
+
+			if (not spPull_JSON_Push_PPT(ioScanner, iChanW))
+				sThrow_ParseException("Expected value");
+
+			ioScanner.ReadSeparators("object");
+			}
+		}
+
+	string theString;
+	if (ioScanner.TryReadString(theString))
+		{
+		sPush(theString, iChanW);
+		return true;
+		}
+
+	Data_ZZ theData;
+	if (ioScanner.TryReadBinary(theData))
+		{
+		// Binary data goes out as a ChannerR_Bin, as it does from the ChanRU_UTF-based code.
+		PullPushPair<byte> thePullPushPair = sMakePullPushPair<byte>();
+		sPush(sGetClear(thePullPushPair.second), iChanW);
+		sFlush(iChanW);
+		sEWriteMem(*thePullPushPair.first, theData.GetPtr(), theData.GetSize());
+		sDisconnectWrite(*thePullPushPair.first);
+		return true;
+		}
+
+	PPT thePPT;
+	if (ioScanner.TryReadOther(thePPT))
+		{
+		sPush(thePPT, iChanW);
+		return true;
+		}
+
+	return false;
+	}
+
+
+static bool spPull_JSON_AsZZ(Scanner_JSON& ioScanner, Val_ZZ& oVal)
+	{
+	ioScanner.SkipWSAndComments();
+
+	if (ioScanner.TryRead('['))
+		{
+		oVal = Seq_ZZ();
+		Seq_ZZ& theSeq = oVal.Mut<Seq_ZZ>();
+		for (;;)
+			{
+			ioScanner.SkipWSAndComments();
+			if (ioScanner.TryRead(']'))
+				return true;
+
+			if (not spPull_JSON_AsZZ(ioScanner, theSeq.Mut(theSeq.Count())))
+				sThrow_ParseException("Expected value");
+
+			ioScanner.ReadSeparators("array");
+			}
+		}
+	else if (ioScanner.TryRead('{'))
+		{
+		oVal = Map_ZZ();
+		Map_ZZ& theMap = oVal.Mut<Map_ZZ>();
+		string theName;
+		for (;;)
+			{
+			ioScanner.SkipWSAndComments();
+			if (ioScanner.TryRead('}'))
+				return true;
+
+			ioScanner.ReadName(theName);
+
+			ioScanner.ReadNameSeparator();
+
+			// A repeated name replaces the earlier value, as Map_ZZ::Set would.
+			if (not spPull_JSON_AsZZ(ioScanner, theMap.Mut(sName(theName))))
+				sThrow_ParseException("Expected value");
+
+			ioScanner.ReadSeparators("object");
+			}
+		}
+
+	string theString;
+	if (ioScanner.TryReadString(theString))
+		{
+		oVal = string();
+		oVal.Mut<string>().swap(theString);
+		return true;
+		}
+
+	// Data_ZZ's default constructor allocates, so only make one when binary could follow.
+	if (ioScanner.IsAt('<'))
+		{
+		Data_ZZ theData;
+		if (ioScanner.TryReadBinary(theData))
+			{
+			oVal = theData;
+			return true;
+			}
+		}
+
+	return ioScanner.TryReadOther(oVal);
+	}
+
+template <class Target_p>
+bool spPull_JSON(const PaC<const UTF8>& iPaC, size_t* oCountConsumed,
+	const Util_Chan_JSON::PullTextOptions_JSON& iRO,
+	bool (*iPull)(Scanner_JSON&, Target_p&), Target_p& ioTarget)
+	{
+	const UTF8* const theSource = sPointer(iPaC);
+	const size_t theCount = sCount(iPaC);
+
+	if (spIsWellFormed(theSource, theSource + theCount))
+		{
+		Scanner_JSON theScanner(iPaC, iRO);
+		const bool result = iPull(theScanner, ioTarget);
+		if (oCountConsumed)
+			*oCountConsumed = theScanner.CountConsumed();
+		return result;
+		}
+
+	// Cleaning up never makes things longer.
+	vector<UTF8> theBuffer(theCount);
+	size_t theCleanCount;
+	Unicode::sUTF8ToUTF8(theSource, theCount,
+		nullptr, nullptr,
+		theBuffer.data(), theCount,
+		&theCleanCount,
+		theCount, nullptr);
+
+	Scanner_JSON theScanner(PaC<const UTF8>(theBuffer.data(), theCleanCount), iRO);
+	const bool result = iPull(theScanner, ioTarget);
+	if (oCountConsumed)
+		{
+		// Map the count back to theSource, by way of the number of code points consumed.
+		const size_t theCountCP = Unicode::sCUToCP(theBuffer.data(), theScanner.CountConsumed());
+		Unicode::sUTF8ToUTF8(theSource, theCount,
+			oCountConsumed, nullptr,
+			theBuffer.data(), theCount,
+			nullptr,
+			theCountCP, nullptr);
+		}
+	return result;
+	}
+
+bool sPull_JSON_Push_PPT(const PaC<const UTF8>& iPaC, size_t* oCountConsumed,
+	const Util_Chan_JSON::PullTextOptions_JSON& iRO,
+	const ChanW_PPT& iChanW)
+	{ return spPull_JSON(iPaC, oCountConsumed, iRO, spPull_JSON_Push_PPT, iChanW); }
+
+bool sPull_JSON_AsZZ(const PaC<const UTF8>& iPaC, size_t* oCountConsumed,
+	const Util_Chan_JSON::PullTextOptions_JSON& iRO,
+	Val_ZZ& oVal)
+	{ return spPull_JSON(iPaC, oCountConsumed, iRO, spPull_JSON_AsZZ, oVal); }
+
 // =================================================================================================
 #pragma mark -
 
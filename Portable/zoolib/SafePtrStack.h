@@ -23,8 +23,12 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zconfig.h"
 
 #include "zoolib/ZDebug.h"
+#include "zoolib/ZStdInt.h"
 #include "zoolib/ZThread.h"
 
+#include <atomic>
+#include <utility> // For std::swap
+
 namespace ZooLib {
 
 // In these templates, P is Pointer and L is Link.
@@ -102,6 +106,258 @@ public:
 		}
 	};
 
+// =================================================================================================
+#pragma mark - SafePtrStack_Caching
+
+/*
+A drop-in for SafePtrStack_WithDestroyer that does not serialize every Push and Pop on a mutex.
+
+Each thread keeps two magazines, chains of up to kMagazineSize entries, and pushes and pops
+against them without synchronization. Only when both are full (or both are empty) does a
+thread exchange a whole magazine with the depot, a fixed array of kDepotSize slots shared by
+all threads. The depot's full and empty slot lists are lock-free stacks whose heads pack a
+slot index with a generation tag, so a slot that is popped and re-pushed between another
+thread's load and CAS cannot be mistaken for the one it saw (the ABA problem).
+
+Retention is bounded: a magazine that finds the depot full is deleted rather than kept. A
+thread's magazines are handed to the depot when the thread exits.
+
+The per-thread magazines are keyed by the template instantiation, so there must be only one
+instance of any given SafePtrStack_Caching<P,L,...>. That is how SafePtrStacks are used anyway,
+as a single static alongside the class whose instances they recycle.
+*/
+
+template <typename P, typename L = P, size_t kMagazineSize = 32, size_t kDepotSize = 64>
+class SafePtrStack_Caching
+	{
+public:
+	struct Stats
+		{
+		uint64 fDepotPuts; // Magazines handed to the depot.
+		uint64 fDepotGets; // Magazines taken from the depot.
+		uint64 fDepotMisses; // Pops that found the thread's magazines and the depot empty.
+		uint64 fDeletes; // Entries deleted because the depot was full.
+		};
+
+	SafePtrStack_Caching()
+	:	fFull(spPack(kNil, 0))
+	,	fEmpty(spPack(kNil, 0))
+	,	fDepotPuts(0)
+	,	fDepotGets(0)
+	,	fDepotMisses(0)
+	,	fDeletes(0)
+		{
+		for (size_t xx = kDepotSize; xx; --xx)
+			{
+			fSlots[xx - 1].fHead = nullptr;
+			fSlots[xx - 1].fCount = 0;
+			this->pPushSlot(fEmpty, uint32(xx - 1));
+			}
+		}
+
+	~SafePtrStack_Caching()
+		{
+		uint32 theIndex;
+		while (this->pPopSlot(fFull, theIndex))
+			spDelete(fSlots[theIndex].fHead);
+		}
+
+	void Push(L* iL)
+		{
+		ZAssertStop(L::kDebug, iL);
+		ZAssertStop(L::kDebug, not iL->fNext);
+
+		Cache& theCache = this->pCache();
+		if (theCache.fLoaded.fCount == kMagazineSize)
+			{
+			if (theCache.fPrevious.fCount == kMagazineSize)
+				this->pPut(theCache.fPrevious);
+			std::swap(theCache.fLoaded, theCache.fPrevious);
+			}
+
+		iL->fNext = theCache.fLoaded.fHead;
+		theCache.fLoaded.fHead = iL;
+		++theCache.fLoaded.fCount;
+		}
+
+	template <class Q>
+	Q* PopIfNotEmpty()
+		{
+		Cache& theCache = this->pCache();
+		if (not theCache.fLoaded.fCount)
+			{
+			if (theCache.fPrevious.fCount)
+				{
+				std::swap(theCache.fLoaded, theCache.fPrevious);
+				}
+			else if (not this->pGet(theCache.fLoaded))
+				{
+				fDepotMisses.fetch_add(1, std::memory_order_relaxed);
+				return nullptr;
+				}
+			}
+
+		L* result = theCache.fLoaded.fHead;
+		theCache.fLoaded.fHead = result->fNext;
+		--theCache.fLoaded.fCount;
+		result->fNext = nullptr;
+		return static_cast<Q*>(result);
+		}
+
+	Stats GetStats() const
+		{
+		Stats result;
+		result.fDepotPuts = fDepotPuts.load(std::memory_order_relaxed);
+		result.fDepotGets = fDepotGets.load(std::memory_order_relaxed);
+		result.fDepotMisses = fDepotMisses.load(std::memory_order_relaxed);
+		result.fDeletes = fDeletes.load(std::memory_order_relaxed);
+		return result;
+		}
+
+private:
+	static const uint32 kNil = 0xFFFFFFFFu;
+
+	struct Magazine
+		{
+		L* fHead;
+		size_t fCount;
+		};
+
+	struct Slot
+		{
+		L* fHead;
+		size_t fCount;
+		std::atomic<uint32> fNext;
+		};
+
+	struct Cache
+		{
+		Cache()
+		:	fPool(nullptr)
+			{
+			fLoaded.fHead = nullptr;
+			fLoaded.fCount = 0;
+			fPrevious.fHead = nullptr;
+			fPrevious.fCount = 0;
+			}
+
+		~Cache()
+			{
+			if (fPool)
+				{
+				fPool->pPut(fLoaded);
+				fPool->pPut(fPrevious);
+				}
+			}
+
+		SafePtrStack_Caching* fPool;
+		Magazine fLoaded;
+		Magazine fPrevious;
+		};
+
+	Cache& pCache()
+		{
+		static thread_local Cache spCache;
+		if (not spCache.fPool)
+			spCache.fPool = this;
+		ZAssertStop(L::kDebug, spCache.fPool == this);
+		return spCache;
+		}
+
+	static uint64 spPack(uint32 iIndex, uint32 iTag)
+		{ return uint64(iTag) << 32 | iIndex; }
+
+	bool pPopSlot(std::atomic<uint64>& ioHead, uint32& oIndex)
+		{
+		uint64 theHead = ioHead.load(std::memory_order_acquire);
+		for (;;)
+			{
+			const uint32 theIndex = uint32(theHead);
+			if (theIndex == kNil)
+				return false;
+
+			// fNext may be stale if the slot has been popped meanwhile, but then the tag
+			// will have moved on and the CAS fails.
+			const uint32 theNext = fSlots[theIndex].fNext.load(std::memory_order_relaxed);
+			if (ioHead.compare_exchange_weak(theHead, spPack(theNext, uint32(theHead >> 32) + 1),
+				std::memory_order_acquire, std::memory_order_acquire))
+				{
+				oIndex = theIndex;
+				return true;
+				}
+			}
+		}
+
+	void pPushSlot(std::atomic<uint64>& ioHead, uint32 iIndex)
+		{
+		uint64 theHead = ioHead.load(std::memory_order_relaxed);
+		for (;;)
+			{
+			fSlots[iIndex].fNext.store(uint32(theHead), std::memory_order_relaxed);
+			if (ioHead.compare_exchange_weak(theHead, spPack(iIndex, uint32(theHead >> 32) + 1),
+				std::memory_order_release, std::memory_order_relaxed))
+				{
+				return;
+				}
+			}
+		}
+
+	void pPut(Magazine& ioMagazine)
+		{
+		if (not ioMagazine.fCount)
+			return;
+
+		uint32 theIndex;
+		if (this->pPopSlot(fEmpty, theIndex))
+			{
+			fSlots[theIndex].fHead = ioMagazine.fHead;
+			fSlots[theIndex].fCount = ioMagazine.fCount;
+			this->pPushSlot(fFull, theIndex);
+			fDepotPuts.fetch_add(1, std::memory_order_relaxed);
+			}
+		else
+			{
+			fDeletes.fetch_add(ioMagazine.fCount, std::memory_order_relaxed);
+			spDelete(ioMagazine.fHead);
+			}
+
+		ioMagazine.fHead = nullptr;
+		ioMagazine.fCount = 0;
+		}
+
+	bool pGet(Magazine& oMagazine)
+		{
+		uint32 theIndex;
+		if (not this->pPopSlot(fFull, theIndex))
+			return false;
+
+		oMagazine.fHead = fSlots[theIndex].fHead;
+		oMagazine.fCount = fSlots[theIndex].fCount;
+		this->pPushSlot(fEmpty, theIndex);
+		fDepotGets.fetch_add(1, std::memory_order_relaxed);
+		return true;
+		}
+
+	static void spDelete(L* iL)
+		{
+		while (L* theL = iL)
+			{
+			iL = theL->fNext;
+			theL->fNext = nullptr;
+			delete static_cast<P*>(theL);
+			}
+		}
+
+	Slot fSlots[kDepotSize];
+	std::atomic<uint64> fFull;
+	std::atomic<uint64> fEmpty;
+
+	std::atomic<uint64> fDepotPuts;
+	std::atomic<uint64> fDepotGets;
+	std::atomic<uint64> fDepotMisses;
+	std::atomic<uint64> fDeletes;
+	};
+
 // =================================================================================================
 #pragma mark - SafePtrStackLink
 
@@ -21,119 +21,504 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/StartScheduler.h"
 
 #include "zoolib/Singleton.h"
-#include "zoolib/Util_STL_set.h"
 
-namespace ZooLib {
+#include <cmath> // For ceil, floor
+#include <limits>
 
-using std::set;
+namespace ZooLib {
 
-using namespace Util_STL;
+using std::vector;
 
 // =================================================================================================
-#pragma mark - StartScheduler
+#pragma mark - StartScheduler::Shard
 
-StartScheduler::StartScheduler()
+namespace { // anonymous
+
+const size_t kSlotBits = 8;
+const size_t kSlotCount = 1 << kSlotBits;
+const int64 kSlotMask = kSlotCount - 1;
+const size_t kLevelCount = 4;
+
+struct Node
+	{
+	StartScheduler::Job fJob;
+	size_t fHash;
+	int64 fTick;
+
+	// Chain in the index bucket, or in the free list.
+	Node* fHashNext;
+
+	// Doubly-linked membership of a wheel slot, or of the overflow or due lists.
+	Node* fNext;
+	Node** fPrevNext;
+	};
+
+void spUnlink(Node* iNode)
+	{
+	*iNode->fPrevNext = iNode->fNext;
+	if (iNode->fNext)
+		iNode->fNext->fPrevNext = iNode->fPrevNext;
+	}
+
+void spLink(Node*& ioHead, Node* iNode)
+	{
+	iNode->fNext = ioHead;
+	iNode->fPrevNext = &ioHead;
+	if (ioHead)
+		ioHead->fPrevNext = &iNode->fNext;
+	ioHead = iNode;
+	}
+
+} // anonymous namespace
+
+class StartScheduler::Shard
+	{
+public:
+	Shard(double iTolerance);
+	~Shard();
+
+	bool Cancel(const Job& iJob, size_t iHash);
+
+	void NextStartAt(double iSystemTime, const Job& iJob, size_t iHash);
+
+private:
+	int64 pTickCeil(double iSystemTime);
+	int64 pTickFloor(double iSystemTime);
+
+	Node* pFind(const Job& iJob, size_t iHash);
+	void pIndexInsert(Node* iNode);
+	void pIndexErase(Node* iNode);
+
+	void pWheelInsert(Node* iNode);
+	void pCascade(size_t iLevel);
+	void pAdvance(int64 iTick);
+	int64 pNextTick();
+
+	void pRun();
+	static void spRun(Shard* iShard);
+
+	ZMtx fMtx;
+	ZCnd fCnd;
+
+	bool fThreadRunning;
+	bool fShutdown;
+
+	const double fTolerance;
+	const double fEpoch;
+	int64 fCurrentTick;
+	int64 fWaitTick;
+
+	// The index, an intrusively chained hash table.
+	vector<Node*> fBuckets;
+	size_t fCount;
+
+	// The wheel.
+	Node* fSlots[kLevelCount][kSlotCount];
+	Node* fOverflow;
+	Node* fDue;
+
+	// Retired nodes, for reuse.
+	Node* fFree;
+
+	vector<Job> fToStart;
+	};
+
+StartScheduler::Shard::Shard(double iTolerance)
 :	fThreadRunning(false)
-	{}
+,	fShutdown(false)
+,	fTolerance(iTolerance > 0 ? iTolerance : 1e-3)
+,	fEpoch(Time::sSystem())
+,	fCurrentTick(0)
+,	fWaitTick(0)
+,	fBuckets(64, nullptr)
+,	fCount(0)
+,	fOverflow(nullptr)
+,	fDue(nullptr)
+,	fFree(nullptr)
+	{
+	for (size_t level = 0; level < kLevelCount; ++level)
+		{
+		for (size_t slot = 0; slot < kSlotCount; ++slot)
+			fSlots[level][slot] = nullptr;
+		}
+	}
 
-bool StartScheduler::Cancel(const Job& iJob)
+StartScheduler::Shard::~Shard()
+	{
 	{
 	ZAcqMtx acq(fMtx);
+	fShutdown = true;
+	fCnd.Broadcast();
+	while (fThreadRunning)
+		fCnd.Wait(fMtx);
+	}
 
-	set<JobTime>::iterator iterJT = fJobTimes.lower_bound(JobTime(iJob, 0.0));
-	if (iterJT != fJobTimes.end() && iterJT->first == iJob)
+	for (size_t xx = 0; xx < fBuckets.size(); ++xx)
 		{
-		sEraseMust(fTimeJobs, TimeJob(iterJT->second, iJob));
-		fJobTimes.erase(iterJT);
+		for (Node* theNode = fBuckets[xx]; theNode; /*no inc*/)
+			{
+			Node* theNext = theNode->fHashNext;
+			delete theNode;
+			theNode = theNext;
+			}
+		}
+
+	for (Node* theNode = fFree; theNode; /*no inc*/)
+		{
+		Node* theNext = theNode->fHashNext;
+		delete theNode;
+		theNode = theNext;
+		}
+	}
+
+bool StartScheduler::Shard::Cancel(const Job& iJob, size_t iHash)
+	{
+	ZAcqMtx acq(fMtx);
+
+	if (Node* theNode = this->pFind(iJob, iHash))
+		{
+		spUnlink(theNode);
+		this->pIndexErase(theNode);
 		return true;
 		}
 	return false;
 	}
 
-void StartScheduler::NextStartAt(double iSystemTime, const Job& iJob)
-	{ this->pNextStartAt(iSystemTime, iJob); }
+void StartScheduler::Shard::NextStartAt(double iSystemTime, const Job& iJob, size_t iHash)
+	{
+	ZAcqMtx acq(fMtx);
 
-void StartScheduler::NextStartIn(double iInterval, const Job& iJob)
-	{ this->pNextStartAt(Time::sSystem() + iInterval, iJob); }
+	const int64 theTick = this->pTickCeil(iSystemTime);
+
+	if (Node* theNode = this->pFind(iJob, iHash))
+		{
+		// As before, a job can be brought forward, but not pushed back.
+		if (theTick < theNode->fTick)
+			{
+			spUnlink(theNode);
+			theNode->fTick = theTick;
+			this->pWheelInsert(theNode);
+			if (fThreadRunning && theTick < fWaitTick)
+				fCnd.Broadcast();
+			}
+		return;
+		}
+
+	Node* theNode = fFree;
+	if (theNode)
+		fFree = theNode->fHashNext;
+	else
+		theNode = new Node;
+
+	theNode->fJob = iJob;
+	theNode->fHash = iHash;
+	theNode->fTick = theTick;
+	this->pIndexInsert(theNode);
+	this->pWheelInsert(theNode);
+
+	if (not fThreadRunning)
+		{
+		fThreadRunning = true;
+		ZThread::sStart_T<Shard*>(spRun, this);
+		}
+	else if (theTick < fWaitTick)
+		{
+		fCnd.Broadcast();
+		}
+	}
 
-void StartScheduler::pNextStartAt(double iSystemTime, const Job& iJob)
+// Converting a double outside int64's range is undefined, so clamp. NaN fails both tests, and
+// like +inf becomes the last tick, one we'll never reach.
+static int64 spClamped(double iTicks)
 	{
-	ZAssert(iJob.first);
+	if (not (iTicks < double(std::numeric_limits<int64>::max())))
+		return std::numeric_limits<int64>::max();
+	if (iTicks <= double(std::numeric_limits<int64>::min()))
+		return std::numeric_limits<int64>::min();
+	return int64(iTicks);
+	}
 
-	ZAcqMtx acq(fMtx);
+int64 StartScheduler::Shard::pTickCeil(double iSystemTime)
+	{ return spClamped(std::ceil((iSystemTime - fEpoch) / fTolerance)); }
+
+int64 StartScheduler::Shard::pTickFloor(double iSystemTime)
+	{ return spClamped(std::floor((iSystemTime - fEpoch) / fTolerance)); }
+
+Node* StartScheduler::Shard::pFind(const Job& iJob, size_t iHash)
+	{
+	for (Node* theNode = fBuckets[iHash & (fBuckets.size() - 1)];
+		theNode; theNode = theNode->fHashNext)
+		{
+		if (theNode->fHash == iHash && theNode->fJob == iJob)
+			return theNode;
+		}
+	return nullptr;
+	}
 
-	set<JobTime>::iterator iterJT = fJobTimes.lower_bound(JobTime(iJob, 0.0));
-	if (iterJT != fJobTimes.end() && iterJT->first == iJob)
+void StartScheduler::Shard::pIndexInsert(Node* iNode)
+	{
+	if (++fCount > fBuckets.size())
 		{
-		if (iSystemTime < iterJT->second)
+		// Grow, and rehash the existing chains.
+		vector<Node*> newBuckets(fBuckets.size() * 2, nullptr);
+		const size_t newMask = newBuckets.size() - 1;
+		for (size_t xx = 0; xx < fBuckets.size(); ++xx)
 			{
-			sEraseMust(fTimeJobs, TimeJob(iterJT->second, iJob));
-			fJobTimes.erase(iterJT);
+			for (Node* theNode = fBuckets[xx]; theNode; /*no inc*/)
+				{
+				Node* theNext = theNode->fHashNext;
+				Node*& theBucket = newBuckets[theNode->fHash & newMask];
+				theNode->fHashNext = theBucket;
+				theBucket = theNode;
+				theNode = theNext;
+				}
+			}
+		fBuckets.swap(newBuckets);
+		}
 
-			sInsertMust(fTimeJobs, TimeJob(iSystemTime, iJob));
-			sInsertMust(fJobTimes, JobTime(iJob, iSystemTime));
-			fCnd.Broadcast();
+	Node*& theBucket = fBuckets[iNode->fHash & (fBuckets.size() - 1)];
+	iNode->fHashNext = theBucket;
+	theBucket = iNode;
+	}
+
+void StartScheduler::Shard::pIndexErase(Node* iNode)
+	{
+	for (Node** thePrevNext = &fBuckets[iNode->fHash & (fBuckets.size() - 1)];
+		*thePrevNext; thePrevNext = &(*thePrevNext)->fHashNext)
+		{
+		if (*thePrevNext == iNode)
+			{
+			*thePrevNext = iNode->fHashNext;
+			break;
 			}
 		}
+	--fCount;
+
+	// Drop the refs now, and keep the node for reuse.
+	iNode->fJob = Job();
+	iNode->fHashNext = fFree;
+	fFree = iNode;
+	}
+
+void StartScheduler::Shard::pWheelInsert(Node* iNode)
+	{
+	const int64 theTick = iNode->fTick;
+	if (theTick <= fCurrentTick)
+		return spLink(fDue, iNode);
+
+	const int64 delta = theTick - fCurrentTick;
+	for (size_t level = 0; level < kLevelCount; ++level)
+		{
+		const size_t shift = level * kSlotBits;
+		if (delta < (int64(1) << (shift + kSlotBits)))
+			return spLink(fSlots[level][(theTick >> shift) & kSlotMask], iNode);
+		}
+
+	spLink(fOverflow, iNode);
+	}
+
+void StartScheduler::Shard::pCascade(size_t iLevel)
+	{
+	Node* theNode;
+	if (iLevel < kLevelCount)
+		{
+		Node*& theSlot = fSlots[iLevel][(fCurrentTick >> (iLevel * kSlotBits)) & kSlotMask];
+		theNode = theSlot;
+		theSlot = nullptr;
+		}
 	else
 		{
-		sInsertMust(fJobTimes, JobTime(iJob, iSystemTime));
-		sInsertMust(fTimeJobs, TimeJob(iSystemTime, iJob));
-		if (not fThreadRunning)
+		theNode = fOverflow;
+		fOverflow = nullptr;
+		}
+
+	while (theNode)
+		{
+		Node* theNext = theNode->fNext;
+		this->pWheelInsert(theNode);
+		theNode = theNext;
+		}
+	}
+
+void StartScheduler::Shard::pAdvance(int64 iTick)
+	{
+	while (fCurrentTick < iTick)
+		{
+		if (not fCount)
 			{
-			fThreadRunning = true;
-			ZThread::sStart_T<StartScheduler*>(spRun, this);
+			fCurrentTick = iTick;
+			break;
+			}
+
+		// Skip over empty level 0 slots, stopping at the boundary where we next cascade.
+		const int64 boundary = (fCurrentTick | kSlotMask) + 1;
+		int64 next = fCurrentTick + 1;
+		while (next < iTick && next < boundary && not fSlots[0][next & kSlotMask])
+			++next;
+		fCurrentTick = next;
+
+		for (size_t level = 1; level <= kLevelCount; ++level)
+			{
+			if (fCurrentTick & ((int64(1) << (level * kSlotBits)) - 1))
+				break;
+			this->pCascade(level);
+			}
+
+		Node*& theSlot = fSlots[0][fCurrentTick & kSlotMask];
+		while (Node* theNode = theSlot)
+			{
+			spUnlink(theNode);
+			spLink(fDue, theNode);
+			}
+		}
+	}
+
+int64 StartScheduler::Shard::pNextTick()
+	{
+	if (fDue)
+		return fCurrentTick;
+
+	// The next occupied slot at each level gives us the next tick at which there's work to do,
+	// either firing jobs or cascading them to a finer level.
+	int64 result = fCurrentTick + (int64(1) << (kLevelCount * kSlotBits));
+	for (size_t level = 0; level < kLevelCount; ++level)
+		{
+		const size_t shift = level * kSlotBits;
+		const int64 base = fCurrentTick >> shift;
+		for (int64 delta = 1; delta <= int64(kSlotCount); ++delta)
+			{
+			if (fSlots[level][(base + delta) & kSlotMask])
+				{
+				const int64 theTick = (base + delta) << shift;
+				if (result > theTick)
+					result = theTick;
+				break;
+				}
 			}
-		fCnd.Broadcast();
 		}
+
+	// Overflowed nodes are only cascaded when fCurrentTick crosses a multiple of the wheel's
+	// span, which may be well past their ticks. They're rare, so just walk the list.
+	for (Node* theNode = fOverflow; theNode; theNode = theNode->fNext)
+		{
+		if (result > theNode->fTick)
+			result = theNode->fTick;
+		}
+
+	return result;
 	}
 
-void StartScheduler::pRun()
+void StartScheduler::Shard::pRun()
 	{
 	ZAcqMtx acq(fMtx);
 	for (;;)
 		{
-		if (fTimeJobs.empty())
+		if (fShutdown)
+			break;
+
+		if (not fCount)
 			{
 			// Nothing pending, wait 100ms in case something else comes along.
+			fWaitTick = std::numeric_limits<int64>::max();
 			fCnd.WaitFor(fMtx, 100e-3);
-			if (fTimeJobs.empty())
+			if (not fCount)
 				{
 				// Still nothing pending, exit thread.
-				fThreadRunning = false;
 				break;
 				}
+			continue;
 			}
-		else
-			{
-			const set<TimeJob>::iterator& begin = fTimeJobs.begin();
-			const double delta = begin->first - Time::sSystem();
-			if (delta > 0)
-				{
-				fCnd.WaitFor(fMtx, delta);
-				}
-			else
-				{
-				ZP<Starter> theStarter = begin->second.first;
-				ZP<Callable_Void> theCallable = begin->second.second;
 
-				sEraseMust(fJobTimes, JobTime(begin->second, begin->first));
-				fTimeJobs.erase(begin);
+		const double now = Time::sSystem();
+		this->pAdvance(this->pTickFloor(now));
 
-				ZRelMtx rel(fMtx);
+		if (not fDue)
+			{
+			fWaitTick = this->pNextTick();
+			fCnd.WaitFor(fMtx, fEpoch + fWaitTick * fTolerance - now);
+			continue;
+			}
 
-				try { theStarter->QStart(theCallable); }
-				catch (...) {}
-				}
+		while (Node* theNode = fDue)
+			{
+			fToStart.push_back(theNode->fJob);
+			spUnlink(theNode);
+			this->pIndexErase(theNode);
+			}
+
+		{
+		ZRelMtx rel(fMtx);
+		for (vector<Job>::iterator iter = fToStart.begin(); iter != fToStart.end(); ++iter)
+			{
+			try { iter->first->QStart(iter->second); }
+			catch (...) {}
 			}
 		}
+
+		fToStart.clear();
+		}
+
+	fThreadRunning = false;
+	fCnd.Broadcast();
 	}
 
-void StartScheduler::spRun(StartScheduler* iStartScheduler)
+void StartScheduler::Shard::spRun(Shard* iShard)
 	{
 	ZThread::sSetName("StartScheduler");
 
-	iStartScheduler->pRun();
+	iShard->pRun();
+	}
+
+// =================================================================================================
+#pragma mark - StartScheduler
+
+StartScheduler::StartScheduler()
+:	fShards(4, nullptr)
+	{
+	for (size_t xx = 0; xx < fShards.size(); ++xx)
+		fShards[xx] = new Shard(1e-3);
+	}
+
+StartScheduler::StartScheduler(size_t iShardCount, double iTolerance)
+:	fShards(iShardCount ? iShardCount : 1, nullptr)
+	{
+	for (size_t xx = 0; xx < fShards.size(); ++xx)
+		fShards[xx] = new Shard(iTolerance);
+	}
+
+StartScheduler::~StartScheduler()
+	{
+	for (size_t xx = 0; xx < fShards.size(); ++xx)
+		delete fShards[xx];
+	}
+
+bool StartScheduler::Cancel(const Job& iJob)
+	{
+	size_t theHash;
+	return this->pShard(iJob, theHash).Cancel(iJob, theHash);
+	}
+
+void StartScheduler::NextStartAt(double iSystemTime, const Job& iJob)
+	{
+	ZAssert(iJob.first);
+
+	size_t theHash;
+	this->pShard(iJob, theHash).NextStartAt(iSystemTime, iJob, theHash);
+	}
+
+void StartScheduler::NextStartIn(double iInterval, const Job& iJob)
+	{ this->NextStartAt(Time::sSystem() + iInterval, iJob); }
+
+StartScheduler::Shard& StartScheduler::pShard(const Job& iJob, size_t& oHash)
+	{
+	uint64 theHash = uint64(reinterpret_cast<uintptr_t>(iJob.first.Get()));
+	theHash = (theHash ^ (theHash >> 29)) * 0xBF58476D1CE4E5B9ULL;
+	theHash ^= uint64(reinterpret_cast<uintptr_t>(iJob.second.Get()));
+	theHash = (theHash ^ (theHash >> 32)) * 0x94D049BB133111EBULL;
+	theHash ^= theHash >> 29;
+
+	oHash = size_t(theHash);
+	return *fShards[(theHash >> 48) % fShards.size()];
 	}
 
 // =================================================================================================
@@ -27,18 +27,24 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/ZThread.h"
 
-#include <set>
+#include <vector>
 
 namespace ZooLib {
 
 // =================================================================================================
 #pragma mark - StartScheduler
 
+// Jobs are hashed across iShardCount shards, each with its own lock, hierarchical timing wheel
+// and firing thread. Wheel ticks are iTolerance seconds long, so jobs due within the same tick
+// are started as a single batch, no earlier than requested and at most iTolerance late.
+
 class StartScheduler
 :	NonCopyable
 	{
 public:
 	StartScheduler();
+	StartScheduler(size_t iShardCount, double iTolerance);
+	~StartScheduler();
 
 	typedef std::pair<ZP<Starter>,ZP<Callable_Void>> Job;
 
@@ -49,20 +55,10 @@ public:
 	void NextStartIn(double iInterval, const Job& iJob);
 
 private:
-	void pNextStartAt(double iSystemTime, const Job& iJob);
-
-	void pRun();
-	static void spRun(StartScheduler*);
-
-	ZMtx fMtx;
-	ZCnd fCnd;
-
-	bool fThreadRunning;
+	class Shard;
+	Shard& pShard(const Job& iJob, size_t& oHash);
 
-	typedef std::pair<double,Job> TimeJob;
-	typedef std::pair<Job,double> JobTime;
-	std::set<TimeJob> fTimeJobs;
-	std::set<JobTime> fJobTimes;
+	std::vector<Shard*> fShards;
 	};
 
 // =================================================================================================
@@ -0,0 +1,445 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#include "zoolib/Starter_WorkStealingPool.h"
+
+#include "zoolib/ThreadVal.h"
+#include "zoolib/ZThread.h"
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+namespace ZooLib {
+
+using std::atomic;
+using std::deque;
+using std::string;
+using std::vector;
+
+namespace { // anonymous
+
+// =================================================================================================
+#pragma mark - Task
+
+struct Task
+	{
+	ZP<Startable> fStartable;
+	double fEnqueued;
+	};
+
+// =================================================================================================
+#pragma mark - Deque
+
+// Chase-Lev work-stealing deque, following Lê, Pop, Cohen & Zappa Nardelli, "Correct and
+// Efficient Work-Stealing for Weak Memory Models". Push and Take are for the owning thread,
+// Steal may be called from any thread.
+
+class Deque
+	{
+public:
+	Deque()
+	:	fTop(0)
+	,	fBottom(0)
+	,	fArray(new Array(64))
+		{}
+
+	~Deque()
+		{
+		delete fArray.load();
+		for (vector<Array*>::iterator iter = fRetired.begin(); iter != fRetired.end(); ++iter)
+			delete *iter;
+		}
+
+	void Push(Task* iTask)
+		{
+		const int64 bottom = fBottom.load(std::memory_order_relaxed);
+		const int64 top = fTop.load(std::memory_order_acquire);
+		Array* theArray = fArray.load(std::memory_order_relaxed);
+		if (bottom - top > theArray->fSize - 1)
+			{
+			// Stealers may still be looking at the old array, so it's retired rather than deleted.
+			Array* newArray = new Array(theArray->fSize * 2);
+			for (int64 xx = top; xx < bottom; ++xx)
+				newArray->Put(xx, theArray->Get(xx));
+			fRetired.push_back(theArray);
+			theArray = newArray;
+			fArray.store(theArray, std::memory_order_release);
+			}
+		theArray->Put(bottom, iTask);
+		std::atomic_thread_fence(std::memory_order_release);
+		fBottom.store(bottom + 1, std::memory_order_relaxed);
+		}
+
+	Task* Take()
+		{
+		const int64 bottom = fBottom.load(std::memory_order_relaxed) - 1;
+		Array* theArray = fArray.load(std::memory_order_relaxed);
+		fBottom.store(bottom, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		int64 top = fTop.load(std::memory_order_relaxed);
+
+		if (top > bottom)
+			{
+			// Empty.
+			fBottom.store(bottom + 1, std::memory_order_relaxed);
+			return nullptr;
+			}
+
+		Task* result = theArray->Get(bottom);
+		if (top == bottom)
+			{
+			// Last element, race any stealers for it.
+			if (not fTop.compare_exchange_strong(top, top + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+				result = nullptr;
+				}
+			fBottom.store(bottom + 1, std::memory_order_relaxed);
+			}
+		return result;
+		}
+
+	// Returns false if we lost a race and the caller might want to try again.
+	bool Steal(Task*& oTask)
+		{
+		oTask = nullptr;
+		int64 top = fTop.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		const int64 bottom = fBottom.load(std::memory_order_acquire);
+		if (top < bottom)
+			{
+			Array* theArray = fArray.load(std::memory_order_acquire);
+			Task* theTask = theArray->Get(top);
+			if (not fTop.compare_exchange_strong(top, top + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed))
+				{
+				return false;
+				}
+			oTask = theTask;
+			}
+		return true;
+		}
+
+	size_t Size()
+		{
+		const int64 bottom = fBottom.load();
+		const int64 top = fTop.load();
+		return bottom > top ? size_t(bottom - top) : 0;
+		}
+
+private:
+	struct Array
+		{
+		Array(int64 iSize)
+		:	fSize(iSize)
+		,	fSlots(new atomic<Task*>[iSize])
+			{}
+
+		~Array()
+			{ delete[] fSlots; }
+
+		Task* Get(int64 iIndex)
+			{ return fSlots[iIndex & (fSize - 1)].load(std::memory_order_relaxed); }
+
+		void Put(int64 iIndex, Task* iTask)
+			{ fSlots[iIndex & (fSize - 1)].store(iTask, std::memory_order_relaxed); }
+
+		const int64 fSize;
+		atomic<Task*>* fSlots;
+		};
+
+	atomic<int64> fTop;
+	atomic<int64> fBottom;
+	atomic<Array*> fArray;
+	vector<Array*> fRetired;
+	};
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - Starter_WorkStealingPool_Imp
+
+class Starter_WorkStealingPool_Imp
+:	public Starter_WorkStealingPool
+	{
+public:
+	Starter_WorkStealingPool_Imp(size_t iThreadCount, const ZQ<string>& iNameQ)
+	:	fKeepRunning(false)
+	,	fThreadsRunning(0)
+	,	fSharedCount(0)
+	,	fSleepers(0)
+	,	fNameQ(iNameQ)
+		{
+		for (size_t xx = 0; xx < (iThreadCount ? iThreadCount : 1); ++xx)
+			fWorkers.push_back(new Worker(this, xx));
+		}
+
+	virtual ~Starter_WorkStealingPool_Imp()
+		{
+		for (vector<Worker*>::iterator iter = fWorkers.begin(); iter != fWorkers.end(); ++iter)
+			{
+			while (Task* theTask = (*iter)->fDeque.Take())
+				delete theTask;
+			delete *iter;
+			}
+
+		for (deque<Task*>::iterator iter = fShared.begin(); iter != fShared.end(); ++iter)
+			delete *iter;
+		}
+
+// From Counted via Starter_WorkStealingPool
+	virtual void Initialize()
+		{
+		Starter_WorkStealingPool::Initialize();
+		ZAcqMtx acq(fMtx);
+
+		ZAssert(not fKeepRunning);
+
+		fKeepRunning = true;
+		fThreadsRunning = fWorkers.size();
+		for (vector<Worker*>::iterator iter = fWorkers.begin(); iter != fWorkers.end(); ++iter)
+			ZThread::sStart_T<Worker*>(&Starter_WorkStealingPool_Imp::spRun, *iter);
+		}
+
+	virtual void Finalize()
+		{
+		ZAcqMtx acq(fMtx);
+		if (not this->FinishFinalize())
+			return;
+
+		ZAssert(fKeepRunning);
+
+		// The last thread out deletes us.
+		fKeepRunning = false;
+		fCnd.Broadcast();
+		}
+
+// From Starter via Starter_WorkStealingPool
+	virtual bool QStart(const ZP<Startable>& iStartable)
+		{
+		if (not iStartable)
+			return false;
+
+		Task* theTask = new Task;
+		theTask->fStartable = iStartable;
+		theTask->fEnqueued = Time::sSystem();
+
+		if (Worker* const* theWorkerP = ThreadVal<Worker*,Tag_Worker>::sPGet())
+			{
+			if ((*theWorkerP)->fPool == this)
+				{
+				(*theWorkerP)->fDeque.Push(theTask);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (fSleepers.load())
+					{
+					ZAcqMtx acq(fMtx);
+					fCnd.Signal();
+					}
+				return true;
+				}
+			}
+
+		ZAcqMtx acq(fMtx);
+		if (not fKeepRunning)
+			{
+			delete theTask;
+			return false;
+			}
+
+		fShared.push_back(theTask);
+		++fSharedCount;
+		if (fSleepers.load())
+			fCnd.Signal();
+		return true;
+		}
+
+// From Starter_WorkStealingPool
+	virtual Stats GetStats()
+		{
+		Stats result;
+		result.fThreadCount = fWorkers.size();
+		result.fQueueDepth = fSharedCount;
+		result.fStartCount = 0;
+		result.fStealCount = 0;
+		result.fLatencyMax = 0;
+
+		uint64 latencyTotal = 0;
+		for (vector<Worker*>::iterator iter = fWorkers.begin(); iter != fWorkers.end(); ++iter)
+			{
+			Worker* theWorker = *iter;
+			result.fQueueDepth += theWorker->fDeque.Size();
+			result.fStartCount += theWorker->fStartCount.load(std::memory_order_relaxed);
+			result.fStealCount += theWorker->fStealCount.load(std::memory_order_relaxed);
+			latencyTotal += theWorker->fLatencyTotal.load(std::memory_order_relaxed);
+			const double theMax = theWorker->fLatencyMax.load(std::memory_order_relaxed) * 1e-6;
+			if (result.fLatencyMax < theMax)
+				result.fLatencyMax = theMax;
+			}
+
+		if (result.fStartCount)
+			result.fLatencyMean = latencyTotal * 1e-6 / result.fStartCount;
+		else
+			result.fLatencyMean = 0;
+
+		return result;
+		}
+
+private:
+	enum { kSharedBatchMax = 64 };
+
+	struct Tag_Worker;
+
+	struct Worker
+		{
+		Worker(Starter_WorkStealingPool_Imp* iPool, size_t iIndex)
+		:	fPool(iPool)
+		,	fIndex(iIndex)
+		,	fStartCount(0)
+		,	fStealCount(0)
+		,	fLatencyTotal(0)
+		,	fLatencyMax(0)
+			{}
+
+		Starter_WorkStealingPool_Imp* const fPool;
+		const size_t fIndex;
+		Deque fDeque;
+
+		// Written only by the worker's own thread, latencies are in microseconds.
+		atomic<uint64> fStartCount;
+		atomic<uint64> fStealCount;
+		atomic<uint64> fLatencyTotal;
+		atomic<uint64> fLatencyMax;
+		};
+
+	Task* pFindWork(Worker* iWorker)
+		{
+		if (Task* theTask = iWorker->fDeque.Take())
+			return theTask;
+
+		if (fSharedCount.load())
+			{
+			ZAcqMtx acq(fMtx);
+			if (not fShared.empty())
+				{
+				// Take our share of the shared queue in one go, keeping the first for ourselves
+				// and putting the rest on our deque, where siblings can still steal them.
+				const size_t theShare = std::min<size_t>(fShared.size(),
+					std::min<size_t>(fShared.size() / fWorkers.size() + 1, kSharedBatchMax));
+
+				Task* theTask = fShared.front();
+				fShared.pop_front();
+				for (size_t xx = 1; xx < theShare; ++xx)
+					{
+					iWorker->fDeque.Push(fShared.front());
+					fShared.pop_front();
+					}
+				fSharedCount -= theShare;
+				return theTask;
+				}
+			}
+
+		const size_t count = fWorkers.size();
+		bool lostRace = true;
+		while (lostRace)
+			{
+			lostRace = false;
+			for (size_t xx = 1; xx < count; ++xx)
+				{
+				Task* theTask;
+				if (not fWorkers[(iWorker->fIndex + xx) % count]->fDeque.Steal(theTask))
+					lostRace = true;
+				else if (theTask)
+					{
+					iWorker->fStealCount.fetch_add(1, std::memory_order_relaxed);
+					return theTask;
+					}
+				}
+			}
+		return nullptr;
+		}
+
+	bool pAnyWork()
+		{
+		if (fSharedCount.load())
+			return true;
+
+		for (vector<Worker*>::iterator iter = fWorkers.begin(); iter != fWorkers.end(); ++iter)
+			{
+			if ((*iter)->fDeque.Size())
+				return true;
+			}
+		return false;
+		}
+
+	void pRun(Worker* iWorker)
+		{
+		if (fNameQ)
+			ZThread::sSetName(fNameQ->c_str());
+		else
+			ZThread::sSetName("WSP");
+
+		ThreadVal<Worker*,Tag_Worker> theTV(iWorker);
+
+		for (;;)
+			{
+			if (Task* theTask = this->pFindWork(iWorker))
+				{
+				const uint64 latency = uint64((Time::sSystem() - theTask->fEnqueued) * 1e6);
+				iWorker->fStartCount.fetch_add(1, std::memory_order_relaxed);
+				iWorker->fLatencyTotal.fetch_add(latency, std::memory_order_relaxed);
+				if (iWorker->fLatencyMax.load(std::memory_order_relaxed) < latency)
+					iWorker->fLatencyMax.store(latency, std::memory_order_relaxed);
+
+				try { theTask->fStartable->Call(); }
+				catch (...) {}
+
+				delete theTask;
+				continue;
+				}
+
+			ZAcqMtx acq(fMtx);
+			if (not fKeepRunning)
+				break;
+
+			// Register as a sleeper before the final check, so a concurrent QStart either
+			// sees us or its work is seen by us.
+			++fSleepers;
+			if (not this->pAnyWork())
+				fCnd.Wait(fMtx);
+			--fSleepers;
+			}
+
+		fMtx.Acquire();
+		const bool isLast = 0 == --fThreadsRunning;
+		fMtx.Release();
+
+		if (isLast)
+			delete this;
+		}
+
+	static void spRun(Worker* iWorker)
+		{ iWorker->fPool->pRun(iWorker); }
+
+	ZMtx fMtx;
+	ZCnd fCnd;
+	bool fKeepRunning;
+	size_t fThreadsRunning;
+
+	deque<Task*> fShared;
+	atomic<size_t> fSharedCount;
+	atomic<size_t> fSleepers;
+
+	vector<Worker*> fWorkers;
+	const ZQ<string> fNameQ;
+	};
+
+// =================================================================================================
+#pragma mark - sStarter_WorkStealingPool
+
+ZP<Starter_WorkStealingPool> sStarter_WorkStealingPool(size_t iThreadCount, const string& iName)
+	{ return new Starter_WorkStealingPool_Imp(iThreadCount, iName); }
+
+ZP<Starter_WorkStealingPool> sStarter_WorkStealingPool(size_t iThreadCount)
+	{ return new Starter_WorkStealingPool_Imp(iThreadCount, null); }
+
+} // namespace ZooLib
@@ -0,0 +1,47 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#ifndef __ZooLib_Starter_WorkStealingPool_h__
+#define __ZooLib_Starter_WorkStealingPool_h__ 1
+#include "zconfig.h"
+
+#include <string>
+
+#include "zoolib/Starter.h"
+
+namespace ZooLib {
+
+// =================================================================================================
+#pragma mark - Starter_WorkStealingPool
+
+// A fixed pool of threads, each with its own Chase-Lev deque. A Startable started from within
+// a pool thread goes onto that thread's deque, others go onto a shared queue. Idle threads steal
+// from their siblings before parking.
+
+class Starter_WorkStealingPool
+:	public Starter
+	{
+public:
+	struct Stats
+		{
+		size_t fThreadCount;
+		size_t fQueueDepth;
+		uint64 fStartCount;
+		uint64 fStealCount;
+		double fLatencyMean;
+		double fLatencyMax;
+		};
+
+	virtual Stats GetStats() = 0;
+	};
+
+// =================================================================================================
+#pragma mark - sStarter_WorkStealingPool
+
+ZP<Starter_WorkStealingPool> sStarter_WorkStealingPool(
+	size_t iThreadCount, const std::string& iName);
+
+ZP<Starter_WorkStealingPool> sStarter_WorkStealingPool(size_t iThreadCount);
+
+} // namespace ZooLib
+
+#endif // __ZooLib_Starter_WorkStealingPool_h__
@@ -22,6 +22,8 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/Util_Chan.h"
 
+#include <string.h> // For strlen
+
 // =================================================================================================
 #pragma mark - Util_Chan_Bin_Operators
 
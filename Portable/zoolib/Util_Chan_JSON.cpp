@@ -25,12 +25,12 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/Chan_UTF_Escaped.h"
 #include "zoolib/ChanW_Bin_HexStrim.h"
 #include "zoolib/Coerce_Any.h"
-#include "zoolib/Compat_cmath.h" // For fmod
 #include "zoolib/ParseException.h"
 #include "zoolib/Unicode.h"
 #include "zoolib/UTCDateTime.h"
 #include "zoolib/Util_Chan_UTF.h"
 #include "zoolib/Util_Chan_UTF_Operators.h"
+#include "zoolib/Util_Number.h"
 #include "zoolib/Util_Time.h"
 
 #include <vector>
@@ -219,29 +219,103 @@ void sWriteLFIndent(size_t iCount, const PushTextOptions& iOptions, const ChanW_
 	sWriteIndent(iCount, iOptions, iChanW);
 	}
 
-void sWriteString(const string& iString, bool iPreferSingleQuotes, const ChanW_UTF& iChanW)
+static bool spNeedsEscaping(UTF8 iCU, UTF8 iQuote)
+	{ return uint8(iCU) < 0x20 || iCU == 0x7F || iCU == '\\' || iCU == iQuote; }
+
+// sFormat_Double doesn't nul-terminate, so we consider only the iCount code units it wrote.
+static bool spIsIntegral(const char* iChars, size_t iCount)
+	{
+	for (size_t xx = 0; xx < iCount; ++xx)
+		{
+		if (iChars[xx] != '-' && (iChars[xx] < '0' || iChars[xx] > '9'))
+			return false;
+		}
+	return true;
+	}
+
+static void spWriteEscaped(const string& iString, UTF8 iQuote, const ChanW_UTF& iChanW)
 	{
 	ChanW_UTF_Escaped::Options theOptions;
+	theOptions.fQuoteQuotes = iQuote == '"';
 	theOptions.fEscapeHighUnicode = false;
 
-	if (iPreferSingleQuotes)
+	ChanW_UTF_Escaped theChanW_Escaped(theOptions, iChanW);
+
+	// Runs needing no escaping are copied directly to iChanW, and only the code units that need
+	// it go through theChanW_Escaped. A run following a CR goes through theChanW_Escaped too,
+	// because the handling of the CR depends on what follows it. And should we come across a
+	// malformed sequence then everything from the start of its run is left to
+	// theChanW_Escaped, so the result is exactly as if everything had gone through it.
+	const UTF8* current = iString.data();
+	const UTF8* const end = current + iString.size();
+	bool priorWasCR = false;
+	while (current < end)
 		{
-		iChanW << "'";
+		const UTF8* runEnd = current;
+		while (runEnd < end)
+			{
+			const uint8 theCU = *runEnd;
+			if (theCU < 0x80)
+				{
+				if (spNeedsEscaping(theCU, iQuote))
+					break;
+				++runEnd;
+				continue;
+				}
+
+			// Overlong sequences could decode to something needing escaping, and so are
+			// treated as malformed.
+			const size_t theLength = Unicode::sUTF8SequenceLength[theCU];
+			if (theLength < 2 || theLength > 4 || theLength > size_t(end - runEnd))
+				break;
+			if (theCU < 0xC2
+				|| (theCU == 0xE0 && uint8(runEnd[1]) < 0xA0)
+				|| (theCU == 0xF0 && uint8(runEnd[1]) < 0x90))
+				{ break; }
+
+			size_t xx = 1;
+			while (xx < theLength && (uint8(runEnd[xx]) & 0xC0) == 0x80)
+				++xx;
+			if (xx < theLength)
+				break;
+			runEnd += theLength;
+			}
+
+		if (runEnd < end && uint8(*runEnd) >= 0x80)
+			{
+			sEWrite(theChanW_Escaped, current, end - current);
+			break;
+			}
 
-		theOptions.fQuoteQuotes = false;
+		if (current < runEnd)
+			{
+			if (priorWasCR)
+				sEWrite(theChanW_Escaped, current, runEnd - current);
+			else
+				sEWrite(iChanW, current, runEnd - current);
+			}
 
-		ChanW_UTF_Escaped(theOptions, iChanW) << iString;
+		if (runEnd == end)
+			break;
+
+		priorWasCR = *runEnd == '\r';
+		sEWrite(theChanW_Escaped, UTF32(*runEnd));
+		current = runEnd + 1;
+		}
+	}
 
+void sWriteString(const string& iString, bool iPreferSingleQuotes, const ChanW_UTF& iChanW)
+	{
+	if (iPreferSingleQuotes)
+		{
+		iChanW << "'";
+		spWriteEscaped(iString, '\'', iChanW);
 		iChanW << "'";
 		}
 	else
 		{
 		iChanW << "\"";
-
-		theOptions.fQuoteQuotes = true;
-
-		ChanW_UTF_Escaped(theOptions, iChanW) << iString;
-
+		spWriteEscaped(iString, '"', iChanW);
 		iChanW << "\"";
 		}
 	}
@@ -323,12 +397,13 @@ void sWriteSimpleValue(const AnyBase& iAny, const PushTextOptions_JSON& iOptions
 		}
 	else if (const double* asDouble = iAny.PGet<double>())
 		{
-		Util_Chan::sWriteExact(w, *asDouble);
-		if (not fmod(*asDouble, 1.0))
+		char buffer[Util_Number::kBufferSize];
+		const size_t theCount = Util_Number::sFormat_Double(*asDouble, buffer);
+		sEWrite(w, buffer, theCount);
+		if (spIsIntegral(buffer, theCount))
 			{
-			// There's no fractional part, so we'll have written a sequence of digits with no
-			// decimal point. So the number would likely be subsequently interpreted as an
-			// integer, so we append a ".0".
+			// We've written a sequence of digits with no decimal point or exponent. So the
+			// number would likely be subsequently interpreted as an integer, so we append a ".0".
 			w << ".0";
 			}
 		}
@@ -25,7 +25,11 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/Chan_UTF_string.h" // For ChanW_UTF_string8
 #include "zoolib/ChanR_XX_Boundary.h"
 #include "zoolib/ParseException.h"
+#include "zoolib/Stringf.h"
 #include "zoolib/Unicode.h" // For Unicode::sIsEOL
+#include "zoolib/Util_Number.h"
+
+#include <stdlib.h> // For strtod
 
 #include <vector>
 
@@ -261,12 +265,11 @@ bool sTryRead_HexInteger(const ChanRU_UTF& iChanRU, int64& oInt64)
 	{ return spTryRead_HexInteger(iChanRU, oInt64); }
 
 static bool spTryRead_Mantissa(const ChanRU_UTF& iChanRU,
-	int64& oInt64, double& oDouble, bool& oIsDouble)
+	int64& oInt64, string8& ioDigits, bool& oIsDouble)
 	{
 	using namespace Util_Chan;
 
 	oInt64 = 0;
-	oDouble = 0;
 	oIsDouble = false;
 
 	for (bool gotAny = false; /*no test*/; gotAny = true)
@@ -286,8 +289,7 @@ static bool spTryRead_Mantissa(const ChanRU_UTF& iChanRU,
 				oIsDouble = true;
 				}
 			}
-		oDouble *= 10;
-		oDouble += curDigit;
+		ioDigits += char('0' + curDigit);
 		}
 	}
 
@@ -350,25 +352,24 @@ static bool spTryRead_DecimalNumber(const ChanRU_UTF& iChanRU,
 		return true;
 		}
 
-	if (not spTryRead_Mantissa(iChanRU, oInt64, oDouble, oIsDouble))
+	// Accumulate the digits and the exponent, and make a single correctly-rounded conversion at
+	// the end. Accumulating into a double loses precision with every digit.
+	string8 theDigits;
+	if (not spTryRead_Mantissa(iChanRU, oInt64, theDigits, oIsDouble))
 		return false;
 
+	int64 theExponent = 0;
 	if (sTryRead_CP('.', iChanRU))
 		{
 		oIsDouble = true;
-		double fracPart = 0.0;
-		double divisor = 1.0;
-
 		for (;;)
 			{
 			int curDigit;
 			if (not spTryRead_Digit(iChanRU, curDigit))
 				break;
-			divisor *= 10;
-			fracPart *= 10;
-			fracPart += curDigit;
+			theDigits += char('0' + curDigit);
+			--theExponent;
 			}
-		oDouble += fracPart / divisor;
 		}
 
 	if (sTryRead_CP('e', iChanRU) || sTryRead_CP('E', iChanRU))
@@ -377,9 +378,14 @@ static bool spTryRead_DecimalNumber(const ChanRU_UTF& iChanRU,
 		int64 exponent;
 		if (not spTryRead_SignedDecimalInteger(iChanRU, exponent))
 			sThrow_ParseException("Expected a valid exponent after 'e'");
-		oDouble = oDouble * pow(10.0, int(exponent));
+		theExponent += exponent;
 		}
 
+	if (oIsDouble)
+		oDouble = sDecimalAsDouble(theDigits.data(), theDigits.size(), theExponent);
+	else
+		oDouble = double(oInt64);
+
 	return true;
 	}
 
@@ -442,6 +448,55 @@ bool sTryRead_SignedGenericNumber(const ChanRU_UTF& iChanRU,
 	return false;
 	}
 
+double sDecimalAsDouble(const char* iDigits, size_t iCount, int64 iExponent)
+	{
+	while (iCount && *iDigits == '0')
+		{
+		++iDigits;
+		--iCount;
+		}
+
+	while (iCount && iDigits[iCount - 1] == '0')
+		{
+		--iCount;
+		++iExponent;
+		}
+
+	if (not iCount)
+		return 0.0;
+
+	static const double spPowersOfTen[] =
+		{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+	if (iCount <= 15 && iExponent >= -22 && iExponent <= 22)
+		{
+		// Clinger's fast path. The significand and the power of ten are both exactly
+		// representable, so the single multiply or divide is correctly rounded.
+		uint64 theSignificand = 0;
+		for (size_t xx = 0; xx < iCount; ++xx)
+			theSignificand = theSignificand * 10 + (iDigits[xx] - '0');
+
+		if (iExponent < 0)
+			return double(theSignificand) / spPowersOfTen[-iExponent];
+		return double(theSignificand) * spPowersOfTen[iExponent];
+		}
+
+	// There's at least one non-zero digit, so these are out of range whatever the digits are.
+	if (iExponent > 400)
+		return INFINITY;
+
+	if (iExponent < -400 - int64(iCount))
+		return 0.0;
+
+	// Let strtod do the hard work. With no decimal point the locale doesn't come into it.
+	string8 theString(iDigits, iCount);
+	theString += sStringf("e%d", int(iExponent));
+	return strtod(theString.c_str(), nullptr);
+	}
+
 // -----------------
 
 bool sSkip_WS(const ChanRU_UTF& iChanRU)
@@ -599,16 +654,16 @@ bool sTryRead_EscapedString(UTF32 iDelimiter, const ChanRU_UTF& iChanRU,
 
 void sWriteExact(const ChanW_UTF& iChanW, float iVal)
 	{
-	// 9 decimal digits are necessary and sufficient for single precision IEEE 754.
-	// "What Every Computer Scientist Should Know About Floating Point", Goldberg, 1991.
-	// <http://docs.sun.com/source/806-3568/ncg_goldberg.html>
-	sEWritef(iChanW, "%.9g", iVal);
+	// The shortest text that reads back as iVal, laid out as %.9g would.
+	char buffer[Util_Number::kBufferSize];
+	sEWrite(iChanW, buffer, Util_Number::sFormat_Float(iVal, buffer));
 	}
 
 void sWriteExact(const ChanW_UTF& iChanW, double iVal)
 	{
-	// 17 decimal digits are necessary and sufficient for double precision IEEE 754.
-	sEWritef(iChanW, "%.17g", iVal);
+	// The shortest text that reads back as iVal, laid out as %.17g would.
+	char buffer[Util_Number::kBufferSize];
+	sEWrite(iChanW, buffer, Util_Number::sFormat_Double(iVal, buffer));
 	}
 
 void sWriteExact(const ChanW_UTF& iChanW, long double iVal)
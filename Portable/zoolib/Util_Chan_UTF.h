@@ -65,6 +65,9 @@ bool sTryRead_SignedDecimalInteger(const ChanRU_UTF& iChanRU, int64& oInt64);
 bool sTryRead_SignedGenericNumber(const ChanRU_UTF& iChanRU,
 int64& oInt64, double& oDouble, bool& oIsDouble);
 
+// The double nearest to iDigits * 10^iExponent, where iDigits are ASCII decimal digits.
+double sDecimalAsDouble(const char* iDigits, size_t iCount, int64 iExponent);
+
 // -----------------
 
 bool sSkip_WS(const ChanRU_UTF& iChanRU);
@@ -25,6 +25,7 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/Stringf.h"
 #include "zoolib/Util_Chan.h" // For sCopyAll
 #include "zoolib/Util_Chan_UTF.h"
+#include "zoolib/Util_Number.h"
 
 // =================================================================================================
 #pragma mark - Util_Chan_UTF_Operators
@@ -32,6 +33,18 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace ZooLib {
 namespace Util_Chan_UTF_Operators {
 
+static void spWrite_Int64(const ChanW_UTF& w, int64 iVal)
+	{
+	char buffer[Util_Number::kBufferSize];
+	sEWrite(w, buffer, Util_Number::sFormat_Int64(iVal, buffer));
+	}
+
+static void spWrite_UInt64(const ChanW_UTF& w, uint64 iVal)
+	{
+	char buffer[Util_Number::kBufferSize];
+	sEWrite(w, buffer, Util_Number::sFormat_UInt64(iVal, buffer));
+	}
+
 const ChanW_UTF& operator<<(const ChanW_UTF& w, const string32& iString)
 	{
 	sEWrite(w, iString);
@@ -106,13 +119,13 @@ const ChanW_UTF& operator<<(const ChanW_UTF& w, char iVal)
 
 const ChanW_UTF& operator<<(const ChanW_UTF& w, unsigned char iVal)
 	{
-	sEWritef(w, "%u", (unsigned int)iVal);
+	spWrite_UInt64(w, iVal);
 	return w;
 	}
 
 const ChanW_UTF& operator<<(const ChanW_UTF& w, signed char iVal)
 	{
-	sEWritef(w, "%d", int(iVal));
+	spWrite_Int64(w, iVal);
 	return w;
 	}
 
@@ -124,49 +137,49 @@ const ChanW_UTF& operator<<(const ChanW_UTF& w, __wchar_t iVal)
 
 const ChanW_UTF& operator<<(const ChanW_UTF& w, short iVal)
 	{
-	sEWritef(w, "%d", iVal);
+	spWrite_Int64(w, iVal);
 	return w;
 	}
 
 const ChanW_UTF& operator<<(const ChanW_UTF& w, unsigned short iVal)
 	{
-	sEWritef(w, "%u", iVal);
+	spWrite_UInt64(w, iVal);
 	return w;
 	}
 
 const ChanW_UTF& operator<<(const ChanW_UTF& w, int iVal)
 	{
-	sEWritef(w, "%d", iVal);
+	spWrite_Int64(w, iVal);
 	return w;
 	}
 
 const ChanW_UTF& operator<<(const ChanW_UTF& w, unsigned int iVal)
 	{
-	sEWritef(w, "%u", iVal);
+	spWrite_UInt64(w, iVal);
 	return w;
 	}
 
 const ChanW_UTF& operator<<(const ChanW_UTF& w, long iVal)
 	{
-	sEWritef(w, "%ld", iVal);
+	spWrite_Int64(w, iVal);
 	return w;
 	}
 
 const ChanW_UTF& operator<<(const ChanW_UTF& w, unsigned long iVal)
 	{
-	sEWritef(w, "%lu", iVal);
+	spWrite_UInt64(w, iVal);
 	return w;
 	}
 
 const ChanW_UTF& operator<<(const ChanW_UTF& w, __int64 iVal)
 	{
-	sEWritef(w, "%lld", iVal);
+	spWrite_Int64(w, iVal);
 	return w;
 	}
 
 const ChanW_UTF& operator<<(const ChanW_UTF& w, __uint64 iVal)
 	{
-	sEWritef(w, "%llu", iVal);
+	spWrite_UInt64(w, iVal);
 	return w;
 	}
 
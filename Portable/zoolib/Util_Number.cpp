@@ -0,0 +1,517 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#include "zoolib/Util_Number.h"
+
+#include "zoolib/Compat_cmath.h"
+
+#include <string.h> // For memcpy
+
+namespace ZooLib {
+namespace Util_Number {
+
+// =================================================================================================
+#pragma mark - Integers
+
+namespace { // anonymous
+
+const char spDigitPairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+const uint64 spPowersOfTen[] =
+	{
+	1ULL,
+	10ULL,
+	100ULL,
+	1000ULL,
+	10000ULL,
+	100000ULL,
+	1000000ULL,
+	10000000ULL,
+	100000000ULL,
+	1000000000ULL,
+	10000000000ULL,
+	100000000000ULL,
+	1000000000000ULL,
+	10000000000000ULL,
+	100000000000000ULL,
+	1000000000000000ULL,
+	10000000000000000ULL,
+	100000000000000000ULL,
+	1000000000000000000ULL,
+	10000000000000000000ULL,
+	};
+
+size_t spCountDigits(uint64 iVal)
+	{
+	// iVal | 1 doesn't change the count (10^n is even), and keeps us away from clz(0).
+	iVal |= 1;
+	#if defined(__GNUC__)
+		// 1233/4096 is just over log10(2), so this is the count or one more than it.
+		const size_t theGuess = ((64 - __builtin_clzll(iVal)) * 1233) >> 12;
+		return theGuess + (iVal >= spPowersOfTen[theGuess]);
+	#else
+		size_t theCount = 1;
+		while (theCount < 20 && iVal >= spPowersOfTen[theCount])
+			++theCount;
+		return theCount;
+	#endif
+	}
+
+} // anonymous namespace
+
+size_t sFormat_Int64(int64 iVal, char* oDest)
+	{
+	if (iVal >= 0)
+		return sFormat_UInt64(iVal, oDest);
+
+	*oDest = '-';
+	return 1 + sFormat_UInt64(0 - uint64(iVal), oDest + 1);
+	}
+
+size_t sFormat_UInt64(uint64 iVal, char* oDest)
+	{
+	const size_t theCount = spCountDigits(iVal);
+
+	// Work back from the end, two digits at a time.
+	char* theDest = oDest + theCount;
+	while (iVal >= 100)
+		{
+		const size_t theOffset = size_t(iVal % 100) * 2;
+		iVal /= 100;
+		theDest -= 2;
+		memcpy(theDest, spDigitPairs + theOffset, 2);
+		}
+
+	if (iVal >= 10)
+		memcpy(theDest - 2, spDigitPairs + size_t(iVal) * 2, 2);
+	else
+		theDest[-1] = char('0' + iVal);
+
+	return theCount;
+	}
+
+// =================================================================================================
+#pragma mark - Grisu2
+
+// Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers", 2010.
+// Grisu2 always generates digits that read back as the value they came from, and they're the
+// shortest such for all but a very small fraction of values (for which there's a spare digit).
+
+namespace { // anonymous
+
+struct DiyFP
+	{
+	DiyFP(uint64 iF, int iE) : f(iF), e(iE) {}
+
+	uint64 f;
+	int e;
+	};
+
+DiyFP spSub(const DiyFP& iL, const DiyFP& iR)
+	{ return DiyFP(iL.f - iR.f, iL.e); }
+
+// The upper 64 bits of the 128 bit product, rounded.
+DiyFP spMul(const DiyFP& iL, const DiyFP& iR)
+	{
+	const uint64 lLo = iL.f & 0xFFFFFFFFu;
+	const uint64 lHi = iL.f >> 32;
+	const uint64 rLo = iR.f & 0xFFFFFFFFu;
+	const uint64 rHi = iR.f >> 32;
+
+	const uint64 p0 = lLo * rLo;
+	const uint64 p1 = lLo * rHi;
+	const uint64 p2 = lHi * rLo;
+	const uint64 p3 = lHi * rHi;
+
+	const uint64 theMid =
+		(p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu) + (uint64(1) << 31);
+
+	return DiyFP(p3 + (p1 >> 32) + (p2 >> 32) + (theMid >> 32), iL.e + iR.e + 64);
+	}
+
+DiyFP spNormalized(DiyFP iDiyFP)
+	{
+	while ((iDiyFP.f >> 63) == 0)
+		{
+		iDiyFP.f <<= 1;
+		--iDiyFP.e;
+		}
+	return iDiyFP;
+	}
+
+DiyFP spNormalizedTo(const DiyFP& iDiyFP, int iE)
+	{ return DiyFP(iDiyFP.f << (iDiyFP.e - iE), iE); }
+
+// The value and the boundaries of its rounding interval.
+struct Boundaries
+	{
+	DiyFP fW;
+	DiyFP fMinus;
+	DiyFP fPlus;
+	};
+
+// iFraction and iBiasedExponent are the fields of an IEEE 754 value that has iFractionBits bits of
+// fraction and the given exponent bias.
+Boundaries spBoundaries(uint64 iFraction, int iBiasedExponent, int iFractionBits, int iBias)
+	{
+	const int theBias = iBias + iFractionBits;
+	const DiyFP theV = iBiasedExponent == 0
+		? DiyFP(iFraction, 1 - theBias)
+		: DiyFP(iFraction + (uint64(1) << iFractionBits), iBiasedExponent - theBias);
+
+	// At a power of two the next value down is closer than the next value up.
+	const bool lowerIsCloser = iFraction == 0 && iBiasedExponent > 1;
+
+	const DiyFP thePlus = spNormalized(DiyFP(2 * theV.f + 1, theV.e - 1));
+	const DiyFP theMinus = lowerIsCloser
+		? DiyFP(4 * theV.f - 1, theV.e - 2)
+		: DiyFP(2 * theV.f - 1, theV.e - 1);
+
+	const Boundaries result =
+		{ spNormalized(theV), spNormalizedTo(theMinus, thePlus.e), thePlus };
+	return result;
+	}
+
+// Scaling by a cached power of ten puts the binary exponent in [kAlpha, kGamma], so the integral
+// part fits in 32 bits and digits can be peeled off with 64 bit arithmetic.
+const int kAlpha = -60;
+const int kGamma = -32;
+
+struct CachedPower
+	{
+	uint64 f;
+	int e;
+	int k;
+	};
+
+// 10^k for k from -300 to 324 in steps of 8, as normalized 64 bit fractions.
+const int kCachedPowersMinK = -300;
+const int kCachedPowersStepK = 8;
+
+const CachedPower spCachedPowers[] =
+	{
+	{ 0xAB70FE17C79AC6CA, -1060, -300 },
+	{ 0xFF77B1FCBEBCDC4F, -1034, -292 },
+	{ 0xBE5691EF416BD60C, -1007, -284 },
+	{ 0x8DD01FAD907FFC3C,  -980, -276 },
+	{ 0xD3515C2831559A83,  -954, -268 },
+	{ 0x9D71AC8FADA6C9B5,  -927, -260 },
+	{ 0xEA9C227723EE8BCB,  -901, -252 },
+	{ 0xAECC49914078536D,  -874, -244 },
+	{ 0x823C12795DB6CE57,  -847, -236 },
+	{ 0xC21094364DFB5637,  -821, -228 },
+	{ 0x9096EA6F3848984F,  -794, -220 },
+	{ 0xD77485CB25823AC7,  -768, -212 },
+	{ 0xA086CFCD97BF97F4,  -741, -204 },
+	{ 0xEF340A98172AACE5,  -715, -196 },
+	{ 0xB23867FB2A35B28E,  -688, -188 },
+	{ 0x84C8D4DFD2C63F3B,  -661, -180 },
+	{ 0xC5DD44271AD3CDBA,  -635, -172 },
+	{ 0x936B9FCEBB25C996,  -608, -164 },
+	{ 0xDBAC6C247D62A584,  -582, -156 },
+	{ 0xA3AB66580D5FDAF6,  -555, -148 },
+	{ 0xF3E2F893DEC3F126,  -529, -140 },
+	{ 0xB5B5ADA8AAFF80B8,  -502, -132 },
+	{ 0x87625F056C7C4A8B,  -475, -124 },
+	{ 0xC9BCFF6034C13053,  -449, -116 },
+	{ 0x964E858C91BA2655,  -422, -108 },
+	{ 0xDFF9772470297EBD,  -396, -100 },
+	{ 0xA6DFBD9FB8E5B88F,  -369,  -92 },
+	{ 0xF8A95FCF88747D94,  -343,  -84 },
+	{ 0xB94470938FA89BCF,  -316,  -76 },
+	{ 0x8A08F0F8BF0F156B,  -289,  -68 },
+	{ 0xCDB02555653131B6,  -263,  -60 },
+	{ 0x993FE2C6D07B7FAC,  -236,  -52 },
+	{ 0xE45C10C42A2B3B06,  -210,  -44 },
+	{ 0xAA242499697392D3,  -183,  -36 },
+	{ 0xFD87B5F28300CA0E,  -157,  -28 },
+	{ 0xBCE5086492111AEB,  -130,  -20 },
+	{ 0x8CBCCC096F5088CC,  -103,  -12 },
+	{ 0xD1B71758E219652C,   -77,   -4 },
+	{ 0x9C40000000000000,   -50,    4 },
+	{ 0xE8D4A51000000000,   -24,   12 },
+	{ 0xAD78EBC5AC620000,     3,   20 },
+	{ 0x813F3978F8940984,    30,   28 },
+	{ 0xC097CE7BC90715B3,    56,   36 },
+	{ 0x8F7E32CE7BEA5C70,    83,   44 },
+	{ 0xD5D238A4ABE98068,   109,   52 },
+	{ 0x9F4F2726179A2245,   136,   60 },
+	{ 0xED63A231D4C4FB27,   162,   68 },
+	{ 0xB0DE65388CC8ADA8,   189,   76 },
+	{ 0x83C7088E1AAB65DB,   216,   84 },
+	{ 0xC45D1DF942711D9A,   242,   92 },
+	{ 0x924D692CA61BE758,   269,  100 },
+	{ 0xDA01EE641A708DEA,   295,  108 },
+	{ 0xA26DA3999AEF774A,   322,  116 },
+	{ 0xF209787BB47D6B85,   348,  124 },
+	{ 0xB454E4A179DD1877,   375,  132 },
+	{ 0x865B86925B9BC5C2,   402,  140 },
+	{ 0xC83553C5C8965D3D,   428,  148 },
+	{ 0x952AB45CFA97A0B3,   455,  156 },
+	{ 0xDE469FBD99A05FE3,   481,  164 },
+	{ 0xA59BC234DB398C25,   508,  172 },
+	{ 0xF6C69A72A3989F5C,   534,  180 },
+	{ 0xB7DCBF5354E9BECE,   561,  188 },
+	{ 0x88FCF317F22241E2,   588,  196 },
+	{ 0xCC20CE9BD35C78A5,   614,  204 },
+	{ 0x98165AF37B2153DF,   641,  212 },
+	{ 0xE2A0B5DC971F303A,   667,  220 },
+	{ 0xA8D9D1535CE3B396,   694,  228 },
+	{ 0xFB9B7CD9A4A7443C,   720,  236 },
+	{ 0xBB764C4CA7A44410,   747,  244 },
+	{ 0x8BAB8EEFB6409C1A,   774,  252 },
+	{ 0xD01FEF10A657842C,   800,  260 },
+	{ 0x9B10A4E5E9913129,   827,  268 },
+	{ 0xE7109BFBA19C0C9D,   853,  276 },
+	{ 0xAC2820D9623BF429,   880,  284 },
+	{ 0x80444B5E7AA7CF85,   907,  292 },
+	{ 0xBF21E44003ACDD2D,   933,  300 },
+	{ 0x8E679C2F5E44FF8F,   960,  308 },
+	{ 0xD433179D9C8CB841,   986,  316 },
+	{ 0x9E19DB92B4E31BA9,  1013,  324 },
+	};
+
+const CachedPower& spCachedPower(int iE)
+	{
+	// The smallest k for which 10^k * 2^iE has a binary exponent of at least kAlpha.
+	// 78913 / 2^18 is just over log10(2).
+	const int theF = kAlpha - iE - 1;
+	const int theK = (theF * 78913) / (1 << 18) + (theF > 0);
+	return spCachedPowers[(theK - kCachedPowersMinK + kCachedPowersStepK - 1) / kCachedPowersStepK];
+	}
+
+int spCountDigits(uint32 iVal, uint32& oPowerOfTen)
+	{
+	int theCount = 1;
+	oPowerOfTen = 1;
+	while (theCount < 10 && iVal >= oPowerOfTen * 10)
+		{
+		oPowerOfTen *= 10;
+		++theCount;
+		}
+	return theCount;
+	}
+
+// Nudge the last digit down while that brings us closer to the value, but stays within the
+// rounding interval.
+void spRound(char* ioDigits, int iLength,
+	uint64 iDistance, uint64 iDelta, uint64 iRest, uint64 iTenK)
+	{
+	while (iRest < iDistance
+		&& iDelta - iRest >= iTenK
+		&& (iRest + iTenK < iDistance || iDistance - iRest > iRest + iTenK - iDistance))
+		{
+		--ioDigits[iLength - 1];
+		iRest += iTenK;
+		}
+	}
+
+void spGenerateDigits(char* oDigits, int& oLength, int& ioExponent,
+	const DiyFP& iMinus, const DiyFP& iW, const DiyFP& iPlus)
+	{
+	uint64 theDelta = spSub(iPlus, iMinus).f;
+	uint64 theDistance = spSub(iPlus, iW).f;
+
+	// iPlus = p1 + p2 * 2^-theShift, where p1 is the integral part and p2 the fractional.
+	const int theShift = -iPlus.e;
+	const uint64 theOne = uint64(1) << theShift;
+	uint32 p1 = uint32(iPlus.f >> theShift);
+	uint64 p2 = iPlus.f & (theOne - 1);
+
+	uint32 thePowerOfTen;
+	for (int remaining = spCountDigits(p1, thePowerOfTen); remaining > 0; /*no inc*/)
+		{
+		oDigits[oLength++] = char('0' + p1 / thePowerOfTen);
+		p1 %= thePowerOfTen;
+		--remaining;
+
+		const uint64 theRest = (uint64(p1) << theShift) + p2;
+		if (theRest <= theDelta)
+			{
+			ioExponent += remaining;
+			spRound(oDigits, oLength,
+				theDistance, theDelta, theRest, uint64(thePowerOfTen) << theShift);
+			return;
+			}
+		thePowerOfTen /= 10;
+		}
+
+	int theFractionalCount = 0;
+	for (;;)
+		{
+		p2 *= 10;
+		oDigits[oLength++] = char('0' + (p2 >> theShift));
+		p2 &= theOne - 1;
+		++theFractionalCount;
+		theDelta *= 10;
+		theDistance *= 10;
+		if (p2 <= theDelta)
+			break;
+		}
+
+	ioExponent -= theFractionalCount;
+	spRound(oDigits, oLength, theDistance, theDelta, p2, theOne);
+	}
+
+// Generates the digits of a positive value, which is their integer value times 10^oExponent.
+int spGrisu2(const Boundaries& iBoundaries, char* oDigits, int& oExponent)
+	{
+	const CachedPower& theCached = spCachedPower(iBoundaries.fPlus.e);
+	const DiyFP theC(theCached.f, theCached.e);
+
+	const DiyFP theW = spMul(iBoundaries.fW, theC);
+	const DiyFP theMinus = spMul(iBoundaries.fMinus, theC);
+	const DiyFP thePlus = spMul(iBoundaries.fPlus, theC);
+
+	// Multiplication can be out by one ulp either way, so we narrow the interval to be safe.
+	int theLength = 0;
+	oExponent = -theCached.k;
+	spGenerateDigits(oDigits, theLength, oExponent,
+		DiyFP(theMinus.f + 1, theMinus.e), theW, DiyFP(thePlus.f - 1, thePlus.e));
+	return theLength;
+	}
+
+// Lays out iLength digits, whose value is times 10^iExponent, as %.<iPrecision>g would.
+size_t spLayout(const char* iDigits, int iLength, int iExponent, int iPrecision, char* oDest)
+	{
+	// The position of the decimal point relative to the first digit.
+	const int thePoint = iLength + iExponent;
+	char* theDest = oDest;
+
+	if (thePoint > iPrecision || thePoint < -3)
+		{
+		// d[.ddd]e[+-]xx
+		*theDest++ = iDigits[0];
+		if (iLength > 1)
+			{
+			*theDest++ = '.';
+			memcpy(theDest, iDigits + 1, iLength - 1);
+			theDest += iLength - 1;
+			}
+		*theDest++ = 'e';
+
+		int theExponent = thePoint - 1;
+		if (theExponent < 0)
+			{
+			*theDest++ = '-';
+			theExponent = -theExponent;
+			}
+		else
+			{
+			*theDest++ = '+';
+			}
+
+		if (theExponent < 10)
+			*theDest++ = '0';
+		theDest += sFormat_UInt64(theExponent, theDest);
+		}
+	else if (thePoint <= 0)
+		{
+		// 0.[000]ddd
+		*theDest++ = '0';
+		*theDest++ = '.';
+		memset(theDest, '0', -thePoint);
+		theDest += -thePoint;
+		memcpy(theDest, iDigits, iLength);
+		theDest += iLength;
+		}
+	else if (thePoint < iLength)
+		{
+		// dd.ddd
+		memcpy(theDest, iDigits, thePoint);
+		theDest += thePoint;
+		*theDest++ = '.';
+		memcpy(theDest, iDigits + thePoint, iLength - thePoint);
+		theDest += iLength - thePoint;
+		}
+	else
+		{
+		// ddd[000]
+		memcpy(theDest, iDigits, iLength);
+		theDest += iLength;
+		memset(theDest, '0', thePoint - iLength);
+		theDest += thePoint - iLength;
+		}
+
+	return theDest - oDest;
+	}
+
+size_t spFormat(bool iIsNegative, const Boundaries& iBoundaries, int iPrecision, char* oDest)
+	{
+	char* theDest = oDest;
+	if (iIsNegative)
+		*theDest++ = '-';
+
+	char theDigits[20];
+	int theExponent;
+	const int theLength = spGrisu2(iBoundaries, theDigits, theExponent);
+	return (theDest - oDest)
+		+ spLayout(theDigits, theLength, theExponent, iPrecision, theDest);
+	}
+
+size_t spFormat_Special(double iVal, char* oDest)
+	{
+	if (isnan(iVal))
+		{
+		memcpy(oDest, "nan", 3);
+		return 3;
+		}
+
+	size_t theCount = 0;
+	if (signbit(iVal))
+		oDest[theCount++] = '-';
+
+	if (isinf(iVal))
+		{
+		memcpy(oDest + theCount, "inf", 3);
+		theCount += 3;
+		}
+	else
+		{
+		oDest[theCount++] = '0';
+		}
+	return theCount;
+	}
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - Floating point
+
+size_t sFormat_Double(double iVal, char* oDest)
+	{
+	if (not isfinite(iVal) || iVal == 0)
+		return spFormat_Special(iVal, oDest);
+
+	uint64 theBits;
+	memcpy(&theBits, &iVal, sizeof(theBits));
+
+	return spFormat(theBits >> 63,
+		spBoundaries(theBits & ((uint64(1) << 52) - 1), int((theBits >> 52) & 0x7FF), 52, 1023),
+		17, oDest);
+	}
+
+size_t sFormat_Float(float iVal, char* oDest)
+	{
+	if (not isfinite(iVal) || iVal == 0)
+		return spFormat_Special(iVal, oDest);
+
+	uint32 theBits;
+	memcpy(&theBits, &iVal, sizeof(theBits));
+
+	return spFormat(theBits >> 31,
+		spBoundaries(theBits & ((uint32(1) << 23) - 1), int((theBits >> 23) & 0xFF), 23, 127),
+		9, oDest);
+	}
+
+} // namespace Util_Number
+} // namespace ZooLib
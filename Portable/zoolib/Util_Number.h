@@ -0,0 +1,33 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#ifndef __ZooLib_Util_Number_h__
+#define __ZooLib_Util_Number_h__ 1
+#include "zconfig.h"
+
+#include "zoolib/ZStdInt.h"
+
+#include <stddef.h> // For size_t
+
+namespace ZooLib {
+namespace Util_Number {
+
+// =================================================================================================
+#pragma mark - Util_Number
+
+// These write ASCII text to oDest, without a terminating nul, and return the count of chars
+// written. They do not consult the locale. oDest must have room for kBufferSize chars.
+
+const size_t kBufferSize = 32;
+
+size_t sFormat_Int64(int64 iVal, char* oDest);
+size_t sFormat_UInt64(uint64 iVal, char* oDest);
+
+// The shortest decimal that reads back as exactly iVal. Layout follows printf's %.17g (%.9g for
+// float), so exponential notation is used for very large or very small magnitudes.
+size_t sFormat_Double(double iVal, char* oDest);
+size_t sFormat_Float(float iVal, char* oDest);
+
+} // namespace Util_Number
+} // namespace ZooLib
+
+#endif // __ZooLib_Util_Number_h__
@@ -36,6 +36,17 @@ ZQ<Val_ZZ> sQRead(const ChanRU_UTF& iChanRU, const PullTextOptions_JSON& iRO)
 ZQ<Val_ZZ> sQRead(const ChanRU_UTF& iChanRU)
 	{ return sQRead(iChanRU, sPullTextOptions_Extended()); }
 
+ZQ<Val_ZZ> sQRead(const PaC<const UTF8>& iPaC, const PullTextOptions_JSON& iRO)
+	{
+	Val_ZZ theVal;
+	if (sPull_JSON_AsZZ(iPaC, nullptr, iRO, theVal))
+		return theVal;
+	return null;
+	}
+
+ZQ<Val_ZZ> sQRead(const PaC<const UTF8>& iPaC)
+	{ return sQRead(iPaC, sPullTextOptions_Extended()); }
+
 // -----
 
 void sWrite(const Val_ZZ& iVal, const ChanW_UTF& iChanW)
@@ -65,7 +76,7 @@ string8 sAsJSON(const Val_ZZ& iVal)
 	}
 
 const Val_ZZ sFromJSON(const string8& iString)
-	{ return sQRead(ChanRU_UTF_string8(iString)).Get(); }
+	{ return sQRead(PaC<const UTF8>(iString.data(), iString.size())).Get(); }
 
 } // namespace Util_ZZ_JSON
 
@@ -20,6 +20,9 @@ using namespace Util_Chan_JSON;
 ZQ<Val_ZZ> sQRead(const ChanRU_UTF& iChanRU);
 ZQ<Val_ZZ> sQRead(const ChanRU_UTF& iChanRU, const PullTextOptions_JSON& iRO);
 
+ZQ<Val_ZZ> sQRead(const PaC<const UTF8>& iPaC);
+ZQ<Val_ZZ> sQRead(const PaC<const UTF8>& iPaC, const PullTextOptions_JSON& iRO);
+
 void sWrite(const Val_ZZ& iVal, const ChanW_UTF& iChanW);
 void sWrite(const Val_ZZ& iVal, bool iPrettyPrint, const ChanW_UTF& iChanW);
 void sWrite(const Val_ZZ& iVal, size_t iInitialIndent, const PushTextOptions_JSON& iOptions, const ChanW_UTF& iChanW);
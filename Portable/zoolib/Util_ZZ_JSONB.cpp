@@ -2,43 +2,258 @@
 
 #include "zoolib/Util_ZZ_JSONB.h"
 
-#include "zoolib/Callable_Bind.h"
-#include "zoolib/Callable_Function.h"
+#include "zoolib/ChanR_Bin_More.h"
+#include "zoolib/ChanW_Bin_More.h"
+#include "zoolib/Coerce_Any.h"
+#include "zoolib/Data_ZZ.h"
 #include "zoolib/Log.h"
-#include "zoolib/PullPush_JSONB.h"
-#include "zoolib/PullPush_ZZ.h"
-
-// =================================================================================================
-#pragma mark -
+#include "zoolib/NameUniquifier.h"
+#include "zoolib/ParseException.h"
+#include "zoolib/Stringf.h"
 
 namespace ZooLib {
-namespace Util_ZZ_JSONB {
 
-ZQ<Val_ZZ> sQRead(const ChanR_Bin& iChanR)
+using std::string;
+
+// =================================================================================================
+#pragma mark - sReadJSONB_ZZ
+
+static void spReadJSONB_ZZ(uint8 iType, const ChanR_Bin& iChanR,
+	const ZP<Callable_JSONB_ZZ_ReadFilter>& iReadFilter,
+	Val_ZZ& oVal)
 	{
-	PullPushPair<PPT> thePair = sMakePullPushPair<PPT>();
-	ZP<Delivery<Val_ZZ>> theDelivery = sStartAsync_AsZZ(sGetClear(thePair.second));
-	sPull_JSONB_Push_PPT(iChanR, null, *thePair.first);
-	sDisconnectWrite(*thePair.first);
+	if (iReadFilter)
+		{
+		if (ZQ<bool> theQ = iReadFilter->QCall(iType, iChanR, oVal))
+			{
+			if (*theQ)
+				return;
+			}
+		}
 
-	return theDelivery->QGet();
+	switch (iType)
+		{
+		case 0xE0:
+			{
+			oVal = Val_ZZ();
+			break;
+			}
+		case 0xE2:
+			{
+			oVal = false;
+			break;
+			}
+		case 0xE3:
+			{
+			oVal = true;
+			break;
+			}
+		case 0xE4:
+			{
+			oVal = sEReadBE<int64>(iChanR);
+			break;
+			}
+		case 0xE5:
+			{
+			oVal = sEReadBE<double>(iChanR);
+			break;
+			}
+		case 0xE7:
+			{
+			Data_ZZ theData;
+			for (;;)
+				{
+				if (const size_t theCount = size_t(sReadCount(iChanR)))
+					{
+					const size_t theSize = theData.GetSize();
+					theData.SetSize(theSize + theCount);
+					sEReadMem(iChanR,
+						static_cast<byte*>(theData.GetPtrMutable()) + theSize, theCount);
+					}
+				else
+					{
+					break;
+					}
+				}
+			oVal = theData;
+			break;
+			}
+		case 0xE8:
+			{
+			oVal = sReadString(iChanR, size_t(sReadCount(iChanR)));
+			break;
+			}
+		case 0xEA:
+			{
+			oVal = Seq_ZZ();
+			Seq_ZZ& theSeq = oVal.Mut<Seq_ZZ>();
+			for (;;)
+				{
+				if (NotQ<uint8> theTypeQ = sQRead(iChanR))
+					{
+					sThrow_ParseException("Unexpected end of ChanR_Bin");
+					}
+				else if (*theTypeQ == 0xFF)
+					{
+					break;
+					}
+				else
+					{
+					spReadJSONB_ZZ(*theTypeQ, iChanR, iReadFilter, theSeq.Mut(theSeq.Count()));
+					}
+				}
+			break;
+			}
+		case 0xED:
+			{
+			oVal = Map_ZZ();
+			Map_ZZ& theMap = oVal.Mut<Map_ZZ>();
+			for (;;)
+				{
+				const string theName = sReadCountPrefixedString(iChanR);
+				if (NotQ<uint8> theTypeQ = sQRead(iChanR))
+					{
+					sThrow_ParseException("Unexpected end of ChanR_Bin");
+					}
+				else if (*theTypeQ == 0xFF)
+					{
+					break;
+					}
+				else
+					{
+					spReadJSONB_ZZ(*theTypeQ, iChanR, iReadFilter, theMap.Mut(sName(theName)));
+					}
+				}
+			break;
+			}
+		default:
+			{
+			sThrow_ParseException(sStringf("JSONB unhandled type %d", int(iType)));
+			break;
+			}
+		}
 	}
 
-// -----
+bool sReadJSONB_ZZ(const ChanR_Bin& iChanR,
+	const ZP<Callable_JSONB_ZZ_ReadFilter>& iReadFilter,
+	Val_ZZ& oVal)
+	{
+	if (NotQ<uint8> theTypeQ = sQRead(iChanR))
+		{
+		return false;
+		}
+	else
+		{
+		spReadJSONB_ZZ(*theTypeQ, iChanR, iReadFilter, oVal);
+		return true;
+		}
+	}
 
-static void spFromZZ_Push_PPT(const Val_ZZ& iVal, const ZP<ChannerWCon_PPT>& iChannerWCon)
+ZQ<Val_ZZ> sQReadJSONB_ZZ(const ChanR_Bin& iChanR)
 	{
-	sFromZZ_Push_PPT(iVal, *iChannerWCon);
-	sDisconnectWrite(*iChannerWCon);
+	Val_ZZ theVal;
+	if (sReadJSONB_ZZ(iChanR, null, theVal))
+		return theVal;
+	return null;
 	}
 
-void sWrite(const Val_ZZ& iVal, const ChanW_Bin& iChanW)
+// =================================================================================================
+#pragma mark - sWriteJSONB_ZZ
+
+void sWriteJSONB_ZZ(const Val_ZZ& iVal,
+	const ZP<Callable_JSONB_ZZ_WriteFilter>& iWriteFilter,
+	const ChanW_Bin& iChanW)
 	{
-	PullPushPair<PPT> thePair = sMakePullPushPair<PPT>();
-	sStartOnNewThread(sBindR(sCallable(spFromZZ_Push_PPT), iVal, sGetClear(thePair.first)));
-	sPull_PPT_Push_JSONB(*thePair.second, null, iChanW);
+	if (iWriteFilter && sCall(iWriteFilter, iVal, iChanW))
+		return;
+
+	if (const string* theString = iVal.PGet<string>())
+		{
+		sEWriteBE<byte>(iChanW, 0xE8);
+		sEWriteCountPrefixedString(iChanW, *theString);
+		}
+
+	else if (const Map_ZZ* theMap = iVal.PGet<Map_ZZ>())
+		{
+		sEWriteBE<uint8>(iChanW, 0xED);
+		for (Map_ZZ::Index_t iter = theMap->Begin(), end = theMap->End();
+			iter != end; ++iter)
+			{
+			sEWriteCountPrefixedString(iChanW, iter->first);
+			sWriteJSONB_ZZ(iter->second, iWriteFilter, iChanW);
+			}
+		// Empty name, and terminator
+		sEWriteBE<uint8>(iChanW, 0);
+		sEWriteBE<uint8>(iChanW, 0xFF);
+		}
+
+	else if (const Seq_ZZ* theSeq = iVal.PGet<Seq_ZZ>())
+		{
+		sEWriteBE<uint8>(iChanW, 0xEA);
+		for (size_t xx = 0, count = theSeq->Count(); xx < count; ++xx)
+			sWriteJSONB_ZZ(theSeq->Get(xx), iWriteFilter, iChanW);
+		sEWriteBE<uint8>(iChanW, 0xFF);
+		}
+
+	else if (const Data_ZZ* theData = iVal.PGet<Data_ZZ>())
+		{
+		// A single chunk, and the zero count that ends the chunks.
+		sEWriteBE<uint8>(iChanW, 0xE7);
+		if (const size_t theSize = theData->GetSize())
+			{
+			sEWriteCount(iChanW, theSize);
+			sEWriteMem(iChanW, theData->GetPtr(), theSize);
+			}
+		sEWriteCount(iChanW, 0);
+		}
+
+	else if (iVal.IsNull())
+		{
+		sEWriteBE<uint8>(iChanW, 0xE0);
+		}
+
+	else if (const bool* p = iVal.PGet<bool>())
+		{
+		if (*p)
+			sEWriteBE<uint8>(iChanW, 0xE3);
+		else
+			sEWriteBE<uint8>(iChanW, 0xE2);
+		}
+
+	else if (ZQ<int64> theQ = sQCoerceInt(iVal))
+		{
+		sEWriteBE<uint8>(iChanW, 0xE4);
+		sEWriteBE<int64>(iChanW, *theQ);
+		}
+
+	else if (ZQ<double> theQ = sQCoerceRat(iVal))
+		{
+		sEWriteBE<uint8>(iChanW, 0xE5);
+		sEWriteBE<double>(iChanW, *theQ);
+		}
+
+	else
+		{
+		if (ZLOGF(w, eErr))
+			w << "Couldn't write " << iVal.Type().name();
+
+		ZUnimplemented();
+		}
 	}
 
+void sWriteJSONB_ZZ(const Val_ZZ& iVal, const ChanW_Bin& iChanW)
+	{ sWriteJSONB_ZZ(iVal, null, iChanW); }
+
+// =================================================================================================
+#pragma mark - Util_ZZ_JSONB
+
+namespace Util_ZZ_JSONB {
+
+ZQ<Val_ZZ> sQRead(const ChanR_Bin& iChanR)
+	{ return sQReadJSONB_ZZ(iChanR); }
+
+void sWrite(const Val_ZZ& iVal, const ChanW_Bin& iChanW)
+	{ sWriteJSONB_ZZ(iVal, iChanW); }
+
 } // namespace Util_ZZ_JSONB
 } // namespace ZooLib
-
@@ -4,14 +4,44 @@
 #define __ZooLib_Util_JSONB_ZZ_h__ 1
 #include "zconfig.h"
 
+#include "zoolib/Callable.h"
 #include "zoolib/ChanR_Bin.h"
 #include "zoolib/ChanW_Bin.h"
 #include "zoolib/Val_ZZ.h"
 
+namespace ZooLib {
+
+// =================================================================================================
+#pragma mark -
+
+// These read and write JSONB directly from and to Val_ZZ, building and walking Map_ZZ and
+// Seq_ZZ in place. The bytes are the same as those handled by sPull_JSONB_Push_PPT and
+// sPull_PPT_Push_JSONB, but no PPT stream (and thus no second thread) is involved.
+
+// The read filter is offered every type byte before we interpret it, and the write filter
+// every value before we examine it. Either returns true if it has handled things.
+
+typedef Callable<bool(uint8 iType, const ChanR_Bin& iChanR, Val_ZZ& oVal)>
+	Callable_JSONB_ZZ_ReadFilter;
+
+bool sReadJSONB_ZZ(const ChanR_Bin& iChanR,
+	const ZP<Callable_JSONB_ZZ_ReadFilter>& iReadFilter,
+	Val_ZZ& oVal);
+
+ZQ<Val_ZZ> sQReadJSONB_ZZ(const ChanR_Bin& iChanR);
+
+typedef Callable<bool(const Val_ZZ& iVal, const ChanW_Bin& iChanW)>
+	Callable_JSONB_ZZ_WriteFilter;
+
+void sWriteJSONB_ZZ(const Val_ZZ& iVal,
+	const ZP<Callable_JSONB_ZZ_WriteFilter>& iWriteFilter,
+	const ChanW_Bin& iChanW);
+
+void sWriteJSONB_ZZ(const Val_ZZ& iVal, const ChanW_Bin& iChanW);
+
 // =================================================================================================
 #pragma mark -
 
-namespace ZooLib {
 namespace Util_ZZ_JSONB {
 
 ZQ<Val_ZZ> sQRead(const ChanR_Bin& iChanR);
@@ -7,6 +7,15 @@
 #include "zoolib/Compare_vector.h"
 #include "zoolib/Singleton.h"
 
+#include <algorithm> // For std::copy, std::copy_backward and std::fill
+
+#if (ZCONFIG(Compiler, GCC) || ZCONFIG(Compiler, Clang)) && defined(__SSE2__)
+	#define ZCONFIG_Val_ZZ_SSE2 1
+	#include <emmintrin.h>
+#else
+	#define ZCONFIG_Val_ZZ_SSE2 0
+#endif
+
 using std::map;
 using std::pair;
 using std::string;
@@ -257,26 +266,43 @@ void Seq_ZZ::pTouch()
 
 namespace {
 
-SafePtrStack_WithDestroyer<Map_ZZ::Rep,SafePtrStackLink_Map_ZZ_Rep> spSafePtrStack_Map_ZZ_Rep;
+SafePtrStack_Caching<Map_ZZ::Rep,SafePtrStackLink_Map_ZZ_Rep> spSafePtrStack_Map_ZZ_Rep;
+
+uint32 spHash(const Name& iName)
+	{ return uint32(iName.Hash()); }
+
+size_t spTableCapacity(size_t iCount)
+	{
+	size_t result = 64;
+	while (result < 2 * iCount)
+		result *= 2;
+	return result;
+	}
 
 } // anonymous namespace
 
 Map_ZZ::Rep::Rep()
-	{}
+:	fCount(0)
+,	fAllocated(0)
+,	fFree(0)
+,	fBig(nullptr)
+	{
+	ZAssertCompile(kInline * sizeof(NameVal) % sizeof(void*) == 0);
+	ZAssertCompile(kInline <= 16 && kInline % 4 == 0);
 
-Map_ZZ::Rep::~Rep()
-	{}
+	// pFind scans all of fHashes, so give the unused part a defined value.
+	std::fill(fHashes, fHashes + kInline, 0);
+	}
 
-Map_ZZ::Rep::Rep(const Map_t& iMap)
-:	fMap(iMap)
-	{}
+Map_ZZ::Rep::~Rep()
+	{ this->pClear(); }
 
 void Map_ZZ::Rep::Finalize()
 	{
 	bool finalized = this->FinishFinalize();
 	ZAssert(finalized);
 	ZAssert(not this->IsReferenced());
-	fMap.clear();
+	this->pClear();
 
 	spSafePtrStack_Map_ZZ_Rep.Push(this);
 	}
@@ -289,15 +315,326 @@ ZP<Map_ZZ::Rep> Map_ZZ::Rep::spMake()
 	return new Rep;
 	}
 
+ZP<Map_ZZ::Rep> Map_ZZ::Rep::spMake(const Rep& iOther)
+	{
+	// The copy's entries are in the same order as iOther's, so positions carry over.
+	ZP<Rep> result = spMake();
+	for (size_t xx = 0, theCount = iOther.pCount(); xx < theCount; ++xx)
+		{
+		const size_t theEntry = iOther.pEntryAt(xx);
+		const NameVal* theNameVal = iOther.pEntry(theEntry);
+		result->pAppend(theNameVal->first, theNameVal->second,
+			iOther.fBig ? iOther.fBig->fHashes[theEntry] : iOther.fHashes[theEntry]);
+		}
+	return result;
+	}
+
 ZP<Map_ZZ::Rep> Map_ZZ::Rep::spMake(const Map_t& iMap)
 	{
-	if (Rep* result = spSafePtrStack_Map_ZZ_Rep.PopIfNotEmpty<Rep>())
+	ZP<Rep> result = spMake();
+	for (Map_t::const_iterator ii = iMap.begin(), end = iMap.end(); ii != end; ++ii)
+		result->pAppend(ii->first, ii->second, spHash(ii->first));
+	return result;
+	}
+
+NameVal* Map_ZZ::Rep::pFind(const Name_t& iName, uint32 iHash) const
+	{
+	if (not fBig)
 		{
-		result->fMap = iMap;
-		return result;
+		uint32 theMatches = 0;
+		#if ZCONFIG_Val_ZZ_SSE2
+			const __m128i theKey = _mm_set1_epi32(int(iHash));
+			for (size_t xx = 0; xx < kInline; xx += 4)
+				{
+				const __m128i theQuad = _mm_loadu_si128((const __m128i*)(fHashes + xx));
+				theMatches |= uint32(_mm_movemask_ps(_mm_castsi128_ps(
+					_mm_cmpeq_epi32(theQuad, theKey)))) << xx;
+				}
+		#else
+			for (size_t xx = 0; xx < fAllocated; ++xx)
+				{
+				if (fHashes[xx] == iHash)
+					theMatches |= 1u << xx;
+				}
+		#endif
+
+		// Disregard entries that are unconstructed or free.
+		theMatches &= ((1u << fAllocated) - 1) & ~uint32(fFree);
+
+		for (size_t xx = 0; theMatches; ++xx, theMatches >>= 1)
+			{
+			if ((theMatches & 1) && this->pEntry(xx)->first == iName)
+				return this->pEntry(xx);
+			}
+		return nullptr;
 		}
 
-	return new Rep(iMap);
+	if (fBig->fTable.empty())
+		{
+		for (size_t xx = 0, theCount = fBig->fOrder.size(); xx < theCount; ++xx)
+			{
+			const uint32 theEntry = fBig->fOrder[xx];
+			if (fBig->fHashes[theEntry] == iHash && this->pEntry(theEntry)->first == iName)
+				return this->pEntry(theEntry);
+			}
+		return nullptr;
+		}
+
+	const size_t theMask = fBig->fTable.size() - 1;
+	for (size_t xx = iHash & theMask; /*no test*/; xx = (xx + 1) & theMask)
+		{
+		const Slot& theSlot = fBig->fTable[xx];
+		if (not theSlot.fNameVal)
+			return nullptr;
+		if (theSlot.fHash == iHash && theSlot.fNameVal->first == iName)
+			return theSlot.fNameVal;
+		}
+	}
+
+// Returns the position of iName, or pCount() if it's not present.
+size_t Map_ZZ::Rep::pPosition(const Name_t& iName) const
+	{
+	const NameVal* theNameVal = this->pFind(iName, spHash(iName));
+	if (not theNameVal)
+		return this->pCount();
+
+	if (fBig)
+		return this->pLowerBound(iName);
+
+	const size_t theEntry = theNameVal - this->pEntry(0);
+	for (size_t xx = 0; /*no test*/; ++xx)
+		{
+		if (fOrder[xx] == theEntry)
+			return xx;
+		}
+	}
+
+// Returns the position of the first entry whose name is not less than iName.
+size_t Map_ZZ::Rep::pLowerBound(const Name_t& iName) const
+	{
+	size_t theLow = 0;
+	for (size_t theHigh = this->pCount(); theLow < theHigh; /*no inc*/)
+		{
+		const size_t theMid = theLow + (theHigh - theLow) / 2;
+		if (this->pAt(theMid)->first < iName)
+			theLow = theMid + 1;
+		else
+			theHigh = theMid;
+		}
+	return theLow;
+	}
+
+NameVal& Map_ZZ::Rep::pMut(const Name_t& iName)
+	{
+	const uint32 theHash = spHash(iName);
+	if (NameVal* result = this->pFind(iName, theHash))
+		return *result;
+
+	const size_t thePosition = this->pLowerBound(iName);
+	const size_t theEntry = this->pAllocate(theHash);
+	NameVal* result = this->pEntry(theEntry);
+	result->first = iName;
+	this->pInsertInOrder(thePosition, theEntry);
+	if (fBig)
+		this->pInsertInTable(result, theHash);
+	return *result;
+	}
+
+void Map_ZZ::Rep::pAppend(const Name_t& iName, const Val_ZZ& iVal, uint32 iHash)
+	{
+	ZAssert(this->pCount() == 0 || this->pAt(this->pCount() - 1)->first < iName);
+
+	const size_t theEntry = this->pAllocate(iHash);
+	NameVal* theNameVal = this->pEntry(theEntry);
+	theNameVal->first = iName;
+	theNameVal->second = iVal;
+	this->pInsertInOrder(this->pCount(), theEntry);
+	if (fBig)
+		this->pInsertInTable(theNameVal, iHash);
+	}
+
+void Map_ZZ::Rep::pErase(size_t iPosition)
+	{
+	size_t theEntry;
+	if (not fBig)
+		{
+		theEntry = fOrder[iPosition];
+		std::copy(fOrder + iPosition + 1, fOrder + fCount, fOrder + iPosition);
+		--fCount;
+		fFree |= 1u << theEntry;
+		}
+	else
+		{
+		theEntry = fBig->fOrder[iPosition];
+		fBig->fOrder.erase(fBig->fOrder.begin() + iPosition);
+		fBig->fFree.push_back(theEntry);
+
+		std::vector<Slot>& theTable = fBig->fTable;
+		if (theTable.size())
+			{
+			const size_t theMask = theTable.size() - 1;
+			const NameVal* theNameVal = this->pEntry(theEntry);
+			size_t theHole = fBig->fHashes[theEntry] & theMask;
+			while (theTable[theHole].fNameVal != theNameVal)
+				theHole = (theHole + 1) & theMask;
+
+			// Close the gap, moving back any later entry in the run that may occupy it.
+			for (size_t xx = (theHole + 1) & theMask;
+				theTable[xx].fNameVal; xx = (xx + 1) & theMask)
+				{
+				const size_t theHome = theTable[xx].fHash & theMask;
+				if (((xx - theHome) & theMask) >= ((xx - theHole) & theMask))
+					{
+					theTable[theHole] = theTable[xx];
+					theHole = xx;
+					}
+				}
+			theTable[theHole].fNameVal = nullptr;
+			}
+		}
+
+	NameVal* theNameVal = this->pEntry(theEntry);
+	theNameVal->first.Clear();
+	theNameVal->second.Clear();
+	}
+
+void Map_ZZ::Rep::pClear()
+	{
+	for (size_t xx = 0; xx < fAllocated; ++xx)
+		this->pEntry(xx)->~NameVal();
+
+	if (fBig)
+		{
+		for (size_t xx = kInline, theEnd = fBig->fHashes.size(); xx < theEnd; ++xx)
+			this->pEntry(xx)->~NameVal();
+
+		for (size_t xx = 0; xx < fBig->fChunks.size(); ++xx)
+			::operator delete(fBig->fChunks[xx]);
+
+		delete fBig;
+		fBig = nullptr;
+		}
+
+	fCount = 0;
+	fAllocated = 0;
+	fFree = 0;
+	}
+
+// Returns the number of an entry, constructed and with an empty name, to hold iHash.
+size_t Map_ZZ::Rep::pAllocate(uint32 iHash)
+	{
+	if (not fBig)
+		{
+		if (fFree)
+			{
+			size_t theEntry = 0;
+			while (not (fFree & (1u << theEntry)))
+				++theEntry;
+			fFree &= ~(1u << theEntry);
+			fHashes[theEntry] = iHash;
+			return theEntry;
+			}
+
+		if (fAllocated < kInline)
+			{
+			new (this->pEntry(fAllocated)) NameVal;
+			fHashes[fAllocated] = iHash;
+			return fAllocated++;
+			}
+
+		this->pSpill();
+		}
+
+	if (fBig->fFree.size())
+		{
+		const size_t theEntry = fBig->fFree.back();
+		fBig->fFree.pop_back();
+		fBig->fHashes[theEntry] = iHash;
+		return theEntry;
+		}
+
+	// fHashes has an element for every entry ever allocated.
+	const size_t theEntry = fBig->fHashes.size();
+	if ((theEntry - kInline) % kChunk == 0)
+		{
+		fBig->fChunks.push_back(
+			static_cast<NameVal*>(::operator new(sizeof(NameVal) * kChunk)));
+		}
+	fBig->fHashes.push_back(iHash);
+	new (this->pEntry(theEntry)) NameVal;
+	return theEntry;
+	}
+
+void Map_ZZ::Rep::pInsertInOrder(size_t iPosition, size_t iEntry)
+	{
+	if (fBig)
+		{
+		fBig->fOrder.insert(fBig->fOrder.begin() + iPosition, uint32(iEntry));
+		}
+	else
+		{
+		std::copy_backward(fOrder + iPosition, fOrder + fCount, fOrder + fCount + 1);
+		fOrder[iPosition] = uint8(iEntry);
+		++fCount;
+		}
+	}
+
+// Called when fInline is full, to move fOrder and fHashes into a new Big.
+void Map_ZZ::Rep::pSpill()
+	{
+	ZAssert(not fBig && fAllocated == kInline && not fFree);
+
+	fBig = new Big;
+	fBig->fOrder.reserve(2 * kInline);
+	fBig->fOrder.assign(fOrder, fOrder + fCount);
+	fBig->fHashes.reserve(2 * kInline);
+	fBig->fHashes.assign(fHashes, fHashes + kInline);
+	}
+
+void Map_ZZ::Rep::pInsertInTable(NameVal* iNameVal, uint32 iHash)
+	{
+	// fOrder already includes iNameVal, so a rebuild will pick it up.
+	std::vector<Slot>& theTable = fBig->fTable;
+	if (theTable.empty())
+		{
+		if (fBig->fOrder.size() > kMaxScan)
+			this->pRebuildTable(spTableCapacity(fBig->fOrder.size()));
+		return;
+		}
+
+	if (fBig->fOrder.size() * 2 > theTable.size())
+		{
+		this->pRebuildTable(theTable.size() * 2);
+		return;
+		}
+
+	const size_t theMask = theTable.size() - 1;
+	size_t xx = iHash & theMask;
+	while (theTable[xx].fNameVal)
+		xx = (xx + 1) & theMask;
+	theTable[xx].fNameVal = iNameVal;
+	theTable[xx].fHash = iHash;
+	}
+
+void Map_ZZ::Rep::pRebuildTable(size_t iCapacity)
+	{
+	ZAssert(iCapacity && 0 == (iCapacity & (iCapacity - 1)));
+
+	std::vector<Slot>& theTable = fBig->fTable;
+	Slot theEmpty = { nullptr, 0 };
+	theTable.assign(iCapacity, theEmpty);
+
+	const size_t theMask = iCapacity - 1;
+	for (size_t yy = 0; yy < fBig->fOrder.size(); ++yy)
+		{
+		const uint32 theEntry = fBig->fOrder[yy];
+		const uint32 theHash = fBig->fHashes[theEntry];
+		size_t xx = theHash & theMask;
+		while (theTable[xx].fNameVal)
+			xx = (xx + 1) & theMask;
+		theTable[xx].fNameVal = this->pEntry(theEntry);
+		theTable[xx].fHash = theHash;
+		}
 	}
 
 // =================================================================================================
@@ -305,8 +642,6 @@ ZP<Map_ZZ::Rep> Map_ZZ::Rep::spMake(const Map_t& iMap)
 
 static Map_ZZ::Name_t spEmptyString;
 
-static Map_ZZ::Map_t spEmptyMap;
-
 Map_ZZ::Map_ZZ()
 	{}
 
@@ -355,7 +690,7 @@ int Map_ZZ::Compare(const Map_ZZ& iOther) const
 	if (not fRep)
 		{
 		// We have no rep, (iOther must have a rep or fRep would be == iOther.fRep).
-		if (iOther.fRep->fMap.empty())
+		if (not iOther.fRep->pCount())
 			{
 			// And iOther's map is empty, we're equivalent.
 			return 0;
@@ -370,7 +705,7 @@ int Map_ZZ::Compare(const Map_ZZ& iOther) const
 	if (not iOther.fRep)
 		{
 		// iOther has no rep.
-		if (fRep->fMap.empty())
+		if (not fRep->pCount())
 			{
 			// And our map is empty, so we're equivalent.
 			return 0;
@@ -382,24 +717,24 @@ int Map_ZZ::Compare(const Map_ZZ& iOther) const
 			}
 		}
 
-	for (Map_t::const_iterator iterThis = fRep->fMap.begin(),
-		iterOther = iOther.fRep->fMap.begin(),
-		endThis = fRep->fMap.end(),
-		endOther = iOther.fRep->fMap.end();
-		/*no test*/; ++iterThis, ++iterOther)
+	const size_t countThis = fRep->pCount();
+	const size_t countOther = iOther.fRep->pCount();
+	for (size_t xx = 0; /*no test*/; ++xx)
 		{
-		if (iterThis != endThis)
+		if (xx < countThis)
 			{
 			// This is not exhausted.
-			if (iterOther != endOther)
+			if (xx < countOther)
 				{
 				// Other is not exhausted either, so we compare their current values.
-				if (int compare = sCompare_T(iterThis->first, iterOther->first))
+				const NameVal* theThis = fRep->pAt(xx);
+				const NameVal* theOther = iOther.fRep->pAt(xx);
+				if (int compare = sCompare_T(theThis->first, theOther->first))
 					{
 					// The names are different.
 					return compare;
 					}
-				if (int compare = sCompare_T<Val_ZZ>(iterThis->second, iterOther->second))
+				if (int compare = sCompare_T<Val_ZZ>(theThis->second, theOther->second))
 					{
 					// The values are different.
 					return compare;
@@ -415,7 +750,7 @@ int Map_ZZ::Compare(const Map_ZZ& iOther) const
 		else
 			{
 			// Exhausted this.
-			if (iterOther != endOther)
+			if (xx < countOther)
 				{
 				// Still have other remaining, so this is less than other.
 				return -1;
@@ -431,7 +766,7 @@ int Map_ZZ::Compare(const Map_ZZ& iOther) const
 	}
 
 bool Map_ZZ::IsEmpty() const
-	{ return not fRep || fRep->fMap.empty(); }
+	{ return not fRep || not fRep->pCount(); }
 
 void Map_ZZ::Clear()
 	{ fRep.Clear(); }
@@ -440,16 +775,15 @@ const Val_ZZ* Map_ZZ::PGet(const Name_t& iName) const
 	{
 	if (fRep)
 		{
-		Index_t theIndex = fRep->fMap.find(iName);
-		if (theIndex != fRep->fMap.end())
-			return &theIndex->second;
+		if (const NameVal* theNameVal = fRep->pFind(iName, spHash(iName)))
+			return &theNameVal->second;
 		}
 	return nullptr;
 	}
 
 const Val_ZZ* Map_ZZ::PGet(const Index_t& iIndex) const
 	{
-	if (fRep && iIndex != fRep->fMap.end())
+	if (fRep && iIndex != this->End())
 		return &iIndex->second;
 	return nullptr;
 	}
@@ -501,16 +835,15 @@ Val_ZZ* Map_ZZ::PMut(const Name_t& iName)
 	if (fRep)
 		{
 		this->pTouch();
-		Index_t theIndex = fRep->fMap.find(iName);
-		if (theIndex != fRep->fMap.end())
-			return &theIndex->second;
+		if (NameVal* theNameVal = fRep->pFind(iName, spHash(iName)))
+			return &theNameVal->second;
 		}
 	return nullptr;
 	}
 
 Val_ZZ* Map_ZZ::PMut(const Index_t& iIndex)
 	{
-	Map_t::iterator theIndex = this->pTouch(iIndex);
+	Index_t theIndex = this->pTouch(iIndex);
 	if (theIndex != this->End())
 		return &theIndex->second;
 	return nullptr;
@@ -519,19 +852,19 @@ Val_ZZ* Map_ZZ::PMut(const Index_t& iIndex)
 Val_ZZ& Map_ZZ::Mut(const Name_t& iName)
 	{
 	this->pTouch();
-	return fRep->fMap[iName];
+	return fRep->pMut(iName).second;
 	}
 
 Map_ZZ& Map_ZZ::Set(const Name_t& iName, const Val_ZZ& iVal)
 	{
 	this->pTouch();
-	fRep->fMap[iName] = iVal;
+	fRep->pMut(iName).second = iVal;
 	return *this;
 	}
 
 Map_ZZ& Map_ZZ::Set(const Index_t& iIndex, const Val_ZZ& iVal)
 	{
-	Map_t::iterator theIndex = this->pTouch(iIndex);
+	Index_t theIndex = this->pTouch(iIndex);
 	if (theIndex != this->End())
 		theIndex->second = iVal;
 	return *this;
@@ -542,64 +875,58 @@ Map_ZZ& Map_ZZ::Erase(const Name_t& iName)
 	if (fRep)
 		{
 		this->pTouch();
-		fRep->fMap.erase(iName);
+		const size_t thePosition = fRep->pPosition(iName);
+		if (thePosition < fRep->pCount())
+			fRep->pErase(thePosition);
 		}
 	return *this;
 	}
 
 Map_ZZ& Map_ZZ::Erase(const Index_t& iIndex)
 	{
-	Map_t::iterator theIndex = this->pTouch(iIndex);
+	Index_t theIndex = this->pTouch(iIndex);
 	if (theIndex != this->End())
-		fRep->fMap.erase(theIndex);
+		fRep->pErase(theIndex.fPosition);
 	return *this;
 	}
 
 Map_ZZ::Index_t Map_ZZ::Begin() const
 	{
 	if (fRep)
-		return fRep->fMap.begin();
-	return spEmptyMap.begin();
+		return Index_t(fRep.Get(), 0);
+	return Index_t();
 	}
 
 Map_ZZ::Index_t Map_ZZ::End() const
 	{
 	if (fRep)
-		return fRep->fMap.end();
-	return spEmptyMap.end();
+		return Index_t(fRep.Get(), fRep->pCount());
+	return Index_t();
 	}
 
 Map_ZZ::iterator Map_ZZ::begin()
-	{
-	if (fRep)
-		return fRep->fMap.begin();
-	return spEmptyMap.begin();
-	}
+	{ return this->Begin(); }
 
 Map_ZZ::iterator Map_ZZ::end()
-	{
-	if (fRep)
-		return fRep->fMap.end();
-	return spEmptyMap.end();
-	}
+	{ return this->End(); }
 
 Map_ZZ::const_iterator Map_ZZ::begin() const
 	{
 	if (fRep)
-		return fRep->fMap.begin();
-	return spEmptyMap.begin();
+		return const_iterator(fRep.Get(), 0);
+	return const_iterator();
 	}
 
 Map_ZZ::const_iterator Map_ZZ::end() const
 	{
 	if (fRep)
-		return fRep->fMap.end();
-	return spEmptyMap.end();
+		return const_iterator(fRep.Get(), fRep->pCount());
+	return const_iterator();
 	}
 
 const Map_ZZ::Name_t& Map_ZZ::NameOf(const Index_t& iIndex) const
 	{
-	if (fRep && iIndex != fRep->fMap.end())
+	if (fRep && iIndex != this->End())
 		return iIndex->first;
 	return spEmptyString;
 	}
@@ -607,8 +934,8 @@ const Map_ZZ::Name_t& Map_ZZ::NameOf(const Index_t& iIndex) const
 Map_ZZ::Index_t Map_ZZ::IndexOf(const Name_t& iName) const
 	{
 	if (fRep)
-		return fRep->fMap.find(iName);
-	return spEmptyMap.end();
+		return Index_t(fRep.Get(), fRep->pPosition(iName));
+	return Index_t();
 	}
 
 Map_ZZ::Index_t Map_ZZ::IndexOf(const Map_ZZ& iOther, const Index_t& iOtherIndex) const
@@ -657,21 +984,21 @@ void Map_ZZ::pTouch()
 		}
 	else if (fRep->IsShared())
 		{
-		fRep = Rep::spMake(fRep->fMap);
+		fRep = Rep::spMake(*fRep);
 		}
 	}
 
-Map_ZZ::Map_t::iterator Map_ZZ::pTouch(const Index_t& iIndex)
+Map_ZZ::Index_t Map_ZZ::pTouch(const Index_t& iIndex)
 	{
 	if (not fRep)
 		{
-		return spEmptyMap.end();
+		return Index_t();
 		}
 	else if (fRep->IsShared())
 		{
-		const Name_t theName = iIndex->first;
-		fRep = Rep::spMake(fRep->fMap);
-		return fRep->fMap.find(theName);
+		// The copy has its entries in the same order, so iIndex's position carries over.
+		fRep = Rep::spMake(*fRep);
+		return Index_t(fRep.Get(), iIndex.fPosition);
 		}
 	else
 		{
@@ -13,6 +13,7 @@
 #include "zoolib/Val.h"
 #include "zoolib/Val_T.h"
 
+#include <iterator> // For std::bidirectional_iterator_tag
 #include <map>
 #include <vector>
 
@@ -188,13 +189,66 @@ public:
 	class Rep;
 	typedef Name Name_t;
 
-#if 0 && ZCONFIG_SPI_Enabled(unordered_map)
-	typedef unordered_map<Name_t, Val_ZZ> Map_t;
-#else
 	typedef std::map<Name_t, Val_ZZ> Map_t;
-#endif
 
-	typedef Map_t::iterator Index_t;
+	// Entries are kept in name order, and Iterator_T visits them in that order.
+	template <class NameVal_p>
+	class Iterator_T
+		{
+	public:
+		typedef std::bidirectional_iterator_tag iterator_category;
+		typedef NameVal_p value_type;
+		typedef ptrdiff_t difference_type;
+		typedef NameVal_p* pointer;
+		typedef NameVal_p& reference;
+
+		Iterator_T()
+		:	fRep(nullptr)
+		,	fPosition(0)
+			{}
+
+		Iterator_T(const Rep* iRep, size_t iPosition)
+		:	fRep(iRep)
+		,	fPosition(iPosition)
+			{}
+
+		reference operator*() const
+			{ return *spAt(fRep, fPosition); }
+
+		pointer operator->() const
+			{ return spAt(fRep, fPosition); }
+
+		Iterator_T& operator++()
+			{
+			++fPosition;
+			return *this;
+			}
+
+		Iterator_T operator++(int)
+			{ return Iterator_T(fRep, fPosition++); }
+
+		Iterator_T& operator--()
+			{
+			--fPosition;
+			return *this;
+			}
+
+		Iterator_T operator--(int)
+			{ return Iterator_T(fRep, fPosition--); }
+
+		bool operator==(const Iterator_T& iOther) const
+			{ return fPosition == iOther.fPosition && fRep == iOther.fRep; }
+
+		bool operator!=(const Iterator_T& iOther) const
+			{ return not (*this == iOther); }
+
+	private:
+		const Rep* fRep;
+		size_t fPosition;
+		friend class Map_ZZ;
+		};
+
+	typedef Iterator_T<NameVal> Index_t;
 	typedef Val_ZZ Val_t;
 
 	Map_ZZ();
@@ -344,11 +398,11 @@ public:
 	Index_t Begin() const;
 	Index_t End() const;
 
-	typedef Map_t::iterator iterator;
+	typedef Iterator_T<NameVal> iterator;
 	iterator begin();
 	iterator end();
 
-	typedef Map_t::const_iterator const_iterator;
+	typedef Iterator_T<const NameVal> const_iterator;
 	const_iterator begin() const;
 	const_iterator end() const;
 
@@ -372,8 +426,10 @@ public:
 	const Val_ZZ& operator[](const Index_t& iIndex) const;
 
 private:
+	static NameVal* spAt(const Rep* iRep, size_t iPosition);
+
 	void pTouch();
-	Map_t::iterator pTouch(const Index_t& iIndex);
+	Index_t pTouch(const Index_t& iIndex);
 
 	ZP<Rep> fRep;
 	};
@@ -458,6 +514,17 @@ class SafePtrStackLink_Map_ZZ_Rep
 :	public SafePtrStackLink<Map_ZZ::Rep,SafePtrStackLink_Map_ZZ_Rep>
 	{};
 
+/*
+A Rep holds its first kInline entries in fInline, so a typical map takes a single allocation.
+Entries are never moved, so pointers to a map's values stay valid as other entries are added,
+just as they did when a Rep was a std::map. fOrder holds entry numbers sorted by name, and fHashes
+holds the hash of each entry's name. The hashes are searched four at a time where SSE2 is
+available. A map that outgrows fInline gets a Big, which keeps further entries in chunks that are
+never reallocated, and takes over fOrder and fHashes. Until it holds more than kMaxScan entries
+a Big is searched by walking fOrder, after which it maintains fTable, an open-addressed hash table
+with linear probing.
+*/
+
 class Map_ZZ::Rep
 :	public Counted
 ,	public SafePtrStackLink_Map_ZZ_Rep
@@ -468,19 +535,81 @@ public:
 private:
 	Rep();
 
-	Rep(const Map_t& iMap);
-
 // From Counted
 	virtual void Finalize();
 
 // Our protocol
 	static ZP<Rep> spMake();
+	static ZP<Rep> spMake(const Rep& iOther);
 	static ZP<Rep> spMake(const Map_t& iMap);
 
-	Map_t fMap;
+	static const size_t kInline = 12;
+	static const size_t kChunk = 8;
+	static const size_t kMaxScan = 32;
+
+	struct Slot
+		{
+		NameVal* fNameVal;
+		uint32 fHash;
+		};
+
+	struct Big
+		{
+		std::vector<uint32> fOrder;
+		std::vector<uint32> fHashes;
+		std::vector<Slot> fTable;
+		std::vector<NameVal*> fChunks;
+		std::vector<uint32> fFree;
+		};
+
+	size_t pCount() const
+		{ return fBig ? fBig->fOrder.size() : fCount; }
+
+	size_t pEntryAt(size_t iPosition) const
+		{ return fBig ? fBig->fOrder[iPosition] : fOrder[iPosition]; }
+
+	NameVal* pEntry(size_t iEntry) const
+		{
+		if (iEntry < kInline)
+			return reinterpret_cast<NameVal*>(const_cast<void**>(fInline)) + iEntry;
+		iEntry -= kInline;
+		return fBig->fChunks[iEntry / kChunk] + iEntry % kChunk;
+		}
+
+	NameVal* pAt(size_t iPosition) const
+		{ return this->pEntry(this->pEntryAt(iPosition)); }
+
+	NameVal* pFind(const Name_t& iName, uint32 iHash) const;
+	size_t pPosition(const Name_t& iName) const;
+	size_t pLowerBound(const Name_t& iName) const;
+	NameVal& pMut(const Name_t& iName);
+	void pAppend(const Name_t& iName, const Val_ZZ& iVal, uint32 iHash);
+	void pErase(size_t iPosition);
+	void pClear();
+
+	size_t pAllocate(uint32 iHash);
+	void pInsertInOrder(size_t iPosition, size_t iEntry);
+	void pSpill();
+	void pInsertInTable(NameVal* iNameVal, uint32 iHash);
+	void pRebuildTable(size_t iCapacity);
+
+	// Storage for kInline NameVals, of which the first fAllocated have been constructed. An
+	// erased entry stays constructed, and its bit is set in fFree until it's reused.
+	void* fInline[kInline * sizeof(NameVal) / sizeof(void*)];
+	uint32 fHashes[kInline];
+	uint8 fOrder[kInline];
+	uint8 fCount;
+	uint8 fAllocated;
+	uint16 fFree;
+
+	Big* fBig;
+
 	friend class Map_ZZ;
 	};
 
+inline NameVal* Map_ZZ::spAt(const Rep* iRep, size_t iPosition)
+	{ return iRep->pAt(iPosition); }
+
 // =================================================================================================
 #pragma mark -
 
@@ -30,14 +30,12 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/ChanW_Bin_More.h"
 #include "zoolib/Chan_Bin_Data.h"
 #include "zoolib/ChanR_XX_AbortOnSlowRead.h"
-#include "zoolib/Chan_XX_Buffered.h"
 #include "zoolib/Chan_XX_Count.h"
 #include "zoolib/Log.h"
 #include "zoolib/StartOnNewThread.h"
 #include "zoolib/Stringf.h"
-#include "zoolib/PullPush_JSONB.h"
-#include "zoolib/PullPush_ZZ.h"
 #include "zoolib/Util_ZZ_JSON.h"
+#include "zoolib/Util_ZZ_JSONB.h"
 #include "zoolib/Util_STL_map.h"
 #include "zoolib/Util_STL_vector.h"
 
@@ -55,73 +53,19 @@ using namespace Util_STL;
 
 using QueryEngine::Result;
 
-static size_t kBufSize = 16;
-
-// =================================================================================================
-#pragma mark -
-
-class Start_Result : public PullPush::Start
-	{
-protected:
-	Start_Result() {}
-
-public:
-	static const PPT sPPT;
-	static bool sIs(const PPT& iPPT);
-	};
-
-const PPT Start_Result::sPPT = ZP<Marker>(new Start_Result);
-
-bool Start_Result::sIs(const PPT& iPPT)
-	{
-	if (const ZP<Marker> theMarker = sGet<ZP<Marker>>(iPPT))
-		{
-		if (theMarker.DynamicCast<Start_Result>())
-			return true;
-		}
-	return false;
-	}
-
 // =================================================================================================
 #pragma mark -
 
 static string8 spStringFromChan(const ChanR_Bin& r)
 	{ return sReadCountPrefixedString(r); }
 
+// Handles the JSONB-->Val_ZZ translation for Result, Daton and for AbsentOptional_t
 class ReadFilter
-:	public Callable_ZZ_ReadFilter
-,	public Callable_JSONB_ReadFilter
+:	public Callable_JSONB_ZZ_ReadFilter
 	{
 public:
-// From Callable_ZZ_ReadFilter
-	virtual ZQ<bool> QCall(const PPT& iPPT, const ChanR_PPT& iChanR, Val_ZZ& oVal)
-		{
-		if (Start_Result::sIs(iPPT))
-			{
-			PPT theRHPPT = sERead(iChanR);
-			RelHead& theRelHead = sMut<RelHead>(theRHPPT);
-			const size_t theRowCount = size_t(sCoerceInt(sERead(iChanR)));
-			size_t theCount = theRowCount * theRelHead.size();
-			vector<Val_DB> theVals;
-			theVals.reserve(theCount);
-			while (theCount--)
-				{
-				PPT thePPT = sERead(iChanR);
-				Val_ZZ munged;
-				sPull_PPT_AsZZ(thePPT, iChanR, this, munged);
-				sPushBack(theVals, munged.As<Val_DB>());
-				}
-			oVal = sZP(new Result(&theRelHead, &theVals));
-
-			sEPull_End(iChanR);
-			return true;
-			}
-
-		return false;
-		}
-
-// From Callable_JSONB_ReadFilter
-	virtual ZQ<bool> QCall(uint8 iType, const ChanR_Bin& iChanR, const ChanW_PPT& iChanW)
+// From Callable_JSONB_ZZ_ReadFilter
+	virtual ZQ<bool> QCall(uint8 iType, const ChanR_Bin& iChanR, Val_ZZ& oVal)
 		{
 		if (iType == 254)
 			{
@@ -131,34 +75,36 @@ public:
 					{
 					case 100:
 						{
-						sPush(Start_Result::sPPT, iChanW);
-
-							// We're at the beginning of a QE::Result. So copy the RelHead to start with.
-							PPT thePPT = sAnyCounted<RelHead,PullPush::Tag_PPT>();
-							RelHead& theRH = sMut<RelHead>(thePPT);
-							for (uint64 theCount = sReadCount(iChanR); theCount; --theCount)
-								theRH |= spStringFromChan(iChanR);
-							sPush(thePPT, iChanW);
-
-							const uint64 theCount = sReadCount(iChanR);
-							sPush(theCount, iChanW);
-
-							// Now copy the vals.
-							for (uint64 xx = theCount * theRH.size(); xx; --xx)
-								sPull_JSONB_Push_PPT(iChanR, this, iChanW);
-
-						sPush_End(iChanW);
-
+						// We're at the beginning of a QE::Result. So read the RelHead first.
+						RelHead theRH;
+						for (uint64 theCount = sReadCount(iChanR); theCount; --theCount)
+							theRH |= spStringFromChan(iChanR);
+
+						const size_t theRowCount = size_t(sReadCount(iChanR));
+
+						// Now the vals.
+						size_t theCount = theRowCount * theRH.size();
+						vector<Val_DB> theVals;
+						theVals.reserve(theCount);
+						while (theCount--)
+							{
+							Val_ZZ theVal;
+							if (not sReadJSONB_ZZ(iChanR, this, theVal))
+								sThrow_ExhaustedR();
+							sPushBack(theVals, theVal.As<Val_DB>());
+							}
+
+						oVal = sZP(new Result(&theRH, &theVals));
 						return true;
 						}
 					case 101:
 						{
-						sPush(Daton(sRead_T<Data_ZZ>(iChanR, size_t(sReadCount(iChanR)))), iChanW);
+						oVal = Daton(sRead_T<Data_ZZ>(iChanR, size_t(sReadCount(iChanR))));
 						return true;
 						}
 					case 102:
 						{
-						sPush(AbsentOptional_t(), iChanW);
+						oVal = AbsentOptional_t();
 						return true;
 						}
 					}
@@ -173,20 +119,13 @@ static Map_ZZ spReadMessage(const ChanR_Bin& iChanR, const ZQ<string>& iDescript
 	{
 	ChanR_XX_Count<ChanR_Bin> theChanR(iChanR);
 
-	// This ReadFilter handles both the JSONB-->PPT and the PPT->Any translations for
-	// Result, Daton and for AbsentOptional_t
 	const ZP<ReadFilter> theReadFilter = sDefault<ZP_Counted<ReadFilter>>();
 
-	PullPushPair<PPT> thePair = sMakePullPushPair<PPT>();
-	ZP<Delivery<Val_ZZ>> theDelivery = sStartAsync_AsZZ(sGetClear(thePair.second), theReadFilter);
-	sPull_JSONB_Push_PPT(theChanR, theReadFilter, ChanW_XX_Buffered<ChanW_PPT>(*thePair.first, kBufSize));
-	sDisconnectWrite(*thePair.first);
-
-	ZQ<Val_ZZ> theQ = theDelivery->QGet();
-	if (not theQ)
+	Val_ZZ theVal;
+	if (not sReadJSONB_ZZ(theChanR, theReadFilter, theVal))
 		sThrow_ExhaustedR();
 
-	const Map_ZZ theMessage = theQ->Get<Map_ZZ>();
+	const Map_ZZ theMessage = theVal.Get<Map_ZZ>();
 	if (ZLOGF(w, eDebug + 1))
 		{
 		w << theChanR.GetCount() << " bytes, ";
@@ -209,65 +148,39 @@ static Map_ZZ spReadMessage(const ChanR_Bin& iChanR, const ZQ<string>& iDescript
 // =================================================================================================
 #pragma mark -
 
+// Handles the Val_ZZ-->JSONB translation for Result, Daton and for AbsentOptional_t
 class WriteFilter
-:	public Callable_ZZ_WriteFilter
-,	public Callable_JSONB_WriteFilter
+:	public Callable_JSONB_ZZ_WriteFilter
 	{
 public:
-// From Callable_ZZ_WriteFilter
-	virtual ZQ<bool> QCall(const Val_ZZ& iVal_ZZ, const ChanW_PPT& iChanW)
+// From Callable_JSONB_ZZ_WriteFilter
+	virtual ZQ<bool> QCall(const Val_ZZ& iVal, const ChanW_Bin& iChanW)
 		{
-		if (const ZP<Result>* theResultP = iVal_ZZ.PGet<ZP<Result>>())
+		if (const ZP<Result>* theResultP = iVal.PGet<ZP<Result>>())
 			{
 			ZP<Result> theResult = *theResultP;
 
-			sPush(Start_Result::sPPT, iChanW);
-
-				const RelHead& theRH = theResult->GetRelHead();
-				sPush(theRH, iChanW);
-
-				const size_t theRowCount = theResult->Count();
-				sPush(theRowCount, iChanW);
-
-				const size_t theRHCount = theRH.size();
-
-				for (size_t yy = 0; yy < theRowCount; ++yy)
-					{
-					const Val_DB* theRow = theResult->GetValsAt(yy);
-					for (size_t xx = 0; xx < theRHCount; ++xx)
-						sFromZZ_Push_PPT(theRow[xx].As<Val_ZZ>(), this, iChanW);
-					}
-			sPush_End(iChanW);
-			return true;
-			}
-		return false;
-		}
-
-// From Callable_JSONB_WriteFilter
-	virtual ZQ<bool> QCall(const PPT& iPPT, const ChanR_PPT& iChanR, const ChanW_Bin& iChanW)
-		{
-		if (Start_Result::sIs(iPPT))
-			{
 			sEWriteBE<uint8>(iChanW, 254);
 			sEWriteBE<uint8>(iChanW, 100);
 
-			const RelHead theRH = sGet<RelHead>(sERead(iChanR));
+			const RelHead& theRH = theResult->GetRelHead();
 			const size_t theRHCount = theRH.size();
 			sEWriteCount(iChanW, theRHCount);
 			foreacha (entry, theRH)
 				sEWriteCountPrefixedString(iChanW, entry);
 
-			const size_t theRowCount = sCoerceInt(sERead(iChanR).As<Val_ZZ>());
+			const size_t theRowCount = theResult->Count();
 			sEWriteCount(iChanW, theRowCount);
 
-			for (size_t xx = theRHCount * theRowCount; xx; --xx)
-				sPull_PPT_Push_JSONB(iChanR, this, iChanW);
-
-			sEPull_End(iChanR);
+			for (size_t yy = 0; yy < theRowCount; ++yy)
+				{
+				for (size_t xx = 0; xx < theRHCount; ++xx)
+					sWriteJSONB_ZZ(theResult->GetVal(yy, xx).As<Val_ZZ>(), this, iChanW);
+				}
 			return true;
 			}
 
-		if (const Daton* theDatonP = iPPT.PGet<Daton>())
+		if (const Daton* theDatonP = iVal.PGet<Daton>())
 			{
 			sEWriteBE<uint8>(iChanW, 254);
 			sEWriteBE<uint8>(iChanW, 101);
@@ -279,7 +192,7 @@ public:
 			return true;
 			}
 
-		if (iPPT.PGet<AbsentOptional_t>())
+		if (iVal.PGet<AbsentOptional_t>())
 			{
 			sEWriteBE<uint8>(iChanW, 254);
 			sEWriteBE<uint8>(iChanW, 102);
@@ -290,14 +203,6 @@ public:
 		}
 	};
 
-static void spFromZZ_Push_PPT(const Val_ZZ& iVal,
-	const ZP<Callable_ZZ_WriteFilter>& iWriteFilter,
-	const ZP<ChannerWCon_PPT>& iChannerWCon)
-	{
-	sFromZZ_Push_PPT(iVal, iWriteFilter, ChanW_XX_Buffered<ChanW_PPT>(*iChannerWCon, kBufSize));
-	sDisconnectWrite(*iChannerWCon);
-	}
-
 static ZAtomic_t spSentMessageCounter;
 
 static void spWriteMessage(const ChanW_Bin& iChanW, Map_ZZ iMessage, const ZQ<string>& iDescriptionQ)
@@ -310,12 +215,7 @@ static void spWriteMessage(const ChanW_Bin& iChanW, Map_ZZ iMessage, const ZQ<st
 
 	iMessage.Set("AAA", sAtomic_Add(&spSentMessageCounter, 1));
 
-	PullPushPair<PPT> thePair = sMakePullPushPair<PPT>();
-	sStartOnNewThread(sBindR(sCallable(spFromZZ_Push_PPT),
-		Val_ZZ(iMessage),
-		theWriteFilter,
-		sGetClear(thePair.first)));
-	sPull_PPT_Push_JSONB(ChanR_XX_Buffered<ChanR_PPT>(*thePair.second, kBufSize), theWriteFilter, theChanW);
+	sWriteJSONB_ZZ(iMessage, theWriteFilter, theChanW);
 
 	sFlush(theChanW);
 
@@ -394,9 +294,8 @@ Val_ZZ spAsVal(ZP<Result> iResult)
 
 	for (size_t yy = 0; yy < theCount; ++yy)
 		{
-		const Val_DB* theRow = iResult->GetValsAt(yy);
 		for (size_t xx = 0; xx < theRH.size(); ++xx)
-			theSeq_Vals.Append(theRow[xx].As<Val_ZZ>());
+			theSeq_Vals.Append(iResult->GetVal(yy, xx).As<Val_ZZ>());
 		}
 
 	return result;
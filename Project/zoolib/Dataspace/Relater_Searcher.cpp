@@ -99,6 +99,8 @@ class Relater_Searcher::PQuery
 public:
 	PQuery(ZP<RA::Expr_Rel> iRel)
 	:	fRel(iRel)
+	,	fPRegSearch_Direct(nullptr)
+	,	fGeneration(0)
 		{}
 
 	const ZP<RA::Expr_Rel> fRel;
@@ -106,6 +108,11 @@ public:
 	set<PRegSearch*> fPRegSearch_Used;
 	ZP<QE::Result> fResult;
 	ZP<ResultDeltas> fResultDeltas;
+
+	// Set when our walker turns out to be a lone Walker_Bingo, in which case fResult is
+	// fPRegSearch_Direct's fResult as of its fGeneration.
+	PRegSearch* fPRegSearch_Direct;
+	uint64 fGeneration;
 	};
 
 // =================================================================================================
@@ -119,12 +126,19 @@ class Relater_Searcher::PRegSearch
 :	public DLink_PRegSearch_NeedsWork
 	{
 public:
-	PRegSearch() {}
+	PRegSearch()
+	:	fGeneration(0)
+		{}
 
 	int64 fRefconInSearcher;
 	SearchSpec fSearchSpec;
 	set<PQuery*> fPQuery_Using;
 	ZP<QE::Result> fResult;
+
+	// Bumped for each fResult. fResultDeltas are the searcher's, and take the fResult
+	// of the prior generation to this one.
+	uint64 fGeneration;
+	ZP<ResultDeltas> fResultDeltas;
 	};
 
 // =================================================================================================
@@ -495,6 +509,33 @@ void Relater_Searcher::ModifyRegistrations(
 
 // =================================================================================================
 
+// If iResult has as many rows as iPriorResult, returns deltas listing the rows that differ.
+static ZP<ResultDeltas> spResultDeltas(const ZP<Result>& iPriorResult, const ZP<Result>& iResult)
+	{
+	ZAssert(iPriorResult->GetRelHead() == iResult->GetRelHead());
+	if (iPriorResult->Count() != iResult->Count())
+		return null;
+
+	ZP<ResultDeltas> theDeltas = new ResultDeltas;
+	const size_t rowCount = iPriorResult->Count();
+	const size_t colCount = iPriorResult->GetRelHead().size();
+
+	for (size_t rr = 0; rr < rowCount; ++rr)
+		{
+		for (size_t cc = 0; cc < colCount; ++cc)
+			{
+			if (iPriorResult->CompareAt(rr, cc, *iResult, rr))
+				{
+				for (size_t cc = 0; cc < colCount; ++cc)
+					theDeltas->fPackedRows.push_back(iResult->GetVal(rr, cc));
+				theDeltas->fMapping.push_back(rr);
+				break;
+				}
+			}
+		}
+	return theDeltas;
+	}
+
 void Relater_Searcher::CollectResults(vector<QueryResult>& oChanged, int64& oChangeCount)
 	{
 	Relater::pCalled_RelaterCollectResults();
@@ -509,57 +550,61 @@ void Relater_Searcher::CollectResults(vector<QueryResult>& oChanged, int64& oCha
 		eraser; eraser.Advance())
 		{
 		PQuery* thePQuery = eraser.Current();
-
-		{
-		ZRelMtx rel(fMtx);
-
-		ZP<QE::Walker> theWalker = Visitor_DoMakeWalker(this, thePQuery).Do(thePQuery->fRel);
-
-		const double start = Time::sSystem();
 		ZP<Result> priorResult = thePQuery->fResult;
-		thePQuery->fResult = QE::sResultFromWalker(theWalker);
-		const double elapsed = Time::sSystem() - start;
+		ZP<ResultDeltas> theDeltas;
 
-		if (elapsed > 0.1)
+		if (PRegSearch* theDirect = thePQuery->fPRegSearch_Direct)
 			{
-			if (ZLOGPF(w, eDebug))
-				{
-				w << "\nSlow Query " << elapsed * 1e3 << "ms: ";
-				w << thePQuery->fRel << "\n";
-				sToStrim(thePQuery->fResult, w);
-				sDumpWalkers(theWalker, w);
-				}
+			// Our result is the search's, so the searcher's deltas are ours too, so long as
+			// they follow on from the result we last had.
+			thePQuery->fResult = theDirect->fResult;
+			if (thePQuery->fGeneration + 1 == theDirect->fGeneration)
+				theDeltas = theDirect->fResultDeltas;
+			thePQuery->fGeneration = theDirect->fGeneration;
 			}
+		else
+			{
+			ZP<QE::Walker> theWalker;
 
-		thePQuery->fResultDeltas.Clear();
-		if (priorResult)
 			{
-			ZAssert(priorResult->GetRelHead() == thePQuery->fResult->GetRelHead());
-			if (priorResult->Count() == thePQuery->fResult->Count())
-				{
-				ZP<ResultDeltas> theDeltas = new ResultDeltas;
-				const size_t rowCount = priorResult->Count();
-				const size_t colCount = priorResult->GetRelHead().size();
+			ZRelMtx rel(fMtx);
+
+			theWalker = Visitor_DoMakeWalker(this, thePQuery).Do(thePQuery->fRel);
 
-				for (size_t rr = 0; rr < rowCount; ++rr)
+			const double start = Time::sSystem();
+			thePQuery->fResult = QE::sResultFromWalker(theWalker);
+			const double elapsed = Time::sSystem() - start;
+
+			if (elapsed > 0.1)
+				{
+				if (ZLOGPF(w, eDebug))
 					{
-					const Val_DB* priorVals = priorResult->GetValsAt(rr);
-					const Val_DB* currVals = thePQuery->fResult->GetValsAt(rr);
-					for (size_t cc = 0; cc < colCount; ++cc)
-						{
-						if (priorVals[cc] != currVals[cc])
-							{
-							for (size_t cc = 0; cc < colCount; ++cc)
-								theDeltas->fPackedRows.push_back(currVals[cc]);
-							theDeltas->fMapping.push_back(rr);
-							break;
-							}
-						}
+					w << "\nSlow Query " << elapsed * 1e3 << "ms: ";
+					w << thePQuery->fRel << "\n";
+					sToStrim(thePQuery->fResult, w);
+					sDumpWalkers(theWalker, w);
 					}
-				thePQuery->fResultDeltas = theDeltas;
 				}
 			}
-		}
+
+			// A Walker_Bingo with nothing bound yields its search's rows unaltered, so we
+			// can use the search's result, and its deltas, from now on.
+			ZP<Walker_Bingo> theBingo = theWalker.DynamicCast<Walker_Bingo>();
+			if (theBingo && theBingo->fPRegSearch && sIsEmpty(theBingo->fBoundNames))
+				{
+				thePQuery->fPRegSearch_Direct = theBingo->fPRegSearch;
+				thePQuery->fResult = theBingo->fPRegSearch->fResult;
+				thePQuery->fGeneration = theBingo->fPRegSearch->fGeneration;
+				}
+			}
+
+		if (priorResult && not theDeltas)
+			{
+			ZRelMtx rel(fMtx);
+			theDeltas = spResultDeltas(priorResult, thePQuery->fResult);
+			}
+
+		thePQuery->fResultDeltas = theDeltas;
 
 		for (DListIterator<ClientQuery, DLink_ClientQuery_InPQuery>
 			iter = thePQuery->fClientQuery_InPQuery; iter; iter.Advance())
@@ -613,6 +658,8 @@ bool Relater_Searcher::pCollectResultsFromSearcher()
 		if (PRegSearch* thePRS = sPMut(fMap_Refcon_PRegSearch, ii->GetRefcon()))
 			{
 			thePRS->fResult = ii->GetResult();
+			thePRS->fResultDeltas = ii->GetResultDeltas();
+			++thePRS->fGeneration;
 			foreacha (thePQuery, thePRS->fPQuery_Using)
 				sQInsertBack(fPQuery_NeedsWork, thePQuery);
 			}
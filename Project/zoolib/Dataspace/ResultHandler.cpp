@@ -35,7 +35,7 @@ bool ResultHandler::QCall(
 
 			std::copy_n(&iResultDeltas->fPackedRows[xx * theColCount],
 				theColCount,
-				&fResult->fPackedRows[target * theColCount]);
+				&fResult->MutPackedRows()[target * theColCount]);
 			}
 		}
 	sCall(fCallable, iRegistration, fResult);
@@ -122,6 +122,7 @@ SearchResult::SearchResult()
 SearchResult::SearchResult(const SearchResult& iOther)
 :	fRefcon(iOther.fRefcon)
 ,	fResult(iOther.fResult)
+,	fResultDeltas(iOther.fResultDeltas)
 	{}
 
 SearchResult::~SearchResult()
@@ -131,6 +132,7 @@ SearchResult& SearchResult::operator=(const SearchResult& iOther)
 	{
 	fRefcon = iOther.fRefcon;
 	fResult = iOther.fResult;
+	fResultDeltas = iOther.fResultDeltas;
 	return *this;
 	}
 
@@ -139,12 +141,22 @@ SearchResult::SearchResult(int64 iRefcon, const ZP<QueryEngine::Result>& iResult
 ,	fResult(iResult)
 	{}
 
+SearchResult::SearchResult(int64 iRefcon, const ZP<QueryEngine::Result>& iResult,
+	const ZP<QueryEngine::ResultDeltas>& iResultDeltas)
+:	fRefcon(iRefcon)
+,	fResult(iResult)
+,	fResultDeltas(iResultDeltas)
+	{}
+
 int64 SearchResult::GetRefcon() const
 	{ return fRefcon; }
 
 ZP<QueryEngine::Result> SearchResult::GetResult() const
 	{ return fResult; }
 
+ZP<QueryEngine::ResultDeltas> SearchResult::GetResultDeltas() const
+	{ return fResultDeltas; }
+
 // =================================================================================================
 #pragma mark - Searcher
 
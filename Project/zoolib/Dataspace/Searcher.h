@@ -93,12 +93,20 @@ public:
 
 	SearchResult(int64 iRefcon, const ZP<QueryEngine::Result>& iResult);
 
+	SearchResult(int64 iRefcon, const ZP<QueryEngine::Result>& iResult,
+		const ZP<QueryEngine::ResultDeltas>& iResultDeltas);
+
 	int64 GetRefcon() const;
 	ZP<QueryEngine::Result> GetResult() const;
 
+	// Non-null only when iResult has the same row count as the result previously delivered
+	// for this refcon, in which case it lists the rows whose values have changed.
+	ZP<QueryEngine::ResultDeltas> GetResultDeltas() const;
+
 private:
 	int64 fRefcon;
 	ZP<QueryEngine::Result> fResult;
+	ZP<QueryEngine::ResultDeltas> fResultDeltas;
 	};
 
 // =================================================================================================
@@ -23,11 +23,13 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/Callable_PMF.h"
 #include "zoolib/Compare.h"
 #include "zoolib/Log.h"
+#include "zoolib/Starter_WorkStealingPool.h"
 #include "zoolib/Stringf.h"
 #include "zoolib/Util_STL.h"
 #include "zoolib/Util_STL_map.h"
 #include "zoolib/Util_STL_vector.h"
 #include "zoolib/Util_ZZ_JSON.h"
+#include "zoolib/ZThread.h"
 
 #include "zoolib/ZMACRO_foreach.h"
 
@@ -35,10 +37,8 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/Expr/Util_Expr_Bool_CNF.h"
 
-#include "zoolib/QueryEngine/ResultFromWalker.h"
 #include "zoolib/QueryEngine/Util_Strim_Result.h"
 #include "zoolib/QueryEngine/Util_Strim_Walker.h"
-#include "zoolib/QueryEngine/Walker_Project.h"
 #include "zoolib/QueryEngine/Walker_Result.h"
 #include "zoolib/QueryEngine/Walker_Restrict.h"
 
@@ -46,10 +46,14 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/RelationalAlgebra/Util_Strim_Rel.h"
 #include "zoolib/RelationalAlgebra/Util_Strim_RelHead.h"
 
+#include "zoolib/ValPred/Compiled_ValPred_DB.h"
 #include "zoolib/ValPred/ValPred_DB.h"
 #include "zoolib/ValPred/Visitor_Expr_Bool_ValPred_DB_ToStrim.h"
 #include "zoolib/ValPred/Visitor_Expr_Bool_ValPred_Do_GetNames.h"
 
+#include <atomic>
+#include <exception> // For std::exception_ptr
+
 namespace ZooLib {
 namespace Dataspace {
 
@@ -142,9 +146,9 @@ public:
 
 	// -----
 
-	Index(const IndexSpec& iIndexSpec)
+	Index(const IndexSpec& iIndexSpec, size_t iShardCount)
 	:	fCount(iIndexSpec.size())
-	,	fSet(Comparer(fCount))
+	,	fSets(iShardCount, Set(Comparer(fCount)))
 		{
 		ZAssert(fCount <= Key::kMaxCols);
 		std::copy_n(iIndexSpec.begin(), fCount, fColNames);
@@ -190,7 +194,8 @@ public:
 	ColName fColNames[Key::kMaxCols];
 	const size_t fCount;
 
-	Set fSet;
+	// One set per shard, each holding keys for just that shard's entries.
+	vector<Set> fSets;
 
 	DListHead<DLink_PSearch_InIndex> fPSearch_InIndex;
 	};
@@ -223,9 +228,12 @@ class Searcher_Datons::Walker_Map
 :	public QE::Walker
 	{
 public:
-	Walker_Map(ZP<Searcher_Datons> iSearcher, const ConcreteHead& iConcreteHead)
+	Walker_Map(ZP<Searcher_Datons> iSearcher, const ConcreteHead& iConcreteHead,
+		Map_Thing::const_iterator iBegin, Map_Thing::const_iterator iEnd)
 	:	fSearcher(iSearcher)
 	,	fConcreteHead(iConcreteHead)
+	,	fBegin(iBegin)
+	,	fEnd(iEnd)
 		{}
 
 	virtual ~Walker_Map()
@@ -255,8 +263,11 @@ public:
 	const ZP<Searcher_Datons> fSearcher;
 	const ConcreteHead fConcreteHead;
 	size_t fBaseOffset;
+
+	const Map_Thing::const_iterator fBegin;
+	const Map_Thing::const_iterator fEnd;
+
 	Map_Thing::const_iterator fCurrent;
-	std::set<std::vector<Val_DB>> fPriors;
 	};
 
 // =================================================================================================
@@ -276,7 +287,6 @@ public:
 	,	fNameBoolVector(iConcreteHead.begin(), iConcreteHead.end())
 	,	fBegin(iBegin)
 	,	fEnd(iEnd)
-	,	fPrior(iIndex->fCount + iConcreteHead.size())
 		{}
 
 	virtual ~Walker_Index()
@@ -315,7 +325,6 @@ public:
 	const Index::Set::const_iterator fEnd;
 
 	Index::Set::const_iterator fCurrent;
-	std::vector<Val_DB> fPrior;
 	};
 
 // =================================================================================================
@@ -337,10 +346,14 @@ public:
 	ClientSearch(int64 iRefcon, PSearch* iPSearch)
 	:	fRefcon(iRefcon)
 	,	fPSearch(iPSearch)
+	,	fHasResult(false)
 		{}
 
 	int64 const fRefcon;
 	PSearch* const fPSearch;
+
+	// Deltas are only meaningful to a client that's seen the prior result.
+	bool fHasResult;
 	};
 
 // =================================================================================================
@@ -364,13 +377,13 @@ public:
 	PSearch(const SearchSpec& iSearchSpec)
 	:	fSearchSpec(iSearchSpec)
 	,	fIndex(nullptr)
+	,	fCount_Collected(0)
 		{}
 
 	const SearchSpec fSearchSpec;
 
 	size_t fUsableIndexNames;
 	ConcreteHead fConcreteHead;
-	RelHead fProjectionIfNecessary;
 
 	Index* fIndex;
 
@@ -379,19 +392,224 @@ public:
 	Bound_t fRangeHi;
 	ZP<Expr_Bool> fRestrictionRemainder;
 
+	// Whichever of fRestrictionRemainder or the searchspec's restriction applies, compiled
+	// once here rather than each time pCollectRows builds a walker. Null if it's trivially true.
+	ZP<Compiled_ValPred_DB> fRestriction_Compiled;
+
 	DListHead<DLink_ClientSearch_InPSearch> fClientSearch_InPSearch;
 
 	ZP<QE::Result> fResult;
+
+	// fResult is maintained incrementally once it's been built. Each distinct row maps to its
+	// position in fResult and to the number of datons currently producing it.
+	struct RowEntry
+		{
+		size_t fPosition;
+		size_t fCount;
+		};
+	map<vector<Val_DB>,RowEntry> fRows;
+
+	// Positions in fResult whose values have changed since the last CollectResults,
+	// and the row count as of then, from which we generate fResultDeltas.
+	set<size_t> fPositions_Touched;
+	size_t fCount_Collected;
+	ZP<QE::ResultDeltas> fResultDeltas;
+	};
+
+// =================================================================================================
+#pragma mark - Searcher_Datons::Shard
+
+class Searcher_Datons::Shard
+	{
+public:
+	// Guards fMap_Thing, and our set in each Index.
+	ZMtx fMtx;
+
+	Map_Thing fMap_Thing;
+
+	// The part of a MakeChanges batch that falls to us. This and the rest of our fields are
+	// guarded by fMtx_MakeChanges.
+	vector<Daton> fToAssert;
+	vector<Daton> fToRetract;
+
+	// Entries of fMap_Thing that the batch added, and that it will remove once they're out
+	// of the indexes.
+	vector<const Map_Thing::value_type*> fInserted;
+	vector<Map_Thing::iterator> fErased;
+
+	// Copies of the entries actually asserted and retracted, from which PSearches are updated.
+	Map_Thing fAsserted;
+	Map_Thing fRetracted;
+	};
+
+// =================================================================================================
+#pragma mark - Searcher_Datons::Acq_Shards
+
+// Holds every shard's lock, taken in order, for the duration of a scope.
+
+class Searcher_Datons::Acq_Shards
+	{
+public:
+	Acq_Shards(const vector<Shard*>& iShards)
+	:	fShards(iShards)
+		{
+		for (size_t xx = 0; xx < fShards.size(); ++xx)
+			fShards[xx]->fMtx.Acquire();
+		}
+
+	~Acq_Shards()
+		{
+		for (size_t xx = fShards.size(); xx > 0; --xx)
+			fShards[xx - 1]->fMtx.Release();
+		}
+
+private:
+	const vector<Shard*>& fShards;
+	};
+
+// =================================================================================================
+#pragma mark - Searcher_Datons::Rows
+
+// Rows of a PSearch's result columns, packed. The count is separate because a search of an
+// empty ConcreteHead still produces (empty) rows.
+
+struct Searcher_Datons::Rows
+	{
+	Rows()
+	:	fCount(0)
+		{}
+
+	vector<Val_DB> fPacked;
+	size_t fCount;
+	};
+
+// =================================================================================================
+#pragma mark - Searcher_Datons::Task
+
+// The work on one PSearch from one shard.
+
+struct Searcher_Datons::Task
+	{
+	Task()
+	:	fElapsed(0)
+		{}
+
+	Rows fInserted;
+	Rows fErased;
+
+	ZP<QE::Walker> fWalker;
+	double fElapsed;
+	};
+
+// =================================================================================================
+#pragma mark - ParallelFor (anonymous)
+
+namespace { // anonymous
+
+// Calls fCallable with each of 0 to fCount - 1, claiming indices one at a time. Any number of
+// threads may Run, and Wait returns once every call has completed. The thread that calls Wait
+// should have called Run first, so progress is made even if no helper ever gets to run. A call
+// that throws still counts as completed, and Wait rethrows the first such exception.
+
+class ParallelFor
+:	public Startable
+	{
+public:
+	ParallelFor(const ZP<Callable<void(size_t)>>& iCallable, size_t iCount)
+	:	fCallable(iCallable)
+	,	fCount(iCount)
+	,	fNext(0)
+	,	fDone(0)
+		{}
+
+// From Callable
+	virtual bool QCall()
+		{
+		this->Run();
+		return true;
+		}
+
+// Our protocol
+	void Run()
+		{
+		size_t theDone = 0;
+		for (;;)
+			{
+			const size_t theIndex = fNext.fetch_add(1);
+			if (theIndex >= fCount)
+				break;
+
+			try
+				{
+				fCallable->Call(theIndex);
+				}
+			catch (...)
+				{
+				ZAcqMtx acq(fMtx);
+				if (not fException)
+					fException = std::current_exception();
+				}
+			++theDone;
+			}
+
+		if (theDone)
+			{
+			ZAcqMtx acq(fMtx);
+			fDone += theDone;
+			if (fDone == fCount)
+				fCnd.Broadcast();
+			}
+		}
+
+	void Wait()
+		{
+		ZAcqMtx acq(fMtx);
+		while (fDone < fCount)
+			fCnd.Wait(fMtx);
+
+		if (fException)
+			std::rethrow_exception(fException);
+		}
+
+private:
+	const ZP<Callable<void(size_t)>> fCallable;
+	const size_t fCount;
+	std::atomic<size_t> fNext;
+
+	ZMtx fMtx;
+	ZCnd fCnd;
+	size_t fDone;
+	std::exception_ptr fException;
 	};
 
+} // anonymous namespace
+
 // =================================================================================================
 #pragma mark - Searcher_Datons
 
 Searcher_Datons::Searcher_Datons(const vector<IndexSpec>& iIndexSpecs)
-:	fChangeCount(0)
+:	fVersion_Data(0)
+,	fVersion_Applied(0)
+,	fChangeCount(0)
 	{
+	fShards.push_back(new Shard);
 	foreacha (entry, iIndexSpecs)
-		fIndexes.push_back(new Index(entry));
+		fIndexes.push_back(new Index(entry, 1));
+	}
+
+Searcher_Datons::Searcher_Datons(const vector<IndexSpec>& iIndexSpecs, size_t iShardCount)
+:	fStarter(iShardCount > 1
+		? ZP<Starter>(sStarter_WorkStealingPool(iShardCount - 1, "Searcher_Datons"))
+		: ZP<Starter>())
+,	fVersion_Data(0)
+,	fVersion_Applied(0)
+,	fChangeCount(0)
+	{
+	iShardCount = std::max<size_t>(1, iShardCount);
+	for (size_t xx = 0; xx < iShardCount; ++xx)
+		fShards.push_back(new Shard);
+	foreacha (entry, iIndexSpecs)
+		fIndexes.push_back(new Index(entry, iShardCount));
 	}
 
 Searcher_Datons::~Searcher_Datons()
@@ -405,6 +623,7 @@ Searcher_Datons::~Searcher_Datons()
 		{}
 
 	sDeleteAll(fIndexes.begin(), fIndexes.end());
+	sDeleteAll(fShards.begin(), fShards.end());
 	}
 
 bool Searcher_Datons::Intersects(const RelHead& iRelHead)
@@ -683,23 +902,15 @@ void Searcher_Datons::pSetupPSearch(PSearch* ioPSearch)
 	// We've got valsEqual filled in with stuff we're doing an equality search on, and
 	// may have a comparison in finalLo/finalHi.
 
-	const RelHead theRH_Wanted = RA::sRelHead(theSearchSpec.GetConcreteHead());
-
 	RelHead theRH_Required, theRH_Optional;
 	RA::sRelHeads(theSearchSpec.GetConcreteHead(), theRH_Required, theRH_Optional);
 
-	// Add in any names in restriction that weren't provided in the searchspec's CH.
+	// Add in any names in restriction that weren't provided in the searchspec's CH. They're
+	// projected back out by pCollectRows, which only picks the names in the searchspec's CH.
 	ioPSearch->fConcreteHead = RA::sAugmentedOptional(
 		theSearchSpec.GetConcreteHead(),
 		sGetNames(theSearchSpec.GetRestriction()));
 
-	if (theRH_Wanted != sRelHead(ioPSearch->fConcreteHead))
-		{
-		// There were names in the restriction that aren't in
-		// the searchspec's CH, so we must project them out.
-		ioPSearch->fProjectionIfNecessary = theRH_Wanted;
-		}
-
 	if (true && bestIndex)
 		{
 		ioPSearch->fIndex = bestIndex;
@@ -718,6 +929,13 @@ void Searcher_Datons::pSetupPSearch(PSearch* ioPSearch)
 		for (size_t xxColName = 0; xxColName < ioPSearch->fUsableIndexNames; ++xxColName)
 			sQErase(ioPSearch->fConcreteHead, ioPSearch->fIndex->fColNames[xxColName]);
 		}
+
+	const ZP<Expr_Bool>& theRestriction = ioPSearch->fIndex
+		? ioPSearch->fRestrictionRemainder
+		: theSearchSpec.GetRestriction();
+
+	if (theRestriction && theRestriction != sTrue())
+		ioPSearch->fRestriction_Compiled = new Compiled_ValPred_DB(theRestriction);
 	}
 
 static void spDump(const ChanW_UTF& w,
@@ -731,16 +949,20 @@ static void spDump(const ChanW_UTF& w,
 
 	foreacha (anIndex, fIndexes)
 		{
-		w << "\n" << anIndex->fSet.size() << " entries, indexed on: ";
+		w << "\n" << "Indexed on: ";
 		for (size_t xx = 0; xx < anIndex->fCount; ++xx)
 			w << anIndex->fColNames[xx] << " ";
 
-		foreacha (entry, anIndex->fSet)
+		foreacha (theSet, anIndex->fSets)
 			{
-			w << "\n";
-			for (size_t xx = 0; xx < anIndex->fCount; ++xx)
-				w << *(entry.fValues[xx]) << " ";
-			w << "--> " << entry.fMapEntryP->second;
+			w << "\n" << theSet.size() << " entries";
+			foreacha (entry, theSet)
+				{
+				w << "\n";
+				for (size_t xx = 0; xx < anIndex->fCount; ++xx)
+					w << *(entry.fValues[xx]) << " ";
+				w << "--> " << entry.fMapEntryP->second;
+				}
 			}
 		}
 	}
@@ -831,103 +1053,87 @@ void Searcher_Datons::CollectResults(vector<SearchResult>& oChanged, int64& oCha
 	oChanged.clear();
 	oChangeCount = fChangeCount;
 
-	for (DListEraser<PSearch,DLink_PSearch_NeedsWork> eraser = fPSearch_NeedsWork;
-		eraser; eraser.Advance())
+	// Build results from scratch for new PSearches, collecting rows from each shard and then
+	// merging them, with distinct PSearches and shards worked on in parallel. If a MakeChanges
+	// has changed the shards but not yet applied that to existing PSearches we leave new ones
+	// for now. It will trigger another call when it's done.
+	fRound_PSearches.clear();
+	for (DListIterator<PSearch,DLink_PSearch_NeedsWork> iter = fPSearch_NeedsWork;
+		iter; iter.Advance())
 		{
-		PSearch* thePSearch = eraser.Current();
-
+		PSearch* thePSearch = iter.Current();
 		if (not thePSearch->fResult)
-			{
-			const SearchSpec& theSearchSpec = thePSearch->fSearchSpec;
+			fRound_PSearches.push_back(make_pair(thePSearch, false));
+		}
 
-			ZP<QE::Walker> theWalker;
+	if (sNotEmpty(fRound_PSearches))
+		{
+		Acq_Shards acq_Shards(fShards);
+		if (fVersion_Data != fVersion_Applied)
+			{
+			fRound_PSearches.clear();
+			}
+		else
+			{
+			size_t theWork = 0;
+			foreacha (aShard, fShards)
+				theWork += aShard->fMap_Thing.size();
+			theWork *= fRound_PSearches.size();
 
-			if (thePSearch->fIndex)
+			foreacha (entry, fRound_PSearches)
 				{
-				Index::Key theKey;
-
-				const size_t countEqual = thePSearch->fValsEqual.size();
-				const size_t countAll = Key::kMaxCols;//thePSearch->fIndex->fCount;
-				ZAssert(countEqual <= countAll);
-				for (size_t xx = 0; xx < countEqual; ++xx)
-					theKey.fValues[xx] = &thePSearch->fValsEqual[xx];
-
-				for (size_t xx = countEqual + 1; xx < countAll; ++xx)
-					theKey.fValues[xx] = nullptr;
-
-				Index::Set::const_iterator theBegin;
-				if (not thePSearch->fRangeLo)
-					{
-					theKey.fValues[countEqual] = nullptr;
-					theKey.fMapEntryP = nullptr;
-					theBegin = thePSearch->fIndex->fSet.lower_bound(theKey);
-					}
-				else
-					{
-					theKey.fValues[countEqual] = &thePSearch->fRangeLo->first;
-					if (thePSearch->fRangeLo->second)
-						{
-						theKey.fMapEntryP = nullptr;
-						theBegin = thePSearch->fIndex->fSet.lower_bound(theKey);
-						}
-					else
-						{
-						theKey.fMapEntryP = spAllOnesPointer<Map_Thing::value_type>();
-						theBegin = thePSearch->fIndex->fSet.upper_bound(theKey);
-						}
-					}
-
-				Index::Set::const_iterator theEnd;
-				if (not thePSearch->fRangeHi)
-					{
-					theKey.fValues[countEqual] = nullptr;
-					theKey.fMapEntryP = spAllOnesPointer<Map_Thing::value_type>();
-					theEnd = thePSearch->fIndex->fSet.upper_bound(theKey);
-					}
-				else
-					{
-					theKey.fValues[countEqual] = &thePSearch->fRangeHi->first;
-					if (thePSearch->fRangeHi->second)
-						{
-						theKey.fMapEntryP = spAllOnesPointer<Map_Thing::value_type>();
-						theEnd = thePSearch->fIndex->fSet.upper_bound(theKey);
-						}
-					else
-						{
-						theKey.fMapEntryP = nullptr;
-						theEnd = thePSearch->fIndex->fSet.lower_bound(theKey);
-						}
-					}
+				PSearch* thePSearch = entry.first;
+				vector<Val_DB> thePackedRows;
+				thePSearch->fResult = new QE::Result(
+					RA::sRelHead(thePSearch->fSearchSpec.GetConcreteHead()), &thePackedRows);
+				thePSearch->fRows.clear();
+				}
 
-				theWalker = new Walker_Index(this,
-					thePSearch->fIndex, thePSearch->fUsableIndexNames, thePSearch->fConcreteHead,
-					theBegin, theEnd);
+			fRound_Tasks.resize(fRound_PSearches.size() * fShards.size());
+			this->pParallel(fRound_Tasks.size(), theWork,
+				&Searcher_Datons::pCollectResults_Collect);
+			}
+		}
 
-				if (thePSearch->fRestrictionRemainder && thePSearch->fRestrictionRemainder != sTrue())
-					theWalker = new QE::Walker_Restrict(theWalker, thePSearch->fRestrictionRemainder);
-				}
-			else
-				{
-				theWalker = new Walker_Map(this, thePSearch->fConcreteHead);
+	if (sNotEmpty(fRound_PSearches))
+		{
+		size_t theWork = 0;
+		foreacha (aTask, fRound_Tasks)
+			theWork += aTask.fInserted.fCount;
+		this->pParallel(fRound_PSearches.size(), theWork, &Searcher_Datons::pMergeTasks);
+		}
 
-				const ZP<Expr_Bool>& theRestriction = theSearchSpec.GetRestriction();
-				if (theRestriction && theRestriction != sTrue())
-					theWalker = new QE::Walker_Restrict(theWalker, theRestriction);
-				}
+	vector<PSearch*> theUnbuilt;
+	size_t theRoundIndex = 0;
+	for (DListEraser<PSearch,DLink_PSearch_NeedsWork> eraser = fPSearch_NeedsWork;
+		eraser; eraser.Advance())
+		{
+		PSearch* thePSearch = eraser.Current();
 
-			if (sNotEmpty(thePSearch->fProjectionIfNecessary))
-				theWalker = new QE::Walker_Project(theWalker, thePSearch->fProjectionIfNecessary);
+		if (not thePSearch->fResult)
+			{
+			theUnbuilt.push_back(thePSearch);
+			continue;
+			}
 
-			const double start = Time::sSystem();
+		if (theRoundIndex < fRound_PSearches.size()
+			&& fRound_PSearches[theRoundIndex].first == thePSearch)
+			{
+			// We've just built it.
+			const Task* theTasks = &fRound_Tasks[theRoundIndex * fShards.size()];
+			++theRoundIndex;
 
-			thePSearch->fResult = QE::sResultFromWalker(theWalker);
+			thePSearch->fResultDeltas.Clear();
 
-			const double elapsed = Time::sSystem() - start;
+			double elapsed = 0;
+			for (size_t xx = 0; xx < fShards.size(); ++xx)
+				elapsed += theTasks[xx].fElapsed;
 
 			if (elapsed > 50e-3)
 				{
 				if (ZLOGPF(w, eDebug))
 					{
+					const SearchSpec& theSearchSpec = thePSearch->fSearchSpec;
 					w << "\nSlow PSearch " << elapsed * 1e3 << "ms: ";
 					Visitor_Expr_Bool_ValPred_DB_ToStrim()
 						.ToStrim(sDefault(), w, theSearchSpec.GetRestriction());
@@ -941,67 +1147,151 @@ void Searcher_Datons::CollectResults(vector<SearchResult>& oChanged, int64& oCha
 					w << "\n";
 					sToStrim(thePSearch->fResult, w);
 
-					sDumpWalkers(theWalker, w);
+					for (size_t xx = 0; xx < fShards.size(); ++xx)
+						sDumpWalkers(theTasks[xx].fWalker, w);
 					}
 				}
-
-			for (DListIterator<ClientSearch, DLink_ClientSearch_InPSearch>
-				iter = thePSearch->fClientSearch_InPSearch; iter; iter.Advance())
-				{ sQInsertBack(fClientSearch_NeedsWork, iter.Current()); }
 			}
+		else
+			{
+			// fResult has been maintained by MakeChanges. If the row count is unchanged
+			// then the touched rows are all that a client needs to hear about.
+			thePSearch->fResultDeltas.Clear();
+			const size_t theCount = thePSearch->fResult->Count();
+			if (theCount == thePSearch->fCount_Collected)
+				{
+				ZP<QE::ResultDeltas> theDeltas = new QE::ResultDeltas;
+				const size_t theColCount = thePSearch->fResult->GetRelHead().size();
+				foreacha (thePosition, thePSearch->fPositions_Touched)
+					{
+					if (thePosition >= theCount)
+						break;
+					const Val_DB* theVals = thePSearch->fResult->GetValsAt(thePosition);
+					theDeltas->fPackedRows.insert(theDeltas->fPackedRows.end(),
+						theVals, theVals + theColCount);
+					theDeltas->fMapping.push_back(thePosition);
+					}
+				thePSearch->fResultDeltas = theDeltas;
+				}
+			}
+
+		thePSearch->fPositions_Touched.clear();
+		thePSearch->fCount_Collected = thePSearch->fResult->Count();
+
+		for (DListIterator<ClientSearch, DLink_ClientSearch_InPSearch>
+			iter = thePSearch->fClientSearch_InPSearch; iter; iter.Advance())
+			{ sQInsertBack(fClientSearch_NeedsWork, iter.Current()); }
 		}
 
+	fRound_PSearches.clear();
+	fRound_Tasks.clear();
+
+	foreacha (thePSearch, theUnbuilt)
+		sInsertBackMust(fPSearch_NeedsWork, thePSearch);
+
+	vector<ClientSearch*> theWaiting;
 	for (DListEraser<ClientSearch,DLink_ClientSearch_NeedsWork> eraser = fClientSearch_NeedsWork;
 		eraser; eraser.Advance())
 		{
 		ClientSearch* theClientSearch = eraser.Current();
 		PSearch* thePSearch = theClientSearch->fPSearch;
-		oChanged.push_back(SearchResult(theClientSearch->fRefcon, thePSearch->fResult));
+
+		if (not thePSearch->fResult)
+			{
+			theWaiting.push_back(theClientSearch);
+			continue;
+			}
+
+		ZP<QE::ResultDeltas> theDeltas;
+		if (theClientSearch->fHasResult)
+			theDeltas = thePSearch->fResultDeltas;
+		theClientSearch->fHasResult = true;
+
+		oChanged.push_back(SearchResult(theClientSearch->fRefcon, thePSearch->fResult, theDeltas));
 		}
+
+	foreacha (theClientSearch, theWaiting)
+		sInsertBackMust(fClientSearch_NeedsWork, theClientSearch);
 	}
 
 int64 Searcher_Datons::MakeChanges(
 	const Daton* iAsserted, size_t iAssertedCount,
 	const Daton* iRetracted, size_t iRetractedCount)
 	{
-	ZAcqMtx acq(fMtx);
+	ZAcqMtx acq_MakeChanges(fMtx_MakeChanges);
+
+	const size_t theWork = iAssertedCount + iRetractedCount;
 
 	while (iAssertedCount--)
 		{
-		const Daton theDaton = *iAsserted++;
-		Map_Thing::iterator iterLB = fMap_Thing.lower_bound(theDaton);
-
-		if (iterLB == fMap_Thing.end() || theDaton != iterLB->first)
-			{
-			Map_Thing::const_iterator iter =
-				fMap_Thing.insert(iterLB, make_pair(theDaton, sAsVal(theDaton)));
-			this->pIndexInsert(&*iter);
-			}
+		const Daton& theDaton = *iAsserted++;
+		fShards[this->pShardIndex(theDaton)]->fToAssert.push_back(theDaton);
 		}
 
 	while (iRetractedCount--)
 		{
-		const Daton theDaton = *iRetracted++;
-		Map_Thing::iterator iter = fMap_Thing.find(theDaton);
-		if (iter != fMap_Thing.end())
-			{
-			this->pIndexErase(&*iter);
-			fMap_Thing.erase(iter);
-			}
+		const Daton& theDaton = *iRetracted++;
+		fShards[this->pShardIndex(theDaton)]->fToRetract.push_back(theDaton);
 		}
 
-	// Invalidate all PSearches unattached to indexes.
-	for (Map_SearchSpec_PSearch::iterator
-		iter = fMap_SearchSpec_PSearch.begin(), end = fMap_SearchSpec_PSearch.end();
-		iter != end; ++iter)
+	// Each shard updates its map, then its set for each index, then erases retracted entries.
+	// Only the shards' locks are needed for this, the bulk of the work.
+	const size_t theShardCount = fShards.size();
+	uint64 theVersion;
 		{
-		if (not iter->second.fIndex)
+		Acq_Shards acq_Shards(fShards);
+		this->pParallel(theShardCount, theWork, &Searcher_Datons::pMakeChanges_Map);
+		this->pParallel(theShardCount * fIndexes.size(), theWork * fIndexes.size(),
+			&Searcher_Datons::pMakeChanges_Index);
+		this->pParallel(theShardCount, theWork, &Searcher_Datons::pMakeChanges_Erase);
+		theVersion = ++fVersion_Data;
+		}
+
+	size_t theChangedCount = 0;
+	foreacha (aShard, fShards)
+		theChangedCount += aShard->fAsserted.size() + aShard->fRetracted.size();
+
+	ZAcqMtx acq(fMtx);
+
+	// Apply the changes as row insertions and removals to every PSearch that has a result. Those
+	// that don't are already in fPSearch_NeedsWork and will be built from scratch.
+	if (theChangedCount)
+		{
+		fRound_PSearches.clear();
+		for (Map_SearchSpec_PSearch::iterator
+			iter = fMap_SearchSpec_PSearch.begin(), end = fMap_SearchSpec_PSearch.end();
+			iter != end; ++iter)
+			{
+			PSearch* thePSearch = &iter->second;
+			if (thePSearch->fResult)
+				fRound_PSearches.push_back(make_pair(thePSearch, false));
+			}
+
+		const size_t theRoundWork = fRound_PSearches.size() * theChangedCount;
+		fRound_Tasks.resize(fRound_PSearches.size() * theShardCount);
+		this->pParallel(fRound_Tasks.size(), theRoundWork,
+			&Searcher_Datons::pMakeChanges_Collect);
+		this->pParallel(fRound_PSearches.size(), theRoundWork,
+			&Searcher_Datons::pMergeTasks);
+
+		foreacha (entry, fRound_PSearches)
 			{
-			iter->second.fResult.Clear();
-			sQInsertBack(fPSearch_NeedsWork, &iter->second);
+			if (entry.second)
+				sQInsertBack(fPSearch_NeedsWork, entry.first);
+			}
+
+		fRound_PSearches.clear();
+		fRound_Tasks.clear();
+
+		foreacha (aShard, fShards)
+			{
+			aShard->fAsserted.clear();
+			aShard->fRetracted.clear();
 			}
 		}
 
+	fVersion_Applied = theVersion;
+
 	int64 theChangeCount = ++fChangeCount;
 
 	if (sNotEmpty(fClientSearch_NeedsWork) || sNotEmpty(fPSearch_NeedsWork))
@@ -1013,97 +1303,416 @@ int64 Searcher_Datons::MakeChanges(
 	return theChangeCount;
 	}
 
-void Searcher_Datons::pInvalidateSearchIfAppropriate(PSearch* iPSearch, const Key& iKey)
+bool Searcher_Datons::pKeyMatches(PSearch* iPSearch, const Key& iKey)
+	{
+	const size_t countEqual = iPSearch->fValsEqual.size();
+
+	if (iPSearch->fRangeLo)
+		{
+		if (iPSearch->fRangeLo->second)
+			{
+			if (not (iPSearch->fRangeLo->first <= *iKey.fValues[countEqual]))
+				return false;
+			}
+		else if (not (iPSearch->fRangeLo->first < *iKey.fValues[countEqual]))
+			{
+			return false;
+			}
+		}
+
+	if (iPSearch->fRangeHi)
+		{
+		if (iPSearch->fRangeHi->second)
+			{
+			if (not (iPSearch->fRangeHi->first >= *iKey.fValues[countEqual]))
+				return false;
+			}
+		else if (not (iPSearch->fRangeHi->first > *iKey.fValues[countEqual]))
+			{
+			return false;
+			}
+		}
+
+	for (size_t xx = countEqual; xx > 0;)
+		{
+		--xx;
+		if (*iKey.fValues[xx] != iPSearch->fValsEqual[xx])
+			return false;
+		}
+
+	// iPSearch->fRestrictionRemainder is applied by the walker in pCollectRows.
+	return true;
+	}
+
+size_t Searcher_Datons::pShardIndex(const Daton& iDaton)
+	{
+	if (fShards.size() == 1)
+		return 0;
+
+	// FNV-1a of the daton's bytes.
+	const Data_ZZ theData = iDaton.GetData();
+	const uint8* theBytes = static_cast<const uint8*>(theData.GetPtr());
+	uint32 theHash = 2166136261U;
+	for (size_t xx = 0, count = theData.GetSize(); xx < count; ++xx)
+		theHash = (theHash ^ theBytes[xx]) * 16777619U;
+	return theHash % fShards.size();
+	}
+
+void Searcher_Datons::pParallel(size_t iCount, size_t iWork,
+	void (Searcher_Datons::*iMethod)(size_t))
 	{
-	if (iPSearch->fResult && not sContains(fPSearch_NeedsWork, iPSearch))
+	// iWork is roughly the number of datons or rows that will be handled. Waking a helper costs
+	// about as much as handling kWorkPerHelper of them, so small batches stay on this thread.
+	const size_t kWorkPerHelper = 1024;
+
+	size_t theHelperCount = 0;
+	if (fStarter)
+		theHelperCount = std::min(std::min(iCount, fShards.size()), iWork / kWorkPerHelper);
+
+	if (theHelperCount <= 1)
+		{
+		for (size_t xx = 0; xx < iCount; ++xx)
+			(this->*iMethod)(xx);
+		}
+	else
 		{
-		// We will invalidate only if iKey matches iPSearch.
-		const size_t countEqual = iPSearch->fValsEqual.size();
+		ZP<ParallelFor> theParallelFor = new ParallelFor(sCallable(this, iMethod), iCount);
+		for (size_t xx = 1; xx < theHelperCount; ++xx)
+			fStarter->QStart(theParallelFor);
+		theParallelFor->Run();
+		theParallelFor->Wait();
+		}
+	}
 
-		bool allMatch = true;
+void Searcher_Datons::pMakeChanges_Map(size_t iShardIndex)
+	{
+	Shard* theShard = fShards[iShardIndex];
+	Map_Thing& theMap_Thing = theShard->fMap_Thing;
+
+	foreacha (theDaton, theShard->fToAssert)
+		{
+		Map_Thing::iterator iterLB = theMap_Thing.lower_bound(theDaton);
 
-		if (allMatch)
+		if (iterLB == theMap_Thing.end() || theDaton != iterLB->first)
 			{
-			if (iPSearch->fRangeLo)
-				{
-				if (iPSearch->fRangeLo->second)
-					allMatch = iPSearch->fRangeLo->first <= *iKey.fValues[countEqual];
-				else
-					allMatch = iPSearch->fRangeLo->first < *iKey.fValues[countEqual];
-				}
+			Map_Thing::iterator iter =
+				theMap_Thing.insert(iterLB, make_pair(theDaton, sAsVal(theDaton)));
+			theShard->fInserted.push_back(&*iter);
+			theShard->fAsserted.insert(*iter);
 			}
+		}
+
+	// Keep our own copies of the retracted entries, so they remain available after
+	// they've been removed from theMap_Thing.
+	foreacha (theDaton, theShard->fToRetract)
+		{
+		Map_Thing::iterator iter = theMap_Thing.find(theDaton);
+		if (iter != theMap_Thing.end() && theShard->fRetracted.insert(*iter).second)
+			theShard->fErased.push_back(iter);
+		}
+
+	theShard->fToAssert.clear();
+	theShard->fToRetract.clear();
+	}
+
+void Searcher_Datons::pMakeChanges_Index(size_t iIndexAndShard)
+	{
+	const size_t theShardIndex = iIndexAndShard % fShards.size();
+	const Shard* theShard = fShards[theShardIndex];
+	Index* theIndex = fIndexes[iIndexAndShard / fShards.size()];
+	Index::Set& theSet = theIndex->fSets[theShardIndex];
+
+	foreacha (theMapEntryP, theShard->fInserted)
+		{
+		Key theKey;
+		if (theIndex->pAsKey(theMapEntryP, theKey))
+			sInsertMust(theSet, theKey);
+		}
+
+	foreacha (iter, theShard->fErased)
+		{
+		Key theKey;
+		if (theIndex->pAsKey(&*iter, theKey))
+			sEraseMust(theSet, theKey);
+		}
+	}
+
+void Searcher_Datons::pMakeChanges_Erase(size_t iShardIndex)
+	{
+	Shard* theShard = fShards[iShardIndex];
+	foreacha (iter, theShard->fErased)
+		theShard->fMap_Thing.erase(iter);
+
+	theShard->fInserted.clear();
+	theShard->fErased.clear();
+	}
+
+void Searcher_Datons::pMakeChanges_Collect(size_t iTaskIndex)
+	{
+	PSearch* thePSearch = fRound_PSearches[iTaskIndex / fShards.size()].first;
+	const Shard* theShard = fShards[iTaskIndex % fShards.size()];
+	Task& theTask = fRound_Tasks[iTaskIndex];
+
+	this->pCollectChanges(thePSearch, theShard->fAsserted, theTask.fInserted);
+	this->pCollectChanges(thePSearch, theShard->fRetracted, theTask.fErased);
+	}
+
+void Searcher_Datons::pCollectResults_Collect(size_t iTaskIndex)
+	{
+	PSearch* thePSearch = fRound_PSearches[iTaskIndex / fShards.size()].first;
+	const size_t theShardIndex = iTaskIndex % fShards.size();
+	Task& theTask = fRound_Tasks[iTaskIndex];
+
+	const double start = Time::sSystem();
+
+	ZP<QE::Walker> theWalker;
+
+	if (thePSearch->fIndex)
+		{
+		const Index::Set& theSet = thePSearch->fIndex->fSets[theShardIndex];
+
+		Index::Key theKey;
+
+		const size_t countEqual = thePSearch->fValsEqual.size();
+		const size_t countAll = Key::kMaxCols;//thePSearch->fIndex->fCount;
+		ZAssert(countEqual <= countAll);
+		for (size_t xx = 0; xx < countEqual; ++xx)
+			theKey.fValues[xx] = &thePSearch->fValsEqual[xx];
 
-		if (allMatch)
+		for (size_t xx = countEqual + 1; xx < countAll; ++xx)
+			theKey.fValues[xx] = nullptr;
+
+		Index::Set::const_iterator theBegin;
+		if (not thePSearch->fRangeLo)
 			{
-			if (iPSearch->fRangeHi)
+			theKey.fValues[countEqual] = nullptr;
+			theKey.fMapEntryP = nullptr;
+			theBegin = theSet.lower_bound(theKey);
+			}
+		else
+			{
+			theKey.fValues[countEqual] = &thePSearch->fRangeLo->first;
+			if (thePSearch->fRangeLo->second)
 				{
-				if (iPSearch->fRangeHi->second)
-					allMatch = iPSearch->fRangeHi->first >= *iKey.fValues[countEqual];
-				else
-					allMatch = iPSearch->fRangeHi->first > *iKey.fValues[countEqual];
+				theKey.fMapEntryP = nullptr;
+				theBegin = theSet.lower_bound(theKey);
+				}
+			else
+				{
+				theKey.fMapEntryP = spAllOnesPointer<Map_Thing::value_type>();
+				theBegin = theSet.upper_bound(theKey);
 				}
 			}
 
-		if (allMatch)
+		Index::Set::const_iterator theEnd;
+		if (not thePSearch->fRangeHi)
 			{
-			for (size_t xx = countEqual; xx > 0;)
+			theKey.fValues[countEqual] = nullptr;
+			theKey.fMapEntryP = spAllOnesPointer<Map_Thing::value_type>();
+			theEnd = theSet.upper_bound(theKey);
+			}
+		else
+			{
+			theKey.fValues[countEqual] = &thePSearch->fRangeHi->first;
+			if (thePSearch->fRangeHi->second)
 				{
-				--xx;
-				if (*iKey.fValues[xx] != iPSearch->fValsEqual[xx])
-					{
-					allMatch = false;
-					break;
-					}
+				theKey.fMapEntryP = spAllOnesPointer<Map_Thing::value_type>();
+				theEnd = theSet.upper_bound(theKey);
+				}
+			else
+				{
+				theKey.fMapEntryP = nullptr;
+				theEnd = theSet.lower_bound(theKey);
 				}
 			}
 
-		// We're ignoring iPSearch->fRestrictionRemainder, so we will have some false positives.
+		theWalker = new Walker_Index(this,
+			thePSearch->fIndex, thePSearch->fUsableIndexNames, thePSearch->fConcreteHead,
+			theBegin, theEnd);
+		}
+	else
+		{
+		const Map_Thing& theMap_Thing = fShards[theShardIndex]->fMap_Thing;
+		theWalker = new Walker_Map(this, thePSearch->fConcreteHead,
+			theMap_Thing.begin(), theMap_Thing.end());
+		}
+
+	this->pCollectRows(thePSearch, theWalker, theTask.fInserted);
+
+	theTask.fWalker = theWalker;
+	theTask.fElapsed = Time::sSystem() - start;
+	}
+
+void Searcher_Datons::pMergeTasks(size_t iPSearchIndex)
+	{
+	PSearch* thePSearch = fRound_PSearches[iPSearchIndex].first;
+	const Task* theTasks = &fRound_Tasks[iPSearchIndex * fShards.size()];
+
+	// All insertions precede all removals, so a row that moves between datons in different
+	// shards keeps its position.
+	bool changed = false;
+	for (size_t xx = 0; xx < fShards.size(); ++xx)
+		changed |= this->pApplyRows(thePSearch, theTasks[xx].fInserted, true);
+
+	for (size_t xx = 0; xx < fShards.size(); ++xx)
+		changed |= this->pApplyRows(thePSearch, theTasks[xx].fErased, false);
+
+	fRound_PSearches[iPSearchIndex].second = changed;
+	}
+
+void Searcher_Datons::pCollectChanges(PSearch* iPSearch, const Map_Thing& iChanged, Rows& ioRows)
+	{
+	if (sIsEmpty(iChanged))
+		return;
 
-		if (allMatch)
+	if (Index* theIndex = iPSearch->fIndex)
+		{
+		// Build a scratch index holding just those changed entries that fall within
+		// iPSearch's key range, and walk it exactly as we would the real index.
+		Index::Set theSet(theIndex->fSets[0].key_comp());
+		foreacha (entry, iChanged)
 			{
-			sQInsertBack(fPSearch_NeedsWork, iPSearch);
-			iPSearch->fResult.Clear();
+			Key theKey;
+			if (theIndex->pAsKey(&entry, theKey) && this->pKeyMatches(iPSearch, theKey))
+				theSet.insert(theKey);
 			}
+
+		if (theSet.empty())
+			return;
+
+		this->pCollectRows(iPSearch,
+			new Walker_Index(this,
+				theIndex, iPSearch->fUsableIndexNames, iPSearch->fConcreteHead,
+				theSet.begin(), theSet.end()),
+			ioRows);
+		}
+	else
+		{
+		this->pCollectRows(iPSearch,
+			new Walker_Map(this, iPSearch->fConcreteHead, iChanged.begin(), iChanged.end()),
+			ioRows);
 		}
 	}
 
-void Searcher_Datons::pIndexInsert(const Map_Thing::value_type* iMapEntryP)
+void Searcher_Datons::pCollectRows(PSearch* iPSearch, ZP<QE::Walker> iWalker, Rows& ioRows)
 	{
-	foreacha (anIndex, fIndexes)
+	if (iPSearch->fRestriction_Compiled)
+		iWalker = new QE::Walker_Restrict(iWalker, iPSearch->fRestriction_Compiled);
+
+	map<string8,size_t> theOffsets;
+	size_t theBaseOffset = 0;
+	iWalker = iWalker->Prime(sDefault(), theOffsets, theBaseOffset);
+	if (not iWalker)
+		return;
+
+	// Pick out the columns of our result, which also serves to project away
+	// any names that were only wanted by the restriction.
+	vector<size_t> theResultOffsets;
+	foreacha (entry, iPSearch->fResult->GetRelHead())
+		theResultOffsets.push_back(sGetMust(theOffsets, entry));
+
+	const size_t kBatchRows = 256;
+	vector<Val_DB> theVals(std::max<size_t>(1, theBaseOffset * kBatchRows));
+	for (;;)
 		{
-		Key theKey;
-		if (anIndex->pAsKey(iMapEntryP, theKey))
+		const size_t theCount = iWalker->QReadBatch(&theVals[0], theBaseOffset, kBatchRows);
+		for (size_t yy = 0; yy < theCount; ++yy)
 			{
-			sInsertMust(anIndex->fSet, theKey);
-			for (DListIterator<PSearch,DLink_PSearch_InIndex> iter = anIndex->fPSearch_InIndex;
-				iter; iter.Advance())
-				{
-				this->pInvalidateSearchIfAppropriate(iter.Current(), theKey);
-				}
+			const Val_DB* theVals_Row = &theVals[yy * theBaseOffset];
+			for (size_t xx = 0; xx < theResultOffsets.size(); ++xx)
+				ioRows.fPacked.push_back(theVals_Row[theResultOffsets[xx]]);
 			}
+		ioRows.fCount += theCount;
+
+		if (theCount < kBatchRows)
+			break;
 		}
 	}
 
-void Searcher_Datons::pIndexErase(const Map_Thing::value_type* iMapEntryP)
+bool Searcher_Datons::pApplyRows(PSearch* ioPSearch, const Rows& iRows, bool iInserted)
 	{
-	foreacha (anIndex, fIndexes)
+	const size_t theColCount = ioPSearch->fResult->GetRelHead().size();
+
+	bool changed = false;
+	vector<Val_DB> theRow(theColCount);
+	for (size_t yy = 0; yy < iRows.fCount; ++yy)
 		{
-		Key theKey;
-		if (anIndex->pAsKey(iMapEntryP, theKey))
-			{
-			sEraseMust(anIndex->fSet, theKey);
-			for (DListIterator<PSearch,DLink_PSearch_InIndex> iter = anIndex->fPSearch_InIndex;
-				iter; iter.Advance())
-				{
-				this->pInvalidateSearchIfAppropriate(iter.Current(), theKey);
-				}
-			}
+		std::copy_n(iRows.fPacked.begin() + yy * theColCount, theColCount, theRow.begin());
+
+		if (iInserted)
+			changed |= this->pInsertRow(ioPSearch, theRow);
+		else
+			changed |= this->pEraseRow(ioPSearch, theRow);
+		}
+
+	return changed;
+	}
+
+bool Searcher_Datons::pInsertRow(PSearch* ioPSearch, const vector<Val_DB>& iRow)
+	{
+	map<vector<Val_DB>,PSearch::RowEntry>::iterator iterLB = ioPSearch->fRows.lower_bound(iRow);
+	if (iterLB != ioPSearch->fRows.end() && iterLB->first == iRow)
+		{
+		// Another daton already produces this row.
+		++iterLB->second.fCount;
+		return false;
+		}
+
+	// Append the row, copying the result first if a client is holding it.
+	ioPSearch->fResult = ioPSearch->fResult->Fresh();
+	const size_t thePosition = ioPSearch->fResult->Count();
+	vector<Val_DB>& thePackedRows = ioPSearch->fResult->MutPackedRows();
+	thePackedRows.insert(thePackedRows.end(), iRow.begin(), iRow.end());
+
+	const PSearch::RowEntry theEntry = { thePosition, 1 };
+	ioPSearch->fRows.insert(iterLB, make_pair(iRow, theEntry));
+	ioPSearch->fPositions_Touched.insert(thePosition);
+	return true;
+	}
+
+bool Searcher_Datons::pEraseRow(PSearch* ioPSearch, const vector<Val_DB>& iRow)
+	{
+	map<vector<Val_DB>,PSearch::RowEntry>::iterator iter = ioPSearch->fRows.find(iRow);
+	if (iter == ioPSearch->fRows.end())
+		{
+		ZAssertStop(kDebug, false);
+		return false;
+		}
+
+	if (--iter->second.fCount)
+		{
+		// Some other daton still produces this row.
+		return false;
 		}
+
+	const size_t thePosition = iter->second.fPosition;
+	ioPSearch->fRows.erase(iter);
+
+	const size_t theColCount = iRow.size();
+	if (not theColCount)
+		return true;
+
+	// Move the last row into the vacated position, so removal costs the same
+	// no matter where the row is.
+	ioPSearch->fResult = ioPSearch->fResult->Fresh();
+	vector<Val_DB>& thePackedRows = ioPSearch->fResult->MutPackedRows();
+	const size_t theLast = thePackedRows.size() / theColCount - 1;
+	if (thePosition != theLast)
+		{
+		const vector<Val_DB>::iterator theSource = thePackedRows.begin() + theLast * theColCount;
+		vector<Val_DB> theMoved(theSource, theSource + theColCount);
+		std::copy(theMoved.begin(), theMoved.end(),
+			thePackedRows.begin() + thePosition * theColCount);
+		ioPSearch->fRows[theMoved].fPosition = thePosition;
+		ioPSearch->fPositions_Touched.insert(thePosition);
+		}
+	thePackedRows.resize(theLast * theColCount);
+	return true;
 	}
 
 void Searcher_Datons::pRewind(ZP<Walker_Map> iWalker_Map)
 	{
-	iWalker_Map->fCurrent = fMap_Thing.begin();
+	iWalker_Map->fCurrent = iWalker_Map->fBegin;
 	}
 
 void Searcher_Datons::pPrime(ZP<Walker_Map> iWalker_Map,
@@ -1111,7 +1720,7 @@ void Searcher_Datons::pPrime(ZP<Walker_Map> iWalker_Map,
 	map<string8,size_t>& oOffsets,
 	size_t& ioBaseOffset)
 	{
-	iWalker_Map->fCurrent = fMap_Thing.begin();
+	iWalker_Map->fCurrent = iWalker_Map->fBegin;
 	iWalker_Map->fBaseOffset = ioBaseOffset;
 	foreacha (entry, iWalker_Map->fConcreteHead)
 		oOffsets[entry.first] = ioBaseOffset++;
@@ -1121,13 +1730,11 @@ bool Searcher_Datons::pReadInc(ZP<Walker_Map> iWalker_Map, Val_DB* ioResults)
 	{
 	const ConcreteHead& theConcreteHead = iWalker_Map->fConcreteHead;
 
-	while (iWalker_Map->fCurrent != fMap_Thing.end())
+	while (iWalker_Map->fCurrent != iWalker_Map->fEnd)
 		{
 		if (const Map_ZZ* theMap = iWalker_Map->fCurrent->second.PGet<Map_ZZ>())
 			{
 			bool gotAll = true;
-			vector<Val_DB> subset;
-			subset.reserve(theConcreteHead.size());
 			size_t offset = iWalker_Map->fBaseOffset;
 			for (ConcreteHead::const_iterator
 				ii = theConcreteHead.begin(), end = theConcreteHead.end();
@@ -1137,19 +1744,15 @@ bool Searcher_Datons::pReadInc(ZP<Walker_Map> iWalker_Map, Val_DB* ioResults)
 				if (theName.empty())
 					{
 					// Empty name indicates that we want the Daton itself.
-					const Val_DB& theVal = iWalker_Map->fCurrent->first;
-					ioResults[offset] = theVal;
-					subset.push_back(theVal);
+					ioResults[offset] = iWalker_Map->fCurrent->first;
 					}
 				else if (const Val_DB* theVal = sPGet(*theMap, theName))
 					{
 					ioResults[offset] = *theVal;
-					subset.push_back(*theVal);
 					}
 				else if (not ii->second)
 					{
 					ioResults[offset] = AbsentOptional_t();
-					subset.push_back(AbsentOptional_t());
 					}
 				else
 					{
@@ -1158,7 +1761,9 @@ bool Searcher_Datons::pReadInc(ZP<Walker_Map> iWalker_Map, Val_DB* ioResults)
 					}
 				}
 
-			if (gotAll && sQInsert(iWalker_Map->fPriors, subset))
+			// Every daton yields its own row, duplicates are reference
+			// counted by pInsertRow and pEraseRow.
+			if (gotAll)
 				{
 				++iWalker_Map->fCurrent;
 				return true;
@@ -1239,30 +1844,11 @@ bool Searcher_Datons::pReadInc(ZP<Walker_Index> iWalker_Index, Val_DB* ioResults
 
 			if (gotAll)
 				{
-				bool allMatch = true;
 				const size_t theCount = theValPtrs.size();
-				const Val_DB* iterPrior = &iWalker_Index->fPrior[theCount-1];
-				const Val_DB** iterCurr = &theValPtrs[theCount-1];
-				for (size_t count = theCount + 1; --count; /*no inc*/)
-					{
-					if (*iterPrior-- != **iterCurr--)
-						{
-						allMatch = false;
-						break;
-						}
-					}
-
-				if (not allMatch)
-					{
-					for (size_t xx = 0; xx < theCount; ++xx)
-						{
-						const Val_DB* theValPtr = theValPtrs[xx];
-						ioResults[iWalker_Index->fBaseOffset + xx] = *theValPtr;
-						iWalker_Index->fPrior[xx] = *theValPtr;
-						}
-					++iWalker_Index->fCurrent;
-					return true;
-					}
+				for (size_t xx = 0; xx < theCount; ++xx)
+					ioResults[iWalker_Index->fBaseOffset + xx] = *theValPtrs[xx];
+				++iWalker_Index->fCurrent;
+				return true;
 				}
 			}
 		else
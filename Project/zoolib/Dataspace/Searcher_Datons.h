@@ -22,6 +22,8 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define __ZooLib_Dataspace_Searcher_Datons_h__ 1
 #include "zconfig.h"
 
+#include "zoolib/Starter.h"
+
 #include "zoolib/Dataspace/Daton.h"
 #include "zoolib/Dataspace/Searcher.h"
 
@@ -44,6 +46,14 @@ public:
 	enum { kDebug = 1 };
 
 	Searcher_Datons(const std::vector<IndexSpec>& iIndexSpecs);
+
+	// Datons are hash-partitioned across iShardCount shards, each with its own lock, map and
+	// set for each index. Work on the shards and indexes, and on distinct PSearches, is spread
+	// across the calling thread and, when there's enough of it, up to iShardCount - 1 threads
+	// of a pool we keep for our lifetime. Each of our entry points still returns only when its
+	// work is complete.
+	Searcher_Datons(const std::vector<IndexSpec>& iIndexSpecs, size_t iShardCount);
+
 	virtual ~Searcher_Datons();
 
 // From Searcher
@@ -60,8 +70,13 @@ public:
 		const Daton* iRetracted, size_t iRetractedCount);
 
 private:
+	// Guards registrations and PSearches. MakeChanges only takes it once its changes have been
+	// made to the shards, so registrations and CollectResults can proceed meanwhile.
 	ZMtx fMtx;
 
+	// Serializes MakeChanges, and guards the batch state in each Shard.
+	ZMtx fMtx_MakeChanges;
+
 	typedef std::map<Daton,Val_DB> Map_Thing;
 
 	// -----
@@ -69,10 +84,32 @@ private:
 	struct Key;
 	class PSearch;
 
-	void pInvalidateSearchIfAppropriate(PSearch* thePSearch, const Key& iKey);
+	bool pKeyMatches(PSearch* iPSearch, const Key& iKey);
+
+	// -----
+
+	class Shard;
+	class Acq_Shards;
+	struct Rows;
+	struct Task;
 
-	void pIndexInsert(const Map_Thing::value_type* iMapEntryP);
-	void pIndexErase(const Map_Thing::value_type* iMapEntryP);
+	size_t pShardIndex(const Daton& iDaton);
+	void pParallel(size_t iCount, size_t iWork, void (Searcher_Datons::*iMethod)(size_t));
+
+	void pMakeChanges_Map(size_t iShardIndex);
+	void pMakeChanges_Index(size_t iIndexAndShard);
+	void pMakeChanges_Erase(size_t iShardIndex);
+	void pMakeChanges_Collect(size_t iTaskIndex);
+	void pCollectResults_Collect(size_t iTaskIndex);
+	void pMergeTasks(size_t iPSearchIndex);
+
+	// -----
+
+	void pCollectChanges(PSearch* iPSearch, const Map_Thing& iChanged, Rows& ioRows);
+	void pCollectRows(PSearch* iPSearch, ZP<QueryEngine::Walker> iWalker, Rows& ioRows);
+	bool pApplyRows(PSearch* ioPSearch, const Rows& iRows, bool iInserted);
+	bool pInsertRow(PSearch* ioPSearch, const std::vector<Val_DB>& iRow);
+	bool pEraseRow(PSearch* ioPSearch, const std::vector<Val_DB>& iRow);
 
 	// -----
 
@@ -110,7 +147,19 @@ public:
 private:
 	std::vector<Index*> fIndexes;
 
-	Map_Thing fMap_Thing;
+	std::vector<Shard*> fShards;
+	const ZP<Starter> fStarter;
+
+	// The number of batches applied to the shards, guarded by every shard's lock, and the number
+	// whose changes have been applied to PSearches, guarded by fMtx. CollectResults only builds
+	// a PSearch's result when they match, so every result reflects the same batches.
+	uint64 fVersion_Data;
+	uint64 fVersion_Applied;
+
+	// The PSearches being worked on by MakeChanges or CollectResults, each with a Task per
+	// shard. The flag records whether merging its tasks' rows changed the PSearch's result.
+	std::vector<std::pair<PSearch*,bool> > fRound_PSearches;
+	std::vector<Task> fRound_Tasks;
 
 	// -----
 
@@ -32,7 +32,7 @@ void Visitor_Expr_Bool_Do_Eval::Visit_Expr_Bool_False(const ZP<Expr_Bool_False>&
 	{ this->pSetResult(false); }
 
 void Visitor_Expr_Bool_Do_Eval::Visit_Expr_Bool_Not(const ZP<Expr_Bool_Not>& iRep)
-	{ this->pSetResult(not this->Do(iRep)); }
+	{ this->pSetResult(not this->Do(iRep->GetOp0())); }
 
 void Visitor_Expr_Bool_Do_Eval::Visit_Expr_Bool_And(const ZP<Expr_Bool_And>& iRep)
 	{ this->pSetResult(this->Do(iRep->GetOp0()) && this->Do(iRep->GetOp1())); }
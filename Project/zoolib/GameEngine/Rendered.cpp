@@ -29,7 +29,7 @@ void Rendered::Accept_Rendered(Visitor_Rendered& iVisitor)
 
 namespace {
 
-SafePtrStack_WithDestroyer<Rendered_Blush,SafePtrStackLink_Rendered_Blush>
+SafePtrStack_Caching<Rendered_Blush,SafePtrStackLink_Rendered_Blush>
 	spSafePtrStack_Blush;
 
 } // anonymous namespace
@@ -129,7 +129,7 @@ ZP<Rendered_Cel> sRendered_Cel(const Cel& iCel)
 
 namespace {
 
-SafePtrStack_WithDestroyer<Rendered_Gain,SafePtrStackLink_Rendered_Gain>
+SafePtrStack_Caching<Rendered_Gain,SafePtrStackLink_Rendered_Gain>
 	spSafePtrStack_Gain;
 
 } // anonymous namespace
@@ -183,7 +183,7 @@ ZP<Rendered> sRendered_Gain(const Gain& iGain, const ZP<Rendered>& iRendered)
 
 namespace { // anonymous
 
-SafePtrStack_WithDestroyer<Rendered_Group,SafePtrStackLink_Rendered_Group> spSafePtrStack_Group;
+SafePtrStack_Caching<Rendered_Group,SafePtrStackLink_Rendered_Group> spSafePtrStack_Group;
 
 } // anonymous namespace
 
@@ -250,7 +250,7 @@ ZP<Rendered> sRendered_Line(const RGBA& iRGBA, const GPoint& iP0, const GPoint&
 
 namespace {
 
-SafePtrStack_WithDestroyer<Rendered_Mat,SafePtrStackLink_Rendered_Mat>
+SafePtrStack_Caching<Rendered_Mat,SafePtrStackLink_Rendered_Mat>
 	spSafePtrStack_Mat;
 
 } // anonymous namespace
@@ -376,7 +376,7 @@ ZP<Rendered> sRendered_String(const RGBA& iRGBA, const ZP<FontStrike>& iFontStri
 
 namespace {
 
-SafePtrStack_WithDestroyer<Rendered_Texture,SafePtrStackLink_Rendered_Texture>
+SafePtrStack_Caching<Rendered_Texture,SafePtrStackLink_Rendered_Texture>
 	spSafePtrStack_Texture;
 
 } // anonymous namespace
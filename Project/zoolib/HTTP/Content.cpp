@@ -20,6 +20,7 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/HTTP/Content.h"
 
+#include "zoolib/Chan_Bin_ZLib.h"
 #include "zoolib/Chan_XX_Limited.h"
 #include "zoolib/ChanW_Bin_More.h"
 #include "zoolib/Memory.h"
@@ -27,6 +28,8 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/Util_Chan.h"
 #include "zoolib/Util_string.h"
 
+#include <cstdio> // For snprintf
+
 namespace ZooLib {
 namespace HTTP {
 
@@ -80,11 +83,36 @@ static uint64 spReadChunkSize(const ChanR_Bin& iChanR)
 	return result;
 	}
 
+static void spSkipTrailer(const ChanR_Bin& iChanR)
+	{
+	// The last chunk is followed by optional trailer fields and then an empty line. Consume
+	// them all, so a kept-alive connection is left at the start of the next message.
+	for (bool lineIsEmpty = true; /*no test*/; /*no inc*/)
+		{
+		ZQ<byte> theQ = sQRead(iChanR);
+		if (not theQ)
+			return;
+
+		if (*theQ == '\n')
+			{
+			if (lineIsEmpty)
+				return;
+			lineIsEmpty = true;
+			}
+		else if (*theQ != '\r')
+			{
+			lineIsEmpty = false;
+			}
+		}
+	}
+
 ChanR_Bin_Chunked::ChanR_Bin_Chunked(const ChanR_Bin& iChanR)
 :	fChanR(iChanR)
 	{
 	fChunkSize = spReadChunkSize(fChanR);
 	fHitEnd = fChunkSize == 0;
+	if (fHitEnd)
+		spSkipTrailer(fChanR);
 	}
 
 ChanR_Bin_Chunked::~ChanR_Bin_Chunked()
@@ -100,7 +128,11 @@ size_t ChanR_Bin_Chunked::Read(byte* oDest, size_t iCount)
 			// Read and discard the CRLF at the end of the chunk.
 			const uint64 countSkipped = sSkip(fChanR, 2);
 			if (countSkipped == 2)
+				{
 				fChunkSize = spReadChunkSize(fChanR);
+				if (fChunkSize == 0)
+					spSkipTrailer(fChanR);
+				}
 			if (fChunkSize == 0)
 				fHitEnd = true;
 			}
@@ -143,12 +175,9 @@ ChanW_Bin_Chunked::~ChanW_Bin_Chunked()
 		{
 		this->pFlush();
 
-		// Terminating zero-length chunk
-		sEWrite(fChanW, "0\r\n");
-
-		// There's supposed to be an additional CRLF at the end of all the data,
-		// after any trailer entity headers.
-		sEWrite(fChanW, "\r\n");
+		// Terminating zero-length chunk. There's supposed to be an additional CRLF at the
+		// end of all the data, after any trailer entity headers.
+		sEWrite(fChanW, "0\r\n\r\n");
 		}
 	catch (...)
 		{}
@@ -156,32 +185,32 @@ ChanW_Bin_Chunked::~ChanW_Bin_Chunked()
 
 size_t ChanW_Bin_Chunked::Write(const byte* iSource, size_t iCount)
 	{
-	const uint8* localSource = reinterpret_cast<const uint8*>(iSource);
-	while (iCount)
+	const PaC<const byte> theSource(iSource, iCount);
+	return this->WriteV(&theSource, 1);
+	}
+
+size_t ChanW_Bin_Chunked::WriteV(const PaC<const byte>* iSources, size_t iCount)
+	{
+	size_t countTotal = 0;
+	for (size_t xx = 0; xx < iCount; ++xx)
+		countTotal += sCount(iSources[xx]);
+
+	if (fBufferUsed + countTotal >= fBuffer.size())
 		{
-		if (fBufferUsed + iCount >= fBuffer.size())
-			{
-			// The data would overflow the buffer, so we can write the
-			// buffer content (if any) plus this new stuff.
-			sEWritef(fChanW, "%X\r\n", fBufferUsed + iCount);
-			// Hmmm. Do we allow an end of stream exception to propogate?
-			sEWrite(fChanW, &fBuffer[0], fBufferUsed);
-			fBufferUsed = 0;
-			sEWrite(fChanW, localSource, iCount);
-			sEWrite(fChanW, "\r\n");
-			localSource += iCount;
-			iCount = 0;
-			}
-		else
+		// The data would overflow the buffer, so we can write the
+		// buffer content (if any) plus this new stuff.
+		// Hmmm. Do we allow an end of stream exception to propogate?
+		this->pWriteChunk(iSources, iCount);
+		}
+	else
+		{
+		for (size_t xx = 0; xx < iCount; ++xx)
 			{
-			size_t countToCopy = min(iCount, size_t(fBuffer.size() - fBufferUsed));
-			sMemCopy(&fBuffer[0] + fBufferUsed, localSource, countToCopy);
-			fBufferUsed += countToCopy;
-			iCount -= countToCopy;
-			localSource += countToCopy;
+			sMemCopy(&fBuffer[0] + fBufferUsed, sPointer(iSources[xx]), sCount(iSources[xx]));
+			fBufferUsed += sCount(iSources[xx]);
 			}
 		}
-	return localSource - reinterpret_cast<const uint8*>(iSource);
+	return countTotal;
 	}
 
 void ChanW_Bin_Chunked::Flush()
@@ -192,13 +221,35 @@ void ChanW_Bin_Chunked::Flush()
 
 void ChanW_Bin_Chunked::pFlush()
 	{
-	if (const size_t bufferUsed = fBufferUsed)
-		{
-		fBufferUsed = 0;
-		sEWritef(fChanW, "%X\r\n", bufferUsed);
-		sEWrite(fChanW, &fBuffer[0], bufferUsed);
-		sEWrite(fChanW, "\r\n");
-		}
+	if (fBufferUsed)
+		this->pWriteChunk(nullptr, 0);
+	}
+
+void ChanW_Bin_Chunked::pWriteChunk(const PaC<const byte>* iSources, size_t iCount)
+	{
+	// The chunk is the buffer content followed by iSources. Its size line, data and trailing
+	// CRLF are passed on in a single call, so a gathering destination can send it as one.
+	size_t countTotal = fBufferUsed;
+	for (size_t xx = 0; xx < iCount; ++xx)
+		countTotal += sCount(iSources[xx]);
+
+	if (not countTotal)
+		return;
+
+	char theSizeLine[24];
+	const int theSizeLineLength =
+		snprintf(theSizeLine, sizeof(theSizeLine), "%llX\r\n", (unsigned long long)countTotal);
+
+	std::vector<PaC<const byte>> theSources;
+	theSources.reserve(iCount + 3);
+	theSources.push_back(PaC<const byte>((const byte*)theSizeLine, theSizeLineLength));
+	if (fBufferUsed)
+		theSources.push_back(PaC<const byte>(&fBuffer[0], fBufferUsed));
+	theSources.insert(theSources.end(), iSources, iSources + iCount);
+	theSources.push_back(PaC<const byte>((const byte*)"\r\n", 2));
+
+	fBufferUsed = 0;
+	sEWriteV(fChanW, &theSources[0], theSources.size());
 	}
 
 // =================================================================================================
@@ -220,11 +271,33 @@ static ZP<ChannerR_Bin> spMakeChanner_Transfer(
 	return iChannerR;
 	}
 
+#if ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
+static ZP<ChannerR_Bin> spMakeChanner_Content(
+	const Map& iHeader, const ZP<ChannerR_Bin>& iChannerR)
+	{
+	// eFormatR_Auto handles both gzip and the zlib-wrapped data that 'deflate' denotes.
+	const string theEncoding = sGetString0(iHeader.Get("content-encoding"));
+	if (Util_string::sContainsi(theEncoding, "gzip")
+		|| Util_string::sContainsi(theEncoding, "deflate"))
+		{ return sChanner_Channer_T<ChanR_Bin_Inflate>(iChannerR); }
+
+	return iChannerR;
+	}
+
+#else // ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
+static ZP<ChannerR_Bin> spMakeChanner_Content(
+	const Map&, const ZP<ChannerR_Bin>& iChannerR)
+	{ return iChannerR; }
+
+#endif // ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
 ZP<ChannerR_Bin> sMakeContentChanner(const Map& iHeader, ZP<ChannerR_Bin> iChannerR)
 	{
 	iChannerR = spMakeChanner_Transfer(iHeader, iChannerR);
 
-	// We could/should look for gzip Content-Encoding, and wrap a decoding filter around it.
+	iChannerR = spMakeChanner_Content(iHeader, iChannerR);
 
 	return iChannerR;
 	}
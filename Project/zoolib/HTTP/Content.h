@@ -62,10 +62,12 @@ public:
 
 // From ChanW_Bin
 	virtual size_t Write(const byte* iSource, size_t iCount);
+	virtual size_t WriteV(const PaC<const byte>* iSources, size_t iCount);
 	virtual void Flush();
 
 private:
 	void pFlush();
+	void pWriteChunk(const PaC<const byte>* iSources, size_t iCount);
 
 	const ChanW_Bin& fChanW;
 	std::vector<byte> fBuffer;
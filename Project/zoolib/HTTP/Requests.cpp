@@ -21,6 +21,7 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/HTTP/Requests.h"
 
 #include "zoolib/Chan_Bin_Data.h"
+#include "zoolib/Chan_Bin_ZLib.h"
 #include "zoolib/ChanW_Bin_More.h"
 #include "zoolib/Chan_XX_Tee.h"
 #include "zoolib/ChanRU_XX_Unreader.h"
@@ -80,6 +81,35 @@ ZP<ChannerRWClose_Bin> spConnect(ZP<Callable_Connect> iCallable_Connect,
 	return sConnect(iHost, thePortAndSSL.first, thePortAndSSL.second);
 	}
 
+#if ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
+bool spHasField(const Map* iHeader, const string& iName)
+	{
+	if (iHeader)
+		{
+		for (Map::Index_t ii = iHeader->Begin(); ii != iHeader->End(); ++ii)
+			{
+			if (Util_string::sEquali(iHeader->NameOf(ii), iName))
+				return true;
+			}
+		}
+	return false;
+	}
+
+void spWrite_AcceptEncoding(const Map* iHeader, const ChanW_Bin& w)
+	{
+	// sMakeContentChanner will decode whichever of these the server chooses to use.
+	if (not spHasField(iHeader, "accept-encoding"))
+		w << "Accept-Encoding: gzip, deflate\r\n";
+	}
+
+#else // ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
+void spWrite_AcceptEncoding(const Map*, const ChanW_Bin&)
+	{}
+
+#endif // ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
 } // anonymous namespace
 
 // =================================================================================================
@@ -95,6 +125,8 @@ static bool spQRequest(const ChanR_Bin& iChanR, const ChanW_Bin& iChanW,
 	if (iHeader)
 		sWrite_Header(*iHeader, iChanW);
 
+	spWrite_AcceptEncoding(iHeader, iChanW);
+
 	if (iSendConnectionClose)
 		iChanW << "Connection: close\r\n";
 
@@ -242,12 +274,49 @@ static void spPOST_Prefix(const ChanW_Bin& w,
 		w << "Connection: close\r\n";
 	if (iHeader)
 		sWrite_Header(*iHeader, w);
+	spWrite_AcceptEncoding(iHeader, w);
+	}
+
+#if ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
+static bool spQPOST_Body_Deflate(const ChanW_Bin& w,
+	const ChanR_Bin& iBody, ZQ<uint64> iBodyCountQ)
+	{
+	// The compressed length isn't known till we're done, so the body is chunked.
+	w << "Content-Encoding: gzip\r\n";
+	w << "Transfer-Encoding: chunked\r\n";
+	w << "\r\n";
+	ChanW_Bin_Chunked theChanW_Chunked(16 * 1024, w);
+	ChanW_Bin_Deflate theChanW_Deflate(theChanW_Chunked);
+	if (iBodyCountQ)
+		sCopyFully(iBody, theChanW_Deflate, *iBodyCountQ);
+	else
+		sCopyAll(iBody, theChanW_Deflate);
+	theChanW_Deflate.Finish();
+	return true;
 	}
 
+#else // ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
+// Without zlib the body goes out uncompressed.
+static bool spQPOST_Body_Deflate(const ChanW_Bin&, const ChanR_Bin&, ZQ<uint64>)
+	{ return false; }
+
+#endif // ZCONFIG_API_Enabled(Chan_Bin_ZLib)
+
 ZP<ChannerRWClose_Bin> sPOST_Send(ZP<Callable_Connect> iCallable_Connect,
 	const string& iMethod,
 	const string& iURL, const Map* iHeader, const ChanR_Bin& iBody, ZQ<uint64> iBodyCountQ)
 	{
+	return sPOST_Send(iCallable_Connect,
+		iMethod, iURL, iHeader, iBody, iBodyCountQ, false);
+	}
+
+ZP<ChannerRWClose_Bin> sPOST_Send(ZP<Callable_Connect> iCallable_Connect,
+	const string& iMethod,
+	const string& iURL, const Map* iHeader, const ChanR_Bin& iBody, ZQ<uint64> iBodyCountQ,
+	bool iCompressBody)
+	{
 	string theScheme;
 	string theHost;
 	uint16 thePort;
@@ -260,7 +329,9 @@ ZP<ChannerRWClose_Bin> sPOST_Send(ZP<Callable_Connect> iCallable_Connect,
 
 			spPOST_Prefix(theChanW, iMethod, theHost, thePath, iHeader, true);
 
-			if (iBodyCountQ)
+			if (iCompressBody && spQPOST_Body_Deflate(theChanW, iBody, iBodyCountQ))
+				{}
+			else if (iBodyCountQ)
 				{
 				sEWritef(theChanW, "Content-Length: %lld\r\n", *iBodyCountQ);
 				theChanW << "\r\n";
@@ -329,8 +400,18 @@ ZP<ChannerRWClose_Bin> sPOST(ZP<Callable_Connect> iCallable_Connect,
 	const string& iURL, const Map* iHeader, const ChanR_Bin& iBody, ZQ<uint64> iBodyCountQ,
 	int32* oResponseCode, Map* oHeader, Data* oRawHeader)
 	{
+	return sPOST(iCallable_Connect,
+		iURL, iHeader, iBody, iBodyCountQ, false,
+		oResponseCode, oHeader, oRawHeader);
+	}
+
+ZP<ChannerRWClose_Bin> sPOST(ZP<Callable_Connect> iCallable_Connect,
+	const string& iURL, const Map* iHeader, const ChanR_Bin& iBody, ZQ<uint64> iBodyCountQ,
+	bool iCompressBody,
+	int32* oResponseCode, Map* oHeader, Data* oRawHeader)
+	{
 	if (ZP<ChannerRWClose_Bin> theConn = sPOST_Send(iCallable_Connect,
-		"POST", iURL, iHeader, iBody, iBodyCountQ))
+		"POST", iURL, iHeader, iBody, iBodyCountQ, iCompressBody))
 		{
 		return sPOST_Receive(theConn, oResponseCode, oHeader, oRawHeader);
 		}
@@ -41,10 +41,19 @@ bool sQRequest(ZP<ChannerRWClose_Bin>& ioConnection,
 
 // -----
 
+// Requests advertise Accept-Encoding (unless iHeader has its own) when zlib is available, and
+// sMakeContentChanner decodes compressed responses. The iCompressBody variants gzip the body
+// and send it chunked; iBodyCountQ is then the uncompressed length, if known.
+
 ZP<ChannerRWClose_Bin> sPOST_Send(ZP<Callable_Connect> iCallable_Connect,
 	const string& iMethod,
 	const string& iURL, const Map* iHeader, const ChanR_Bin& iBody, ZQ<uint64> iBodyCountQ);
 
+ZP<ChannerRWClose_Bin> sPOST_Send(ZP<Callable_Connect> iCallable_Connect,
+	const string& iMethod,
+	const string& iURL, const Map* iHeader, const ChanR_Bin& iBody, ZQ<uint64> iBodyCountQ,
+	bool iCompressBody);
+
 ZP<ChannerRWClose_Bin> sPOST_Receive(ZP<ChannerRWClose_Bin> iConn,
 	int32* oResponseCode, Map* oHeader, Data* oRawHeader);
 
@@ -52,6 +61,11 @@ ZP<ChannerRWClose_Bin> sPOST(ZP<Callable_Connect> iCallable_Connect,
 	const string& iURL, const Map* iHeader, const ChanR_Bin& iBody, ZQ<uint64> iBodyCountQ,
 	int32* oResponseCode, Map* oHeader, Data* oRawHeader);
 
+ZP<ChannerRWClose_Bin> sPOST(ZP<Callable_Connect> iCallable_Connect,
+	const string& iURL, const Map* iHeader, const ChanR_Bin& iBody, ZQ<uint64> iBodyCountQ,
+	bool iCompressBody,
+	int32* oResponseCode, Map* oHeader, Data* oRawHeader);
+
 // -----
 
 bool sQCONNECT(const ChanR_Bin& r, const ChanW_Bin& w,
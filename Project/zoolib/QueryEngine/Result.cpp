@@ -21,7 +21,12 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/QueryEngine/Result.h"
 
 #include "zoolib/Compare_Ref.h"
+#include "zoolib/Compare_string.h"
 #include "zoolib/Compare_vector.h"
+#include "zoolib/ZMACRO_foreach.h"
+
+#include <algorithm> // For std::sort, std::upper_bound
+#include <functional> // For std::hash
 
 using std::map;
 using std::pair;
@@ -46,39 +51,172 @@ int sCompare_T<ZP<QueryEngine::Result>>(
 
 ZMACRO_CompareRegistration_T(ZP<QueryEngine::Result>)
 
-// =================================================================================================
-#pragma mark - QueryEngine::Result
-
 namespace QueryEngine {
 
 using RelationalAlgebra::RelHead;
 
+// =================================================================================================
+#pragma mark - Hashing (anonymous)
+
+namespace { // anonymous
+
+// Values of different types never compare equal, so the type participates in a value's hash.
+// Common scalar types also contribute their value, the rest are distinguished by type alone.
+// Typed columns must hash their cells exactly as the equivalent Val_DB would be hashed.
+
+const uint64 kHash_Null = 0x9E3779B97F4A7C15ULL;
+
+inline uint64 spHash(const std::type_info& iType, uint64 iValue)
+	{ return uint64(iType.hash_code()) ^ (iValue * 0xFF51AFD7ED558CCDULL); }
+
+inline uint64 spHash(int64 iVal)
+	{ return spHash(typeid(int64), uint64(iVal)); }
+
+inline uint64 spHash(double iVal)
+	{ return spHash(typeid(double), std::hash<double>()(iVal)); }
+
+inline uint64 spHash(const string8& iVal)
+	{ return spHash(typeid(string8), std::hash<string8>()(iVal)); }
+
+uint64 spHash(const Val_DB& iVal)
+	{
+	if (iVal.IsNull())
+		return kHash_Null;
+	else if (const int64* theP = iVal.PGet<int64>())
+		return spHash(*theP);
+	else if (const double* theP = iVal.PGet<double>())
+		return spHash(*theP);
+	else if (const string8* theP = iVal.PGet<string8>())
+		return spHash(*theP);
+	else if (const int32* theP = iVal.PGet<int32>())
+		return spHash(typeid(int32), uint64(*theP));
+	else if (const bool* theP = iVal.PGet<bool>())
+		return spHash(typeid(bool), *theP);
+	return spHash(iVal.Type(), 0);
+	}
+
+inline void spMix(uint64& ioHash, uint64 iHash)
+	{ ioHash = (ioHash ^ iHash) * 0x100000001B3ULL; }
+
+// The low bits of a row hash are used to pick buckets, so give every bit a say in them.
+inline uint64 spFinish(uint64 iHash)
+	{
+	iHash ^= iHash >> 33;
+	iHash *= 0xC4CEB9FE1A85EC53ULL;
+	iHash ^= iHash >> 33;
+	return iHash;
+	}
+
+void spMixColumn(const Result::Column& iColumn, vector<uint64>& ioHashes)
+	{
+	const size_t theCount = ioHashes.size();
+	switch (iColumn.GetType())
+		{
+		case Result::Column::eNull:
+			{
+			for (size_t yy = 0; yy < theCount; ++yy)
+				spMix(ioHashes[yy], kHash_Null);
+			break;
+			}
+		case Result::Column::eVal:
+			{
+			for (size_t yy = 0; yy < theCount; ++yy)
+				spMix(ioHashes[yy], spHash(iColumn.fVals[yy]));
+			break;
+			}
+		case Result::Column::eInt64:
+			{
+			for (size_t yy = 0; yy < theCount; ++yy)
+				{
+				spMix(ioHashes[yy],
+					iColumn.IsNull(yy) ? kHash_Null : spHash(iColumn.fInt64s[yy]));
+				}
+			break;
+			}
+		case Result::Column::eDouble:
+			{
+			for (size_t yy = 0; yy < theCount; ++yy)
+				{
+				spMix(ioHashes[yy],
+					iColumn.IsNull(yy) ? kHash_Null : spHash(iColumn.fDoubles[yy]));
+				}
+			break;
+			}
+		case Result::Column::eString:
+			{
+			for (size_t yy = 0; yy < theCount; ++yy)
+				{
+				spMix(ioHashes[yy],
+					iColumn.IsNull(yy) ? kHash_Null : spHash(iColumn.fStrings[yy]));
+				}
+			break;
+			}
+		}
+	}
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - QueryEngine::Result
+
 Result::Result(const Result& iOther)
 :	fRelHead(iOther.fRelHead)
-,	fPackedRows(iOther.fPackedRows)
-	{}
+,	fColumns(iOther.fColumns)
+,	fCount(iOther.fCount)
+,	fHasPackedRows(false)
+,	fHasRowHashes(false)
+	{
+	if (fColumns.empty())
+		{
+		fPackedRows = iOther.fPackedRows;
+		fHasPackedRows = true;
+		}
+	}
 
 Result::Result(RelHead* ioRelHead,
 	vector<Val_DB>* ioPackedRows)
+:	fCount(0)
+,	fHasPackedRows(true)
+,	fHasRowHashes(false)
 	{
 	ioRelHead->swap(fRelHead);
 	ioPackedRows->swap(fPackedRows);
+	this->pColumnize();
 	}
 
 Result::Result(const RelHead& iRelHead,
 	vector<Val_DB>* ioPackedRows)
 :	fRelHead(iRelHead)
+,	fCount(0)
+,	fHasPackedRows(true)
+,	fHasRowHashes(false)
 	{
 	ioPackedRows->swap(fPackedRows);
+	this->pColumnize();
+	}
+
+Result::Result(const RelHead& iRelHead,
+	vector<Column>* ioColumns)
+:	fRelHead(iRelHead)
+,	fCount(0)
+,	fHasPackedRows(true)
+,	fHasRowHashes(false)
+	{
+	ZAssert(ioColumns->size() == fRelHead.size());
+	ioColumns->swap(fColumns);
+	this->pAdoptColumns();
 	}
 
 Result::Result(const ZP<Result>& iOther, size_t iRow)
 :	fRelHead(iOther->GetRelHead())
+,	fCount(0)
+,	fHasPackedRows(true)
+,	fHasRowHashes(false)
 	{
 	if (iRow < iOther->Count())
 		{
-		const Val_DB* theVals = iOther->GetValsAt(iRow);
-		fPackedRows.insert(fPackedRows.end(), theVals, theVals + fRelHead.size());
+		for (size_t xx = 0; xx < fRelHead.size(); ++xx)
+			fPackedRows.push_back(iOther->GetVal(iRow, xx));
 		}
 	}
 
@@ -89,24 +227,104 @@ const RelHead& Result::GetRelHead()
 	{ return fRelHead; }
 
 size_t Result::Count()
-	{
-	if (const size_t theSize = fRelHead.size())
-		return fPackedRows.size() / theSize;
-	return 0;
-	}
+	{ return this->pCount(); }
 
 const Val_DB* Result::GetValsAt(size_t iIndex)
 	{
+	this->pEnsurePackedRows();
 	const size_t theOffset = fRelHead.size() * iIndex;
 	ZAssert(theOffset < fPackedRows.size() + fRelHead.size());
 	return &fPackedRows[theOffset];
 	}
 
+Val_DB Result::GetVal(size_t iRow, size_t iCol) const
+	{
+	if (fColumns.size())
+		return fColumns[iCol].Get(iRow);
+	return fPackedRows[iRow * fRelHead.size() + iCol];
+	}
+
+const Result::Column* Result::GetColumn(size_t iCol) const
+	{
+	if (fColumns.size())
+		return &fColumns[iCol];
+	return nullptr;
+	}
+
+int Result::CompareAt(size_t iRow, size_t iCol, const Result& iOther, size_t iRow_Other) const
+	{
+	if (fColumns.size())
+		{
+		if (iOther.fColumns.size())
+			return fColumns[iCol].Compare(iRow, iOther.fColumns[iCol], iRow_Other);
+		return sCompare_T(fColumns[iCol].Get(iRow),
+			iOther.fPackedRows[iRow_Other * iOther.fRelHead.size() + iCol]);
+		}
+	else if (iOther.fColumns.size())
+		{
+		return sCompare_T(fPackedRows[iRow * fRelHead.size() + iCol],
+			iOther.fColumns[iCol].Get(iRow_Other));
+		}
+	return sCompare_T(fPackedRows[iRow * fRelHead.size() + iCol],
+		iOther.fPackedRows[iRow_Other * iOther.fRelHead.size() + iCol]);
+	}
+
 int Result::Compare(const Result& iOther) const
 	{
 	if (int compare = sCompare_T(fRelHead, iOther.fRelHead))
 		return compare;
-	return sCompare_T(fPackedRows, iOther.fPackedRows);
+
+	// Equivalent to comparing the packed rows, however each of us is holding its values.
+	const size_t theCount = this->pCount();
+	const size_t theCount_Other = iOther.pCount();
+	const size_t theColCount = fRelHead.size();
+	for (size_t yy = 0; yy < theCount && yy < theCount_Other; ++yy)
+		{
+		for (size_t xx = 0; xx < theColCount; ++xx)
+			{
+			if (int compare = this->CompareAt(yy, xx, iOther, yy))
+				return compare;
+			}
+		}
+
+	if (theCount < theCount_Other)
+		return -1;
+	else if (theCount > theCount_Other)
+		return 1;
+	return 0;
+	}
+
+const vector<uint64>& Result::GetRowHashes() const
+	{
+	if (fHasRowHashes)
+		return fRowHashes;
+
+	ZAcqMtx acq(fMtx);
+	if (not fHasRowHashes)
+		{
+		const size_t theCount = this->pCount();
+		fRowHashes.assign(theCount, 0);
+		if (fColumns.size())
+			{
+			foreacha (theColumn, fColumns)
+				spMixColumn(theColumn, fRowHashes);
+			}
+		else
+			{
+			const size_t theColCount = fRelHead.size();
+			for (size_t yy = 0; yy < theCount; ++yy)
+				{
+				for (size_t xx = 0; xx < theColCount; ++xx)
+					spMix(fRowHashes[yy], spHash(fPackedRows[yy * theColCount + xx]));
+				}
+			}
+
+		foreacha (theHash, fRowHashes)
+			theHash = spFinish(theHash);
+
+		fHasRowHashes = true;
+		}
+	return fRowHashes;
 	}
 
 ZP<Result> Result::Fresh()
@@ -116,6 +334,252 @@ ZP<Result> Result::Fresh()
 	return this;
 	}
 
+vector<Val_DB>& Result::MutPackedRows()
+	{
+	this->pEnsurePackedRows();
+	vector<Column>().swap(fColumns);
+	fHasRowHashes = false;
+	vector<uint64>().swap(fRowHashes);
+	return fPackedRows;
+	}
+
+size_t Result::pCount() const
+	{
+	if (fColumns.size())
+		return fCount;
+	if (const size_t theSize = fRelHead.size())
+		return fPackedRows.size() / theSize;
+	return 0;
+	}
+
+void Result::pColumnize()
+	{
+	const size_t theColCount = fRelHead.size();
+	if (not theColCount || fPackedRows.empty())
+		return;
+
+	const size_t theCount = fPackedRows.size() / theColCount;
+
+	vector<Column> theColumns(theColCount);
+	bool anyTyped = false;
+	for (size_t xx = 0; xx < theColCount; ++xx)
+		{
+		Column& theColumn = theColumns[xx];
+		for (size_t yy = 0; yy < theCount; ++yy)
+			theColumn.Append(fPackedRows[yy * theColCount + xx]);
+		anyTyped |= theColumn.IsTyped();
+		}
+
+	if (not anyTyped)
+		return;
+
+	fColumns.swap(theColumns);
+	fCount = theCount;
+	vector<Val_DB>().swap(fPackedRows);
+	fHasPackedRows = false;
+	}
+
+void Result::pAdoptColumns()
+	{
+	if (fColumns.empty())
+		return;
+
+	fCount = fColumns[0].Count();
+
+	foreacha (theColumn, fColumns)
+		{
+		ZAssert(theColumn.Count() == fCount);
+		if (theColumn.IsTyped())
+			{
+			fHasPackedRows = false;
+			return;
+			}
+		}
+
+	// Nothing gains from being held as columns.
+	fHasPackedRows = false;
+	this->pEnsurePackedRows();
+	vector<Column>().swap(fColumns);
+	}
+
+void Result::pEnsurePackedRows() const
+	{
+	if (fHasPackedRows)
+		return;
+
+	ZAcqMtx acq(fMtx);
+	if (fHasPackedRows)
+		return;
+
+	const size_t theColCount = fColumns.size();
+	fPackedRows.reserve(fCount * theColCount);
+	for (size_t yy = 0; yy < fCount; ++yy)
+		{
+		for (size_t xx = 0; xx < theColCount; ++xx)
+			fPackedRows.push_back(fColumns[xx].Get(yy));
+		}
+
+	fHasPackedRows = true;
+	}
+
+// =================================================================================================
+#pragma mark - Result::Column
+
+Result::Column::Column()
+:	fType(eNull)
+,	fCount(0)
+	{}
+
+Val_DB Result::Column::Get(size_t iRow) const
+	{
+	switch (fType)
+		{
+		case eNull:
+			break;
+		case eVal:
+			return fVals[iRow];
+		case eInt64:
+			if (not this->IsNull(iRow))
+				return fInt64s[iRow];
+			break;
+		case eDouble:
+			if (not this->IsNull(iRow))
+				return fDoubles[iRow];
+			break;
+		case eString:
+			if (not this->IsNull(iRow))
+				return fStrings[iRow];
+			break;
+		}
+	return Val_DB();
+	}
+
+int Result::Column::Compare(size_t iRow, const Column& iOther, size_t iRow_Other) const
+	{
+	if (fType == iOther.fType)
+		{
+		if (fType == eVal)
+			return sCompare_T(fVals[iRow], iOther.fVals[iRow_Other]);
+
+		// Nulls are rare, and are ordered relative to non-nulls by the general mechanism.
+		if (not this->IsNull(iRow) && not iOther.IsNull(iRow_Other))
+			{
+			switch (fType)
+				{
+				case eInt64:
+					{
+					const int64 theL = fInt64s[iRow];
+					const int64 theR = iOther.fInt64s[iRow_Other];
+					return theL < theR ? -1 : theR < theL ? 1 : 0;
+					}
+				case eDouble:
+					return sCompare_T(fDoubles[iRow], iOther.fDoubles[iRow_Other]);
+				case eString:
+					return sCompare_T(fStrings[iRow], iOther.fStrings[iRow_Other]);
+				default:
+					break;
+				}
+			}
+		}
+	return sCompare_T(this->Get(iRow), iOther.Get(iRow_Other));
+	}
+
+void Result::Column::Append(const Val_DB& iVal)
+	{
+	const bool isNull = iVal.IsNull();
+
+	if (fType == eNull)
+		{
+		if (not isNull)
+			{
+			if (iVal.PGet<int64>())
+				fType = eInt64;
+			else if (iVal.PGet<double>())
+				fType = eDouble;
+			else if (iVal.PGet<string8>())
+				fType = eString;
+			else
+				fType = eVal;
+
+			// Fill in the nulls we've seen so far.
+			switch (fType)
+				{
+				case eInt64: fInt64s.resize(fCount); break;
+				case eDouble: fDoubles.resize(fCount); break;
+				case eString: fStrings.resize(fCount); break;
+				case eVal: fVals.resize(fCount); break;
+				default: break;
+				}
+
+			if (fCount && fType != eVal)
+				fNulls.resize(fCount, true);
+			}
+		}
+	else if (fType != eVal)
+		{
+		if (not isNull
+			&& (fType == eInt64 ? not iVal.PGet<int64>()
+			: fType == eDouble ? not iVal.PGet<double>()
+			: not iVal.PGet<string8>()))
+			{
+			this->pBecomeVal();
+			}
+		}
+
+	switch (fType)
+		{
+		case eNull:
+			break;
+		case eVal:
+			fVals.push_back(iVal);
+			break;
+		default:
+			this->pAppendTyped(iVal, isNull);
+			break;
+		}
+
+	++fCount;
+	}
+
+void Result::Column::pAppendTyped(const Val_DB& iVal, bool iIsNull)
+	{
+	if (iIsNull && fNulls.empty())
+		fNulls.resize(fCount, false);
+
+	if (fNulls.size())
+		fNulls.push_back(iIsNull);
+
+	switch (fType)
+		{
+		case eInt64:
+			fInt64s.push_back(iIsNull ? 0 : *iVal.PGet<int64>());
+			break;
+		case eDouble:
+			fDoubles.push_back(iIsNull ? 0.0 : *iVal.PGet<double>());
+			break;
+		case eString:
+			fStrings.push_back(iIsNull ? string8() : *iVal.PGet<string8>());
+			break;
+		default:
+			break;
+		}
+	}
+
+void Result::Column::pBecomeVal()
+	{
+	vector<Val_DB> theVals;
+	theVals.reserve(fCount + 1);
+	for (size_t xx = 0; xx < fCount; ++xx)
+		theVals.push_back(this->Get(xx));
+
+	fType = eVal;
+	fVals.swap(theVals);
+	vector<bool>().swap(fNulls);
+	vector<int64>().swap(fInt64s);
+	vector<double>().swap(fDoubles);
+	vector<string8>().swap(fStrings);
+	}
+
 // =================================================================================================
 #pragma mark - ResultDeltas
 
@@ -130,14 +594,17 @@ ResultDeltas::~ResultDeltas()
 
 namespace { // anonymous
 
+const size_t kNone = size_t(-1);
+
 pair<int,size_t> spCompare(const vector<size_t>& iOffsets,
-	const Val_DB* iVals_Left, const Val_DB* iVals_Right)
+	const Result& iResult_Left, size_t iRow_Left,
+	const Result& iResult_Right, size_t iRow_Right)
 	{
 	const size_t offsetsCount = iOffsets.size();
 	for (size_t yy = 0; yy < offsetsCount; ++yy)
 		{
 		const size_t theCol = iOffsets[yy];
-		if (int compare = sCompare_T(iVals_Left[theCol], iVals_Right[theCol]))
+		if (int compare = iResult_Left.CompareAt(iRow_Left, theCol, iResult_Right, iRow_Right))
 			return pair<int,size_t>(compare, yy);
 		}
 	return pair<int,size_t>(0, offsetsCount);
@@ -152,9 +619,7 @@ struct Comparer_t
 
 	bool operator()(const size_t& iLeft, const size_t& iRight) const
 		{
-		return 0 > spCompare(fOffsets,
-			fResult->GetValsAt(iLeft),
-			fResult->GetValsAt(iRight)).first;
+		return 0 > spCompare(fOffsets, *fResult, iLeft, *fResult, iRight).first;
 		}
 
 	const vector<size_t>& fOffsets;
@@ -212,7 +677,7 @@ void ResultDiffer::Apply(const ZP<Result>& iResult,
 
 			std::copy_n(&iResultDeltas->fPackedRows[xx * theColCount],
 				theColCount,
-				&fResult_Prior->fPackedRows[target * theColCount]);
+				&fResult_Prior->MutPackedRows()[target * theColCount]);
 
 			oChanged->push_back(
 				Multi3<size_t,size_t,size_t>(
@@ -283,15 +748,16 @@ void ResultDiffer::Apply(const ZP<Result>& iResult,
 	const size_t theCount = iResult->Count();
 
 	vector<size_t> theSort_New;
-	theSort_New.reserve(theCount);
-	for (size_t xx = 0; xx < theCount; ++xx)
-		theSort_New.push_back(xx);
-
-	sort(theSort_New.begin(), theSort_New.end(), Comparer_t(fPermute, iResult));
 
 	if (not fResult_Prior)
 		{
-		// This is our first result, everything is an add.
+		// This is our first result, so sort it in its entirety, and everything is an add.
+		theSort_New.reserve(theCount);
+		for (size_t xx = 0; xx < theCount; ++xx)
+			theSort_New.push_back(xx);
+
+		sort(theSort_New.begin(), theSort_New.end(), Comparer_t(fPermute, iResult));
+
 		if (oAdded)
 			{
 			for (size_t yy = 0; yy < theSort_New.size(); ++yy)
@@ -301,94 +767,252 @@ void ResultDiffer::Apply(const ZP<Result>& iResult,
 	else
 		{
 		// We have a prior result, do the diff.
+		this->pDiff(iResult, theSort_New, oRemoved, oAdded, oChanged);
+		}
 
-		size_t theIndex_Prior = 0;
-		const size_t theCount_Prior = fSort_Prior.size();
+	if (oPriorResult)
+		*oPriorResult = fResult_Prior;
 
-		size_t theIndex_New = 0;
-		const size_t theCount_New = theSort_New.size();
+	fResult_Prior = iResult;
+
+	swap(fSort_Prior, theSort_New);
+	}
+
+// Rather than sorting iResult and merging it against the prior sort, we first pair every new
+// row with an identical prior row, finding candidates by their row hashes. Paired rows keep
+// their prior order, and in the usual case of a small change that's almost everything. The
+// remainder of the new rows are sorted and placed among the survivors by binary search, and
+// the remainders of the two lists are then merged as before to find removes, adds and changes.
 
-		for (;;)
+void ResultDiffer::pDiff(const ZP<Result>& iResult,
+	vector<size_t>& oSort_New,
+	vector<size_t>* oRemoved,
+	vector<pair<size_t,size_t>>* oAdded,
+	vector<Multi3<size_t,size_t,size_t>>* oChanged)
+	{
+	const size_t theCount_New = iResult->Count();
+	const size_t theCount_Prior = fSort_Prior.size();
+
+	const vector<uint64>& theHashes_New = iResult->GetRowHashes();
+	const vector<uint64>& theHashes_Prior = fResult_Prior->GetRowHashes();
+
+	// Index the prior rows by hash, open addressed. A slot holds a row hash and one plus the
+	// position in fSort_Prior of that row, or zero if the slot's empty.
+	size_t theSlotCount = 1;
+	while (theSlotCount < theCount_Prior * 2)
+		theSlotCount <<= 1;
+	const size_t theMask = theSlotCount - 1;
+
+	vector<pair<uint64,size_t>> theSlots(theSlotCount, pair<uint64,size_t>(0, 0));
+	for (size_t pp = 0; pp < theCount_Prior; ++pp)
+		{
+		const uint64 theHash = theHashes_Prior[fSort_Prior[pp]];
+		size_t theSlot = theHash & theMask;
+		while (theSlots[theSlot].second)
+			theSlot = (theSlot + 1) & theMask;
+		theSlots[theSlot] = pair<uint64,size_t>(theHash, pp + 1);
+		}
+
+	// For each prior position, the new row that's identical to it.
+	vector<size_t> theMatches(theCount_Prior, kNone);
+
+	vector<size_t> theUnmatched_New;
+	for (size_t xx = 0; xx < theCount_New; ++xx)
+		{
+		const uint64 theHash = theHashes_New[xx];
+		bool matched = false;
+		for (size_t theSlot = theHash & theMask;
+			theSlots[theSlot].second;
+			theSlot = (theSlot + 1) & theMask)
 			{
-			if (theIndex_New >= theCount_New)
-				{
-				// Anything remaining in prior when new is exhausted is a removal.
-				if (oRemoved)
-					{
-					oRemoved->reserve(oRemoved->size() + theCount_Prior - theIndex_Prior);
-					while (theCount_Prior > theIndex_Prior)
-						oRemoved->push_back(theIndex_Prior++);
-					}
-				break;
-				}
+			if (theSlots[theSlot].first != theHash)
+				continue;
+
+			const size_t pp = theSlots[theSlot].second - 1;
+			if (theMatches[pp] != kNone)
+				continue;
 
-			if (theIndex_Prior >= theCount_Prior)
+			const size_t theRow_Prior = fSort_Prior[pp];
+			if (0 == spCompare(fPermute, *fResult_Prior, theRow_Prior, *iResult, xx).first)
 				{
-				// Anything remaining in new when prior is exhausted is an addition.
-				if (oAdded)
-					{
-					oAdded->reserve(oAdded->size() + theCount_New - theIndex_New);
-					while (theCount_New > theIndex_New)
-						{
-						oAdded->push_back(pair<size_t,size_t>(theIndex_New, theSort_New[theIndex_New]));
-						++theIndex_New;
-						}
-					}
+				theMatches[pp] = xx;
+				matched = true;
 				break;
 				}
+			}
 
-			// Match current prior against current new
-			const pair<int,size_t> result = spCompare(fPermute,
-				fResult_Prior->GetValsAt(fSort_Prior[theIndex_Prior]),
-				iResult->GetValsAt(theSort_New[theIndex_New]));
+		if (not matched)
+			theUnmatched_New.push_back(xx);
+		}
 
-			if (result.second < fIdentity.size())
+	// The survivors are new rows, in prior order.
+	vector<size_t> theSurvivors;
+	vector<size_t> theSurvivors_Prior;
+	vector<size_t> theUnmatched_Prior;
+	theSurvivors.reserve(theCount_New - theUnmatched_New.size());
+	theSurvivors_Prior.reserve(theSurvivors.capacity());
+	for (size_t pp = 0; pp < theCount_Prior; ++pp)
+		{
+		if (theMatches[pp] == kNone)
+			{
+			theUnmatched_Prior.push_back(pp);
+			}
+		else
+			{
+			theSurvivors.push_back(theMatches[pp]);
+			theSurvivors_Prior.push_back(pp);
+			}
+		}
+
+	// Sort the unmatched new rows, and interleave them with the survivors.
+	const Comparer_t theComparer(fPermute, iResult);
+	sort(theUnmatched_New.begin(), theUnmatched_New.end(), theComparer);
+
+	vector<size_t> theUnmatched_New_Positions;
+	theUnmatched_New_Positions.reserve(theUnmatched_New.size());
+
+	oSort_New.reserve(theCount_New);
+	vector<size_t>::const_iterator iterSurvivors = theSurvivors.begin();
+	foreacha (theRow, theUnmatched_New)
+		{
+		vector<size_t>::const_iterator iterNext =
+			std::upper_bound(iterSurvivors, theSurvivors.cend(), theRow, theComparer);
+		oSort_New.insert(oSort_New.end(), iterSurvivors, iterNext);
+		iterSurvivors = iterNext;
+		theUnmatched_New_Positions.push_back(oSort_New.size());
+		oSort_New.push_back(theRow);
+		}
+	oSort_New.insert(oSort_New.end(), iterSurvivors, theSurvivors.cend());
+
+	// Merge the unmatched rows of prior and new. These are both in sorted order, and
+	// are the only ones that can be removes, adds, or changes other than dummies.
+	vector<Multi3<size_t,size_t,size_t>> theChanged;
+
+	size_t theIndex_Prior = 0;
+	const size_t theCount_Unmatched_Prior = theUnmatched_Prior.size();
+
+	size_t theIndex_New = 0;
+	const size_t theCount_Unmatched_New = theUnmatched_New.size();
+
+	for (;;)
+		{
+		if (theIndex_New >= theCount_Unmatched_New)
+			{
+			// Anything remaining in prior when new is exhausted is a removal.
+			if (oRemoved)
 				{
-				// Comparison was terminated in the 'identity' portion of the values,
-				// and so the values can't be equal.
-				ZAssert(result.first != 0);
+				while (theCount_Unmatched_Prior > theIndex_Prior)
+					oRemoved->push_back(theUnmatched_Prior[theIndex_Prior++]);
+				}
+			break;
+			}
 
-				if (result.first < 0)
-					{
-					// Prior is less than new, so prior is not in new, and this is a removal.
-					if (oRemoved)
-						oRemoved->push_back(theIndex_Prior);
-					++theIndex_Prior;
-					}
-				else
+		if (theIndex_Prior >= theCount_Unmatched_Prior)
+			{
+			// Anything remaining in new when prior is exhausted is an addition.
+			if (oAdded)
+				{
+				while (theCount_Unmatched_New > theIndex_New)
 					{
-					// Contrariwise.
-					if (oAdded)
-						oAdded->push_back(pair<size_t,size_t>(theIndex_New, theSort_New[theIndex_New]));
+					oAdded->push_back(pair<size_t,size_t>(
+						theUnmatched_New_Positions[theIndex_New], theUnmatched_New[theIndex_New]));
 					++theIndex_New;
 					}
 				}
+			break;
+			}
+
+		const size_t thePosition_Prior = theUnmatched_Prior[theIndex_Prior];
+		const size_t theRow_Prior = fSort_Prior[thePosition_Prior];
+
+		const size_t thePosition_New = theUnmatched_New_Positions[theIndex_New];
+		const size_t theRow_New = theUnmatched_New[theIndex_New];
+
+		// Match current prior against current new
+		const pair<int,size_t> result = spCompare(fPermute,
+			*fResult_Prior, theRow_Prior,
+			*iResult, theRow_New);
+
+		if (result.second < fIdentity.size())
+			{
+			// Comparison was terminated in the 'identity' portion of the values,
+			// and so the values can't be equal.
+			ZAssert(result.first != 0);
+
+			if (result.first < 0)
+				{
+				// Prior is less than new, so prior is not in new, and this is a removal.
+				if (oRemoved)
+					oRemoved->push_back(thePosition_Prior);
+				++theIndex_Prior;
+				}
 			else
 				{
-				if (oChanged
-					&& (fEmitDummyChanges
-						|| (result.second < fIdentity.size() + fSignificant.size())))
-					{
-					// We care about changes, and comparison was terminated in the 'significant'
-					// portion of the values. So they matched in the identity portion, and thus
-					// reference the same entity, but differ in the significant portion, thus
-					// this is a change.
-					oChanged->push_back(
-						Multi3<size_t,size_t,size_t>(
-							theIndex_New, fSort_Prior[theIndex_Prior], theSort_New[theIndex_New]));
-					}
+				// Contrariwise.
+				if (oAdded)
+					oAdded->push_back(pair<size_t,size_t>(thePosition_New, theRow_New));
 				++theIndex_New;
-				++theIndex_Prior;
 				}
 			}
+		else if (thePosition_Prior - theIndex_Prior != thePosition_New - theIndex_New)
+			{
+			// The same entity, but it's moved past one or more survivors (which can only happen
+			// when identities aren't unique), so it can't be a change in place.
+			if (oRemoved)
+				oRemoved->push_back(thePosition_Prior);
+			if (oAdded)
+				oAdded->push_back(pair<size_t,size_t>(thePosition_New, theRow_New));
+			++theIndex_New;
+			++theIndex_Prior;
+			}
+		else
+			{
+			if (oChanged
+				&& (fEmitDummyChanges
+					|| (result.second < fIdentity.size() + fSignificant.size())))
+				{
+				// We care about changes, and comparison was terminated in the 'significant'
+				// portion of the values. So they matched in the identity portion, and thus
+				// reference the same entity, but differ in the significant portion, thus
+				// this is a change.
+				theChanged.push_back(
+					Multi3<size_t,size_t,size_t>(thePosition_New, theRow_Prior, theRow_New));
+				}
+			++theIndex_New;
+			++theIndex_Prior;
+			}
 		}
 
-	if (oPriorResult)
-		*oPriorResult = fResult_Prior;
+	if (not oChanged)
+		return;
 
-	fResult_Prior = iResult;
+	if (not fEmitDummyChanges)
+		{
+		oChanged->insert(oChanged->end(), theChanged.begin(), theChanged.end());
+		return;
+		}
 
-	swap(fSort_Prior, theSort_New);
+	// Every survivor is a dummy change, and they're interleaved with the real ones.
+	oChanged->reserve(oChanged->size() + theSurvivors.size() + theChanged.size());
+	size_t theIndex_Changed = 0;
+	size_t theIndex_Survivor = 0;
+	theIndex_New = 0;
+	for (size_t yy = 0; yy < oSort_New.size(); ++yy)
+		{
+		if (theIndex_New < theCount_Unmatched_New
+			&& theUnmatched_New_Positions[theIndex_New] == yy)
+			{
+			++theIndex_New;
+			if (theIndex_Changed < theChanged.size() && theChanged[theIndex_Changed].f0 == yy)
+				oChanged->push_back(theChanged[theIndex_Changed++]);
+			}
+		else
+			{
+			oChanged->push_back(Multi3<size_t,size_t,size_t>(
+				yy, fSort_Prior[theSurvivors_Prior[theIndex_Survivor]], oSort_New[yy]));
+			++theIndex_Survivor;
+			}
+		}
 	}
 
 // =================================================================================================
@@ -26,9 +26,11 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/Counted.h"
 #include "zoolib/Multi.h"
 #include "zoolib/Val_DB.h"
+#include "zoolib/ZThread.h"
 
 #include "zoolib/RelationalAlgebra/RelHead.h"
 
+#include <atomic>
 #include <map>
 #include <set>
 #include <vector>
@@ -39,17 +41,27 @@ namespace QueryEngine {
 // =================================================================================================
 #pragma mark - Result
 
+// Values are handed to us as packed rows, or as Columns. Where a column's values are all
+// int64, double or string8 (or null) we hold them in a typed array, and when any column is
+// typed every column is held separately, with the rest in arrays of Val_DB. Rows are then
+// only reconstituted should someone ask for them with GetValsAt.
+
 class Result : public Counted
 	{
 	Result(const Result& iOther);
 
 public:
+	class Column;
+
 	Result(RelationalAlgebra::RelHead* ioRelHead,
 		std::vector<Val_DB>* ioPackedRows);
 
 	Result(const RelationalAlgebra::RelHead& iRelHead,
 		std::vector<Val_DB>* ioPackedRows);
 
+	Result(const RelationalAlgebra::RelHead& iRelHead,
+		std::vector<Column>* ioColumns);
+
 	Result(const ZP<Result>& iOther, size_t iRow);
 
 	virtual ~Result();
@@ -59,13 +71,89 @@ public:
 	size_t Count();
 	const Val_DB* GetValsAt(size_t iIndex);
 
+	Val_DB GetVal(size_t iRow, size_t iCol) const;
+
+	// Null if we're holding packed rows.
+	const Column* GetColumn(size_t iCol) const;
+
+	int CompareAt(size_t iRow, size_t iCol, const Result& iOther, size_t iRow_Other) const;
+
 	int Compare(const Result& iOther) const;
 
+	// A fingerprint of each row, computed the first time it's asked for. Rows that compare
+	// equal have equal fingerprints, the converse is very likely but must be checked.
+	const std::vector<uint64>& GetRowHashes() const;
+
 	ZP<Result> Fresh();
 
-public:
+	// For in-place editing. Any typed columns and row hashes are discarded.
+	std::vector<Val_DB>& MutPackedRows();
+
+private:
+	size_t pCount() const;
+	void pColumnize();
+	void pAdoptColumns();
+	void pEnsurePackedRows() const;
+
 	RelationalAlgebra::RelHead fRelHead;
-	std::vector<Val_DB> fPackedRows;
+	std::vector<Column> fColumns;
+	size_t fCount;
+
+	// When we have columns, fPackedRows is built on demand.
+	mutable ZMtx fMtx;
+	mutable std::atomic<bool> fHasPackedRows;
+	mutable std::vector<Val_DB> fPackedRows;
+
+	mutable std::atomic<bool> fHasRowHashes;
+	mutable std::vector<uint64> fRowHashes;
+	};
+
+// =================================================================================================
+#pragma mark - Result::Column
+
+class Result::Column
+	{
+public:
+	// eNull is a column in which every value so far has been null.
+	enum EType { eNull, eVal, eInt64, eDouble, eString };
+
+	Column();
+
+	EType GetType() const
+		{ return fType; }
+
+	size_t Count() const
+		{ return fCount; }
+
+	bool IsNull(size_t iRow) const
+		{ return fType == eNull || (fNulls.size() && fNulls[iRow]); }
+
+	Val_DB Get(size_t iRow) const;
+
+	int Compare(size_t iRow, const Column& iOther, size_t iRow_Other) const;
+
+	// Appends iVal, retaining our type if it can, otherwise we fall back to eVal.
+	void Append(const Val_DB& iVal);
+
+	bool IsTyped() const
+		{ return fType == eInt64 || fType == eDouble || fType == eString; }
+
+private:
+	void pAppendTyped(const Val_DB& iVal, bool iIsNull);
+	void pBecomeVal();
+
+public:
+	EType fType;
+	size_t fCount;
+
+	// Empty if nothing is null, and only meaningful for typed columns.
+	std::vector<bool> fNulls;
+
+	// Only the vector corresponding to fType is populated.
+	std::vector<int64> fInt64s;
+	std::vector<double> fDoubles;
+	std::vector<string8> fStrings;
+	std::vector<Val_DB> fVals;
 	};
 
 // =================================================================================================
@@ -102,6 +190,12 @@ public:
 		std::vector<Multi3<size_t,size_t,size_t>>* oChanged);
 
 private:
+	void pDiff(const ZP<Result>& iResult,
+		std::vector<size_t>& oSort_New,
+		std::vector<size_t>* oRemoved,
+		std::vector<std::pair<size_t,size_t>>* oAdded,
+		std::vector<Multi3<size_t,size_t,size_t>>* oChanged);
+
 	const RelationalAlgebra::RelHead fIdentity;
 	const RelationalAlgebra::RelHead fSignificant;
 	const bool fEmitDummyChanges;
@@ -24,6 +24,8 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/ZMACRO_foreach.h"
 
+#include <algorithm> // For std::max
+
 namespace ZooLib {
 namespace QueryEngine {
 
@@ -41,22 +43,36 @@ ZP<Result> sResultFromWalker(ZP<Walker> iWalker)
 	size_t baseOffset = 0;
 	iWalker = iWalker->Prime(sDefault(), offsets, baseOffset);
 
-	vector<Val_DB> thePackedRows;
-	vector<Val_DB> theRow(baseOffset);
+	vector<size_t> theOffsets;
+	foreacha (entry, offsets)
+		theOffsets.push_back(entry.second);
+
+	// Read blocks of rows at a time, so walkers that support it can handle a block per call.
+	const size_t kBatchRows = 256;
+	vector<Val_DB> theRows(std::max<size_t>(1, baseOffset * kBatchRows));
+
+	// Build the columns directly, rather than packing rows that Result would then take apart.
+	vector<Result::Column> theColumns(theOffsets.size());
 	for (;;)
 		{
-		if (not iWalker->QReadInc(&theRow[0]))
-			break;
+		const size_t theCount = iWalker->QReadBatch(&theRows[0], baseOffset, kBatchRows);
+		for (size_t xx = 0; xx < theOffsets.size(); ++xx)
+			{
+			Result::Column& theColumn = theColumns[xx];
+			const Val_DB* theCells = &theRows[theOffsets[xx]];
+			for (size_t yy = 0; yy < theCount; ++yy)
+				theColumn.Append(theCells[yy * baseOffset]);
+			}
 
-		foreacha (entry, offsets)
-			thePackedRows.push_back(theRow[entry.second]);
+		if (theCount < kBatchRows)
+			break;
 		}
 
 	RelHead theRelHead;
 	foreacha (entry, offsets)
 		theRelHead.insert(entry.first);
 
-	return new Result(&theRelHead, &thePackedRows);
+	return new Result(theRelHead, &theColumns);
 	}
 
 } // namespace QueryEngine
@@ -51,15 +51,15 @@ void sToStrim(const ZP<Result>& iResult, const ChanW_UTF& w)
 	for (size_t yy = 0; yy < theCount; ++yy)
 		{
 		w << "\n";
-		const Val_DB* theRow = iResult->GetValsAt(yy);
 		for (size_t xx = 0; xx < theRH.size(); ++xx)
 			{
 			if (xx)
 				w << ", ";
-			if (theRow[xx].PGet<DataspaceTypes::AbsentOptional_t>())
+			const Val_DB theVal = iResult->GetVal(yy, xx);
+			if (theVal.PGet<DataspaceTypes::AbsentOptional_t>())
 				w << "!absent!";
 			else
-				Util_ZZ_JSON::sWrite(theRow[xx].As<Val_ZZ>(), false, w);
+				Util_ZZ_JSON::sWrite(theVal.As<Val_ZZ>(), false, w);
 			}
 		}
 	}
@@ -7,6 +7,8 @@
 
 #include "zoolib/QueryEngine/Walker_Comment.h"
 #include "zoolib/QueryEngine/Walker_Embed.h"
+#include "zoolib/QueryEngine/Walker_HashJoin.h"
+#include "zoolib/QueryEngine/Walker_MergeJoin.h"
 #include "zoolib/QueryEngine/Walker_Product.h"
 #include "zoolib/QueryEngine/Walker_Union.h"
 
@@ -36,7 +38,9 @@ public:
 		for (size_t xx = 0; xx < fIndent; ++xx)
 			fW << "\t";
 
-		fW << iWalker->fCalled_Rewind << "\t" << iWalker->fCalled_QReadInc;
+		fW << iWalker->fCalled_Rewind
+			<< "\t" << iWalker->fCalled_QReadInc
+			<< "\t" << iWalker->fCalled_QReadBatch;
 		Walker* asPointer = iWalker.Get();
 		fW << " " << typeid(*asPointer).name();
 
@@ -54,6 +58,16 @@ public:
 			theW->GetLeft()->Accept(*this);
 			theW->GetRight()->Accept(*this);
 			}
+		else if (ZP<Walker_HashJoin> theW = iWalker.DynamicCast<Walker_HashJoin>())
+			{
+			theW->GetLeft()->Accept(*this);
+			theW->GetRight()->Accept(*this);
+			}
+		else if (ZP<Walker_MergeJoin> theW = iWalker.DynamicCast<Walker_MergeJoin>())
+			{
+			theW->GetLeft()->Accept(*this);
+			theW->GetRight()->Accept(*this);
+			}
 		else if (ZP<Walker_Union> theW = iWalker.DynamicCast<Walker_Union>())
 			{
 			theW->GetLeft()->Accept(*this);
@@ -21,26 +21,135 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/QueryEngine/Visitor_DoMakeWalker.h"
 
 #include "zoolib/Log.h"
+#include "zoolib/ZMACRO_foreach.h"
 
+#include "zoolib/Expr/Util_Expr_Bool_CNF.h"
+
+#include "zoolib/QueryEngine/Expr_Rel_Search.h"
 #include "zoolib/QueryEngine/Walker_Calc.h"
 #include "zoolib/QueryEngine/Walker_Comment.h"
 #include "zoolib/QueryEngine/Walker_Const.h"
 #include "zoolib/QueryEngine/Walker_Dee.h"
 #include "zoolib/QueryEngine/Walker_Dum.h"
 #include "zoolib/QueryEngine/Walker_Embed.h"
+#include "zoolib/QueryEngine/Walker_HashJoin.h"
+#include "zoolib/QueryEngine/Walker_MergeJoin.h"
 #include "zoolib/QueryEngine/Walker_Product.h"
 #include "zoolib/QueryEngine/Walker_Project.h"
 #include "zoolib/QueryEngine/Walker_Rename.h"
 #include "zoolib/QueryEngine/Walker_Restrict.h"
 #include "zoolib/QueryEngine/Walker_Union.h"
 
+#include "zoolib/RelationalAlgebra/GetRelHead.h"
+
 #include "zoolib/ValPred/Expr_Bool_ValPred.h"
+#include "zoolib/ValPred/Visitor_Expr_Bool_ValPred_Do_GetNames.h"
+
+#include <algorithm> // For std::includes
 
 namespace ZooLib {
 namespace QueryEngine {
 
 namespace RA = RelationalAlgebra;
 
+using std::vector;
+
+using namespace Util_Expr_Bool;
+
+// =================================================================================================
+#pragma mark - Helpers (anonymous)
+
+namespace { // anonymous
+
+// Returns true if walking iRel might consume values bound outside it, in which case it must
+// be re-read for every row of whatever's to its left. Anything unrecognized is assumed to.
+
+class Visitor_ConsumesNames
+:	public virtual Visitor_Do_T<bool>
+,	public virtual Visitor_Expr_Op0_T<RA::Expr_Rel>
+,	public virtual Visitor_Expr_Op1_T<RA::Expr_Rel>
+,	public virtual Visitor_Expr_Op2_T<RA::Expr_Rel>
+,	public virtual RA::Visitor_Expr_Rel_Embed
+,	public virtual RA::Visitor_Expr_Rel_Restrict
+,	public virtual Visitor_Expr_Rel_Search
+	{
+public:
+	virtual void Visit(const ZP<Visitee>&)
+		{ this->pSetResult(true); }
+
+	virtual void Visit_Expr_Op0(const ZP<Expr_Op0_T<RA::Expr_Rel>>&)
+		{ this->pSetResult(false); }
+
+	virtual void Visit_Expr_Op1(const ZP<Expr_Op1_T<RA::Expr_Rel>>& iExpr)
+		{ this->pSetResult(this->Do(iExpr->GetOp0())); }
+
+	virtual void Visit_Expr_Op2(const ZP<Expr_Op2_T<RA::Expr_Rel>>& iExpr)
+		{ this->pSetResult(this->Do(iExpr->GetOp0()) || this->Do(iExpr->GetOp1())); }
+
+	virtual void Visit_Expr_Rel_Embed(const ZP<RA::Expr_Rel_Embed>&)
+		{ this->pSetResult(true); }
+
+	virtual void Visit_Expr_Rel_Restrict(const ZP<RA::Expr_Rel_Restrict>& iExpr)
+		{
+		if (this->Do(iExpr->GetOp0()))
+			{
+			this->pSetResult(true);
+			}
+		else
+			{
+			const RA::RelHead theRelHead = RA::sGetRelHead(iExpr->GetOp0());
+			const std::set<string8> theNames = sGetNames(iExpr->GetExpr_Bool());
+			this->pSetResult(not std::includes(
+				theRelHead.begin(), theRelHead.end(), theNames.begin(), theNames.end()));
+			}
+		}
+
+	virtual void Visit_Expr_Rel_Search(const ZP<Expr_Rel_Search>& iExpr)
+		{ this->pSetResult(not iExpr->GetRelHead_Bound().empty()); }
+	};
+
+// Picks out the top-level conjuncts of iExpr that compare one name with another, separating
+// equalities from the other simple comparisons.
+void spGetJoinValPreds(const ZP<Expr_Bool>& iExpr,
+	vector<ValPred>& oEqualities, vector<ValPred>& oRanges)
+	{
+	const CNF theCNF = sAsCNF(iExpr);
+	foreacha (theDClause, theCNF)
+		{
+		if (theDClause.size() != 1)
+			continue;
+
+		ZP<Expr_Bool_ValPred> theExpr = theDClause.begin()->Get().DynamicCast<Expr_Bool_ValPred>();
+		if (not theExpr)
+			continue;
+
+		const ValPred& theValPred = theExpr->GetValPred();
+
+		ZP<ValComparator_Simple> theComparator =
+			theValPred.GetComparator().DynamicCast<ValComparator_Simple>();
+		if (not theComparator)
+			continue;
+
+		if (not theValPred.GetLHS().DynamicCast<ValComparand_Name>()
+			|| not theValPred.GetRHS().DynamicCast<ValComparand_Name>())
+			{ continue; }
+
+		switch (theComparator->GetEComparator())
+			{
+			case ValComparator_Simple::eEQ:
+				oEqualities.push_back(theValPred);
+				break;
+			case ValComparator_Simple::eNE:
+				break;
+			default:
+				oRanges.push_back(theValPred);
+				break;
+			}
+		}
+	}
+
+} // anonymous namespace
+
 // =================================================================================================
 #pragma mark - Visitor_DoMakeWalker
 
@@ -108,8 +217,22 @@ void Visitor_DoMakeWalker::Visit_Expr_Rel_Rename(const ZP<RA::Expr_Rel_Rename>&
 
 void Visitor_DoMakeWalker::Visit_Expr_Rel_Restrict(const ZP<RA::Expr_Rel_Restrict>& iExpr)
 	{
-	if (ZP<Walker> op0 = this->Do(iExpr->GetOp0()))
+	// A restriction over a product that relates columns from either side can be satisfied by
+	// a join, rather than by filtering every row of the product. The Walker_Restrict remains
+	// responsible for the restriction as a whole, the joins just save it most of the work.
+	vector<ValPred> theEqualities, theRanges;
+	if (iExpr->GetOp0().DynamicCast<RA::Expr_Rel_Product>())
+		spGetJoinValPreds(iExpr->GetExpr_Bool(), theEqualities, theRanges);
+
+	if (theEqualities.size() || theRanges.size())
+		{
+		if (ZP<Walker> op0 = this->pDoJoin(iExpr->GetOp0(), theEqualities, theRanges))
+			this->pSetResult(new Walker_Restrict(op0, iExpr->GetExpr_Bool()));
+		}
+	else if (ZP<Walker> op0 = this->Do(iExpr->GetOp0()))
+		{
 		this->pSetResult(new Walker_Restrict(op0, iExpr->GetExpr_Bool()));
+		}
 	}
 
 void Visitor_DoMakeWalker::Visit_Expr_Rel_Union(const ZP<RA::Expr_Rel_Union>& iExpr)
@@ -125,5 +248,27 @@ void Visitor_DoMakeWalker::Visit_Expr_Rel_Union(const ZP<RA::Expr_Rel_Union>& iE
 		this->pSetResult(op1);
 	}
 
+ZP<Walker> Visitor_DoMakeWalker::pDoJoin(const ZP<RA::Expr_Rel>& iRel,
+	const vector<ValPred>& iEqualities, const vector<ValPred>& iRanges)
+	{
+	// The join walkers read their right side once, so it can't depend on the left. Nested
+	// products are handled by recursing down the left, each join using whichever of the
+	// comparisons straddle its own two sides.
+	ZP<RA::Expr_Rel_Product> theProduct = iRel.DynamicCast<RA::Expr_Rel_Product>();
+	if (not theProduct || Visitor_ConsumesNames().Do(theProduct->GetOp1()))
+		return this->Do(iRel);
+
+	if (ZP<Walker> op0 = this->pDoJoin(theProduct->GetOp0(), iEqualities, iRanges))
+		{
+		if (ZP<Walker> op1 = this->Do(theProduct->GetOp1()))
+			{
+			if (iEqualities.size())
+				return new Walker_HashJoin(op0, op1, iEqualities);
+			return new Walker_MergeJoin(op0, op1, iRanges);
+			}
+		}
+	return null;
+	}
+
 } // namespace QueryEngine
 } // namespace ZooLib
@@ -38,6 +38,10 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "zoolib/RelationalAlgebra/Expr_Rel_Restrict.h"
 #include "zoolib/RelationalAlgebra/Expr_Rel_Union.h"
 
+#include "zoolib/ValPred/ValPred.h"
+
+#include <vector>
+
 namespace ZooLib {
 namespace QueryEngine {
 
@@ -74,6 +78,10 @@ public:
 	virtual void Visit_Expr_Rel_Rename(const ZP<RelationalAlgebra::Expr_Rel_Rename>& iExpr);
 	virtual void Visit_Expr_Rel_Restrict(const ZP<RelationalAlgebra::Expr_Rel_Restrict>& iExpr);
 	virtual void Visit_Expr_Rel_Union(const ZP<RelationalAlgebra::Expr_Rel_Union>& iExpr);
+
+private:
+	ZP<Walker> pDoJoin(const ZP<RelationalAlgebra::Expr_Rel>& iRel,
+		const std::vector<ValPred>& iEqualities, const std::vector<ValPred>& iRanges);
 	};
 
 } // namespace QueryEngine
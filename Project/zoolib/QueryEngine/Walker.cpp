@@ -30,6 +30,7 @@ Walker::Walker()
 	{
 	fCalled_Rewind = 0;
 	fCalled_QReadInc = 0;
+	fCalled_QReadBatch = 0;
 	}
 
 Walker::~Walker()
@@ -46,6 +47,14 @@ void Walker::Accept(const Visitor& iVisitor)
 void Walker::Accept_Walker(Visitor_Walker& iVisitor)
 	{ iVisitor.Visit_Walker(this); }
 
+size_t Walker::QReadBatch(Val_DB* ioRows, size_t iStride, size_t iMaxRows)
+	{
+	size_t count = 0;
+	while (count < iMaxRows && this->QReadInc(ioRows + count * iStride))
+		++count;
+	return count;
+	}
+
 void Walker::Called_Rewind()
 	{
 	++fCalled_Rewind;
@@ -56,6 +65,11 @@ void Walker::Called_QReadInc()
 	++fCalled_QReadInc;
 	}
 
+void Walker::Called_QReadBatch()
+	{
+	++fCalled_QReadBatch;
+	}
+
 // =================================================================================================
 #pragma mark - Visitor_Walker
 
@@ -59,13 +59,22 @@ public:
 
 	virtual bool QReadInc(Val_DB* ioResults) = 0;
 
+	// Reads up to iMaxRows rows, each iStride Val_DBs after the previous, and returns how
+	// many were read. Fewer than iMaxRows indicates we're exhausted, and like a false return
+	// from QReadInc no further reads should be made until we've been rewound. As with
+	// QReadInc each row must hold any values bound from outside. The default implementation
+	// calls QReadInc per row, walkers that can do better a block at a time override it.
+	virtual size_t QReadBatch(Val_DB* ioRows, size_t iStride, size_t iMaxRows);
+
 protected:
 	void Called_Rewind();
 	void Called_QReadInc();
+	void Called_QReadBatch();
 
 public:
 	size_t fCalled_Rewind;
 	size_t fCalled_QReadInc;
+	size_t fCalled_QReadBatch;
 	};
 
 // =================================================================================================
@@ -69,5 +69,20 @@ bool Walker_Calc::QReadInc(Val_DB* ioResults)
 	return true;
 	}
 
+size_t Walker_Calc::QReadBatch(Val_DB* ioRows, size_t iStride, size_t iMaxRows)
+	{
+	this->Called_QReadBatch();
+
+	const size_t theCount = fWalker->QReadBatch(ioRows, iStride, iMaxRows);
+
+	for (size_t xx = 0; xx < theCount; ++xx)
+		{
+		Val_DB* theRow = ioRows + xx * iStride;
+		theRow[fOutputOffset] = fCallable->Call(PseudoMap(&fBindings, theRow));
+		}
+
+	return theCount;
+	}
+
 } // namespace QueryEngine
 } // namespace ZooLib
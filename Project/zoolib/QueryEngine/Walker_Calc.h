@@ -52,6 +52,8 @@ public:
 
 	virtual bool QReadInc(Val_DB* oResults);
 
+	virtual size_t QReadBatch(Val_DB* ioRows, size_t iStride, size_t iMaxRows);
+
 private:
 	const string8 fColName;
 	const ZP<Callable_t> fCallable;
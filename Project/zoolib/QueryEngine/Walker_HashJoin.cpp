@@ -0,0 +1,241 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#include "zoolib/QueryEngine/Walker_HashJoin.h"
+
+#include "zoolib/Util_STL_map.h"
+#include "zoolib/ZMACRO_foreach.h"
+
+#include "zoolib/QueryEngine/Walker_Dee.h"
+
+#include <functional> // For std::hash
+
+namespace ZooLib {
+namespace QueryEngine {
+
+using std::map;
+using std::vector;
+
+using namespace Util_STL;
+
+// =================================================================================================
+#pragma mark - Helpers (anonymous)
+
+namespace { // anonymous
+
+const size_t kNone = size_t(-1);
+
+// Val_DB::Compare treats values of different types as unequal, so the type participates in the
+// hash. The value participates for common scalar types, everything else relies on the type alone.
+size_t spHash(const Val_DB& iVal)
+	{
+	size_t result = iVal.Type().hash_code();
+
+	if (const int64* theP = iVal.PGet<int64>())
+		result ^= std::hash<int64>()(*theP);
+	else if (const int32* theP = iVal.PGet<int32>())
+		result ^= std::hash<int32>()(*theP);
+	else if (const double* theP = iVal.PGet<double>())
+		result ^= std::hash<double>()(*theP);
+	else if (const bool* theP = iVal.PGet<bool>())
+		result ^= std::hash<bool>()(*theP);
+	else if (const string8* theP = iVal.PGet<string8>())
+		result ^= std::hash<string8>()(*theP);
+
+	return result;
+	}
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - Walker_HashJoin
+
+Walker_HashJoin::Walker_HashJoin(const ZP<Walker>& iWalker_Left, const ZP<Walker>& iWalker_Right,
+	const std::vector<ValPred>& iValPreds)
+:	fWalker_Left(iWalker_Left)
+,	fWalker_Right(iWalker_Right)
+,	fBaseOffset_Right(0)
+,	fCount_Right(0)
+,	fValPreds(iValPreds)
+,	fBuilt(false)
+,	fNeedLoadLeft(true)
+,	fHash_Left(0)
+,	fCurrent(kNone)
+	{}
+
+Walker_HashJoin::~Walker_HashJoin()
+	{}
+
+void Walker_HashJoin::Rewind()
+	{
+	this->Called_Rewind();
+	fWalker_Left->Rewind();
+	fNeedLoadLeft = true;
+	}
+
+ZP<Walker> Walker_HashJoin::Prime(
+	const map<string8,size_t>& iOffsets,
+	map<string8,size_t>& oOffsets,
+	size_t& ioBaseOffset)
+	{
+	map<string8,size_t> leftOffsets;
+	fWalker_Left = fWalker_Left->Prime(iOffsets, leftOffsets, ioBaseOffset);
+
+	fResults_Left.resize(ioBaseOffset);
+	oOffsets.insert(leftOffsets.begin(), leftOffsets.end());
+
+	map<string8,size_t> combined = iOffsets;
+	combined.insert(leftOffsets.begin(), leftOffsets.end());
+
+	fBaseOffset_Right = ioBaseOffset;
+	map<string8,size_t> rightOffsets;
+	fWalker_Right = fWalker_Right->Prime(combined, rightOffsets, ioBaseOffset);
+	fCount_Right = ioBaseOffset - fBaseOffset_Right;
+	oOffsets.insert(rightOffsets.begin(), rightOffsets.end());
+
+	if (not fWalker_Left || not fWalker_Right)
+		return null;
+
+	if (fWalker_Left.DynamicCast<Walker_Dee>())
+		return fWalker_Right;
+	else if (fWalker_Right.DynamicCast<Walker_Dee>())
+		return fWalker_Left;
+
+	// Pick out the equalities that relate a left column to a right column.
+	foreacha (theValPred, fValPreds)
+		{
+		ZP<ValComparator_Simple> theComparator =
+			theValPred.GetComparator().DynamicCast<ValComparator_Simple>();
+		if (not theComparator || theComparator->GetEComparator() != ValComparator_Simple::eEQ)
+			continue;
+
+		ZP<ValComparand_Name> theLHS = theValPred.GetLHS().DynamicCast<ValComparand_Name>();
+		ZP<ValComparand_Name> theRHS = theValPred.GetRHS().DynamicCast<ValComparand_Name>();
+		if (not theLHS || not theRHS)
+			continue;
+
+		ZQ<size_t> leftQ = sQGet(leftOffsets, theLHS->GetName());
+		ZQ<size_t> rightQ = sQGet(rightOffsets, theRHS->GetName());
+		if (not leftQ || not rightQ)
+			{
+			leftQ = sQGet(leftOffsets, theRHS->GetName());
+			rightQ = sQGet(rightOffsets, theLHS->GetName());
+			}
+
+		if (leftQ && rightQ)
+			{
+			fKeyOffsets_Left.push_back(*leftQ);
+			fKeyOffsets_Right.push_back(*rightQ - fBaseOffset_Right);
+			}
+		}
+
+	return this;
+	}
+
+bool Walker_HashJoin::QReadInc(Val_DB* ioResults)
+	{
+	this->Called_QReadInc();
+
+	if (not fBuilt)
+		this->pBuild(ioResults);
+
+	for (;;)
+		{
+		if (fNeedLoadLeft)
+			{
+			fNeedLoadLeft = false;
+
+			if (not fWalker_Left->QReadInc(ioResults))
+				return false;
+
+			std::copy_n(ioResults, fResults_Left.size(), fResults_Left.begin());
+
+			if (fBuckets.empty())
+				{
+				fCurrent = kNone;
+				}
+			else
+				{
+				fHash_Left = this->pHash(ioResults, fKeyOffsets_Left);
+				fCurrent = fBuckets[fHash_Left & (fBuckets.size() - 1)];
+				}
+			}
+
+		while (fCurrent != kNone)
+			{
+			const size_t theRow = fCurrent;
+			fCurrent = fNext[theRow];
+
+			if (fHashes[theRow] != fHash_Left)
+				continue;
+
+			const Val_DB* theVals = fRows.data() + theRow * fCount_Right;
+
+			bool allMatch = true;
+			for (size_t xx = 0; xx < fKeyOffsets_Left.size(); ++xx)
+				{
+				if (sCompare_T(fResults_Left[fKeyOffsets_Left[xx]], theVals[fKeyOffsets_Right[xx]]))
+					{
+					allMatch = false;
+					break;
+					}
+				}
+
+			if (allMatch)
+				{
+				std::copy(fResults_Left.begin(), fResults_Left.end(), ioResults);
+				std::copy_n(theVals, fCount_Right, ioResults + fBaseOffset_Right);
+				return true;
+				}
+			}
+
+		fNeedLoadLeft = true;
+		}
+	}
+
+void Walker_HashJoin::pBuild(Val_DB* ioResults)
+	{
+	fBuilt = true;
+
+	// ioResults serves as scratch space while we read the right side. Nothing of the left
+	// side has been loaded yet, and the caller's bindings are left untouched.
+	size_t theCount = 0;
+	fWalker_Right->Rewind();
+	while (fWalker_Right->QReadInc(ioResults))
+		{
+		fRows.insert(fRows.end(), ioResults + fBaseOffset_Right,
+			ioResults + fBaseOffset_Right + fCount_Right);
+		++theCount;
+		}
+
+	if (not theCount)
+		return;
+
+	size_t theBucketCount = 1;
+	while (theBucketCount < theCount * 2)
+		theBucketCount <<= 1;
+
+	fBuckets.resize(theBucketCount, kNone);
+	fHashes.resize(theCount);
+	fNext.resize(theCount);
+
+	// Chain in reverse so each bucket lists its rows in the order they were read.
+	for (size_t theRow = theCount; theRow--; /*no inc*/)
+		{
+		const size_t theHash = this->pHash(fRows.data() + theRow * fCount_Right, fKeyOffsets_Right);
+		fHashes[theRow] = theHash;
+		size_t& theBucket = fBuckets[theHash & (theBucketCount - 1)];
+		fNext[theRow] = theBucket;
+		theBucket = theRow;
+		}
+	}
+
+size_t Walker_HashJoin::pHash(const Val_DB* iVals, const vector<size_t>& iOffsets)
+	{
+	size_t result = 0;
+	foreacha (theOffset, iOffsets)
+		result = (result * 1000003) ^ spHash(iVals[theOffset]);
+	return result;
+	}
+
+} // namespace QueryEngine
+} // namespace ZooLib
@@ -0,0 +1,87 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#ifndef __ZooLib_QueryEngine_Walker_HashJoin_h__
+#define __ZooLib_QueryEngine_Walker_HashJoin_h__ 1
+#include "zconfig.h"
+
+#include "zoolib/QueryEngine/Walker.h"
+
+#include "zoolib/ValPred/ValPred.h"
+
+#include <vector>
+
+namespace ZooLib {
+namespace QueryEngine {
+
+// =================================================================================================
+#pragma mark - Walker_HashJoin
+
+// Produces the same rows as a Walker_Product, restricted to those where the equality
+// comparisons in iValPreds hold between a column from the left and one from the right.
+// The right side is read once and kept in a hash table keyed on the right's columns. Each
+// left row then only visits the right rows whose keys are equal to its own.
+//
+// iValPreds are expected to be name-to-name equalities. Prime works out which names come
+// from which side. Any that don't straddle the two sides are ignored, and with none left
+// we degenerate to a product against the materialized right side. The restriction is not
+// otherwise applied, so this walker is normally wrapped by a Walker_Restrict.
+//
+// The right side must not depend on values bound by the left. Visitor_DoMakeWalker
+// checks for that before choosing us.
+
+class Walker_HashJoin : public Walker
+	{
+public:
+	Walker_HashJoin(const ZP<Walker>& iWalker_Left, const ZP<Walker>& iWalker_Right,
+		const std::vector<ValPred>& iValPreds);
+
+	virtual ~Walker_HashJoin();
+
+// From QueryEngine::Walker
+	virtual void Rewind();
+
+	virtual ZP<Walker> Prime(
+		const std::map<string8,size_t>& iOffsets,
+		std::map<string8,size_t>& oOffsets,
+		size_t& ioBaseOffset);
+
+	virtual bool QReadInc(Val_DB* ioResults);
+
+// Our protocol
+	ZP<Walker> GetLeft()
+		{ return fWalker_Left; }
+
+	ZP<Walker> GetRight()
+		{ return fWalker_Right; }
+
+private:
+	void pBuild(Val_DB* ioResults);
+	size_t pHash(const Val_DB* iVals, const std::vector<size_t>& iOffsets);
+
+	ZP<Walker> fWalker_Left;
+	std::vector<Val_DB> fResults_Left;
+
+	ZP<Walker> fWalker_Right;
+	size_t fBaseOffset_Right;
+	size_t fCount_Right;
+
+	const std::vector<ValPred> fValPreds;
+	std::vector<size_t> fKeyOffsets_Left;
+	std::vector<size_t> fKeyOffsets_Right;
+
+	// The right side's rows, packed, with a chain through each bucket.
+	bool fBuilt;
+	std::vector<Val_DB> fRows;
+	std::vector<size_t> fHashes;
+	std::vector<size_t> fNext;
+	std::vector<size_t> fBuckets;
+
+	bool fNeedLoadLeft;
+	size_t fHash_Left;
+	size_t fCurrent;
+	};
+
+} // namespace QueryEngine
+} // namespace ZooLib
+
+#endif // __ZooLib_QueryEngine_Walker_HashJoin_h__
@@ -0,0 +1,287 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#include "zoolib/QueryEngine/Walker_MergeJoin.h"
+
+#include "zoolib/Util_STL_map.h"
+#include "zoolib/ZMACRO_foreach.h"
+
+#include "zoolib/QueryEngine/Walker_Dee.h"
+
+#include <algorithm> // For std::stable_sort
+
+namespace ZooLib {
+namespace QueryEngine {
+
+using std::map;
+using std::vector;
+
+using namespace Util_STL;
+
+// =================================================================================================
+#pragma mark - Helpers (anonymous)
+
+namespace { // anonymous
+
+ValComparator_Simple::EComparator spFlipped(ValComparator_Simple::EComparator iEComparator)
+	{
+	switch (iEComparator)
+		{
+		case ValComparator_Simple::eLT: return ValComparator_Simple::eGT;
+		case ValComparator_Simple::eLE: return ValComparator_Simple::eGE;
+		case ValComparator_Simple::eGE: return ValComparator_Simple::eLE;
+		case ValComparator_Simple::eGT: return ValComparator_Simple::eLT;
+		default: return iEComparator;
+		}
+	}
+
+// Orders row indices by the value at iOffset within each packed row.
+struct Comparer_Row
+	{
+	Comparer_Row(const vector<Val_DB>& iRows, size_t iWidth, size_t iOffset)
+	:	fRows(iRows)
+	,	fWidth(iWidth)
+	,	fOffset(iOffset)
+		{}
+
+	bool operator()(size_t iLeft, size_t iRight) const
+		{
+		return sCompare_T(fRows[iLeft * fWidth + fOffset], fRows[iRight * fWidth + fOffset]) < 0;
+		}
+
+	const vector<Val_DB>& fRows;
+	const size_t fWidth;
+	const size_t fOffset;
+	};
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - Walker_MergeJoin
+
+Walker_MergeJoin::Walker_MergeJoin(const ZP<Walker>& iWalker_Left, const ZP<Walker>& iWalker_Right,
+	const std::vector<ValPred>& iValPreds)
+:	fWalker_Left(iWalker_Left)
+,	fCount_Left(0)
+,	fWalker_Right(iWalker_Right)
+,	fBaseOffset_Right(0)
+,	fCount_Right(0)
+,	fValPreds(iValPreds)
+,	fHasKey(false)
+,	fEComparator(ValComparator_Simple::eEQ)
+,	fKeyOffset_Left(0)
+,	fKeyOffset_Right(0)
+,	fLoaded_Right(false)
+,	fLoaded_Left(false)
+,	fIndex_Left(0)
+,	fLower(0)
+,	fUpper(0)
+,	fCurrent(0)
+,	fEnd(0)
+	{}
+
+Walker_MergeJoin::~Walker_MergeJoin()
+	{}
+
+void Walker_MergeJoin::Rewind()
+	{
+	this->Called_Rewind();
+	fWalker_Left->Rewind();
+	fLoaded_Left = false;
+	}
+
+ZP<Walker> Walker_MergeJoin::Prime(
+	const map<string8,size_t>& iOffsets,
+	map<string8,size_t>& oOffsets,
+	size_t& ioBaseOffset)
+	{
+	map<string8,size_t> leftOffsets;
+	fWalker_Left = fWalker_Left->Prime(iOffsets, leftOffsets, ioBaseOffset);
+
+	fCount_Left = ioBaseOffset;
+	oOffsets.insert(leftOffsets.begin(), leftOffsets.end());
+
+	map<string8,size_t> combined = iOffsets;
+	combined.insert(leftOffsets.begin(), leftOffsets.end());
+
+	fBaseOffset_Right = ioBaseOffset;
+	map<string8,size_t> rightOffsets;
+	fWalker_Right = fWalker_Right->Prime(combined, rightOffsets, ioBaseOffset);
+	fCount_Right = ioBaseOffset - fBaseOffset_Right;
+	oOffsets.insert(rightOffsets.begin(), rightOffsets.end());
+
+	if (not fWalker_Left || not fWalker_Right)
+		return null;
+
+	if (fWalker_Left.DynamicCast<Walker_Dee>())
+		return fWalker_Right;
+	else if (fWalker_Right.DynamicCast<Walker_Dee>())
+		return fWalker_Left;
+
+	// Find the first comparison that relates a left column to a right column.
+	foreacha (theValPred, fValPreds)
+		{
+		ZP<ValComparator_Simple> theComparator =
+			theValPred.GetComparator().DynamicCast<ValComparator_Simple>();
+		if (not theComparator || theComparator->GetEComparator() == ValComparator_Simple::eNE)
+			continue;
+
+		ZP<ValComparand_Name> theLHS = theValPred.GetLHS().DynamicCast<ValComparand_Name>();
+		ZP<ValComparand_Name> theRHS = theValPred.GetRHS().DynamicCast<ValComparand_Name>();
+		if (not theLHS || not theRHS)
+			continue;
+
+		if (ZQ<size_t> leftQ = sQGet(leftOffsets, theLHS->GetName()))
+			{
+			if (ZQ<size_t> rightQ = sQGet(rightOffsets, theRHS->GetName()))
+				{
+				fEComparator = theComparator->GetEComparator();
+				fKeyOffset_Left = *leftQ;
+				fKeyOffset_Right = *rightQ - fBaseOffset_Right;
+				fHasKey = true;
+				break;
+				}
+			}
+
+		if (ZQ<size_t> leftQ = sQGet(leftOffsets, theRHS->GetName()))
+			{
+			if (ZQ<size_t> rightQ = sQGet(rightOffsets, theLHS->GetName()))
+				{
+				fEComparator = spFlipped(theComparator->GetEComparator());
+				fKeyOffset_Left = *leftQ;
+				fKeyOffset_Right = *rightQ - fBaseOffset_Right;
+				fHasKey = true;
+				break;
+				}
+			}
+		}
+
+	return this;
+	}
+
+bool Walker_MergeJoin::QReadInc(Val_DB* ioResults)
+	{
+	this->Called_QReadInc();
+
+	if (not fLoaded_Right)
+		this->pLoadRight(ioResults);
+
+	if (not fLoaded_Left)
+		this->pLoadLeft(ioResults);
+
+	for (;;)
+		{
+		if (fCurrent < fEnd)
+			{
+			const size_t theRow_Left = fSorted_Left[fIndex_Left - 1];
+			const size_t theRow_Right = fSorted_Right[fCurrent++];
+			std::copy_n(fRows_Left.data() + theRow_Left * fCount_Left, fCount_Left, ioResults);
+			std::copy_n(fRows_Right.data() + theRow_Right * fCount_Right, fCount_Right,
+				ioResults + fBaseOffset_Right);
+			return true;
+			}
+
+		if (fIndex_Left >= fSorted_Left.size())
+			return false;
+
+		const size_t theCount_Right = fSorted_Right.size();
+		if (not fHasKey)
+			{
+			fLower = 0;
+			fUpper = theCount_Right;
+			}
+		else
+			{
+			// Advance the first right row not less than the left key, and the first right row
+			// greater than the left key. Left keys ascend, so these never move backwards.
+			const Val_DB& theKey =
+				fRows_Left[fSorted_Left[fIndex_Left] * fCount_Left + fKeyOffset_Left];
+
+			while (fLower < theCount_Right
+				&& sCompare_T(fRows_Right[fSorted_Right[fLower] * fCount_Right + fKeyOffset_Right],
+					theKey) < 0)
+				{ ++fLower; }
+
+			if (fUpper < fLower)
+				fUpper = fLower;
+
+			while (fUpper < theCount_Right
+				&& sCompare_T(fRows_Right[fSorted_Right[fUpper] * fCount_Right + fKeyOffset_Right],
+					theKey) <= 0)
+				{ ++fUpper; }
+			}
+
+		++fIndex_Left;
+
+		// Given left OP right, the matching run of (sorted) right rows is:
+		switch (fEComparator)
+			{
+			case ValComparator_Simple::eLT:
+				fCurrent = fUpper;
+				fEnd = theCount_Right;
+				break;
+			case ValComparator_Simple::eLE:
+				fCurrent = fLower;
+				fEnd = theCount_Right;
+				break;
+			case ValComparator_Simple::eGE:
+				fCurrent = 0;
+				fEnd = fUpper;
+				break;
+			case ValComparator_Simple::eGT:
+				fCurrent = 0;
+				fEnd = fLower;
+				break;
+			default:
+				fCurrent = fLower;
+				fEnd = fUpper;
+				break;
+			}
+		}
+	}
+
+void Walker_MergeJoin::pLoadRight(Val_DB* ioResults)
+	{
+	fLoaded_Right = true;
+
+	fWalker_Right->Rewind();
+	while (fWalker_Right->QReadInc(ioResults))
+		{
+		fSorted_Right.push_back(fSorted_Right.size());
+		fRows_Right.insert(fRows_Right.end(), ioResults + fBaseOffset_Right,
+			ioResults + fBaseOffset_Right + fCount_Right);
+		}
+
+	if (fHasKey)
+		{
+		std::stable_sort(fSorted_Right.begin(), fSorted_Right.end(),
+			Comparer_Row(fRows_Right, fCount_Right, fKeyOffset_Right));
+		}
+	}
+
+void Walker_MergeJoin::pLoadLeft(Val_DB* ioResults)
+	{
+	fLoaded_Left = true;
+
+	fRows_Left.clear();
+	fSorted_Left.clear();
+	while (fWalker_Left->QReadInc(ioResults))
+		{
+		fSorted_Left.push_back(fSorted_Left.size());
+		fRows_Left.insert(fRows_Left.end(), ioResults, ioResults + fCount_Left);
+		}
+
+	if (fHasKey)
+		{
+		std::stable_sort(fSorted_Left.begin(), fSorted_Left.end(),
+			Comparer_Row(fRows_Left, fCount_Left, fKeyOffset_Left));
+		}
+
+	fIndex_Left = 0;
+	fLower = 0;
+	fUpper = 0;
+	fCurrent = 0;
+	fEnd = 0;
+	}
+
+} // namespace QueryEngine
+} // namespace ZooLib
@@ -0,0 +1,90 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#ifndef __ZooLib_QueryEngine_Walker_MergeJoin_h__
+#define __ZooLib_QueryEngine_Walker_MergeJoin_h__ 1
+#include "zconfig.h"
+
+#include "zoolib/QueryEngine/Walker.h"
+
+#include "zoolib/ValPred/ValPred.h"
+
+#include <vector>
+
+namespace ZooLib {
+namespace QueryEngine {
+
+// =================================================================================================
+#pragma mark - Walker_MergeJoin
+
+// The counterpart to Walker_HashJoin for range comparisons (<, <=, >=, >) between a left
+// and a right column. Both sides are read and sorted on their key column, and the left side
+// is then swept in order while the bounds of the matching run of right rows advance
+// monotonically. The first of iValPreds that straddles the two sides serves as the key,
+// and as with Walker_HashJoin the restriction is otherwise left to a Walker_Restrict.
+
+class Walker_MergeJoin : public Walker
+	{
+public:
+	Walker_MergeJoin(const ZP<Walker>& iWalker_Left, const ZP<Walker>& iWalker_Right,
+		const std::vector<ValPred>& iValPreds);
+
+	virtual ~Walker_MergeJoin();
+
+// From QueryEngine::Walker
+	virtual void Rewind();
+
+	virtual ZP<Walker> Prime(
+		const std::map<string8,size_t>& iOffsets,
+		std::map<string8,size_t>& oOffsets,
+		size_t& ioBaseOffset);
+
+	virtual bool QReadInc(Val_DB* ioResults);
+
+// Our protocol
+	ZP<Walker> GetLeft()
+		{ return fWalker_Left; }
+
+	ZP<Walker> GetRight()
+		{ return fWalker_Right; }
+
+private:
+	void pLoadRight(Val_DB* ioResults);
+	void pLoadLeft(Val_DB* ioResults);
+
+	ZP<Walker> fWalker_Left;
+	size_t fCount_Left;
+
+	ZP<Walker> fWalker_Right;
+	size_t fBaseOffset_Right;
+	size_t fCount_Right;
+
+	const std::vector<ValPred> fValPreds;
+
+	// Which key relationship, if any, we're exploiting. Expressed as left OP right.
+	bool fHasKey;
+	ValComparator_Simple::EComparator fEComparator;
+	size_t fKeyOffset_Left;
+	size_t fKeyOffset_Right;
+
+	// The right side is loaded once, the left side is reloaded after each Rewind.
+	bool fLoaded_Right;
+	std::vector<Val_DB> fRows_Right;
+	std::vector<size_t> fSorted_Right;
+
+	bool fLoaded_Left;
+	std::vector<Val_DB> fRows_Left;
+	std::vector<size_t> fSorted_Left;
+
+	// Position in fSorted_Left, the sweeping bounds of right rows equal to the current
+	// left key, and the run of right rows being emitted for the current left row.
+	size_t fIndex_Left;
+	size_t fLower;
+	size_t fUpper;
+	size_t fCurrent;
+	size_t fEnd;
+	};
+
+} // namespace QueryEngine
+} // namespace ZooLib
+
+#endif // __ZooLib_QueryEngine_Walker_MergeJoin_h__
@@ -90,5 +90,43 @@ bool Walker_Project::QReadInc(Val_DB* ioResults)
 		}
 	}
 
+size_t Walker_Project::QReadBatch(Val_DB* ioRows, size_t iStride, size_t iMaxRows)
+	{
+	this->Called_QReadBatch();
+
+	const size_t count = fRelHead.size();
+
+	size_t theSelected = 0;
+	while (theSelected < iMaxRows)
+		{
+		Val_DB* theBlock = ioRows + theSelected * iStride;
+		const size_t theRequested = iMaxRows - theSelected;
+		const size_t theCount = fWalker->QReadBatch(theBlock, iStride, theRequested);
+
+		for (size_t xx = 0; xx < theCount; ++xx)
+			{
+			Val_DB* theRow = theBlock + xx * iStride;
+
+			vector<Val_DB> subset;
+			subset.reserve(count);
+			for (size_t yy = 0; yy < count; ++yy)
+				subset.push_back(theRow[fChildMapping[yy]]);
+
+			if (Util_STL::sQInsert(fPriors, subset))
+				{
+				Val_DB* theDest = ioRows + theSelected * iStride;
+				if (theDest != theRow)
+					std::copy_n(theRow, iStride, theDest);
+				++theSelected;
+				}
+			}
+
+		if (theCount < theRequested)
+			break;
+		}
+
+	return theSelected;
+	}
+
 } // namespace QueryEngine
 } // namespace ZooLib
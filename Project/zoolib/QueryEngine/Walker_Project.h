@@ -47,6 +47,8 @@ public:
 
 	virtual bool QReadInc(Val_DB* ioResults);
 
+	virtual size_t QReadBatch(Val_DB* ioRows, size_t iStride, size_t iMaxRows);
+
 private:
 	const RelationalAlgebra::RelHead fRelHead;
 	std::vector<size_t> fChildMapping;
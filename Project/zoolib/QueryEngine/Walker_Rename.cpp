@@ -66,5 +66,11 @@ bool Walker_Rename::QReadInc(Val_DB* ioResults)
 	return fWalker->QReadInc(ioResults);
 	}
 
+size_t Walker_Rename::QReadBatch(Val_DB* ioRows, size_t iStride, size_t iMaxRows)
+	{
+	this->Called_QReadBatch();
+	return fWalker->QReadBatch(ioRows, iStride, iMaxRows);
+	}
+
 } // namespace QueryEngine
 } // namespace ZooLib
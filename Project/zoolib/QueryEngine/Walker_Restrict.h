@@ -24,6 +24,7 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/Expr/Expr_Bool.h"
 #include "zoolib/QueryEngine/Walker.h"
+#include "zoolib/ValPred/Compiled_ValPred_DB.h"
 
 namespace ZooLib {
 namespace QueryEngine {
@@ -35,6 +36,7 @@ class Walker_Restrict : public Walker_Unary
 	{
 public:
 	Walker_Restrict(ZP<Walker> iWalker, ZP<Expr_Bool> iExpr_Bool);
+	Walker_Restrict(ZP<Walker> iWalker, ZP<Compiled_ValPred_DB> iCompiled);
 	virtual ~Walker_Restrict();
 
 // From QueryEngine::Walker
@@ -45,14 +47,11 @@ public:
 
 	virtual bool QReadInc(Val_DB* ioResults);
 
-	class Exec;
+	virtual size_t QReadBatch(Val_DB* ioRows, size_t iStride, size_t iMaxRows);
 
 private:
-	const ZP<Expr_Bool> fExpr_Bool;
-	std::map<string8,size_t> fCombinedOffsets;
-
-	std::vector<Val_DB> fConsts;
-	Exec* fExec;
+	const ZP<Compiled_ValPred_DB> fCompiled;
+	std::vector<size_t> fOffsets;
 	};
 
 } // namespace QueryEngine
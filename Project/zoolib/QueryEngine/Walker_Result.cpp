@@ -63,13 +63,55 @@ bool Walker_Result::QReadInc(Val_DB* oResults)
 	if (fIndex >= fResult->Count())
 		return false;
 
-	const Val_DB* theVals = fResult->GetValsAt(fIndex);
-	std::copy_n(theVals, fResult->GetRelHead().size(), oResults + fBaseOffset);
+	const size_t theWidth = fResult->GetRelHead().size();
+	for (size_t xx = 0; xx < theWidth; ++xx)
+		oResults[fBaseOffset + xx] = fResult->GetVal(fIndex, xx);
 
 	++fIndex;
 
 	return true;
 	}
 
+size_t Walker_Result::QReadBatch(Val_DB* ioRows, size_t iStride, size_t iMaxRows)
+	{
+	this->Called_QReadBatch();
+
+	const size_t theWidth = fResult->GetRelHead().size();
+	const size_t theCount = std::min(iMaxRows, fResult->Count() - fIndex);
+
+	// Fill a column at a time, so typed columns are handled without per-value dispatch.
+	for (size_t yy = 0; yy < theWidth; ++yy)
+		{
+		Val_DB* theCells = ioRows + fBaseOffset + yy;
+		const Result::Column* theColumn = fResult->GetColumn(yy);
+		if (not theColumn)
+			{
+			for (size_t xx = 0; xx < theCount; ++xx)
+				theCells[xx * iStride] = fResult->GetVal(fIndex + xx, yy);
+			}
+		else if (theColumn->GetType() == Result::Column::eInt64 && theColumn->fNulls.empty())
+			{
+			const int64* theInt64s = &theColumn->fInt64s[fIndex];
+			for (size_t xx = 0; xx < theCount; ++xx)
+				theCells[xx * iStride] = theInt64s[xx];
+			}
+		else if (theColumn->GetType() == Result::Column::eDouble && theColumn->fNulls.empty())
+			{
+			const double* theDoubles = &theColumn->fDoubles[fIndex];
+			for (size_t xx = 0; xx < theCount; ++xx)
+				theCells[xx * iStride] = theDoubles[xx];
+			}
+		else
+			{
+			for (size_t xx = 0; xx < theCount; ++xx)
+				theCells[xx * iStride] = theColumn->Get(fIndex + xx);
+			}
+		}
+
+	fIndex += theCount;
+
+	return theCount;
+	}
+
 } // namespace QueryEngine
 } // namespace ZooLib
@@ -20,8 +20,12 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/Server/Roster.h"
 
+#include "zoolib/Time.h"
 #include "zoolib/Util_STL_set.h"
 
+#include <cmath> // For exp
+#include <string.h> // For memcpy
+
 #include <vector>
 
 namespace ZooLib {
@@ -34,13 +38,27 @@ using namespace Util_STL;
 // =================================================================================================
 #pragma mark - Roster
 
+static const double kAcceptRateTimeConstant = 10;
+
 Roster::Roster()
+:	fPending(0)
+,	fAccepted(0)
+,	fShed(0)
+,	fAcceptRate(0)
+,	fAcceptRateTime(Time::sSystem())
+,	fLifetimes()
 	{}
 
 Roster::Roster(const ZP<Callable_Void>& iCallable_Change,
 	const ZP<Callable_Void>& iCallable_Gone)
 :	fCallable_Change(iCallable_Change)
 ,	fCallable_Gone(iCallable_Gone)
+,	fPending(0)
+,	fAccepted(0)
+,	fShed(0)
+,	fAcceptRate(0)
+,	fAcceptRateTime(Time::sSystem())
+,	fLifetimes()
 	{}
 
 Roster::~Roster()
@@ -127,6 +145,41 @@ bool Roster::WaitUntil(double iDeadline, size_t iCount)
 	return fEntries.size() != iCount;
 	}
 
+void Roster::NoteAccepted()
+	{
+	ZAcqMtx acq(fMtx);
+	++fAccepted;
+	this->pDecayAcceptRate(Time::sSystem());
+	fAcceptRate += 1.0 / kAcceptRateTimeConstant;
+	}
+
+void Roster::NoteShed()
+	{
+	ZAcqMtx acq(fMtx);
+	++fShed;
+	}
+
+void Roster::NotePending(size_t iCount)
+	{
+	ZAcqMtx acq(fMtx);
+	fPending = iCount;
+	}
+
+Roster::Metrics Roster::GetMetrics()
+	{
+	ZAcqMtx acq(fMtx);
+	this->pDecayAcceptRate(Time::sSystem());
+
+	Metrics result;
+	result.fActive = fEntries.size();
+	result.fPending = fPending;
+	result.fAccepted = fAccepted;
+	result.fShed = fShed;
+	result.fAcceptRate = fAcceptRate;
+	::memcpy(result.fLifetimes, fLifetimes, sizeof(fLifetimes));
+	return result;
+	}
+
 void Roster::pFinalizeEntry(Entry* iEntry, const ZP<Callable_Void>& iCallable_Gone)
 	{
 	{
@@ -135,6 +188,15 @@ void Roster::pFinalizeEntry(Entry* iEntry, const ZP<Callable_Void>& iCallable_Go
 	if (not iEntry->FinishFinalize())
 		return;
 
+	const double theLifetime = Time::sSystem() - iEntry->fCreated;
+	size_t theBucket = 0;
+	for (double limit = 1e-3; theBucket < kLifetimeBucketCount - 1; limit *= 2, ++theBucket)
+		{
+		if (theLifetime < limit)
+			break;
+		}
+	++fLifetimes[theBucket];
+
 	sEraseMust(fEntries, iEntry);
 	delete iEntry;
 	fCnd.Broadcast();
@@ -144,6 +206,15 @@ void Roster::pFinalizeEntry(Entry* iEntry, const ZP<Callable_Void>& iCallable_Go
 	sCall(iCallable_Gone);
 	}
 
+void Roster::pDecayAcceptRate(double iNow)
+	{
+	if (iNow > fAcceptRateTime)
+		{
+		fAcceptRate *= std::exp((fAcceptRateTime - iNow) / kAcceptRateTimeConstant);
+		fAcceptRateTime = iNow;
+		}
+	}
+
 // =================================================================================================
 #pragma mark - Roster::Entry
 
@@ -152,6 +223,7 @@ Roster::Entry::Entry(
 	const ZP<Callable_Void>& iCallable_Broadcast,
 	const ZP<Callable_Void>& iCallable_Gone)
 :	fRoster(iRoster)
+,	fCreated(Time::sSystem())
 ,	fCallable_Broadcast(iCallable_Broadcast)
 ,	fCallable_Gone(iCallable_Gone)
 	{}
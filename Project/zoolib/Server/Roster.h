@@ -24,6 +24,7 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/Callable.h"
 #include "zoolib/Compat_NonCopyable.h"
+#include "zoolib/ZStdInt.h" // For uint64
 
 #include <set>
 
@@ -39,6 +40,20 @@ class Roster
 public:
 	class Entry;
 
+	// Bucket 0 counts entries that lived less than a millisecond, bucket i those that lived
+	// between 2^(i-1) and 2^i milliseconds, and the last bucket everything longer.
+	enum { kLifetimeBucketCount = 24 };
+
+	struct Metrics
+		{
+		size_t fActive; // Entries currently alive.
+		size_t fPending; // As last passed to NotePending.
+		uint64 fAccepted; // Calls to NoteAccepted.
+		uint64 fShed; // Calls to NoteShed.
+		double fAcceptRate; // Per second, exponentially smoothed with a ten second time constant.
+		uint64 fLifetimes[kLifetimeBucketCount];
+		};
+
 	Roster();
 
 	Roster(const ZP<Callable_Void>& iCallable_Change,
@@ -62,8 +77,15 @@ public:
 	bool WaitFor(double iTimeout, size_t iCount);
 	bool WaitUntil(double iDeadline, size_t iCount);
 
+	void NoteAccepted();
+	void NoteShed();
+	void NotePending(size_t iCount);
+
+	Metrics GetMetrics();
+
 private:
 	void pFinalizeEntry(Entry* iEntry, const ZP<Callable_Void>& iCallable_Gone);
+	void pDecayAcceptRate(double iNow);
 
 	ZMtx fMtx;
 	ZCnd fCnd;
@@ -71,6 +93,13 @@ private:
 	const ZP<Callable_Void> fCallable_Change;
 	const ZP<Callable_Void> fCallable_Gone;
 
+	size_t fPending;
+	uint64 fAccepted;
+	uint64 fShed;
+	double fAcceptRate;
+	double fAcceptRateTime;
+	uint64 fLifetimes[kLifetimeBucketCount];
+
 	friend class Entry;
 	};
 
@@ -95,6 +124,7 @@ public:
 
 private:
 	WP<Roster> fRoster;
+	const double fCreated;
 
 	const ZP<Callable_Void> fCallable_Broadcast;
 	const ZP<Callable_Void> fCallable_Gone;
@@ -26,10 +26,28 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 namespace ZooLib {
 
+using std::vector;
+
+// How long to wait before offering connections again to an iStarter_Connection that refused them.
+static const double kRetryInterval = 10e-3;
+
+// =================================================================================================
+#pragma mark - Server::Limits
+
+Server::Limits::Limits()
+:	fMaxConnections(0)
+,	fMaxPending(0)
+,	fShed(eShed_None)
+,	fAcceptBatch(1)
+	{}
+
 // =================================================================================================
 #pragma mark - Server
 
 Server::Server()
+:	fActive(0)
+,	fAwaitingRoom(false)
+,	fStarterRefused(false)
 	{}
 
 Server::~Server()
@@ -43,6 +61,8 @@ void Server::Finalize()
 	ZAssert(not fFactory);
 	fRoster.Clear();
 	fCallable_Connection.Clear();
+	fStarter_Connection.Clear();
+	fRetry = StartScheduler::Job();
 	}
 
 	Counted::Finalize();
@@ -58,6 +78,24 @@ void Server::Start(ZP<Starter> iStarter,
 		ZP<Factory_ChannerRW_Bin> iFactory,
 		ZP<Cancellable> iCancellable,
 		ZP<Callable_Connection> iCallable_Connection)
+	{ this->Start(iStarter, iFactory, iCancellable, iCallable_Connection, Limits(), null); }
+
+/**
+Connections are passed to iCallable_Connection on iStarter_Connection, which should generally be
+a pool with a bounded number of threads. If iStarter_Connection is null, they're passed on
+iStarter, from the thread doing the accepting. If iStarter_Connection refuses a connection it's
+put back at the head of the queue, and offered again a little later.
+
+An active connection is one whose Roster::Entry is still referenced. Once iLimits.fMaxConnections
+are active, newly accepted connections are queued, up to iLimits.fMaxPending of them, after which
+iLimits.fShed determines whether we stop accepting or abort connections to make room.
+*/
+void Server::Start(ZP<Starter> iStarter,
+		ZP<Factory_ChannerRW_Bin> iFactory,
+		ZP<Cancellable> iCancellable,
+		ZP<Callable_Connection> iCallable_Connection,
+		const Limits& iLimits,
+		ZP<Starter> iStarter_Connection)
 	{
 	ZAssert(iStarter);
 	ZAssert(iFactory);
@@ -78,6 +116,11 @@ void Server::Start(ZP<Starter> iStarter,
 	fFactory = iFactory;
 	fCallable_Connection = iCallable_Connection;
 	fCancellable = iCancellable;
+	fLimits = iLimits;
+	fStarter_Connection = iStarter_Connection;
+	fAwaitingRoom = false;
+	fStarterRefused = false;
+	fRetry = StartScheduler::Job(new Starter_Trivial, sCallable(sWP(this), &Server::pRetry));
 
 	fWorker = new Worker(
 		sCallable(sWP(this), &Server::pWork),
@@ -90,6 +133,9 @@ void Server::Start(ZP<Starter> iStarter,
 
 void Server::Stop()
 	{
+	// Declared before the acq, so queued connections are closed with our mutex released.
+	std::deque<ZP<ChannerRW_Bin>> priorPending;
+
 	ZAcqMtx acq(fMtx);
 	if (ZP<Factory_ChannerRW_Bin> theFactory = fFactory)
 		{
@@ -99,11 +145,20 @@ void Server::Stop()
 		fCancellable.Clear();
 		}
 	fCallable_Connection.Clear();
+	if (fStarterRefused)
+		sCancel(fRetry);
+	priorPending.swap(fPending);
+	if (fRoster)
+		fRoster->NotePending(0);
+	if (fWorker)
+		fWorker->Wake();
 	fCnd.Broadcast();
 	}
 
 void Server::StopWait()
 	{
+	std::deque<ZP<ChannerRW_Bin>> priorPending;
+
 	ZAcqMtx acq(fMtx);
 
 	if (ZP<Factory_ChannerRW_Bin> theFactory = fFactory)
@@ -114,6 +169,12 @@ void Server::StopWait()
 		fCancellable.Clear();
 		}
 
+	if (fStarterRefused)
+		sCancel(fRetry);
+	priorPending.swap(fPending);
+	if (fRoster)
+		fRoster->NotePending(0);
+
 	if (fWorker)
 		{
 		fWorker->Wake();
@@ -161,6 +222,17 @@ ZP<Server::Callable_Connection> Server::GetCallable_Connection()
 	return fCallable_Connection;
 	}
 
+Roster::Metrics Server::GetMetrics()
+	{
+	ZAcqMtx acq(fMtx);
+	if (ZP<Roster> theRoster = fRoster)
+		{
+		ZRelMtx rel(fMtx);
+		return theRoster->GetMetrics();
+		}
+	return Roster::Metrics();
+	}
+
 static void spKill(ZP<ChannerAbort> iChannerAbort)
 	{
 	if (iChannerAbort)
@@ -170,29 +242,54 @@ static void spKill(ZP<ChannerAbort> iChannerAbort)
 bool Server::pWork(ZP<Worker> iWorker)
 	{
 	ZAcqMtx acq(fMtx);
-	if (ZP<Factory_ChannerRW_Bin> theFactory = fFactory)
+	for (size_t count = 0; /*no test*/; ++count)
+		{
+		vector<Dispatch> theDispatches;
+		this->pDispatch_Locked(theDispatches);
+		if (theDispatches.size())
+			{
+			// Entries must not be released with our mutex held, pConnectionGone acquires it.
+			ZRelMtx rel(fMtx);
+			this->pCall(theDispatches);
+			theDispatches.clear();
+			}
+
+		ZP<Factory_ChannerRW_Bin> theFactory = fFactory;
+		if (not theFactory)
+			return false;
+
+		if (count >= std::max<size_t>(1, fLimits.fAcceptBatch))
+			break;
+
+		if (fLimits.fShed == eShed_None && this->pFull_Locked())
+			{
+			// pConnectionGone will wake us when there's room.
+			fAwaitingRoom = true;
+			return true;
+			}
+
+		ZP<ChannerRW_Bin> theChanner;
 		{
 		ZRelMtx rel(fMtx);
-		if (ZP<ChannerRW_Bin> theChanner = sCall(theFactory))
+		theChanner = sCall(theFactory);
+		}
+
+		if (not theChanner)
+			break;
+
+		fRoster->NoteAccepted();
+		if (ZP<ChannerRW_Bin> theShed = this->pEnqueue_Locked(theChanner))
 			{
-			ZAcqMtx acq(fMtx);
-			if (ZP<Callable_Connection> theCallable = fCallable_Connection)
-				{
-				ZRelMtx rel(fMtx);
-				try
-					{
-					ZP<Callable_Void> theCallable_Kill =
-						sBindR(sCallable(spKill), sZP(theChanner.DynamicCast<ChannerAbort>()));
-					theCallable->Call(fRoster->MakeEntry(theCallable_Kill, null), theChanner);
-					}
-				catch (...)
-					{}
-				}
+			fRoster->NoteShed();
+			ZRelMtx rel(fMtx);
+			spKill(theShed.DynamicCast<ChannerAbort>());
+			theShed.Clear();
 			}
-		iWorker->Wake();
-		return true;
+		fRoster->NotePending(fPending.size());
 		}
-	return false;
+
+	iWorker->Wake();
+	return true;
 	}
 
 void Server::pWorkDetached(ZP<Worker> iWorker)
@@ -202,4 +299,159 @@ void Server::pWorkDetached(ZP<Worker> iWorker)
 	fCnd.Broadcast();
 	}
 
+bool Server::pFull_Locked()
+	{
+	return fLimits.fMaxConnections
+		&& fActive >= fLimits.fMaxConnections
+		&& fPending.size() >= fLimits.fMaxPending;
+	}
+
+// Returns the connection, if any, that must be shed to respect our limits.
+ZP<ChannerRW_Bin> Server::pEnqueue_Locked(const ZP<ChannerRW_Bin>& iChanner)
+	{
+	if (not this->pFull_Locked())
+		{
+		fPending.push_back(iChanner);
+		return null;
+		}
+
+	if (fLimits.fShed != eShed_Oldest || fPending.empty())
+		return iChanner;
+
+	const ZP<ChannerRW_Bin> result = fPending.front();
+	fPending.pop_front();
+	fPending.push_back(iChanner);
+	return result;
+	}
+
+void Server::pDispatch_Locked(vector<Dispatch>& oDispatches)
+	{
+	if (not fCallable_Connection || fStarterRefused)
+		return;
+
+	while (fPending.size()
+		&& (not fLimits.fMaxConnections || fActive < fLimits.fMaxConnections))
+		{
+		Dispatch theDispatch;
+		theDispatch.fChanner = fPending.front();
+		fPending.pop_front();
+
+		ZP<Callable_Void> theCallable_Kill =
+			sBindR(sCallable(spKill), sZP(theDispatch.fChanner.DynamicCast<ChannerAbort>()));
+
+		theDispatch.fEntry = fRoster->MakeEntry(theCallable_Kill,
+			sCallable(sWP(this), &Server::pConnectionGone));
+
+		++fActive;
+		oDispatches.push_back(theDispatch);
+		}
+
+	fRoster->NotePending(fPending.size());
+	}
+
+static void spCall(ZP<Server::Callable_Connection> iCallable,
+	ZP<Roster::Entry> iEntry, ZP<ChannerRW_Bin> iChanner)
+	{
+	try
+		{
+		iCallable->Call(iEntry, iChanner);
+		}
+	catch (...)
+		{}
+	}
+
+void Server::pCall(const vector<Dispatch>& iDispatches)
+	{
+	ZP<Callable_Connection> theCallable;
+	ZP<Starter> theStarter;
+	{
+	ZAcqMtx acq(fMtx);
+	theCallable = fCallable_Connection;
+	theStarter = fStarter_Connection;
+	}
+
+	if (not theCallable)
+		return;
+
+	vector<ZP<ChannerRW_Bin>> refused;
+	for (vector<Dispatch>::const_iterator ii = iDispatches.begin(); ii != iDispatches.end(); ++ii)
+		{
+		if (not theStarter)
+			{
+			spCall(theCallable, ii->fEntry, ii->fChanner);
+			}
+		else if (refused.empty()
+			&& sQStart(theStarter,
+				sBindR(sCallable(spCall), theCallable, ii->fEntry, ii->fChanner)))
+			{}
+		else
+			{
+			refused.push_back(ii->fChanner);
+			}
+		}
+
+	if (refused.empty())
+		return;
+
+	// Running the handler here would tie up the accepting thread, or one finishing a connection.
+	// Instead requeue the connections, and stop dispatching till pRetry. Our caller releases
+	// their entries, and pConnectionGone must not simply hand them back to us.
+	ZAcqMtx acq(fMtx);
+	if (fCallable_Connection != theCallable)
+		return;
+
+	fPending.insert(fPending.begin(), refused.begin(), refused.end());
+	fRoster->NotePending(fPending.size());
+	fStarterRefused = true;
+	sNextStartIn(kRetryInterval, fRetry);
+	}
+
+void Server::pConnectionGone()
+	{
+	vector<Dispatch> theDispatches;
+
+	ZAcqMtx acq(fMtx);
+	--fActive;
+
+	if (fStarter_Connection)
+		{
+		// Hand queued connections straight to the pool, rather than waiting for the
+		// accepting thread, which may be blocked in the factory.
+		this->pDispatch_Locked(theDispatches);
+		}
+	else if (fPending.size() && fWorker)
+		{
+		fWorker->Wake();
+		}
+
+	if (fAwaitingRoom && fWorker)
+		{
+		fAwaitingRoom = false;
+		fWorker->Wake();
+		}
+
+	if (theDispatches.size())
+		{
+		ZRelMtx rel(fMtx);
+		this->pCall(theDispatches);
+		theDispatches.clear();
+		}
+	}
+
+void Server::pRetry()
+	{
+	vector<Dispatch> theDispatches;
+
+	ZAcqMtx acq(fMtx);
+	fStarterRefused = false;
+	this->pDispatch_Locked(theDispatches);
+
+	if (theDispatches.size())
+		{
+		ZRelMtx rel(fMtx);
+		this->pCall(theDispatches);
+		theDispatches.clear();
+		}
+	}
+
 } // namespace ZooLib
@@ -24,10 +24,14 @@ OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "zoolib/Cancellable.h"
 #include "zoolib/Connection.h"
+#include "zoolib/StartScheduler.h"
 
 #include "zoolib/Server/Roster.h"
 #include "zoolib/Server/Worker.h"
 
+#include <deque>
+#include <vector>
+
 namespace ZooLib {
 
 // =================================================================================================
@@ -40,6 +44,25 @@ public:
 	typedef ZP<Roster::Entry> ZP_Roster_Entry; // CW7
 	typedef Callable<void(ZP_Roster_Entry,ZP<ChannerRW<byte>>)> Callable_Connection;
 
+	// What to do with a newly accepted connection when fMaxConnections are active and
+	// fMaxPending are already queued.
+	enum EShed
+		{
+		eShed_None, // Don't accept, leave connections in the listener's backlog till there's room.
+		eShed_Newest, // Abort the new connection.
+		eShed_Oldest // Abort the longest-queued connection, and queue the new one.
+		};
+
+	struct Limits
+		{
+		Limits();
+
+		size_t fMaxConnections; // Zero for no limit.
+		size_t fMaxPending;
+		EShed fShed;
+		size_t fAcceptBatch; // How many connections to accept before yielding the Starter.
+		};
+
 	Server();
 	virtual ~Server();
 
@@ -54,6 +77,13 @@ public:
 		ZP<Cancellable> iCancellable,
 		ZP<Callable_Connection> iCallable_Connection);
 
+	void Start(ZP<Starter> iStarter,
+		ZP<Factory_ChannerRW_Bin> iFactory,
+		ZP<Cancellable> iCancellable,
+		ZP<Callable_Connection> iCallable_Connection,
+		const Limits& iLimits,
+		ZP<Starter> iStarter_Connection);
+
 	void Stop();
 	void StopWait();
 
@@ -64,10 +94,25 @@ public:
 
 	ZP<Callable_Connection> GetCallable_Connection();
 
+	Roster::Metrics GetMetrics();
+
 private:
+	struct Dispatch
+		{
+		ZP<Roster::Entry> fEntry;
+		ZP<ChannerRW_Bin> fChanner;
+		};
+
 	bool pWork(ZP<Worker> iWorker);
 	void pWorkDetached(ZP<Worker> iWorker);
 
+	bool pFull_Locked();
+	ZP<ChannerRW_Bin> pEnqueue_Locked(const ZP<ChannerRW_Bin>& iChanner);
+	void pDispatch_Locked(std::vector<Dispatch>& oDispatches);
+	void pCall(const std::vector<Dispatch>& iDispatches);
+	void pConnectionGone();
+	void pRetry();
+
 	ZMtx fMtx;
 	ZCnd fCnd;
 
@@ -76,6 +121,14 @@ private:
 	ZP<Cancellable> fCancellable;
 	ZP<Roster> fRoster;
 
+	Limits fLimits;
+	ZP<Starter> fStarter_Connection;
+	std::deque<ZP<ChannerRW_Bin>> fPending;
+	size_t fActive;
+	bool fAwaitingRoom;
+	bool fStarterRefused;
+	StartScheduler::Job fRetry;
+
 	ZP<Worker> fWorker;
 	};
 
@@ -0,0 +1,539 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#include "zoolib/ValPred/Compiled_ValPred_DB.h"
+
+#include "zoolib/Compare_Rational.h"
+#include "zoolib/Compare_string.h"
+#include "zoolib/Visitor_Do_T.h"
+
+#include "zoolib/ValPred/Expr_Bool_ValPred.h"
+
+#include <algorithm> // For stable_sort
+#include <limits>
+#include <map>
+
+namespace ZooLib {
+
+using std::map;
+using std::vector;
+
+typedef Compiled_ValPred_DB::Op Op;
+typedef ValComparator_Simple::EComparator EComparator;
+
+// =================================================================================================
+#pragma mark - Helpers (anonymous)
+
+namespace { // anonymous
+
+EComparator spFlipped(EComparator iEComparator)
+	{
+	switch (iEComparator)
+		{
+		case ValComparator_Simple::eLT: return ValComparator_Simple::eGT;
+		case ValComparator_Simple::eLE: return ValComparator_Simple::eGE;
+		case ValComparator_Simple::eGE: return ValComparator_Simple::eLE;
+		case ValComparator_Simple::eGT: return ValComparator_Simple::eLT;
+		default: return iEComparator;
+		}
+	}
+
+inline bool spIsTrue(int iCompare, uint8 iEComparator)
+	{
+	switch (iEComparator)
+		{
+		case ValComparator_Simple::eLT: return iCompare < 0;
+		case ValComparator_Simple::eLE: return iCompare <= 0;
+		case ValComparator_Simple::eEQ: return iCompare == 0;
+		case ValComparator_Simple::eNE: return iCompare != 0;
+		case ValComparator_Simple::eGE: return iCompare >= 0;
+		default: return iCompare > 0;
+		}
+	}
+
+template <class T>
+inline int spCompare(const T& iL, const T& iR)
+	{ return iL < iR ? -1 : iR < iL ? 1 : 0; }
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - Node (anonymous)
+
+namespace { // anonymous
+
+// The intermediate form. Not has been pushed down to the leaves, And and Or are n-ary, and
+// constant subexpressions have been folded away.
+
+struct Node
+	{
+	enum EKind { eTrue, eFalse, eLeaf, eAnd, eOr };
+
+	Node(EKind iKind = eTrue)
+	:	fKind(iKind)
+	,	fNegated(false)
+	,	fCost(0)
+	,	fPass(iKind == eTrue ? 1 : 0)
+	,	fLeafCount(0)
+		{}
+
+	EKind fKind;
+
+	Op fOp;
+	bool fNegated;
+
+	vector<Node> fChildren;
+
+	// Expected cost of evaluating this node, and the estimated fraction of rows it passes.
+	double fCost;
+	double fPass;
+
+	size_t fLeafCount;
+	};
+
+// Ratio of cost to the chance of deciding the outcome. Evaluating the terms of an And in
+// ascending order of cost / P(false) minimizes expected cost, and likewise for an Or with
+// cost / P(true).
+double spRank(const Node& iNode, bool iForAnd)
+	{
+	const double decisive = iForAnd ? 1 - iNode.fPass : iNode.fPass;
+	if (decisive <= 0)
+		return std::numeric_limits<double>::infinity();
+	return iNode.fCost / decisive;
+	}
+
+struct CompareRank
+	{
+	CompareRank(bool iForAnd) : fForAnd(iForAnd) {}
+
+	bool operator()(const Node& iL, const Node& iR) const
+		{ return spRank(iL, fForAnd) < spRank(iR, fForAnd); }
+
+	const bool fForAnd;
+	};
+
+// Combine iChildren under an And (or an Or), splicing in nested nodes of the same kind,
+// folding constants and ordering what remains.
+Node spCombined(bool iIsAnd, const vector<Node>& iChildren)
+	{
+	const Node::EKind theKind = iIsAnd ? Node::eAnd : Node::eOr;
+	const Node::EKind theIdentity = iIsAnd ? Node::eTrue : Node::eFalse;
+	const Node::EKind theAbsorber = iIsAnd ? Node::eFalse : Node::eTrue;
+
+	Node result(theKind);
+	for (vector<Node>::const_iterator ii = iChildren.begin(); ii != iChildren.end(); ++ii)
+		{
+		if (ii->fKind == theAbsorber)
+			return Node(theAbsorber);
+		else if (ii->fKind == theKind)
+			{
+			result.fChildren.insert(result.fChildren.end(),
+				ii->fChildren.begin(), ii->fChildren.end());
+			}
+		else if (ii->fKind != theIdentity)
+			result.fChildren.push_back(*ii);
+		}
+
+	if (result.fChildren.empty())
+		return Node(theIdentity);
+
+	if (result.fChildren.size() == 1)
+		return result.fChildren.front();
+
+	std::stable_sort(result.fChildren.begin(), result.fChildren.end(), CompareRank(iIsAnd));
+
+	// The chance we get as far as evaluating each child.
+	double reached = 1;
+	double allPass = 1;
+	double nonePass = 1;
+	result.fCost = 0;
+	result.fLeafCount = 0;
+	for (vector<Node>::const_iterator ii = result.fChildren.begin();
+		ii != result.fChildren.end(); ++ii)
+		{
+		result.fCost += reached * ii->fCost;
+		result.fLeafCount += ii->fLeafCount;
+		allPass *= ii->fPass;
+		nonePass *= 1 - ii->fPass;
+		reached *= iIsAnd ? ii->fPass : 1 - ii->fPass;
+		}
+	result.fPass = iIsAnd ? allPass : 1 - nonePass;
+	return result;
+	}
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - Compiler (anonymous)
+
+namespace { // anonymous
+
+class Compiler
+:	public virtual Visitor_Do_T<Node>
+,	public virtual Visitor_Expr_Bool_True
+,	public virtual Visitor_Expr_Bool_False
+,	public virtual Visitor_Expr_Bool_Not
+,	public virtual Visitor_Expr_Bool_And
+,	public virtual Visitor_Expr_Bool_Or
+,	public virtual Visitor_Expr_Bool_ValPred
+	{
+public:
+	Compiler(vector<string8>& ioNames, vector<Val_DB>& ioConsts,
+		vector<ZP<ValComparator_Callable_DB::Callable_t> >& ioCallables)
+	:	fNames(ioNames)
+	,	fConsts(ioConsts)
+	,	fCallables(ioCallables)
+	,	fNegate(false)
+		{}
+
+// From Visitor_Expr_Bool_XXX
+	virtual void Visit_Expr_Bool_True(const ZP<Expr_Bool_True>&)
+		{ this->pSetResult(Node(fNegate ? Node::eFalse : Node::eTrue)); }
+
+	virtual void Visit_Expr_Bool_False(const ZP<Expr_Bool_False>&)
+		{ this->pSetResult(Node(fNegate ? Node::eTrue : Node::eFalse)); }
+
+	virtual void Visit_Expr_Bool_Not(const ZP<Expr_Bool_Not>& iRep)
+		{
+		SaveSetRestore<bool> ssr(fNegate, not fNegate);
+		this->pSetResult(this->Do(iRep->GetOp0()));
+		}
+
+	virtual void Visit_Expr_Bool_And(const ZP<Expr_Bool_And>& iRep)
+		{ this->pSetResult(this->pCombined(not fNegate, iRep->GetOp0(), iRep->GetOp1())); }
+
+	virtual void Visit_Expr_Bool_Or(const ZP<Expr_Bool_Or>& iRep)
+		{ this->pSetResult(this->pCombined(fNegate, iRep->GetOp0(), iRep->GetOp1())); }
+
+// From Visitor_Expr_Bool_ValPred
+	virtual void Visit_Expr_Bool_ValPred(const ZP<Expr_Bool_ValPred>& iExpr);
+
+private:
+	Node pCombined(bool iIsAnd, const ZP<Expr_Bool>& iOp0, const ZP<Expr_Bool>& iOp1);
+
+	bool pOperand(const ZP<ValComparand>& iComparand, uint32& oIndex);
+	uint32 pName(const string8& iName);
+	uint32 pConst(const Val_DB& iVal);
+
+	vector<string8>& fNames;
+	vector<Val_DB>& fConsts;
+	vector<ZP<ValComparator_Callable_DB::Callable_t> >& fCallables;
+	map<string8,uint32> fNameIndices;
+	bool fNegate;
+	};
+
+Node Compiler::pCombined(bool iIsAnd, const ZP<Expr_Bool>& iOp0, const ZP<Expr_Bool>& iOp1)
+	{
+	vector<Node> theChildren;
+	theChildren.push_back(this->Do(iOp0));
+	theChildren.push_back(this->Do(iOp1));
+	return spCombined(iIsAnd, theChildren);
+	}
+
+bool Compiler::pOperand(const ZP<ValComparand>& iComparand, uint32& oIndex)
+	{
+	if (ZP<ValComparand_Name> asName = iComparand.DynamicCast<ValComparand_Name>())
+		{
+		oIndex = this->pName(asName->GetName());
+		return false;
+		}
+	else if (ZP<ValComparand_Const_DB> asConst = iComparand.DynamicCast<ValComparand_Const_DB>())
+		{
+		oIndex = this->pConst(asConst->GetVal());
+		return true;
+		}
+	ZUnimplemented();
+	}
+
+uint32 Compiler::pName(const string8& iName)
+	{
+	map<string8,uint32>::iterator iter = fNameIndices.lower_bound(iName);
+	if (iter == fNameIndices.end() || iter->first != iName)
+		{
+		iter = fNameIndices.insert(iter, std::make_pair(iName, uint32(fNames.size())));
+		fNames.push_back(iName);
+		}
+	return iter->second;
+	}
+
+uint32 Compiler::pConst(const Val_DB& iVal)
+	{
+	fConsts.push_back(iVal);
+	return uint32(fConsts.size() - 1);
+	}
+
+void Compiler::Visit_Expr_Bool_ValPred(const ZP<Expr_Bool_ValPred>& iExpr)
+	{
+	const ValPred& theValPred = iExpr->GetValPred();
+	const ZP<ValComparator>& theComparator = theValPred.GetComparator();
+
+	Node result(Node::eLeaf);
+	result.fNegated = fNegate;
+	result.fLeafCount = 1;
+
+	Op& theOp = result.fOp;
+	theOp.fEComparator = 0;
+	theOp.fCallable = 0;
+	theOp.fInt64 = 0;
+	theOp.fDouble = 0;
+	theOp.fString = nullptr;
+	theOp.fIfTrue = Compiled_ValPred_DB::kAccept;
+	theOp.fIfFalse = Compiled_ValPred_DB::kReject;
+	theOp.fLeftIsConst = this->pOperand(theValPred.GetLHS(), theOp.fLeft);
+	theOp.fRightIsConst = this->pOperand(theValPred.GetRHS(), theOp.fRight);
+
+	if (ZP<ValComparator_Simple> asSimple = theComparator.DynamicCast<ValComparator_Simple>())
+		{
+		EComparator theEComparator = asSimple->GetEComparator();
+
+		if (theOp.fLeftIsConst && theOp.fRightIsConst)
+			{
+			bool isTrue = spIsTrue(
+				sCompare_T(fConsts[theOp.fLeft], fConsts[theOp.fRight]), theEComparator);
+			if (fNegate)
+				isTrue = not isTrue;
+			this->pSetResult(Node(isTrue ? Node::eTrue : Node::eFalse));
+			return;
+			}
+
+		if (theOp.fLeftIsConst)
+			{
+			// Put the name on the left.
+			std::swap(theOp.fLeft, theOp.fRight);
+			std::swap(theOp.fLeftIsConst, theOp.fRightIsConst);
+			theEComparator = spFlipped(theEComparator);
+			}
+		theOp.fEComparator = theEComparator;
+
+		theOp.fKind = Op::eGeneric;
+		result.fCost = 4;
+		if (theOp.fRightIsConst)
+			{
+			const Val_DB& theConst = fConsts[theOp.fRight];
+			if (const int64* asInt64 = theConst.PGet<int64>())
+				{
+				theOp.fKind = Op::eInt64;
+				theOp.fInt64 = *asInt64;
+				result.fCost = 1;
+				}
+			else if (const double* asDouble = theConst.PGet<double>())
+				{
+				theOp.fKind = Op::eDouble;
+				theOp.fDouble = *asDouble;
+				result.fCost = 1;
+				}
+			else if (theConst.PGet<string8>())
+				{
+				// fString is filled in once fConsts has stopped moving.
+				theOp.fKind = Op::eString;
+				result.fCost = 2;
+				}
+			}
+
+		// The textbook default selectivities.
+		switch (theEComparator)
+			{
+			case ValComparator_Simple::eEQ: result.fPass = 0.1; break;
+			case ValComparator_Simple::eNE: result.fPass = 0.9; break;
+			default: result.fPass = 1.0 / 3; break;
+			}
+		}
+	else if (ZP<ValComparator_Callable_DB> asCallable =
+		theComparator.DynamicCast<ValComparator_Callable_DB>())
+		{
+		theOp.fKind = Op::eCallable;
+		theOp.fCallable = uint32(fCallables.size());
+		fCallables.push_back(asCallable->GetCallable());
+		result.fCost = 16;
+		result.fPass = 0.5;
+		}
+	else
+		{
+		// ValComparator_StringContains is not implemented by the uncompiled evaluators either.
+		ZUnimplemented();
+		}
+
+	if (fNegate)
+		result.fPass = 1 - result.fPass;
+
+	this->pSetResult(result);
+	}
+
+// Append iNode's ops to ioOps, branching to iIfTrue or iIfFalse once its value is known.
+void spEmit(const Node& iNode, uint32 iIfTrue, uint32 iIfFalse, vector<Op>& ioOps)
+	{
+	switch (iNode.fKind)
+		{
+		case Node::eLeaf:
+			{
+			ioOps.push_back(iNode.fOp);
+			Op& theOp = ioOps.back();
+			theOp.fIfTrue = iNode.fNegated ? iIfFalse : iIfTrue;
+			theOp.fIfFalse = iNode.fNegated ? iIfTrue : iIfFalse;
+			break;
+			}
+		case Node::eAnd:
+		case Node::eOr:
+			{
+			const bool isAnd = iNode.fKind == Node::eAnd;
+			for (size_t xx = 0; xx < iNode.fChildren.size(); ++xx)
+				{
+				const Node& theChild = iNode.fChildren[xx];
+				if (xx + 1 == iNode.fChildren.size())
+					{
+					spEmit(theChild, iIfTrue, iIfFalse, ioOps);
+					}
+				else
+					{
+					const uint32 theNext = uint32(ioOps.size() + theChild.fLeafCount);
+					if (isAnd)
+						spEmit(theChild, theNext, iIfFalse, ioOps);
+					else
+						spEmit(theChild, iIfTrue, theNext, ioOps);
+					}
+				}
+			break;
+			}
+		default:
+			{
+			// Constants are folded away by spCombined, other than at the root.
+			ZUnimplemented();
+			}
+		}
+	}
+
+} // anonymous namespace
+
+// =================================================================================================
+#pragma mark - Compiled_ValPred_DB
+
+Compiled_ValPred_DB::Compiled_ValPred_DB(const ZP<Expr_Bool>& iExpr_Bool)
+:	fResult_Constant(true)
+	{
+	const Node theRoot = Compiler(fNames, fConsts, fCallables).Do(iExpr_Bool);
+
+	if (theRoot.fKind == Node::eTrue || theRoot.fKind == Node::eFalse)
+		{
+		fResult_Constant = theRoot.fKind == Node::eTrue;
+		}
+	else
+		{
+		fOps.reserve(theRoot.fLeafCount);
+		spEmit(theRoot, kAccept, kReject, fOps);
+		}
+
+	for (vector<Op>::iterator ii = fOps.begin(); ii != fOps.end(); ++ii)
+		{
+		if (ii->fKind == Op::eString)
+			ii->fString = fConsts[ii->fRight].PGet<string8>();
+		}
+
+	fNames_Interned.assign(fNames.begin(), fNames.end());
+	}
+
+Compiled_ValPred_DB::~Compiled_ValPred_DB()
+	{}
+
+const vector<string8>& Compiled_ValPred_DB::GetNames() const
+	{ return fNames; }
+
+namespace { // anonymous
+
+struct Fetch_Row
+	{
+	const Val_DB& operator()(uint32 iIndex) const
+		{ return fRow[fOffsets[iIndex]]; }
+
+	const Val_DB* fRow;
+	const size_t* fOffsets;
+	};
+
+struct Fetch_Map
+	{
+	const Val_DB& operator()(uint32 iIndex) const
+		{ return fMap.Get(fNames[iIndex]); }
+
+	const Map_ZZ& fMap;
+	const Name* fNames;
+	};
+
+} // anonymous namespace
+
+bool Compiled_ValPred_DB::Matches(const Val_DB* iRow, const size_t* iOffsets) const
+	{
+	const Fetch_Row theFetch = { iRow, iOffsets };
+	return this->pRun(theFetch);
+	}
+
+bool Compiled_ValPred_DB::Matches(const Val_DB& iVal) const
+	{
+	const Fetch_Map theFetch = { iVal.Get<Map_ZZ>(), fNames_Interned.data() };
+	return this->pRun(theFetch);
+	}
+
+template <class Fetch_p>
+bool Compiled_ValPred_DB::pRun(const Fetch_p& iFetch) const
+	{
+	if (fOps.empty())
+		return fResult_Constant;
+
+	const Op* theOps = fOps.data();
+	const Val_DB* theConsts = fConsts.data();
+	for (uint32 pc = 0; /*no test*/; /*no inc*/)
+		{
+		const Op& theOp = theOps[pc];
+		bool isTrue;
+		switch (theOp.fKind)
+			{
+			case Op::eInt64:
+				{
+				const Val_DB& theVal = iFetch(theOp.fLeft);
+				if (const int64* asInt64 = theVal.PGet<int64>())
+					isTrue = spIsTrue(spCompare(*asInt64, theOp.fInt64), theOp.fEComparator);
+				else
+					isTrue = spIsTrue(theVal.Compare(theConsts[theOp.fRight]), theOp.fEComparator);
+				break;
+				}
+			case Op::eDouble:
+				{
+				const Val_DB& theVal = iFetch(theOp.fLeft);
+				if (const double* asDouble = theVal.PGet<double>())
+					isTrue = spIsTrue(sCompare_T(*asDouble, theOp.fDouble), theOp.fEComparator);
+				else
+					isTrue = spIsTrue(theVal.Compare(theConsts[theOp.fRight]), theOp.fEComparator);
+				break;
+				}
+			case Op::eString:
+				{
+				const Val_DB& theVal = iFetch(theOp.fLeft);
+				if (const string8* asString = theVal.PGet<string8>())
+					isTrue = spIsTrue(asString->compare(*theOp.fString), theOp.fEComparator);
+				else
+					isTrue = spIsTrue(theVal.Compare(theConsts[theOp.fRight]), theOp.fEComparator);
+				break;
+				}
+			case Op::eGeneric:
+				{
+				const Val_DB& theL = iFetch(theOp.fLeft);
+				const Val_DB& theR =
+					theOp.fRightIsConst ? theConsts[theOp.fRight] : iFetch(theOp.fRight);
+				isTrue = spIsTrue(sCompare_T(theL, theR), theOp.fEComparator);
+				break;
+				}
+			default:
+				{
+				const Val_DB& theL =
+					theOp.fLeftIsConst ? theConsts[theOp.fLeft] : iFetch(theOp.fLeft);
+				const Val_DB& theR =
+					theOp.fRightIsConst ? theConsts[theOp.fRight] : iFetch(theOp.fRight);
+				isTrue = fCallables[theOp.fCallable]->Call(theL, theR);
+				break;
+				}
+			}
+
+		pc = isTrue ? theOp.fIfTrue : theOp.fIfFalse;
+		if (pc >= kReject)
+			return pc == kAccept;
+		}
+	}
+
+} // namespace ZooLib
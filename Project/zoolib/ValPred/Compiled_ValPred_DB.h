@@ -0,0 +1,83 @@
+// Copyright (c) 2020 Andrew Green. MIT License. http://www.zoolib.org
+
+#ifndef __ZooLib_ValPred_Compiled_ValPred_DB_h__
+#define __ZooLib_ValPred_Compiled_ValPred_DB_h__ 1
+#include "zconfig.h"
+
+#include "zoolib/Counted.h"
+#include "zoolib/Val_DB.h"
+
+#include "zoolib/Expr/Expr_Bool.h"
+
+#include "zoolib/ValPred/ValPred_DB.h"
+
+#include <vector>
+
+namespace ZooLib {
+
+// =================================================================================================
+#pragma mark - Compiled_ValPred_DB
+
+// An Expr_Bool of ValPreds flattened into a branch program. Names are numbered ahead of time,
+// comparisons against int64, double and string constants skip the Comparer registry, and the
+// terms of each And/Or are ordered so the cheapest, most decisive ones are evaluated first.
+
+class Compiled_ValPred_DB : public Counted
+	{
+public:
+	Compiled_ValPred_DB(const ZP<Expr_Bool>& iExpr_Bool);
+	virtual ~Compiled_ValPred_DB();
+
+// Our protocol
+	// The distinct names referenced by the expression. Matches(iRow, iOffsets) expects
+	// iOffsets[xx] to be the offset within iRow of the column named GetNames()[xx].
+	const std::vector<string8>& GetNames() const;
+
+	bool Matches(const Val_DB* iRow, const size_t* iOffsets) const;
+
+	// iVal is expected to hold a Map_ZZ, whose entries are looked up by name.
+	bool Matches(const Val_DB& iVal) const;
+
+	struct Op
+		{
+		enum EKind { eInt64, eDouble, eString, eGeneric, eCallable };
+
+		uint8 fKind;
+		uint8 fEComparator;
+		bool fLeftIsConst;
+		bool fRightIsConst;
+
+		// Name or const indices. The specialized kinds always have a name on the left and
+		// a const on the right, whose payload is also held in fInt64, fDouble or fString.
+		uint32 fLeft;
+		uint32 fRight;
+
+		// Index into fOps, or kAccept or kReject.
+		uint32 fIfTrue;
+		uint32 fIfFalse;
+
+		uint32 fCallable;
+
+		int64 fInt64;
+		double fDouble;
+		const string8* fString;
+		};
+
+	static const uint32 kAccept = 0xFFFFFFFF;
+	static const uint32 kReject = 0xFFFFFFFE;
+
+private:
+	template <class Fetch_p>
+	bool pRun(const Fetch_p& iFetch) const;
+
+	std::vector<string8> fNames;
+	std::vector<Name> fNames_Interned;
+	std::vector<Val_DB> fConsts;
+	std::vector<ZP<ValComparator_Callable_DB::Callable_t> > fCallables;
+	std::vector<Op> fOps;
+	bool fResult_Constant;
+	};
+
+} // namespace ZooLib
+
+#endif // __ZooLib_ValPred_Compiled_ValPred_DB_h__
@@ -31,6 +31,8 @@ private:
 	const Val_DB& fVal;
 	};
 
+// Walks iExpr afresh on each call. To test many values against the same expression build a
+// Compiled_ValPred_DB once and use its Matches instead.
 bool sMatches(const ZP<Expr_Bool>& iExpr, const Val_DB& iVal);
 
 } // namespace ZooLib